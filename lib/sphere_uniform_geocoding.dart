@@ -2,6 +2,9 @@ import 'dart:async';
 import 'dart:ffi';
 import 'dart:io';
 import 'dart:isolate';
+import 'dart:typed_data';
+
+import 'package:ffi/ffi.dart';
 
 import 'sphere_uniform_geocoding_bindings_generated.dart';
 
@@ -12,15 +15,138 @@ import 'sphere_uniform_geocoding_bindings_generated.dart';
 /// only do this for native functions which are guaranteed to be short-lived.
 int sum(int a, int b) => _bindings.sum(a, b);
 
+/// Precomputed tables for one [n] (a native GeocodingContext), for repeated
+/// calls at the same [n] (at most 14654).
+///
+/// [precision] is one of the [LatLngPrecision] constants and applies to the
+/// centers returned here; the top-level functions always use
+/// `LatLngPrecision_Exact`. The tables never change after creation, so one
+/// geocoder may be used from several isolates at once. Native memory is
+/// released when this object is garbage collected, or earlier with [dispose].
+final class Geocoder implements Finalizable {
+  Geocoder(this.n, {this.precision = LatLngPrecision.LatLngPrecision_Exact})
+      : _context = _bindings.CreateGeocodingContextWithPrecision(n, precision) {
+    if (_context == nullptr) {
+      throw ArgumentError('invalid n or precision');
+    }
+    _geocodingContextFinalizer.attach(this, _context.cast(), detach: this);
+  }
+
+  final int n;
+  final int precision;
+  final Pointer<GeocodingContext> _context;
+  bool _disposed = false;
+
+  Pointer<GeocodingContext> get _checkedContext {
+    if (_disposed) {
+      throw StateError('the geocoder has been disposed');
+    }
+    return _context;
+  }
+
+  int segmentIndexFromLatLng(double lat, double lng) =>
+      _bindings.CalculateSegmentIndexFromLatLngWithContext(
+          _checkedContext, lat, lng);
+
+  (double, double) segmentCenter(int segmentId) {
+    final center = _bindings.CalculateSegmentCenterLatLngWithContext(
+        _checkedContext, segmentId);
+    return (center.lat, center.lng);
+  }
+
+  void dispose() {
+    if (!_disposed) {
+      _disposed = true;
+      _geocodingContextFinalizer.detach(this);
+      _bindings.DestroyGeocodingContext(_context);
+    }
+  }
+}
+
+final NativeFinalizer _geocodingContextFinalizer = NativeFinalizer(
+    _dylib.lookup<NativeFunction<Void Function(Pointer<Void>)>>(
+        'DestroyGeocodingContext'));
+
+/// Writes the precomputed adjacency of every segment at [n] to [path]; open it
+/// with [SegmentAdjacencyTable]. Throws [FileSystemException] if the file
+/// cannot be written.
+void writeAdjacencyTableFile(int n, String path) {
+  final nativePath = path.toNativeUtf8();
+  try {
+    final result = _bindings.WriteAdjacencyTableFile(n, nativePath.cast());
+    if (result == ErrorCode.ErrorCode_IoError) {
+      throw FileSystemException('cannot write adjacency table', path);
+    }
+    if (result < 0) {
+      throw ArgumentError('invalid n ($result)');
+    }
+  } finally {
+    malloc.free(nativePath);
+  }
+}
+
+/// A memory-mapped adjacency table file (a native AdjacencyTable) written by
+/// [writeAdjacencyTableFile].
+///
+/// Opening only maps the file, and isolates or processes that open the same
+/// file share its pages. Lookups beat [getNeighborsOfSegmentIndex] when the
+/// table fits in cache (n <= 64) or segments are visited in index order, but
+/// are slower for random access to larger tables. The mapping is released
+/// when this object is garbage collected, or earlier with [dispose].
+final class SegmentAdjacencyTable implements Finalizable {
+  factory SegmentAdjacencyTable(String path) {
+    final nativePath = path.toNativeUtf8();
+    try {
+      final table = _bindings.OpenAdjacencyTable(nativePath.cast());
+      if (table == nullptr) {
+        throw FileSystemException('not a valid adjacency table', path);
+      }
+      return SegmentAdjacencyTable._(table);
+    } finally {
+      malloc.free(nativePath);
+    }
+  }
+
+  SegmentAdjacencyTable._(this._table)
+      : n = _bindings.GetAdjacencyTableN(_table) {
+    _adjacencyTableFinalizer.attach(this, _table.cast(), detach: this);
+  }
+
+  final int n;
+  final Pointer<AdjacencyTable> _table;
+  bool _disposed = false;
+
+  /// Same neighbors, in the same order, as [getNeighborsOfSegmentIndex].
+  List<int> neighborsOf(int segmentId) {
+    if (_disposed) {
+      throw StateError('the adjacency table has been disposed');
+    }
+    final segIdList =
+        _bindings.GetNeighborsFromAdjacencyTable64(_table, segmentId);
+    return List<int>.generate(
+        segIdList.count, (i) => segIdList.neighborSegId[i]);
+  }
+
+  void dispose() {
+    if (!_disposed) {
+      _disposed = true;
+      _adjacencyTableFinalizer.detach(this);
+      _bindings.CloseAdjacencyTable(_table);
+    }
+  }
+}
+
+final NativeFinalizer _adjacencyTableFinalizer = NativeFinalizer(
+    _dylib.lookup<NativeFunction<Void Function(Pointer<Void>)>>(
+        'CloseAdjacencyTable'));
+
 int calculateSegmentIndexFromLatLng(
         int n, double userPosLat, double userPosLng) =>
     _bindings.CalculateSegmentIndexFromLatLng(n, userPosLat, userPosLng);
 
 (double, double) calculateSegmentCenter(int n, int segmentId) {
-  return (
-    _bindings.CalculateSegmentCenterLat(n, segmentId),
-    _bindings.CalculateSegmentCenterLng(n, segmentId)
-  );
+  final center = _bindings.CalculateSegmentCenterLatLng(n, segmentId);
+  return (center.lat, center.lng);
 }
 
 Vector3 calculateSegmentCenterPos(int n, int segmentId) {
@@ -36,6 +162,180 @@ List<int> getNeighborsOfSegmentIndex(int n, int segmentId) {
   return ret;
 }
 
+/// Segments within [k] neighbor hops of [segmentId], the center included,
+/// in ascending index order. Computed natively in one call.
+List<int> getKRingOfSegmentIndex(int n, int segmentId, int k) =>
+    _getRing(n, segmentId, k, _bindings.GetKRingOfSegmentIndex);
+
+/// Segments exactly [k] neighbor hops away from [segmentId].
+List<int> getHollowRingOfSegmentIndex(int n, int segmentId, int k) =>
+    _getRing(n, segmentId, k, _bindings.GetHollowRingOfSegmentIndex);
+
+List<int> _getRing(int n, int segmentId, int k,
+    int Function(int, int, int, Pointer<Int>, int) query) {
+  final count = query(n, segmentId, k, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid n, segment index or k ($count)');
+  }
+  final buffer = malloc<Int>(count == 0 ? 1 : count);
+  try {
+    final written = query(n, segmentId, k, buffer, count);
+    return List<int>.generate(written, (i) => buffer[i]);
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
+/// Segments covering a polygon given as rings of (lat, lng) in radians: the
+/// first ring is the outer boundary and the rest are holes. With [overlap]
+/// set, segments that overlap the polygon at all are included; otherwise only
+/// those whose center lies inside.
+List<int> getSegmentIndicesInPolygon(
+    int n, List<List<(double, double)>> rings,
+    {bool overlap = false}) {
+  final vertexCount = rings.fold<int>(0, (sum, ring) => sum + ring.length);
+  final vertices = malloc<GpsCoords>(vertexCount == 0 ? 1 : vertexCount);
+  final ringVertexCounts = malloc<Int>(rings.isEmpty ? 1 : rings.length);
+  final cursor = malloc<Int64>();
+  try {
+    var offset = 0;
+    for (var r = 0; r < rings.length; r++) {
+      ringVertexCounts[r] = rings[r].length;
+      for (final (lat, lng) in rings[r]) {
+        vertices[offset].lat = lat;
+        vertices[offset].lng = lng;
+        offset++;
+      }
+    }
+
+    final mode = overlap
+        ? PolygonFillMode.PolygonFillMode_Overlap
+        : PolygonFillMode.PolygonFillMode_Center;
+    cursor.value = 0;
+    final count = _bindings.GetSegmentIndicesInPolygon(
+        n, vertices, ringVertexCounts, rings.length, mode, cursor, nullptr, 0);
+    if (count < 0) {
+      throw ArgumentError('invalid n or polygon ($count)');
+    }
+    final buffer = malloc<Int>(count == 0 ? 1 : count);
+    try {
+      final written = _bindings.GetSegmentIndicesInPolygon(n, vertices,
+          ringVertexCounts, rings.length, mode, cursor, buffer, count);
+      return List<int>.generate(written, (i) => buffer[i]);
+    } finally {
+      malloc.free(buffer);
+    }
+  } finally {
+    malloc.free(vertices);
+    malloc.free(ringVertexCounts);
+    malloc.free(cursor);
+  }
+}
+
+/// Segments within the spherical cap around ([lat], [lng]) in radians.
+/// [radius] is an angle in radians; divide a distance on Earth by the Earth
+/// radius. With [conservative] set, segments that overlap the cap at all are
+/// included; otherwise only those whose center lies inside.
+List<int> getSegmentIndicesInCap(int n, double lat, double lng, double radius,
+    {bool conservative = false}) {
+  final mode = conservative
+      ? CapQueryMode.CapQueryMode_Conservative
+      : CapQueryMode.CapQueryMode_Exact;
+  final count =
+      _bindings.GetSegmentIndicesInCap(n, lat, lng, radius, mode, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid n or radius ($count)');
+  }
+  final buffer = malloc<Int>(count == 0 ? 1 : count);
+  try {
+    final written = _bindings.GetSegmentIndicesInCap(
+        n, lat, lng, radius, mode, buffer, count);
+    return List<int>.generate(written, (i) => buffer[i]);
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
+/// Segments covering a lat/lng box in radians, in ascending index order.
+/// [minLng] greater than [maxLng] means the box crosses the antimeridian.
+/// The result is produced in chunks of at most [chunkSize] indices as the
+/// iterable is walked, so memory stays bounded however large the box is.
+/// With [overlap] set, segments that overlap the box at all are included;
+/// otherwise only those whose center lies inside.
+Iterable<List<int>> getSegmentIndicesInLatLngBox(
+    int n, double minLat, double minLng, double maxLat, double maxLng,
+    {bool overlap = false, int chunkSize = 4096}) sync* {
+  if (chunkSize < 1) {
+    throw ArgumentError.value(chunkSize, 'chunkSize');
+  }
+  final mode = overlap
+      ? PolygonFillMode.PolygonFillMode_Overlap
+      : PolygonFillMode.PolygonFillMode_Center;
+  final cursor = malloc<Int64>();
+  final buffer = malloc<Int64>(chunkSize);
+  try {
+    cursor.value = 0;
+    while (cursor.value != -1) {
+      final written = _bindings.GetSegmentIndicesInLatLngBox64(n, minLat,
+          minLng, maxLat, maxLng, mode, cursor, buffer, chunkSize);
+      if (written < 0) {
+        throw ArgumentError('invalid n or box ($written)');
+      }
+      if (written > 0) {
+        yield List<int>.generate(written, (i) => buffer[i]);
+      }
+    }
+  } finally {
+    malloc.free(cursor);
+    malloc.free(buffer);
+  }
+}
+
+/// The segment of the [n] grid that contains [segmentId] of the `k * n` grid.
+int getParentSegmentIndex(int n, int k, int segmentId) {
+  final parent = _bindings.GetParentSegmentIndex(n, k, segmentId);
+  if (parent < 0) {
+    throw ArgumentError('invalid n, k or segment index ($parent)');
+  }
+  return parent;
+}
+
+/// [getParentSegmentIndex] for many segments in one native call.
+List<int> getParentSegmentIndexBatch(int n, int k, List<int> segmentIds) {
+  final count = segmentIds.length;
+  final buffer = malloc<Int>(count == 0 ? 1 : count);
+  try {
+    for (var i = 0; i < count; i++) {
+      buffer[i] = segmentIds[i];
+    }
+    final result = _bindings.GetParentSegmentIndexBatch(
+        _batchThreadPool, n, k, count, buffer, buffer);
+    if (result != ErrorCode.ErrorCode_None) {
+      throw ArgumentError('invalid n or k ($result)');
+    }
+    return List<int>.generate(count, (i) => buffer[i]);
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
+/// The `k * k` segments of the `k * n` grid that make up [segmentId] of the
+/// [n] grid, in ascending index order.
+List<int> getChildSegmentIndices(int n, int k, int segmentId) {
+  final count = _bindings.GetChildSegmentIndices(n, k, segmentId, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid n, k or segment index ($count)');
+  }
+  final buffer = malloc<Int>(count == 0 ? 1 : count);
+  try {
+    final written =
+        _bindings.GetChildSegmentIndices(n, k, segmentId, buffer, count);
+    return List<int>.generate(written, (i) => buffer[i]);
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
 int convertToSegmentIndex2(int n, int segmentGroupIndex, int localSegmentIndex) {
   return _bindings.ConvertToSegmentIndex2(n, segmentGroupIndex, localSegmentIndex);
 }
@@ -53,6 +353,487 @@ List<(double, double)> calculateSegmentCornersInLatLng(int n, int segmentIndex)
   ];
 }
 
+/// 64-bit variants of the functions above, for `n` beyond 14654 (up to 1048576).
+///
+/// Segment indices are numbered the same way, so they equal the 32-bit ones
+/// wherever those are valid.
+int calculateSegmentIndexFromLatLng64(
+        int n, double userPosLat, double userPosLng) =>
+    _bindings.CalculateSegmentIndexFromLatLng64(n, userPosLat, userPosLng);
+
+(double, double) calculateSegmentCenter64(int n, int segmentId) {
+  final center = _bindings.CalculateSegmentCenterLatLng64(n, segmentId);
+  return (center.lat, center.lng);
+}
+
+Vector3 calculateSegmentCenterPos64(int n, int segmentId) {
+  return _bindings.CalculateSegmentCenter64(n, segmentId);
+}
+
+List<int> getNeighborsOfSegmentIndex64(int n, int segmentId) {
+  final segIdList = _bindings.GetNeighborsOfSegmentIndex64(n, segmentId);
+  final ret = <int>[];
+  for (var i = 0; i < segIdList.count; i++) {
+    ret.add(segIdList.neighborSegId[i]);
+  }
+  return ret;
+}
+
+List<int> getKRingOfSegmentIndex64(int n, int segmentId, int k) =>
+    _getRing64(n, segmentId, k, _bindings.GetKRingOfSegmentIndex64);
+
+List<int> getHollowRingOfSegmentIndex64(int n, int segmentId, int k) =>
+    _getRing64(n, segmentId, k, _bindings.GetHollowRingOfSegmentIndex64);
+
+List<int> _getRing64(int n, int segmentId, int k,
+    int Function(int, int, int, Pointer<Int64>, int) query) {
+  final count = query(n, segmentId, k, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid n, segment index or k ($count)');
+  }
+  final buffer = malloc<Int64>(count == 0 ? 1 : count);
+  try {
+    final written = query(n, segmentId, k, buffer, count);
+    return List<int>.generate(written, (i) => buffer[i]);
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
+int convertToSegmentIndex64(int n, int segmentGroupIndex, int localSegmentIndex) {
+  return _bindings.ConvertToSegmentIndex64(n, segmentGroupIndex, localSegmentIndex);
+}
+
+SegGroupAndLocalSegIndex64 splitSegIndexToSegGroupAndLocalSegmentIndex64(int n, int segmentIndex) {
+  return _bindings.SplitSegIndexToSegGroupAndLocalSegmentIndex64(n, segmentIndex);
+}
+
+List<(double, double)> calculateSegmentCornersInLatLng64(int n, int segmentIndex) {
+  final corners = _bindings.CalculateSegmentCornersInLatLng64(n, segmentIndex);
+  return [
+    (corners.points[0].lat, corners.points[0].lng),
+    (corners.points[1].lat, corners.points[1].lng),
+    (corners.points[2].lat, corners.points[2].lng),
+  ];
+}
+
+/// Encodes ascending, unique segment indices at the finest of [levelN]
+/// (ascending, each a multiple of the previous) as the fewest cells across
+/// those resolutions.
+Uint8List compactSegmentIndices64(List<int> levelN, List<int> segmentIds) {
+  final levels = malloc<Int>(levelN.isEmpty ? 1 : levelN.length);
+  final ids = malloc<Int64>(segmentIds.isEmpty ? 1 : segmentIds.length);
+  try {
+    for (var i = 0; i < levelN.length; i++) {
+      levels[i] = levelN[i];
+    }
+    for (var i = 0; i < segmentIds.length; i++) {
+      ids[i] = segmentIds[i];
+    }
+    final size = _bindings.CompactSegmentIndices64(
+        levels, levelN.length, ids, segmentIds.length, nullptr, 0);
+    if (size < 0) {
+      throw ArgumentError('invalid levels or segment indices ($size)');
+    }
+    final out = malloc<Uint8>(size);
+    try {
+      _bindings.CompactSegmentIndices64(
+          levels, levelN.length, ids, segmentIds.length, out, size);
+      return Uint8List.fromList(out.asTypedList(size));
+    } finally {
+      malloc.free(out);
+    }
+  } finally {
+    malloc.free(levels);
+    malloc.free(ids);
+  }
+}
+
+/// Expands an encoding from [compactSegmentIndices64] back to the ascending
+/// segment indices at its finest resolution.
+List<int> uncompactSegmentIndices64(Uint8List encoded) {
+  return _withEncoded(encoded, (data) {
+    final count =
+        _bindings.UncompactSegmentIndices64(data, encoded.length, nullptr, 0);
+    if (count < 0) {
+      throw ArgumentError('malformed compact segment set ($count)');
+    }
+    final buffer = malloc<Int64>(count == 0 ? 1 : count);
+    try {
+      final written = _bindings.UncompactSegmentIndices64(
+          data, encoded.length, buffer, count);
+      return List<int>.generate(written, (i) => buffer[i]);
+    } finally {
+      malloc.free(buffer);
+    }
+  });
+}
+
+bool isSegmentInCompactSet64(Uint8List encoded, int segmentId) {
+  final result = _withEncoded(encoded,
+      (data) => _bindings.IsSegmentInCompactSet64(data, encoded.length, segmentId));
+  if (result < 0) {
+    throw ArgumentError('malformed set or invalid segment index ($result)');
+  }
+  return result == 1;
+}
+
+T _withEncoded<T>(Uint8List encoded, T Function(Pointer<Uint8>) body) {
+  final data = malloc<Uint8>(encoded.isEmpty ? 1 : encoded.length);
+  try {
+    data.asTypedList(encoded.length).setAll(0, encoded);
+    return body(data);
+  } finally {
+    malloc.free(data);
+  }
+}
+
+// Top-level variables are per isolate, so each isolate owns its pool and no
+// batch call can still be using it when it is replaced.
+Pointer<ThreadPool> _batchThreadPool = nullptr;
+
+/// Runs the batch functions called from this isolate on a native
+/// work-stealing pool of [threadCount] threads (0: one per processor). Pass 1
+/// to go back to the calling thread.
+///
+/// Results are the same either way. Other isolates are not affected.
+void setBatchThreadCount(int threadCount) {
+  _bindings.DestroyThreadPool(_batchThreadPool);
+  _batchThreadPool = nullptr;
+  if (threadCount == 1) {
+    return;
+  }
+  _batchThreadPool = _bindings.CreateThreadPool(threadCount);
+  if (_batchThreadPool == nullptr) {
+    throw StateError('could not start the thread pool');
+  }
+}
+
+/// Per-segment point counts and weight sums from [aggregatePointsBySegment].
+class SegmentAggregationResult {
+  /// Segment indices that received at least one point, ascending.
+  final Int64List segmentIds;
+  final Int64List counts;
+
+  /// One list per weight column, parallel to [segmentIds].
+  final List<Float64List> sums;
+
+  /// Per thread: (points, points that could not be geocoded, seconds).
+  final List<(int, int, double)> threadStats;
+  final double mergeSeconds;
+
+  const SegmentAggregationResult(this.segmentIds, this.counts, this.sums,
+      this.threadStats, this.mergeSeconds);
+}
+
+/// Buckets points into segments on [threadCount] native threads (0: one per
+/// processor), counting points and summing each of [weights] per segment.
+///
+/// Blocks until done, so call it off the main isolate for large inputs.
+SegmentAggregationResult aggregatePointsBySegment(
+    int n, Float64List lat, Float64List lng,
+    {List<Float64List> weights = const [], int threadCount = 0}) {
+  final count = lat.length;
+  if (lng.length != count || weights.any((w) => w.length != count)) {
+    throw ArgumentError('lat, lng and weights must have the same length');
+  }
+  final latPtr = malloc<Double>(count == 0 ? 1 : count);
+  final lngPtr = malloc<Double>(count == 0 ? 1 : count);
+  final weightPtrs = malloc<Pointer<Double>>(weights.isEmpty ? 1 : weights.length);
+  Pointer<SegmentAggregation> aggregation = nullptr;
+  try {
+    latPtr.asTypedList(count).setAll(0, lat);
+    lngPtr.asTypedList(count).setAll(0, lng);
+    for (var c = 0; c < weights.length; c++) {
+      weightPtrs[c] = malloc<Double>(count == 0 ? 1 : count);
+      weightPtrs[c].asTypedList(count).setAll(0, weights[c]);
+    }
+    aggregation = _bindings.AggregatePointsBySegment(n, count, latPtr, lngPtr,
+        weightPtrs, weights.length, threadCount);
+    if (aggregation == nullptr) {
+      throw ArgumentError('invalid n, or out of memory');
+    }
+
+    final segmentCount =
+        _bindings.GetSegmentAggregationSegmentCount(aggregation);
+    return SegmentAggregationResult(
+      Int64List.fromList(_bindings
+          .GetSegmentAggregationSegmentIndices(aggregation)
+          .asTypedList(segmentCount)),
+      Int64List.fromList(_bindings
+          .GetSegmentAggregationCounts(aggregation)
+          .asTypedList(segmentCount)),
+      List<Float64List>.generate(
+          weights.length,
+          (c) => Float64List.fromList(_bindings
+              .GetSegmentAggregationSums(aggregation, c)
+              .asTypedList(segmentCount))),
+      List<(int, int, double)>.generate(
+          _bindings.GetSegmentAggregationThreadCount(aggregation), (t) {
+        final stats =
+            _bindings.GetSegmentAggregationThreadStats(aggregation, t);
+        return (stats.pointCount, stats.skippedCount, stats.seconds);
+      }),
+      _bindings.GetSegmentAggregationMergeSeconds(aggregation),
+    );
+  } finally {
+    _bindings.DestroySegmentAggregation(aggregation);
+    for (var c = 0; c < weights.length; c++) {
+      malloc.free(weightPtrs[c]);
+    }
+    malloc.free(weightPtrs);
+    malloc.free(latPtr);
+    malloc.free(lngPtr);
+  }
+}
+
+/// One face of the shared-vertex globe mesh (see [globeMeshFace]).
+class GlobeMeshFace {
+  /// Global index of the first vertex in [positions].
+  final int firstVertex;
+
+  /// x, y, z of each vertex the face owns, on the unit sphere.
+  final Float32List positions;
+
+  /// Three global vertex indices per triangle; triangle t is segment
+  /// face * n * n + t.
+  final Uint32List indices;
+
+  const GlobeMeshFace(this.firstVertex, this.positions, this.indices);
+}
+
+/// Number of vertices of the shared-vertex globe mesh (10 * n * n + 2).
+int globeMeshVertexCount(int n) {
+  final count = _bindings.GetGlobeMeshVertexCount(n);
+  if (count < 0) {
+    throw ArgumentError('invalid n ($count)');
+  }
+  return count;
+}
+
+/// The vertices owned by [face] (0 .. 19) and its triangles. Appending the
+/// faces in order builds the whole mesh; a renderer can also upload them one
+/// at a time.
+GlobeMeshFace globeMeshFace(int n, int face) {
+  final vertexCount = _bindings.GetGlobeMeshFaceVertices(n, face, nullptr, 0);
+  if (vertexCount < 0) {
+    throw ArgumentError('invalid n or face ($vertexCount)');
+  }
+  final triangleCount = n * n;
+  final positions = malloc<Float>(vertexCount == 0 ? 3 : vertexCount * 3);
+  final indices = malloc<Uint32>(triangleCount * 3);
+  try {
+    _bindings.GetGlobeMeshFaceVertices(n, face, positions, vertexCount);
+    _bindings.GetGlobeMeshFaceTriangles(n, face, indices, triangleCount);
+    return GlobeMeshFace(
+      _bindings.GetGlobeMeshFaceVertexStart(n, face),
+      Float32List.fromList(positions.asTypedList(vertexCount * 3)),
+      Uint32List.fromList(indices.asTypedList(triangleCount * 3)),
+    );
+  } finally {
+    malloc.free(positions);
+    malloc.free(indices);
+  }
+}
+
+/// One level-of-detail patch of the globe mesh (see [globePatch]).
+class GlobePatch {
+  /// x, y, z of each patch vertex, on the unit sphere.
+  final Float32List positions;
+
+  /// Index of each patch vertex in the globe mesh.
+  final Uint32List meshVertexIndices;
+
+  /// Local triangle indices; the same for every patch at one detail, see
+  /// [globePatchTriangles].
+  final Uint32List indices;
+
+  const GlobePatch(this.positions, this.meshVertexIndices, this.indices);
+}
+
+/// Patch [patchIndex] of the coarse grid [patchN] (a divisor of [n]), drawn
+/// with [detailN] triangles per side (a divisor of n / patchN).
+GlobePatch globePatch(int n, int patchN, int patchIndex, int detailN) {
+  final count = _bindings.GetGlobePatchVertices(
+      n, patchN, patchIndex, detailN, nullptr, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid n, patchN, patchIndex or detailN ($count)');
+  }
+  final positions = malloc<Float>(count * 3);
+  final vertexIndices = malloc<Uint32>(count);
+  try {
+    _bindings.GetGlobePatchVertices(
+        n, patchN, patchIndex, detailN, positions, vertexIndices, count);
+    return GlobePatch(
+      Float32List.fromList(positions.asTypedList(count * 3)),
+      Uint32List.fromList(vertexIndices.asTypedList(count)),
+      globePatchTriangles(detailN),
+    );
+  } finally {
+    malloc.free(positions);
+    malloc.free(vertexIndices);
+  }
+}
+
+/// Local triangle indices of a patch drawn at [detailN].
+Uint32List globePatchTriangles(int detailN) {
+  final count = _bindings.GetGlobePatchTriangles(detailN, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid detailN ($count)');
+  }
+  final indices = malloc<Uint32>(count * 3);
+  try {
+    _bindings.GetGlobePatchTriangles(detailN, indices, count);
+    return Uint32List.fromList(indices.asTypedList(count * 3));
+  } finally {
+    malloc.free(indices);
+  }
+}
+
+/// Segment index of each triangle of the patch at full detail (n / patchN),
+/// for mapping picks back to segments.
+Int32List globePatchSegmentIndices(int n, int patchN, int patchIndex) {
+  final count =
+      _bindings.GetGlobePatchSegmentIndices(n, patchN, patchIndex, nullptr, 0);
+  if (count < 0) {
+    throw ArgumentError('invalid n, patchN or patchIndex ($count)');
+  }
+  final buffer = malloc<Int>(count);
+  try {
+    _bindings.GetGlobePatchSegmentIndices(
+        n, patchN, patchIndex, buffer, count);
+    return Int32List.fromList(buffer.cast<Int32>().asTypedList(count));
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
+/// Number of grid vertices (`10 * n * n + 2`) of the [n] grid.
+int gridVertexCount(int n) {
+  final count = _bindings.GetGridVertexCount64(n);
+  if (count < 0) {
+    throw ArgumentError('invalid n ($count)');
+  }
+  return count;
+}
+
+/// Number of grid edges (`30 * n * n`) of the [n] grid.
+int gridEdgeCount(int n) {
+  final count = _bindings.GetGridEdgeCount64(n);
+  if (count < 0) {
+    throw ArgumentError('invalid n ($count)');
+  }
+  return count;
+}
+
+List<int> _gridIds(int Function(Pointer<Int64> out) query, String what) {
+  final buffer = malloc<Int64>(6);
+  try {
+    final count = query(buffer);
+    if (count < 0) {
+      throw ArgumentError('invalid n or $what ($count)');
+    }
+    return List<int>.generate(count, (i) => buffer[i]);
+  } finally {
+    malloc.free(buffer);
+  }
+}
+
+/// Stable ids of the 3 corner vertices of [segmentId], in the order of
+/// [calculateSegmentCornersInLatLng64]. Same as the globe mesh vertex indices.
+List<int> segmentGridVertexIds(int n, int segmentId) => _gridIds(
+    (out) => _bindings.GetSegmentGridVertexIndices64(n, segmentId, out),
+    'segment index');
+
+/// Stable ids of the 3 edges of [segmentId]; edge c joins corner c and
+/// corner (c + 1) % 3.
+List<int> segmentGridEdgeIds(int n, int segmentId) => _gridIds(
+    (out) => _bindings.GetSegmentGridEdgeIndices64(n, segmentId, out),
+    'segment index');
+
+/// The 6 segments sharing [vertexId] (5 at the 12 icosahedron corners),
+/// ascending.
+List<int> gridVertexSegmentIds(int n, int vertexId) => _gridIds(
+    (out) => _bindings.GetGridVertexSegmentIndices64(n, vertexId, out),
+    'vertex id');
+
+/// The 2 end vertices of [edgeId].
+List<int> gridEdgeVertexIds(int n, int edgeId) => _gridIds(
+    (out) => _bindings.GetGridEdgeVertexIndices64(n, edgeId, out), 'edge id');
+
+/// The 2 segments sharing [edgeId], ascending.
+List<int> gridEdgeSegmentIds(int n, int edgeId) => _gridIds(
+    (out) => _bindings.GetGridEdgeSegmentIndices64(n, edgeId, out),
+    'edge id');
+
+/// Latitude and longitude (radians) of [vertexId].
+(double, double) gridVertexLatLng(int n, int vertexId) {
+  final position = _bindings.CalculateGridVertexLatLng64(n, vertexId);
+  return (position.lat, position.lng);
+}
+
+/// Outline of a segment set from [segmentRegionBoundary].
+class SegmentRegionBoundaryResult {
+  /// Grid vertex ids of each closed loop (see [segmentGridVertexIds]); the
+  /// last vertex connects back to the first.
+  final List<Int64List> vertexIds;
+
+  /// Latitude and longitude (radians) of the same vertices.
+  final List<List<(double, double)>> latLng;
+
+  const SegmentRegionBoundaryResult(this.vertexIds, this.latLng);
+}
+
+/// Outline of [segmentIds] (duplicates allowed) as closed loops, for drawing
+/// borders instead of every triangle edge. Loops keep the region on their left
+/// seen from outside the sphere: outer boundaries run counter-clockwise and
+/// holes clockwise. Takes time linear in the number of segments.
+SegmentRegionBoundaryResult segmentRegionBoundary(
+    int n, List<int> segmentIds) {
+  final count = segmentIds.length;
+  final segments = malloc<Int64>(count == 0 ? 1 : count);
+  Pointer<SegmentRegionBoundary> boundary = nullptr;
+  Pointer<GpsCoords> points = nullptr;
+  try {
+    segments.asTypedList(count).setAll(0, segmentIds);
+    boundary = _bindings.ExtractSegmentRegionBoundary(n, count, segments);
+    if (boundary == nullptr) {
+      throw ArgumentError('invalid n or segment index, or out of memory');
+    }
+
+    final loopCount = _bindings.GetSegmentRegionBoundaryLoopCount(boundary);
+    final vertexCount =
+        _bindings.GetSegmentRegionBoundaryVertexCount(boundary);
+    final offsets = _bindings
+        .GetSegmentRegionBoundaryLoopOffsets(boundary)
+        .asTypedList(loopCount + 1);
+    final vertexIds = _bindings
+        .GetSegmentRegionBoundaryVertexIndices(boundary)
+        .asTypedList(vertexCount);
+    points = malloc<GpsCoords>(vertexCount == 0 ? 1 : vertexCount);
+    _bindings.GetSegmentRegionBoundaryPoints(
+        boundary, points, nullptr, vertexCount);
+    return SegmentRegionBoundaryResult(
+      List<Int64List>.generate(
+          loopCount, (l) => vertexIds.sublist(offsets[l], offsets[l + 1])),
+      List<List<(double, double)>>.generate(
+          loopCount,
+          (l) => List<(double, double)>.generate(
+              offsets[l + 1] - offsets[l],
+              (i) => (
+                    points[offsets[l] + i].lat,
+                    points[offsets[l] + i].lng
+                  ))),
+    );
+  } finally {
+    _bindings.DestroySegmentRegionBoundary(boundary);
+    malloc.free(segments);
+    if (points != nullptr) {
+      malloc.free(points);
+    }
+  }
+}
+
 /// A longer lived native function, which occupies the thread calling it.
 ///
 /// Do not call these kind of native functions in the main isolate. They will
@@ -170,6 +951,313 @@ Future<SendPort> _helperIsolateSendPort = () async {
   return completer.future;
 }();
 
+/// A native (malloc) array of doubles that batch calls read and write in
+/// place.
+///
+/// [list] is a view of the same memory, so filling it and reading results
+/// copies nothing, and helper isolates receive only its address. The memory is
+/// released when this object is garbage collected, or earlier with [free].
+final class NativeFloat64List implements Finalizable {
+  NativeFloat64List(this.length)
+      : pointer = malloc<Double>(length == 0 ? 1 : length) {
+    _nativeBufferFinalizer.attach(this, pointer.cast(), detach: this);
+  }
+
+  final int length;
+  final Pointer<Double> pointer;
+  bool _freed = false;
+
+  Float64List get list => pointer.asTypedList(length);
+
+  void free() {
+    if (!_freed) {
+      _freed = true;
+      _nativeBufferFinalizer.detach(this);
+      malloc.free(pointer);
+    }
+  }
+}
+
+/// A native (malloc) array of 32-bit ints; see [NativeFloat64List].
+final class NativeInt32List implements Finalizable {
+  NativeInt32List(this.length)
+      : pointer = malloc<Int32>(length == 0 ? 1 : length) {
+    _nativeBufferFinalizer.attach(this, pointer.cast(), detach: this);
+  }
+
+  final int length;
+  final Pointer<Int32> pointer;
+  bool _freed = false;
+
+  Int32List get list => pointer.asTypedList(length);
+
+  void free() {
+    if (!_freed) {
+      _freed = true;
+      _nativeBufferFinalizer.detach(this);
+      malloc.free(pointer);
+    }
+  }
+}
+
+final NativeFinalizer _nativeBufferFinalizer = NativeFinalizer(malloc.nativeFree);
+
+/// Geocodes `lat[i]`, `lng[i]` (radians) into [out] (allocated when omitted)
+/// on the batch helper isolates, leaving the calling isolate free.
+///
+/// A point that cannot be geocoded gets its negative error code. The buffers
+/// must not be freed or resized until the future completes. If a helper
+/// isolate dies, the future completes with an error and the next call starts
+/// new helpers.
+Future<NativeInt32List> geocodeBatchAsync(
+    int n, NativeFloat64List lat, NativeFloat64List lng,
+    {NativeInt32List? out}) async {
+  final count = lat.length;
+  final result = out ?? NativeInt32List(count);
+  if (lng.length != count || result.length < count) {
+    throw ArgumentError('lat, lng and out must have the same length');
+  }
+  await _runBatchOnIsolates(_BatchKind.geocode, n, count,
+      [(lat.pointer.address, 8), (lng.pointer.address, 8)],
+      (result.pointer.address, 4));
+  return result;
+}
+
+/// Centers of [segmentIds] as interleaved lat/lng pairs (radians) in [out]
+/// (allocated with 2 * length entries when omitted), computed on the batch
+/// helper isolates. Invalid ids get (0, 0).
+Future<NativeFloat64List> centersBatchAsync(int n, NativeInt32List segmentIds,
+    {NativeFloat64List? out}) async {
+  final count = segmentIds.length;
+  final result = out ?? NativeFloat64List(count * 2);
+  if (result.length < count * 2) {
+    throw ArgumentError('out must hold 2 * segmentIds.length values');
+  }
+  await _runBatchOnIsolates(_BatchKind.centers, n, count,
+      [(segmentIds.pointer.address, 4)], (result.pointer.address, 16));
+  return result;
+}
+
+/// Sets how many helper isolates the async batch functions use. Takes effect
+/// only before the first async batch call; defaults to one less than the
+/// number of processors (at least one).
+void setBatchIsolateCount(int count) {
+  if (_batchIsolatePool != null) {
+    throw StateError('the batch isolates are already running');
+  }
+  _batchIsolateCount = count < 1 ? 1 : count;
+}
+
+enum _BatchKind { geocode, centers }
+
+/// A slice of a batch call. The context and buffers are passed by address, so
+/// sending this to a helper isolate copies only a few integers.
+class _BatchRequest {
+  final int id;
+  final _BatchKind kind;
+  final int context;
+  final int count;
+  final List<int> inputs;
+  final int output;
+
+  const _BatchRequest(
+      this.id, this.kind, this.context, this.count, this.inputs, this.output);
+}
+
+class _BatchResponse {
+  final int id;
+  final int result;
+
+  const _BatchResponse(this.id, this.result);
+}
+
+/// Slices smaller than this are not worth a round trip to another isolate.
+const int _batchMinSliceSize = 4096;
+
+int _batchIsolateCount =
+    Platform.numberOfProcessors > 2 ? Platform.numberOfProcessors - 1 : 1;
+_BatchIsolatePool? _batchIsolatePool;
+int _nextBatchRequestId = 0;
+
+/// One [Geocoder] per n used by the async batch functions. They are kept for
+/// the rest of the process, so the helper isolates can use their contexts by
+/// address without the tables being rebuilt for every call.
+final Map<int, Geocoder> _batchGeocoders = <int, Geocoder>{};
+
+/// Splits [count] items into contiguous slices, one per helper isolate, and
+/// waits for all of them. Each slice reads and writes its own range of the
+/// buffers (address + begin * stride), so the output is the same as one call.
+Future<void> _runBatchOnIsolates(_BatchKind kind, int n, int count,
+    List<(int, int)> inputs, (int, int) output) async {
+  if (count == 0) {
+    return;
+  }
+  final geocoder = _batchGeocoders.putIfAbsent(n, () => Geocoder(n));
+  final pool = _batchIsolatePool ??= _BatchIsolatePool(_batchIsolateCount);
+  final ports = await pool.ready;
+  final maxSlices = (count + _batchMinSliceSize - 1) ~/ _batchMinSliceSize;
+  final sliceCount = ports.length < maxSlices ? ports.length : maxSlices;
+  final futures = <Future<int>>[];
+  for (var i = 0; i < sliceCount; i++) {
+    final begin = count * i ~/ sliceCount;
+    final end = count * (i + 1) ~/ sliceCount;
+    final id = _nextBatchRequestId++;
+    futures.add(pool.send(
+        ports[i],
+        _BatchRequest(
+            id,
+            kind,
+            geocoder._checkedContext.address,
+            end - begin,
+            [for (final (address, stride) in inputs) address + begin * stride],
+            output.$1 + begin * output.$2)));
+  }
+  for (final result in await Future.wait(futures)) {
+    if (result < 0) {
+      throw ArgumentError('batch call failed ($result)');
+    }
+  }
+}
+
+/// The running batch helper isolates and the requests they have not answered.
+///
+/// The helpers are spawned with error and exit listeners: if any of them fails
+/// (to spawn, or later with an uncaught error) the whole pool is shut down,
+/// every pending request completes with that error, and the next batch call
+/// starts a new pool.
+class _BatchIsolatePool {
+  _BatchIsolatePool(int count) {
+    _receivePort.listen(_handleMessage);
+    _controlPort.listen(_handleControlMessage);
+    _start(count);
+  }
+
+  final ReceivePort _receivePort = ReceivePort();
+  final ReceivePort _controlPort = ReceivePort();
+  final List<Isolate> _isolates = <Isolate>[];
+  final List<SendPort> _ports = <SendPort>[];
+  final Completer<List<SendPort>> _ready = Completer<List<SendPort>>();
+  final Map<int, Completer<int>> _requests = <int, Completer<int>>{};
+  int _count = 0;
+  bool _closed = false;
+
+  Future<List<SendPort>> get ready => _ready.future;
+
+  Future<int> send(SendPort port, _BatchRequest request) {
+    if (_closed) {
+      return Future<int>.error(StateError('the batch isolates have stopped'));
+    }
+    final completer = Completer<int>();
+    _requests[request.id] = completer;
+    port.send(request);
+    return completer.future;
+  }
+
+  Future<void> _start(int count) async {
+    _count = count;
+    try {
+      for (var i = 0; i < count && !_closed; i++) {
+        final isolate = await Isolate.spawn(
+            _runBatchIsolate, _receivePort.sendPort,
+            onError: _controlPort.sendPort, onExit: _controlPort.sendPort);
+        _isolates.add(isolate);
+        if (_closed) {
+          isolate.kill(priority: Isolate.immediate);
+        }
+      }
+    } catch (error, stackTrace) {
+      _close(error, stackTrace);
+    }
+  }
+
+  void _handleMessage(dynamic data) {
+    if (data is SendPort) {
+      _ports.add(data);
+      if (_ports.length == _count && !_ready.isCompleted) {
+        _ready.complete(_ports);
+      }
+      return;
+    }
+    if (data is _BatchResponse) {
+      _requests.remove(data.id)?.complete(data.result);
+      return;
+    }
+    throw UnsupportedError('Unsupported message type: ${data.runtimeType}');
+  }
+
+  /// Receives the helpers' uncaught errors (a two-element list of the error
+  /// and stack trace strings) and exit notifications (null). The helpers never
+  /// exit on their own, so either one means the pool is broken.
+  void _handleControlMessage(dynamic data) {
+    if (data is List && data.length == 2) {
+      final error =
+          RemoteError(data[0] as String, (data[1] as String?) ?? '');
+      _close(error, error.stackTrace);
+      return;
+    }
+    _close(StateError('a batch isolate exited'), StackTrace.current);
+  }
+
+  void _close(Object error, StackTrace stackTrace) {
+    if (_closed) {
+      return;
+    }
+    _closed = true;
+    if (identical(_batchIsolatePool, this)) {
+      _batchIsolatePool = null;
+    }
+    if (!_ready.isCompleted) {
+      _ready.completeError(error, stackTrace);
+    }
+    final requests = _requests.values.toList();
+    _requests.clear();
+    for (final completer in requests) {
+      completer.completeError(error, stackTrace);
+    }
+    for (final isolate in _isolates) {
+      isolate.kill(priority: Isolate.immediate);
+    }
+    _receivePort.close();
+    _controlPort.close();
+  }
+}
+
+/// Entry point of a batch helper isolate. It lives for the rest of the
+/// process and answers one request at a time.
+void _runBatchIsolate(SendPort sendPort) {
+  final receivePort = ReceivePort()
+    ..listen((dynamic data) {
+      if (data is _BatchRequest) {
+        sendPort.send(_BatchResponse(data.id, _runBatchRequest(data)));
+        return;
+      }
+      throw UnsupportedError('Unsupported message type: ${data.runtimeType}');
+    });
+  sendPort.send(receivePort.sendPort);
+}
+
+int _runBatchRequest(_BatchRequest request) {
+  final context = Pointer<GeocodingContext>.fromAddress(request.context);
+  switch (request.kind) {
+    case _BatchKind.geocode:
+      return _bindings.CalculateSegmentIndexFromLatLngBatchWithContext(
+          context,
+          nullptr,
+          request.count,
+          Pointer<Double>.fromAddress(request.inputs[0]),
+          Pointer<Double>.fromAddress(request.inputs[1]),
+          Pointer<Int>.fromAddress(request.output));
+    case _BatchKind.centers:
+      return _bindings.CalculateSegmentCenterBatchWithContext(
+          context,
+          nullptr,
+          request.count,
+          Pointer<Int>.fromAddress(request.inputs[0]),
+          Pointer<GpsCoords>.fromAddress(request.output),
+          nullptr);
+  }
+}
+
 extension Vector3Extension on Vector3 {
   String toCustomString() {
     const fractionDigits = 2;
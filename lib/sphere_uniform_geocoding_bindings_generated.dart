@@ -67,6 +67,83 @@ class SphereUniformGeocodingBindings {
       _CalculateSegmentIndexFromLatLngPtr.asFunction<
           int Function(int, double, double)>();
 
+  /// Geocodes `count` points given as separate lat/lng arrays (radians) into `outSegmentIndex`.
+  /// A point that cannot be geocoded gets its (negative) ErrorCode in place of the segment index.
+  int CalculateSegmentIndexFromLatLngBatch(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Double> lat,
+    ffi.Pointer<ffi.Double> lng,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+  ) {
+    return _CalculateSegmentIndexFromLatLngBatch(
+      pool,
+      n,
+      count,
+      lat,
+      lng,
+      outSegmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentIndexFromLatLngBatchPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int>)>>('CalculateSegmentIndexFromLatLngBatch');
+  late final _CalculateSegmentIndexFromLatLngBatch =
+      _CalculateSegmentIndexFromLatLngBatchPtr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int,
+              ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int>)>();
+
+  /// Center of a segment as lat/lng (radians), computed with a single decode.
+  GpsCoords CalculateSegmentCenterLatLng(
+    int n,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLatLng(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterLatLngPtr =
+      _lookup<ffi.NativeFunction<GpsCoords Function(ffi.Int, ffi.Int)>>(
+          'CalculateSegmentCenterLatLng');
+  late final _CalculateSegmentCenterLatLng = _CalculateSegmentCenterLatLngPtr
+      .asFunction<GpsCoords Function(int, int)>();
+
+  /// Centers of `count` segments. Either output may be NULL; each segment is decoded once for both.
+  int CalculateSegmentCenterBatch(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int> segmentIndex,
+    ffi.Pointer<GpsCoords> outLatLng,
+    ffi.Pointer<Vector3> outCenter,
+  ) {
+    return _CalculateSegmentCenterBatch(
+      pool,
+      n,
+      count,
+      segmentIndex,
+      outLatLng,
+      outCenter,
+    );
+  }
+
+  late final _CalculateSegmentCenterBatchPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int>, ffi.Pointer<GpsCoords>,
+              ffi.Pointer<Vector3>)>>('CalculateSegmentCenterBatch');
+  late final _CalculateSegmentCenterBatch =
+      _CalculateSegmentCenterBatchPtr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int, ffi.Pointer<ffi.Int>,
+              ffi.Pointer<GpsCoords>, ffi.Pointer<Vector3>)>();
+
   double CalculateSegmentCenterLat(
     int n,
     int segmentIndex,
@@ -131,6 +208,310 @@ class SphereUniformGeocodingBindings {
   late final _GetNeighborsOfSegmentIndex = _GetNeighborsOfSegmentIndexPtr
       .asFunction<NeighborSegIdList Function(int, int)>();
 
+  /// Neighbors of `count` segments in CSR form: the neighbors of segmentIndex[i] are
+  /// outNeighbors[outOffsets[i]] .. outNeighbors[outOffsets[i + 1] - 1], and outOffsets has count + 1 entries.
+  /// With `dedupe` set, each neighbor appears once in the whole output, in the row of the first segment that has it.
+  /// Returns the number of neighbors written, or the number needed when outNeighbors is NULL (outOffsets may then
+  /// also be NULL). Returns ErrorCode_BufferTooSmall if outNeighborsCapacity is exceeded; 12 * count always suffices.
+  int GetNeighborsOfSegmentIndexCsr(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int> segmentIndex,
+    int dedupe,
+    ffi.Pointer<ffi.Int> outOffsets,
+    ffi.Pointer<ffi.Int> outNeighbors,
+    int outNeighborsCapacity,
+  ) {
+    return _GetNeighborsOfSegmentIndexCsr(
+      pool,
+      n,
+      count,
+      segmentIndex,
+      dedupe,
+      outOffsets,
+      outNeighbors,
+      outNeighborsCapacity,
+    );
+  }
+
+  late final _GetNeighborsOfSegmentIndexCsrPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int>, ffi.Int, ffi.Pointer<ffi.Int>,
+              ffi.Pointer<ffi.Int>, ffi.Int)>>('GetNeighborsOfSegmentIndexCsr');
+  late final _GetNeighborsOfSegmentIndexCsr =
+      _GetNeighborsOfSegmentIndexCsrPtr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int, ffi.Pointer<ffi.Int>,
+              int, ffi.Pointer<ffi.Int>, ffi.Pointer<ffi.Int>, int)>();
+
+  /// Segments within k neighbor hops of segmentIndex (a filled disk, the center included), in ascending index order
+  /// (unsigned, for the 32-bit form).
+  /// The hollow ring is the segments exactly k hops away. Both return the number written, or the number needed when
+  /// outSegmentIndex is NULL, and ErrorCode_BufferTooSmall if outCapacity is exceeded. A k-ring that does not reach an
+  /// icosahedron vertex has 6k^2 + 6k + 1 segments (a hollow ring 12k); one that does has fewer.
+  int GetKRingOfSegmentIndex(
+    int n,
+    int segmentIndex,
+    int k,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetKRingOfSegmentIndex(
+      n,
+      segmentIndex,
+      k,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetKRingOfSegmentIndexPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int, ffi.Int, ffi.Pointer<ffi.Int>,
+              ffi.Int)>>('GetKRingOfSegmentIndex');
+  late final _GetKRingOfSegmentIndex = _GetKRingOfSegmentIndexPtr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int>, int)>();
+
+  int GetHollowRingOfSegmentIndex(
+    int n,
+    int segmentIndex,
+    int k,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetHollowRingOfSegmentIndex(
+      n,
+      segmentIndex,
+      k,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetHollowRingOfSegmentIndexPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int, ffi.Int, ffi.Pointer<ffi.Int>,
+              ffi.Int)>>('GetHollowRingOfSegmentIndex');
+  late final _GetHollowRingOfSegmentIndex = _GetHollowRingOfSegmentIndexPtr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int>, int)>();
+
+  /// Segments covering a spherical polygon, in ascending index order (unsigned, for the 32-bit form). The polygon is
+  /// ringCount rings of lat/lng vertices (radians) stored back to back in `vertices`, ringVertexCounts[r] each: ring 0
+  /// is the outer boundary and the rest are holes. Edges are great-circle arcs; each ring must fit in a hemisphere.
+  /// `mode` is a PolygonFillMode. Output is resumable: start with *cursor = 0. When outCapacity runs out, *cursor is
+  /// set to where the next call continues; it becomes -1 once everything has been written. Returns the number
+  /// written by this call. With outSegmentIndex NULL, returns the number remaining from *cursor and leaves it as is.
+  int GetSegmentIndicesInPolygon(
+    int n,
+    ffi.Pointer<GpsCoords> vertices,
+    ffi.Pointer<ffi.Int> ringVertexCounts,
+    int ringCount,
+    int mode,
+    ffi.Pointer<ffi.Int64> cursor,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetSegmentIndicesInPolygon(
+      n,
+      vertices,
+      ringVertexCounts,
+      ringCount,
+      mode,
+      cursor,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentIndicesInPolygonPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Pointer<GpsCoords>,
+              ffi.Pointer<ffi.Int>, ffi.Int, ffi.Int, ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Int>, ffi.Int)>>('GetSegmentIndicesInPolygon');
+  late final _GetSegmentIndicesInPolygon =
+      _GetSegmentIndicesInPolygonPtr.asFunction<
+          int Function(int, ffi.Pointer<GpsCoords>, ffi.Pointer<ffi.Int>, int,
+              int, ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int>, int)>();
+
+  /// Segments in the spherical cap around lat/lng (radians) with the given angular radius (radians; for a distance on
+  /// Earth, divide it by the Earth radius), in ascending index order (unsigned, for the 32-bit form). `mode` is a
+  /// CapQueryMode. Returns the number written, or the number needed when outSegmentIndex is NULL, and
+  /// ErrorCode_BufferTooSmall if outCapacity is exceeded.
+  int GetSegmentIndicesInCap(
+    int n,
+    double lat,
+    double lng,
+    double radius,
+    int mode,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetSegmentIndicesInCap(
+      n,
+      lat,
+      lng,
+      radius,
+      mode,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentIndicesInCapPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Double, ffi.Double, ffi.Double, ffi.Int,
+              ffi.Pointer<ffi.Int>, ffi.Int)>>('GetSegmentIndicesInCap');
+  late final _GetSegmentIndicesInCap = _GetSegmentIndicesInCapPtr.asFunction<
+      int Function(int, double, double, double, int, ffi.Pointer<ffi.Int>,
+          int)>();
+
+  /// Segments covering a lat/lng bounding box (radians), streamed face by face in row order, which is ascending index
+  /// order (unsigned, for the 32-bit form). minLng > maxLng means the box crosses the antimeridian; minLng = -pi with
+  /// maxLng = pi covers every longitude, and a box reaching +-pi/2 includes the pole. `mode` is a PolygonFillMode.
+  /// Output is resumable the same way as GetSegmentIndicesInPolygon(), and the query itself only keeps a few face
+  /// constants, so a viewport of any size can be drained through a fixed-size buffer.
+  int GetSegmentIndicesInLatLngBox(
+    int n,
+    double minLat,
+    double minLng,
+    double maxLat,
+    double maxLng,
+    int mode,
+    ffi.Pointer<ffi.Int64> cursor,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetSegmentIndicesInLatLngBox(
+      n,
+      minLat,
+      minLng,
+      maxLat,
+      maxLng,
+      mode,
+      cursor,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentIndicesInLatLngBoxPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Double, ffi.Double, ffi.Double,
+              ffi.Double, ffi.Int, ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int>,
+              ffi.Int)>>('GetSegmentIndicesInLatLngBox');
+  late final _GetSegmentIndicesInLatLngBox =
+      _GetSegmentIndicesInLatLngBoxPtr.asFunction<
+          int Function(int, double, double, double, double, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int>, int)>();
+
+  /// Parent/child mapping between the n grid and the k * n grid, in integer arithmetic. Both grids subdivide the same
+  /// faces, so each segment of the n grid is split into exactly k^2 segments of the k * n grid.
+  /// GetParentSegmentIndex() takes a segment of the k * n grid and returns the n-grid segment that contains it, or a
+  /// negative ErrorCode. In the batch form, an invalid index gets its ErrorCode in place of the parent.
+  int GetParentSegmentIndex(
+    int n,
+    int k,
+    int segmentIndex,
+  ) {
+    return _GetParentSegmentIndex(
+      n,
+      k,
+      segmentIndex,
+    );
+  }
+
+  late final _GetParentSegmentIndexPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function(ffi.Int, ffi.Int, ffi.Int)>>(
+          'GetParentSegmentIndex');
+  late final _GetParentSegmentIndex =
+      _GetParentSegmentIndexPtr.asFunction<int Function(int, int, int)>();
+
+  int GetParentSegmentIndexBatch(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int k,
+    int count,
+    ffi.Pointer<ffi.Int> segmentIndex,
+    ffi.Pointer<ffi.Int> outParent,
+  ) {
+    return _GetParentSegmentIndexBatch(
+      pool,
+      n,
+      k,
+      count,
+      segmentIndex,
+      outParent,
+    );
+  }
+
+  late final _GetParentSegmentIndexBatchPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int>,
+              ffi.Pointer<ffi.Int>)>>('GetParentSegmentIndexBatch');
+  late final _GetParentSegmentIndexBatch =
+      _GetParentSegmentIndexBatchPtr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int, int,
+              ffi.Pointer<ffi.Int>, ffi.Pointer<ffi.Int>)>();
+
+  /// The k^2 segments of the k * n grid that make up segment segmentIndex of the n grid, in ascending index order
+  /// (unsigned, for the 32-bit form). The batch form writes k^2 children per input, in input order. Returns the number
+  /// written, or the number needed when outSegmentIndex is NULL, and ErrorCode_BufferTooSmall if outCapacity is
+  /// exceeded. The 32-bit forms need k * n <= 14654.
+  int GetChildSegmentIndices(
+    int n,
+    int k,
+    int segmentIndex,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetChildSegmentIndices(
+      n,
+      k,
+      segmentIndex,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetChildSegmentIndicesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int, ffi.Int, ffi.Pointer<ffi.Int>,
+              ffi.Int)>>('GetChildSegmentIndices');
+  late final _GetChildSegmentIndices = _GetChildSegmentIndicesPtr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int>, int)>();
+
+  int GetChildSegmentIndicesBatch(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int k,
+    int count,
+    ffi.Pointer<ffi.Int> segmentIndex,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetChildSegmentIndicesBatch(
+      pool,
+      n,
+      k,
+      count,
+      segmentIndex,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetChildSegmentIndicesBatchPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int>, ffi.Pointer<ffi.Int>,
+              ffi.Int)>>('GetChildSegmentIndicesBatch');
+  late final _GetChildSegmentIndicesBatch =
+      _GetChildSegmentIndicesBatchPtr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int, int,
+              ffi.Pointer<ffi.Int>, ffi.Pointer<ffi.Int>, int)>();
+
   int ConvertToSegmentIndex2(
     int n,
     int segmentGroupIndex,
@@ -185,64 +566,1894 @@ class SphereUniformGeocodingBindings {
       _CalculateSegmentCornersInLatLngPtr.asFunction<
           SegmentCornersInLatLng Function(int, int)>();
 
-  /// A longer lived native function, which occupies the thread calling it.
-  ///
-  /// Do not call these kind of native functions in the main isolate. They will
-  /// block Dart execution. This will cause dropped frames in Flutter applications.
-  /// Instead, call these native functions on a separate isolate.
-  int sum_long_running(
-    int a,
-    int b,
+  /// Returns NULL if n is out of range. Release with DestroyGeocodingContext().
+  /// The *WithContext center/corner lat/lng functions use the context's LatLngPrecision (`precision`, which is fixed at
+  /// creation, so a context can be shared between threads); every function without a context uses LatLngPrecision_Exact.
+  ffi.Pointer<GeocodingContext> CreateGeocodingContext(
+    int n,
   ) {
-    return _sum_long_running(
-      a,
-      b,
+    return _CreateGeocodingContext(
+      n,
     );
   }
 
-  late final _sum_long_runningPtr =
-      _lookup<ffi.NativeFunction<ffi.IntPtr Function(ffi.IntPtr, ffi.IntPtr)>>(
-          'sum_long_running');
-  late final _sum_long_running =
-      _sum_long_runningPtr.asFunction<int Function(int, int)>();
-}
+  late final _CreateGeocodingContextPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Pointer<GeocodingContext> Function(ffi.Int)>>(
+      'CreateGeocodingContext');
+  late final _CreateGeocodingContext = _CreateGeocodingContextPtr
+      .asFunction<ffi.Pointer<GeocodingContext> Function(int)>();
 
-final class Vector3 extends ffi.Struct {
-  @ffi.Double()
-  external double x;
+  ffi.Pointer<GeocodingContext> CreateGeocodingContextWithPrecision(
+    int n,
+    int precision,
+  ) {
+    return _CreateGeocodingContextWithPrecision(
+      n,
+      precision,
+    );
+  }
 
-  @ffi.Double()
-  external double y;
+  late final _CreateGeocodingContextWithPrecisionPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<GeocodingContext> Function(ffi.Int,
+              ffi.Int)>>('CreateGeocodingContextWithPrecision');
+  late final _CreateGeocodingContextWithPrecision =
+      _CreateGeocodingContextWithPrecisionPtr.asFunction<
+          ffi.Pointer<GeocodingContext> Function(int, int)>();
 
-  @ffi.Double()
-  external double z;
-}
+  void DestroyGeocodingContext(
+    ffi.Pointer<GeocodingContext> context,
+  ) {
+    return _DestroyGeocodingContext(
+      context,
+    );
+  }
 
-final class NeighborSegIdList extends ffi.Struct {
-  @ffi.Array.multi([12])
-  external ffi.Array<ffi.Int> neighborSegId;
+  late final _DestroyGeocodingContextPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Void Function(ffi.Pointer<GeocodingContext>)>>(
+      'DestroyGeocodingContext');
+  late final _DestroyGeocodingContext = _DestroyGeocodingContextPtr
+      .asFunction<void Function(ffi.Pointer<GeocodingContext>)>();
 
-  @ffi.Int()
-  external int count;
-}
+  int CalculateSegmentIndexFromLatLngWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    double lat,
+    double lng,
+  ) {
+    return _CalculateSegmentIndexFromLatLngWithContext(
+      context,
+      lat,
+      lng,
+    );
+  }
 
-final class SegGroupAndLocalSegIndex extends ffi.Struct {
-  @ffi.Int()
-  external int segGroup;
+  late final _CalculateSegmentIndexFromLatLngWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<GeocodingContext>, ffi.Double,
+              ffi.Double)>>('CalculateSegmentIndexFromLatLngWithContext');
+  late final _CalculateSegmentIndexFromLatLngWithContext =
+      _CalculateSegmentIndexFromLatLngWithContextPtr.asFunction<
+          int Function(ffi.Pointer<GeocodingContext>, double, double)>();
 
-  @ffi.Int()
-  external int localSegIndex;
-}
+  int CalculateSegmentIndexFromLatLngBatchWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    ffi.Pointer<ThreadPool> pool,
+    int count,
+    ffi.Pointer<ffi.Double> lat,
+    ffi.Pointer<ffi.Double> lng,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+  ) {
+    return _CalculateSegmentIndexFromLatLngBatchWithContext(
+      context,
+      pool,
+      count,
+      lat,
+      lng,
+      outSegmentIndex,
+    );
+  }
 
-final class GpsCoords extends ffi.Struct {
-  @ffi.Double()
-  external double lat;
+  late final _CalculateSegmentIndexFromLatLngBatchWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<GeocodingContext>,
+              ffi.Pointer<ThreadPool>, ffi.Int, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int>)>>(
+      'CalculateSegmentIndexFromLatLngBatchWithContext');
+  late final _CalculateSegmentIndexFromLatLngBatchWithContext =
+      _CalculateSegmentIndexFromLatLngBatchWithContextPtr.asFunction<
+          int Function(ffi.Pointer<GeocodingContext>, ffi.Pointer<ThreadPool>,
+              int, ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int>)>();
 
-  @ffi.Double()
-  external double lng;
-}
+  GpsCoords CalculateSegmentCenterLatLngWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLatLngWithContext(
+      context,
+      segmentIndex,
+    );
+  }
 
-final class SegmentCornersInLatLng extends ffi.Struct {
-  @ffi.Array.multi([3])
-  external ffi.Array<GpsCoords> points;
+  late final _CalculateSegmentCenterLatLngWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          GpsCoords Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>('CalculateSegmentCenterLatLngWithContext');
+  late final _CalculateSegmentCenterLatLngWithContext =
+      _CalculateSegmentCenterLatLngWithContextPtr.asFunction<
+          GpsCoords Function(ffi.Pointer<GeocodingContext>, int)>();
+
+  int CalculateSegmentCenterBatchWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    ffi.Pointer<ThreadPool> pool,
+    int count,
+    ffi.Pointer<ffi.Int> segmentIndex,
+    ffi.Pointer<GpsCoords> outLatLng,
+    ffi.Pointer<Vector3> outCenter,
+  ) {
+    return _CalculateSegmentCenterBatchWithContext(
+      context,
+      pool,
+      count,
+      segmentIndex,
+      outLatLng,
+      outCenter,
+    );
+  }
+
+  late final _CalculateSegmentCenterBatchWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<GeocodingContext>,
+              ffi.Pointer<ThreadPool>, ffi.Int, ffi.Pointer<ffi.Int>,
+              ffi.Pointer<GpsCoords>,
+              ffi.Pointer<Vector3>)>>('CalculateSegmentCenterBatchWithContext');
+  late final _CalculateSegmentCenterBatchWithContext =
+      _CalculateSegmentCenterBatchWithContextPtr.asFunction<
+          int Function(ffi.Pointer<GeocodingContext>, ffi.Pointer<ThreadPool>,
+              int, ffi.Pointer<ffi.Int>, ffi.Pointer<GpsCoords>,
+              ffi.Pointer<Vector3>)>();
+
+  double CalculateSegmentCenterLatWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLatWithContext(
+      context,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterLatWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Double Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>('CalculateSegmentCenterLatWithContext');
+  late final _CalculateSegmentCenterLatWithContext =
+      _CalculateSegmentCenterLatWithContextPtr.asFunction<
+          double Function(ffi.Pointer<GeocodingContext>, int)>();
+
+  double CalculateSegmentCenterLngWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLngWithContext(
+      context,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterLngWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Double Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>('CalculateSegmentCenterLngWithContext');
+  late final _CalculateSegmentCenterLngWithContext =
+      _CalculateSegmentCenterLngWithContextPtr.asFunction<
+          double Function(ffi.Pointer<GeocodingContext>, int)>();
+
+  Vector3 CalculateSegmentCenterWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterWithContext(
+      context,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          Vector3 Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>('CalculateSegmentCenterWithContext');
+  late final _CalculateSegmentCenterWithContext =
+      _CalculateSegmentCenterWithContextPtr.asFunction<
+          Vector3 Function(ffi.Pointer<GeocodingContext>, int)>();
+
+  NeighborSegIdList GetNeighborsOfSegmentIndexWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _GetNeighborsOfSegmentIndexWithContext(
+      context,
+      segmentIndex,
+    );
+  }
+
+  late final _GetNeighborsOfSegmentIndexWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          NeighborSegIdList Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>('GetNeighborsOfSegmentIndexWithContext');
+  late final _GetNeighborsOfSegmentIndexWithContext =
+      _GetNeighborsOfSegmentIndexWithContextPtr.asFunction<
+          NeighborSegIdList Function(ffi.Pointer<GeocodingContext>, int)>();
+
+  int ConvertToSegmentIndex2WithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentGroupIndex,
+    int localSegmentIndex,
+  ) {
+    return _ConvertToSegmentIndex2WithContext(
+      context,
+      segmentGroupIndex,
+      localSegmentIndex,
+    );
+  }
+
+  late final _ConvertToSegmentIndex2WithContextPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<GeocodingContext>, ffi.Int,
+              ffi.Int)>>('ConvertToSegmentIndex2WithContext');
+  late final _ConvertToSegmentIndex2WithContext =
+      _ConvertToSegmentIndex2WithContextPtr.asFunction<
+          int Function(ffi.Pointer<GeocodingContext>, int, int)>();
+
+  SegGroupAndLocalSegIndex SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext(
+      context,
+      segmentIndex,
+    );
+  }
+
+  late final _SplitSegIndexToSegGroupAndLocalSegmentIndexWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          SegGroupAndLocalSegIndex Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>(
+      'SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext');
+  late final _SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext =
+      _SplitSegIndexToSegGroupAndLocalSegmentIndexWithContextPtr.asFunction<
+          SegGroupAndLocalSegIndex Function(ffi.Pointer<GeocodingContext>,
+              int)>();
+
+  SegmentCornersInLatLng CalculateSegmentCornersInLatLngWithContext(
+    ffi.Pointer<GeocodingContext> context,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCornersInLatLngWithContext(
+      context,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCornersInLatLngWithContextPtr = _lookup<
+      ffi.NativeFunction<
+          SegmentCornersInLatLng Function(ffi.Pointer<GeocodingContext>,
+              ffi.Int)>>('CalculateSegmentCornersInLatLngWithContext');
+  late final _CalculateSegmentCornersInLatLngWithContext =
+      _CalculateSegmentCornersInLatLngWithContextPtr.asFunction<
+          SegmentCornersInLatLng Function(ffi.Pointer<GeocodingContext>,
+              int)>();
+
+  /// 64-bit segment indices, for n beyond the 32-bit limit (20 * n * n <= 2^32, i.e. n <= 14654).
+  /// n may go up to 2^20 (1048576), about 7 m segments on the Earth. The numbering is the same as the 32-bit
+  /// functions, so wherever a 32-bit index is valid both return the same value. Invalid input yields a negative
+  /// index, or zeroed results. Up to n = 14654 both use the original 7-digit icosahedron tables, so stored ids
+  /// keep their meaning; larger n geocode and place centers and corners on one exact icosahedron.
+  int CalculateSegmentIndexFromLatLng64(
+    int n,
+    double lat,
+    double lng,
+  ) {
+    return _CalculateSegmentIndexFromLatLng64(
+      n,
+      lat,
+      lng,
+    );
+  }
+
+  late final _CalculateSegmentIndexFromLatLng64Ptr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int64 Function(ffi.Int, ffi.Double, ffi.Double)>>(
+      'CalculateSegmentIndexFromLatLng64');
+  late final _CalculateSegmentIndexFromLatLng64 =
+      _CalculateSegmentIndexFromLatLng64Ptr.asFunction<
+          int Function(int, double, double)>();
+
+  int CalculateSegmentIndexFromLatLngBatch64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Double> lat,
+    ffi.Pointer<ffi.Double> lng,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+  ) {
+    return _CalculateSegmentIndexFromLatLngBatch64(
+      pool,
+      n,
+      count,
+      lat,
+      lng,
+      outSegmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentIndexFromLatLngBatch64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int64>)>>(
+      'CalculateSegmentIndexFromLatLngBatch64');
+  late final _CalculateSegmentIndexFromLatLngBatch64 =
+      _CalculateSegmentIndexFromLatLngBatch64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int,
+              ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Int64>)>();
+
+  GpsCoords CalculateSegmentCenterLatLng64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLatLng64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterLatLng64Ptr =
+      _lookup<ffi.NativeFunction<GpsCoords Function(ffi.Int, ffi.Int64)>>(
+          'CalculateSegmentCenterLatLng64');
+  late final _CalculateSegmentCenterLatLng64 =
+      _CalculateSegmentCenterLatLng64Ptr.asFunction<
+          GpsCoords Function(int, int)>();
+
+  double CalculateSegmentCenterLat64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLat64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterLat64Ptr =
+      _lookup<ffi.NativeFunction<ffi.Double Function(ffi.Int, ffi.Int64)>>(
+          'CalculateSegmentCenterLat64');
+  late final _CalculateSegmentCenterLat64 =
+      _CalculateSegmentCenterLat64Ptr.asFunction<double Function(int, int)>();
+
+  double CalculateSegmentCenterLng64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenterLng64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenterLng64Ptr =
+      _lookup<ffi.NativeFunction<ffi.Double Function(ffi.Int, ffi.Int64)>>(
+          'CalculateSegmentCenterLng64');
+  late final _CalculateSegmentCenterLng64 =
+      _CalculateSegmentCenterLng64Ptr.asFunction<double Function(int, int)>();
+
+  Vector3 CalculateSegmentCenter64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCenter64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCenter64Ptr =
+      _lookup<ffi.NativeFunction<Vector3 Function(ffi.Int, ffi.Int64)>>(
+          'CalculateSegmentCenter64');
+  late final _CalculateSegmentCenter64 =
+      _CalculateSegmentCenter64Ptr.asFunction<Vector3 Function(int, int)>();
+
+  int CalculateSegmentCenterBatch64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    ffi.Pointer<GpsCoords> outLatLng,
+    ffi.Pointer<Vector3> outCenter,
+  ) {
+    return _CalculateSegmentCenterBatch64(
+      pool,
+      n,
+      count,
+      segmentIndex,
+      outLatLng,
+      outCenter,
+    );
+  }
+
+  late final _CalculateSegmentCenterBatch64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<GpsCoords>,
+              ffi.Pointer<Vector3>)>>('CalculateSegmentCenterBatch64');
+  late final _CalculateSegmentCenterBatch64 =
+      _CalculateSegmentCenterBatch64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<GpsCoords>,
+              ffi.Pointer<Vector3>)>();
+
+  NeighborSegIdList64 GetNeighborsOfSegmentIndex64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _GetNeighborsOfSegmentIndex64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _GetNeighborsOfSegmentIndex64Ptr = _lookup<
+          ffi
+          .NativeFunction<NeighborSegIdList64 Function(ffi.Int, ffi.Int64)>>(
+      'GetNeighborsOfSegmentIndex64');
+  late final _GetNeighborsOfSegmentIndex64 = _GetNeighborsOfSegmentIndex64Ptr
+      .asFunction<NeighborSegIdList64 Function(int, int)>();
+
+  int GetNeighborsOfSegmentIndexBatch64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    ffi.Pointer<NeighborSegIdList64> outNeighbors,
+  ) {
+    return _GetNeighborsOfSegmentIndexBatch64(
+      pool,
+      n,
+      count,
+      segmentIndex,
+      outNeighbors,
+    );
+  }
+
+  late final _GetNeighborsOfSegmentIndexBatch64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<NeighborSegIdList64>)>>(
+      'GetNeighborsOfSegmentIndexBatch64');
+  late final _GetNeighborsOfSegmentIndexBatch64 =
+      _GetNeighborsOfSegmentIndexBatch64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<NeighborSegIdList64>)>();
+
+  int GetNeighborsOfSegmentIndexCsr64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    int dedupe,
+    ffi.Pointer<ffi.Int64> outOffsets,
+    ffi.Pointer<ffi.Int64> outNeighbors,
+    int outNeighborsCapacity,
+  ) {
+    return _GetNeighborsOfSegmentIndexCsr64(
+      pool,
+      n,
+      count,
+      segmentIndex,
+      dedupe,
+      outOffsets,
+      outNeighbors,
+      outNeighborsCapacity,
+    );
+  }
+
+  late final _GetNeighborsOfSegmentIndexCsr64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int64>, ffi.Int, ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetNeighborsOfSegmentIndexCsr64');
+  late final _GetNeighborsOfSegmentIndexCsr64 =
+      _GetNeighborsOfSegmentIndexCsr64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int,
+              ffi.Pointer<ffi.Int64>, int, ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Int64>, int)>();
+
+  int GetKRingOfSegmentIndex64(
+    int n,
+    int segmentIndex,
+    int k,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetKRingOfSegmentIndex64(
+      n,
+      segmentIndex,
+      k,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetKRingOfSegmentIndex64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Int64, ffi.Int,
+              ffi.Pointer<ffi.Int64>, ffi.Int64)>>('GetKRingOfSegmentIndex64');
+  late final _GetKRingOfSegmentIndex64 = _GetKRingOfSegmentIndex64Ptr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int64>, int)>();
+
+  int GetHollowRingOfSegmentIndex64(
+    int n,
+    int segmentIndex,
+    int k,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetHollowRingOfSegmentIndex64(
+      n,
+      segmentIndex,
+      k,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetHollowRingOfSegmentIndex64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Int64, ffi.Int,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetHollowRingOfSegmentIndex64');
+  late final _GetHollowRingOfSegmentIndex64 = _GetHollowRingOfSegmentIndex64Ptr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int64>, int)>();
+
+  int GetSegmentIndicesInPolygon64(
+    int n,
+    ffi.Pointer<GpsCoords> vertices,
+    ffi.Pointer<ffi.Int> ringVertexCounts,
+    int ringCount,
+    int mode,
+    ffi.Pointer<ffi.Int64> cursor,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetSegmentIndicesInPolygon64(
+      n,
+      vertices,
+      ringVertexCounts,
+      ringCount,
+      mode,
+      cursor,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentIndicesInPolygon64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Pointer<GpsCoords>,
+              ffi.Pointer<ffi.Int>, ffi.Int, ffi.Int, ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetSegmentIndicesInPolygon64');
+  late final _GetSegmentIndicesInPolygon64 =
+      _GetSegmentIndicesInPolygon64Ptr.asFunction<
+          int Function(int, ffi.Pointer<GpsCoords>, ffi.Pointer<ffi.Int>, int,
+              int, ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int64>, int)>();
+
+  int GetSegmentIndicesInCap64(
+    int n,
+    double lat,
+    double lng,
+    double radius,
+    int mode,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetSegmentIndicesInCap64(
+      n,
+      lat,
+      lng,
+      radius,
+      mode,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentIndicesInCap64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Double, ffi.Double, ffi.Double,
+              ffi.Int, ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetSegmentIndicesInCap64');
+  late final _GetSegmentIndicesInCap64 =
+      _GetSegmentIndicesInCap64Ptr.asFunction<
+          int Function(int, double, double, double, int, ffi.Pointer<ffi.Int64>,
+              int)>();
+
+  int GetSegmentIndicesInLatLngBox64(
+    int n,
+    double minLat,
+    double minLng,
+    double maxLat,
+    double maxLng,
+    int mode,
+    ffi.Pointer<ffi.Int64> cursor,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetSegmentIndicesInLatLngBox64(
+      n,
+      minLat,
+      minLng,
+      maxLat,
+      maxLng,
+      mode,
+      cursor,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentIndicesInLatLngBox64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Double, ffi.Double, ffi.Double,
+              ffi.Double, ffi.Int, ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetSegmentIndicesInLatLngBox64');
+  late final _GetSegmentIndicesInLatLngBox64 =
+      _GetSegmentIndicesInLatLngBox64Ptr.asFunction<
+          int Function(int, double, double, double, double, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int64>, int)>();
+
+  int GetParentSegmentIndex64(
+    int n,
+    int k,
+    int segmentIndex,
+  ) {
+    return _GetParentSegmentIndex64(
+      n,
+      k,
+      segmentIndex,
+    );
+  }
+
+  late final _GetParentSegmentIndex64Ptr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int64 Function(ffi.Int, ffi.Int, ffi.Int64)>>(
+      'GetParentSegmentIndex64');
+  late final _GetParentSegmentIndex64 =
+      _GetParentSegmentIndex64Ptr.asFunction<int Function(int, int, int)>();
+
+  int GetParentSegmentIndexBatch64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int k,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    ffi.Pointer<ffi.Int64> outParent,
+  ) {
+    return _GetParentSegmentIndexBatch64(
+      pool,
+      n,
+      k,
+      count,
+      segmentIndex,
+      outParent,
+    );
+  }
+
+  late final _GetParentSegmentIndexBatch64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<ffi.Int64>)>>('GetParentSegmentIndexBatch64');
+  late final _GetParentSegmentIndexBatch64 =
+      _GetParentSegmentIndexBatch64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int64>)>();
+
+  int GetChildSegmentIndices64(
+    int n,
+    int k,
+    int segmentIndex,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetChildSegmentIndices64(
+      n,
+      k,
+      segmentIndex,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetChildSegmentIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>, ffi.Int64)>>('GetChildSegmentIndices64');
+  late final _GetChildSegmentIndices64 = _GetChildSegmentIndices64Ptr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int64>, int)>();
+
+  int GetChildSegmentIndicesBatch64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int k,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetChildSegmentIndicesBatch64(
+      pool,
+      n,
+      k,
+      count,
+      segmentIndex,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetChildSegmentIndicesBatch64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetChildSegmentIndicesBatch64');
+  late final _GetChildSegmentIndicesBatch64 =
+      _GetChildSegmentIndicesBatch64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<ffi.Int64>, int)>();
+
+  int ConvertToSegmentIndex64(
+    int n,
+    int segmentGroupIndex,
+    int localSegmentIndex,
+  ) {
+    return _ConvertToSegmentIndex64(
+      n,
+      segmentGroupIndex,
+      localSegmentIndex,
+    );
+  }
+
+  late final _ConvertToSegmentIndex64Ptr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int64 Function(ffi.Int, ffi.Int, ffi.Int64)>>(
+      'ConvertToSegmentIndex64');
+  late final _ConvertToSegmentIndex64 =
+      _ConvertToSegmentIndex64Ptr.asFunction<int Function(int, int, int)>();
+
+  SegGroupAndLocalSegIndex64 SplitSegIndexToSegGroupAndLocalSegmentIndex64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _SplitSegIndexToSegGroupAndLocalSegmentIndex64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _SplitSegIndexToSegGroupAndLocalSegmentIndex64Ptr = _lookup<
+      ffi.NativeFunction<
+          SegGroupAndLocalSegIndex64 Function(ffi.Int,
+              ffi.Int64)>>('SplitSegIndexToSegGroupAndLocalSegmentIndex64');
+  late final _SplitSegIndexToSegGroupAndLocalSegmentIndex64 =
+      _SplitSegIndexToSegGroupAndLocalSegmentIndex64Ptr.asFunction<
+          SegGroupAndLocalSegIndex64 Function(int, int)>();
+
+  SegmentCornersInLatLng CalculateSegmentCornersInLatLng64(
+    int n,
+    int segmentIndex,
+  ) {
+    return _CalculateSegmentCornersInLatLng64(
+      n,
+      segmentIndex,
+    );
+  }
+
+  late final _CalculateSegmentCornersInLatLng64Ptr = _lookup<
+          ffi
+          .NativeFunction<SegmentCornersInLatLng Function(ffi.Int, ffi.Int64)>>(
+      'CalculateSegmentCornersInLatLng64');
+  late final _CalculateSegmentCornersInLatLng64 =
+      _CalculateSegmentCornersInLatLng64Ptr.asFunction<
+          SegmentCornersInLatLng Function(int, int)>();
+
+  int CalculateSegmentCornersInLatLngBatch64(
+    ffi.Pointer<ThreadPool> pool,
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    ffi.Pointer<SegmentCornersInLatLng> outCorners,
+  ) {
+    return _CalculateSegmentCornersInLatLngBatch64(
+      pool,
+      n,
+      count,
+      segmentIndex,
+      outCorners,
+    );
+  }
+
+  late final _CalculateSegmentCornersInLatLngBatch64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ThreadPool>, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Int64>,
+              ffi.Pointer<SegmentCornersInLatLng>)>>(
+      'CalculateSegmentCornersInLatLngBatch64');
+  late final _CalculateSegmentCornersInLatLngBatch64 =
+      _CalculateSegmentCornersInLatLngBatch64Ptr.asFunction<
+          int Function(ffi.Pointer<ThreadPool>, int, int,
+              ffi.Pointer<ffi.Int64>, ffi.Pointer<SegmentCornersInLatLng>)>();
+
+  /// A set of segments at the finest of several nested resolutions levelN[0] < ... < levelN[L-1] (each a multiple of
+  /// the previous), stored as the fewest cells: every coarse cell whose (n_{i+1} / n_i)^2 children are all present
+  /// replaces them. The encoding is self-describing and byte-order independent: a version byte, the levels, then per
+  /// level the cell count, the body length, a block index (first cell and body offset of every 128 cells, 8-byte
+  /// little-endian each) and the body (the other cells, delta-coded as LEB128 varints).
+  /// CompactSegmentIndices64() takes ascending, unique indices at levelN[L-1] and returns the encoded size; with
+  /// out == NULL it only measures. The readers return ErrorCode_ArgumentOutOfRangeException for malformed input.
+  int CompactSegmentIndices64(
+    ffi.Pointer<ffi.Int> levelN,
+    int levelCount,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+    int count,
+    ffi.Pointer<ffi.Uint8> out,
+    int outCapacity,
+  ) {
+    return _CompactSegmentIndices64(
+      levelN,
+      levelCount,
+      segmentIndex,
+      count,
+      out,
+      outCapacity,
+    );
+  }
+
+  late final _CompactSegmentIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<ffi.Int>, ffi.Int,
+              ffi.Pointer<ffi.Int64>, ffi.Int64, ffi.Pointer<ffi.Uint8>,
+              ffi.Int64)>>('CompactSegmentIndices64');
+  late final _CompactSegmentIndices64 = _CompactSegmentIndices64Ptr.asFunction<
+      int Function(ffi.Pointer<ffi.Int>, int, ffi.Pointer<ffi.Int64>, int,
+          ffi.Pointer<ffi.Uint8>, int)>();
+
+  /// The stored cells, coarsest level first, each level ascending. With outN == NULL returns only the count.
+  int GetCompactSegmentCells64(
+    ffi.Pointer<ffi.Uint8> encoded,
+    int encodedSize,
+    ffi.Pointer<ffi.Int> outN,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetCompactSegmentCells64(
+      encoded,
+      encodedSize,
+      outN,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetCompactSegmentCells64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<ffi.Uint8>, ffi.Int64,
+              ffi.Pointer<ffi.Int>, ffi.Pointer<ffi.Int64>,
+              ffi.Int64)>>('GetCompactSegmentCells64');
+  late final _GetCompactSegmentCells64 =
+      _GetCompactSegmentCells64Ptr.asFunction<
+          int Function(ffi.Pointer<ffi.Uint8>, int, ffi.Pointer<ffi.Int>,
+              ffi.Pointer<ffi.Int64>, int)>();
+
+  /// The original set at the finest level, ascending. With outSegmentIndex == NULL returns only the count.
+  int UncompactSegmentIndices64(
+    ffi.Pointer<ffi.Uint8> encoded,
+    int encodedSize,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _UncompactSegmentIndices64(
+      encoded,
+      encodedSize,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _UncompactSegmentIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<ffi.Uint8>, ffi.Int64,
+              ffi.Pointer<ffi.Int64>, ffi.Int64)>>('UncompactSegmentIndices64');
+  late final _UncompactSegmentIndices64 =
+      _UncompactSegmentIndices64Ptr.asFunction<
+          int Function(ffi.Pointer<ffi.Uint8>, int, ffi.Pointer<ffi.Int64>,
+              int)>();
+
+  /// 1 if the finest-level segment is in the set, 0 if not. Binary-searches each level's block index and decodes one
+  /// block, without expanding the set.
+  int IsSegmentInCompactSet64(
+    ffi.Pointer<ffi.Uint8> encoded,
+    int encodedSize,
+    int segmentIndex,
+  ) {
+    return _IsSegmentInCompactSet64(
+      encoded,
+      encodedSize,
+      segmentIndex,
+    );
+  }
+
+  late final _IsSegmentInCompactSet64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Pointer<ffi.Uint8>, ffi.Int64,
+              ffi.Int64)>>('IsSegmentInCompactSet64');
+  late final _IsSegmentInCompactSet64 = _IsSegmentInCompactSet64Ptr
+      .asFunction<int Function(ffi.Pointer<ffi.Uint8>, int, int)>();
+
+  /// Precomputed adjacency for a fixed n, stored as 12 fixed slots per segment, 2, 4 or 8 bytes wide (the narrowest
+  /// that fits 20 * n * n), unused slots all ones. WriteAdjacencyTableFile() generates the file;
+  /// OpenAdjacencyTable() maps it read-only so opening is immediate and processes share the page cache. Slots are
+  /// little-endian on every host. A lookup reads 12 slots; it is about 2x faster than GetNeighborsOfSegmentIndex64()
+  /// when the table fits in cache (n <= 64) or when segments are visited in index order, but about 2x slower for
+  /// random access to a table larger than cache (n >= 256).
+  int WriteAdjacencyTableFile(
+    int n,
+    ffi.Pointer<ffi.Char> path,
+  ) {
+    return _WriteAdjacencyTableFile(
+      n,
+      path,
+    );
+  }
+
+  late final _WriteAdjacencyTableFilePtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int Function(ffi.Int, ffi.Pointer<ffi.Char>)>>(
+      'WriteAdjacencyTableFile');
+  late final _WriteAdjacencyTableFile = _WriteAdjacencyTableFilePtr
+      .asFunction<int Function(int, ffi.Pointer<ffi.Char>)>();
+
+  /// Returns NULL if the file is missing or not a valid adjacency table.
+  ffi.Pointer<AdjacencyTable> OpenAdjacencyTable(
+    ffi.Pointer<ffi.Char> path,
+  ) {
+    return _OpenAdjacencyTable(
+      path,
+    );
+  }
+
+  late final _OpenAdjacencyTablePtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<AdjacencyTable> Function(ffi.Pointer<ffi.Char>)>>(
+      'OpenAdjacencyTable');
+  late final _OpenAdjacencyTable =
+      _OpenAdjacencyTablePtr.asFunction<
+          ffi.Pointer<AdjacencyTable> Function(ffi.Pointer<ffi.Char>)>();
+
+  void CloseAdjacencyTable(
+    ffi.Pointer<AdjacencyTable> table,
+  ) {
+    return _CloseAdjacencyTable(
+      table,
+    );
+  }
+
+  late final _CloseAdjacencyTablePtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Void Function(ffi.Pointer<AdjacencyTable>)>>(
+      'CloseAdjacencyTable');
+  late final _CloseAdjacencyTable = _CloseAdjacencyTablePtr
+      .asFunction<void Function(ffi.Pointer<AdjacencyTable>)>();
+
+  int GetAdjacencyTableN(
+    ffi.Pointer<AdjacencyTable> table,
+  ) {
+    return _GetAdjacencyTableN(
+      table,
+    );
+  }
+
+  late final _GetAdjacencyTableNPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int Function(ffi.Pointer<AdjacencyTable>)>>(
+      'GetAdjacencyTableN');
+  late final _GetAdjacencyTableN = _GetAdjacencyTableNPtr
+      .asFunction<int Function(ffi.Pointer<AdjacencyTable>)>();
+
+  int GetAdjacencyTableSlotWidth(
+    ffi.Pointer<AdjacencyTable> table,
+  ) {
+    return _GetAdjacencyTableSlotWidth(
+      table,
+    );
+  }
+
+  late final _GetAdjacencyTableSlotWidthPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int Function(ffi.Pointer<AdjacencyTable>)>>(
+      'GetAdjacencyTableSlotWidth');
+  late final _GetAdjacencyTableSlotWidth = _GetAdjacencyTableSlotWidthPtr
+      .asFunction<int Function(ffi.Pointer<AdjacencyTable>)>();
+
+  /// The mapped slot array: the neighbors of segment s are slots s * 12 .. s * 12 + 11.
+  ffi.Pointer<ffi.Void> GetAdjacencyTableSlots(
+    ffi.Pointer<AdjacencyTable> table,
+  ) {
+    return _GetAdjacencyTableSlots(
+      table,
+    );
+  }
+
+  late final _GetAdjacencyTableSlotsPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<ffi.Void> Function(ffi.Pointer<AdjacencyTable>)>>(
+      'GetAdjacencyTableSlots');
+  late final _GetAdjacencyTableSlots =
+      _GetAdjacencyTableSlotsPtr.asFunction<
+          ffi.Pointer<ffi.Void> Function(ffi.Pointer<AdjacencyTable>)>();
+
+  /// Same neighbors, in the same order, as GetNeighborsOfSegmentIndex(). The 32-bit form needs a table with n <= 14654.
+  NeighborSegIdList GetNeighborsFromAdjacencyTable(
+    ffi.Pointer<AdjacencyTable> table,
+    int segmentIndex,
+  ) {
+    return _GetNeighborsFromAdjacencyTable(
+      table,
+      segmentIndex,
+    );
+  }
+
+  late final _GetNeighborsFromAdjacencyTablePtr = _lookup<
+      ffi.NativeFunction<
+          NeighborSegIdList Function(ffi.Pointer<AdjacencyTable>,
+              ffi.Int)>>('GetNeighborsFromAdjacencyTable');
+  late final _GetNeighborsFromAdjacencyTable =
+      _GetNeighborsFromAdjacencyTablePtr.asFunction<
+          NeighborSegIdList Function(ffi.Pointer<AdjacencyTable>, int)>();
+
+  NeighborSegIdList64 GetNeighborsFromAdjacencyTable64(
+    ffi.Pointer<AdjacencyTable> table,
+    int segmentIndex,
+  ) {
+    return _GetNeighborsFromAdjacencyTable64(
+      table,
+      segmentIndex,
+    );
+  }
+
+  late final _GetNeighborsFromAdjacencyTable64Ptr = _lookup<
+      ffi.NativeFunction<
+          NeighborSegIdList64 Function(ffi.Pointer<AdjacencyTable>,
+              ffi.Int64)>>('GetNeighborsFromAdjacencyTable64');
+  late final _GetNeighborsFromAdjacencyTable64 =
+      _GetNeighborsFromAdjacencyTable64Ptr.asFunction<
+          NeighborSegIdList64 Function(ffi.Pointer<AdjacencyTable>, int)>();
+
+  /// A pool of threadCount workers (<= 0: one per processor), each with its own task queue; idle workers steal from
+  /// the others. Create it once and reuse it. DestroyThreadPool() finishes queued work and joins the workers; call it
+  /// only after every batch call that was given the pool has returned.
+  /// The *Batch* functions, and the CSR neighbor query without dedupe, take the pool as their first argument (after
+  /// the context, for the *WithContext forms). With a pool they split large inputs into chunks and run them on it;
+  /// NULL runs everything on the calling thread. Output is identical either way: every chunk writes its own fixed
+  /// range, and the calling thread helps until its call is done. Several threads may run batch calls on the same pool
+  /// at once. The CSR query runs on the pool only when outNeighborsCapacity >= 12 * count, and then uses that whole
+  /// buffer as scratch space.
+  ffi.Pointer<ThreadPool> CreateThreadPool(
+    int threadCount,
+  ) {
+    return _CreateThreadPool(
+      threadCount,
+    );
+  }
+
+  late final _CreateThreadPoolPtr =
+      _lookup<ffi.NativeFunction<ffi.Pointer<ThreadPool> Function(ffi.Int)>>(
+          'CreateThreadPool');
+  late final _CreateThreadPool =
+      _CreateThreadPoolPtr.asFunction<ffi.Pointer<ThreadPool> Function(int)>();
+
+  void DestroyThreadPool(
+    ffi.Pointer<ThreadPool> pool,
+  ) {
+    return _DestroyThreadPool(
+      pool,
+    );
+  }
+
+  late final _DestroyThreadPoolPtr =
+      _lookup<ffi.NativeFunction<ffi.Void Function(ffi.Pointer<ThreadPool>)>>(
+          'DestroyThreadPool');
+  late final _DestroyThreadPool = _DestroyThreadPoolPtr
+      .asFunction<void Function(ffi.Pointer<ThreadPool>)>();
+
+  int GetThreadPoolThreadCount(
+    ffi.Pointer<ThreadPool> pool,
+  ) {
+    return _GetThreadPoolThreadCount(
+      pool,
+    );
+  }
+
+  late final _GetThreadPoolThreadCountPtr =
+      _lookup<ffi.NativeFunction<ffi.Int Function(ffi.Pointer<ThreadPool>)>>(
+          'GetThreadPoolThreadCount');
+  late final _GetThreadPoolThreadCount = _GetThreadPoolThreadCountPtr
+      .asFunction<int Function(ffi.Pointer<ThreadPool>)>();
+
+  /// Geocodes count points on threadCount threads (<= 0: one per processor) and accumulates, per segment, the number
+  /// of points and the sum of each weight column (weights[c][i] is column c of point i; weights may be NULL when
+  /// weightCount is 0). Each thread takes a contiguous slice of the points and fills private histograms, one per
+  /// sixteenth of each face's index range, allocated on first use: dense arrays while one face fits in 64 KiB and hash
+  /// tables above that. The slices are then merged and copied into the result in parallel, so the merge scales even
+  /// when the points fall on one face. Sums are added in thread order, so a given input and thread count always gives
+  /// the same bits.
+  /// Points that cannot be geocoded are skipped and counted in the thread stats. Returns NULL for invalid arguments
+  /// or when out of memory. Blocks until done; call it off the main isolate.
+  ffi.Pointer<SegmentAggregation> AggregatePointsBySegment(
+    int n,
+    int count,
+    ffi.Pointer<ffi.Double> lat,
+    ffi.Pointer<ffi.Double> lng,
+    ffi.Pointer<ffi.Pointer<ffi.Double>> weights,
+    int weightCount,
+    int threadCount,
+  ) {
+    return _AggregatePointsBySegment(
+      n,
+      count,
+      lat,
+      lng,
+      weights,
+      weightCount,
+      threadCount,
+    );
+  }
+
+  late final _AggregatePointsBySegmentPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<SegmentAggregation> Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Pointer<ffi.Double>>, ffi.Int,
+              ffi.Int)>>('AggregatePointsBySegment');
+  late final _AggregatePointsBySegment =
+      _AggregatePointsBySegmentPtr.asFunction<
+          ffi.Pointer<SegmentAggregation> Function(int, int,
+              ffi.Pointer<ffi.Double>, ffi.Pointer<ffi.Double>,
+              ffi.Pointer<ffi.Pointer<ffi.Double>>, int, int)>();
+
+  void DestroySegmentAggregation(
+    ffi.Pointer<SegmentAggregation> aggregation,
+  ) {
+    return _DestroySegmentAggregation(
+      aggregation,
+    );
+  }
+
+  late final _DestroySegmentAggregationPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Void Function(ffi.Pointer<SegmentAggregation>)>>(
+      'DestroySegmentAggregation');
+  late final _DestroySegmentAggregation = _DestroySegmentAggregationPtr
+      .asFunction<void Function(ffi.Pointer<SegmentAggregation>)>();
+
+  /// Number of distinct segments that received at least one point.
+  int GetSegmentAggregationSegmentCount(
+    ffi.Pointer<SegmentAggregation> aggregation,
+  ) {
+    return _GetSegmentAggregationSegmentCount(
+      aggregation,
+    );
+  }
+
+  late final _GetSegmentAggregationSegmentCountPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int64 Function(ffi.Pointer<SegmentAggregation>)>>(
+      'GetSegmentAggregationSegmentCount');
+  late final _GetSegmentAggregationSegmentCount =
+      _GetSegmentAggregationSegmentCountPtr.asFunction<
+          int Function(ffi.Pointer<SegmentAggregation>)>();
+
+  /// Parallel arrays of GetSegmentAggregationSegmentCount() entries, in ascending segment index order.
+  ffi.Pointer<ffi.Int64> GetSegmentAggregationSegmentIndices(
+    ffi.Pointer<SegmentAggregation> aggregation,
+  ) {
+    return _GetSegmentAggregationSegmentIndices(
+      aggregation,
+    );
+  }
+
+  late final _GetSegmentAggregationSegmentIndicesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentAggregation>)>>(
+      'GetSegmentAggregationSegmentIndices');
+  late final _GetSegmentAggregationSegmentIndices =
+      _GetSegmentAggregationSegmentIndicesPtr.asFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentAggregation>)>();
+
+  ffi.Pointer<ffi.Int64> GetSegmentAggregationCounts(
+    ffi.Pointer<SegmentAggregation> aggregation,
+  ) {
+    return _GetSegmentAggregationCounts(
+      aggregation,
+    );
+  }
+
+  late final _GetSegmentAggregationCountsPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentAggregation>)>>(
+      'GetSegmentAggregationCounts');
+  late final _GetSegmentAggregationCounts =
+      _GetSegmentAggregationCountsPtr.asFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentAggregation>)>();
+
+  /// NULL if weightColumn is out of range.
+  ffi.Pointer<ffi.Double> GetSegmentAggregationSums(
+    ffi.Pointer<SegmentAggregation> aggregation,
+    int weightColumn,
+  ) {
+    return _GetSegmentAggregationSums(
+      aggregation,
+      weightColumn,
+    );
+  }
+
+  late final _GetSegmentAggregationSumsPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<ffi.Double> Function(ffi.Pointer<SegmentAggregation>,
+              ffi.Int)>>('GetSegmentAggregationSums');
+  late final _GetSegmentAggregationSums =
+      _GetSegmentAggregationSumsPtr.asFunction<
+          ffi.Pointer<ffi.Double> Function(ffi.Pointer<SegmentAggregation>,
+              int)>();
+
+  /// Threads actually used (never more than the point count).
+  int GetSegmentAggregationThreadCount(
+    ffi.Pointer<SegmentAggregation> aggregation,
+  ) {
+    return _GetSegmentAggregationThreadCount(
+      aggregation,
+    );
+  }
+
+  late final _GetSegmentAggregationThreadCountPtr = _lookup<
+          ffi
+          .NativeFunction<ffi.Int Function(ffi.Pointer<SegmentAggregation>)>>(
+      'GetSegmentAggregationThreadCount');
+  late final _GetSegmentAggregationThreadCount =
+      _GetSegmentAggregationThreadCountPtr.asFunction<
+          int Function(ffi.Pointer<SegmentAggregation>)>();
+
+  AggregationThreadStats GetSegmentAggregationThreadStats(
+    ffi.Pointer<SegmentAggregation> aggregation,
+    int threadIndex,
+  ) {
+    return _GetSegmentAggregationThreadStats(
+      aggregation,
+      threadIndex,
+    );
+  }
+
+  late final _GetSegmentAggregationThreadStatsPtr = _lookup<
+      ffi.NativeFunction<
+          AggregationThreadStats Function(ffi.Pointer<SegmentAggregation>,
+              ffi.Int)>>('GetSegmentAggregationThreadStats');
+  late final _GetSegmentAggregationThreadStats =
+      _GetSegmentAggregationThreadStatsPtr.asFunction<
+          AggregationThreadStats Function(ffi.Pointer<SegmentAggregation>,
+              int)>();
+
+  /// Wall time of the merge step.
+  double GetSegmentAggregationMergeSeconds(
+    ffi.Pointer<SegmentAggregation> aggregation,
+  ) {
+    return _GetSegmentAggregationMergeSeconds(
+      aggregation,
+    );
+  }
+
+  late final _GetSegmentAggregationMergeSecondsPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Double Function(ffi.Pointer<SegmentAggregation>)>>(
+      'GetSegmentAggregationMergeSeconds');
+  late final _GetSegmentAggregationMergeSeconds =
+      _GetSegmentAggregationMergeSecondsPtr.asFunction<
+          double Function(ffi.Pointer<SegmentAggregation>)>();
+
+  /// Shared-vertex mesh of the whole grid for rendering, produced face by face so large n never has to be in memory at
+  /// once. Vertices are numbered 0 .. 10 * n * n + 1; each face owns a contiguous range starting at
+  /// GetGlobeMeshFaceVertexStart(n, face) (face == 20 gives the total), so concatenating the faces in order gives the
+  /// whole vertex buffer. The triangles of a face are its n * n segments in segment index order (segment
+  /// face * n * n + t is triangle t), as global vertex indices. Every triangle is wound the same way as the icosahedron
+  /// faces (counter-clockwise seen from outside); its first corner is CalculateSegmentCornersInLatLng()'s first, and the
+  /// other two are swapped for every second triangle to keep the winding. Needs n <= 14654.
+  int GetGlobeMeshVertexCount(
+    int n,
+  ) {
+    return _GetGlobeMeshVertexCount(
+      n,
+    );
+  }
+
+  late final _GetGlobeMeshVertexCountPtr =
+      _lookup<ffi.NativeFunction<ffi.Int64 Function(ffi.Int)>>(
+          'GetGlobeMeshVertexCount');
+  late final _GetGlobeMeshVertexCount =
+      _GetGlobeMeshVertexCountPtr.asFunction<int Function(int)>();
+
+  int GetGlobeMeshFaceVertexStart(
+    int n,
+    int face,
+  ) {
+    return _GetGlobeMeshFaceVertexStart(
+      n,
+      face,
+    );
+  }
+
+  late final _GetGlobeMeshFaceVertexStartPtr =
+      _lookup<ffi.NativeFunction<ffi.Int64 Function(ffi.Int, ffi.Int)>>(
+          'GetGlobeMeshFaceVertexStart');
+  late final _GetGlobeMeshFaceVertexStart =
+      _GetGlobeMeshFaceVertexStartPtr.asFunction<int Function(int, int)>();
+
+  /// Unit-sphere positions (x, y, z floats) of the vertices face owns, in vertex index order. outCapacity counts vertices.
+  /// Returns the number written, or the number needed when outPositions is NULL.
+  int GetGlobeMeshFaceVertices(
+    int n,
+    int face,
+    ffi.Pointer<ffi.Float> outPositions,
+    int outCapacity,
+  ) {
+    return _GetGlobeMeshFaceVertices(
+      n,
+      face,
+      outPositions,
+      outCapacity,
+    );
+  }
+
+  late final _GetGlobeMeshFaceVerticesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Int, ffi.Pointer<ffi.Float>,
+              ffi.Int64)>>('GetGlobeMeshFaceVertices');
+  late final _GetGlobeMeshFaceVertices = _GetGlobeMeshFaceVerticesPtr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Float>, int)>();
+
+  /// Three vertex indices per triangle. outCapacity counts triangles. Returns n * n, the number written or needed.
+  int GetGlobeMeshFaceTriangles(
+    int n,
+    int face,
+    ffi.Pointer<ffi.Uint32> outIndices,
+    int outCapacity,
+  ) {
+    return _GetGlobeMeshFaceTriangles(
+      n,
+      face,
+      outIndices,
+      outCapacity,
+    );
+  }
+
+  late final _GetGlobeMeshFaceTrianglesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Int, ffi.Int, ffi.Pointer<ffi.Uint32>,
+              ffi.Int64)>>('GetGlobeMeshFaceTriangles');
+  late final _GetGlobeMeshFaceTriangles = _GetGlobeMeshFaceTrianglesPtr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Uint32>, int)>();
+
+  /// Level-of-detail patches of the same mesh. A patch is a segment of a coarser grid patchN that divides n, so patchN = 1
+  /// gives the 20 faces, and each patch of patchN splits into the k^2 patches of k * patchN that
+  /// GetChildSegmentIndices(patchN, k, patchIndex) lists. GetParentSegmentIndex(patchN, n / patchN, segment) finds the
+  /// patch of a segment. Each patch is drawn as its own triangle grid of detailN (a divisor of n / patchN) per side, with
+  /// (detailN + 1)(detailN + 2) / 2 local vertices and detailN^2 triangles in the same winding as the globe mesh.
+  /// Positions are bit-identical to the globe mesh vertex at the same grid point, so patches of equal detail meet without
+  /// cracks. Vertices are in rows of the patch grid. outVertexIndex (optional) receives each vertex's index in the globe
+  /// mesh. Pass NULL for both outputs to get the count.
+  int GetGlobePatchVertices(
+    int n,
+    int patchN,
+    int patchIndex,
+    int detailN,
+    ffi.Pointer<ffi.Float> outPositions,
+    ffi.Pointer<ffi.Uint32> outVertexIndex,
+    int outCapacity,
+  ) {
+    return _GetGlobePatchVertices(
+      n,
+      patchN,
+      patchIndex,
+      detailN,
+      outPositions,
+      outVertexIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetGlobePatchVerticesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int, ffi.Int, ffi.Int,
+              ffi.Pointer<ffi.Float>, ffi.Pointer<ffi.Uint32>,
+              ffi.Int)>>('GetGlobePatchVertices');
+  late final _GetGlobePatchVertices = _GetGlobePatchVerticesPtr.asFunction<
+      int Function(int, int, int, int, ffi.Pointer<ffi.Float>,
+          ffi.Pointer<ffi.Uint32>, int)>();
+
+  /// Local triangle indices, the same for every patch drawn at detailN. outCapacity counts triangles.
+  int GetGlobePatchTriangles(
+    int detailN,
+    ffi.Pointer<ffi.Uint32> outIndices,
+    int outCapacity,
+  ) {
+    return _GetGlobePatchTriangles(
+      detailN,
+      outIndices,
+      outCapacity,
+    );
+  }
+
+  late final _GetGlobePatchTrianglesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Pointer<ffi.Uint32>,
+              ffi.Int)>>('GetGlobePatchTriangles');
+  late final _GetGlobePatchTriangles = _GetGlobePatchTrianglesPtr
+      .asFunction<int Function(int, ffi.Pointer<ffi.Uint32>, int)>();
+
+  /// The (n / patchN)^2 segments of a patch, in the order of its triangles at full detail (detailN = n / patchN), so a
+  /// pick on triangle t of that patch is segment outSegmentIndex[t].
+  int GetGlobePatchSegmentIndices(
+    int n,
+    int patchN,
+    int patchIndex,
+    ffi.Pointer<ffi.Int> outSegmentIndex,
+    int outCapacity,
+  ) {
+    return _GetGlobePatchSegmentIndices(
+      n,
+      patchN,
+      patchIndex,
+      outSegmentIndex,
+      outCapacity,
+    );
+  }
+
+  late final _GetGlobePatchSegmentIndicesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int, ffi.Int, ffi.Pointer<ffi.Int>,
+              ffi.Int)>>('GetGlobePatchSegmentIndices');
+  late final _GetGlobePatchSegmentIndices = _GetGlobePatchSegmentIndicesPtr
+      .asFunction<int Function(int, int, int, ffi.Pointer<ffi.Int>, int)>();
+
+  /// Stable ids for the 10 * n * n + 2 grid vertices and 30 * n * n grid edges, computed with integer math from the
+  /// segment index, so they can key per-vertex or per-edge data (heights, borders, flows) across sessions. Vertex ids are
+  /// the globe mesh vertex indices above, extended to n <= 1048576. Edge ids are likewise grouped by face. Each call
+  /// returns the number of ids written, or a negative ErrorCode for an out-of-range n or id.
+  int GetGridVertexCount64(
+    int n,
+  ) {
+    return _GetGridVertexCount64(
+      n,
+    );
+  }
+
+  late final _GetGridVertexCount64Ptr =
+      _lookup<ffi.NativeFunction<ffi.Int64 Function(ffi.Int)>>(
+          'GetGridVertexCount64');
+  late final _GetGridVertexCount64 =
+      _GetGridVertexCount64Ptr.asFunction<int Function(int)>();
+
+  int GetGridEdgeCount64(
+    int n,
+  ) {
+    return _GetGridEdgeCount64(
+      n,
+    );
+  }
+
+  late final _GetGridEdgeCount64Ptr =
+      _lookup<ffi.NativeFunction<ffi.Int64 Function(ffi.Int)>>(
+          'GetGridEdgeCount64');
+  late final _GetGridEdgeCount64 =
+      _GetGridEdgeCount64Ptr.asFunction<int Function(int)>();
+
+  /// The 3 corner vertices of a segment, in CalculateSegmentCornersInLatLng() order.
+  int GetSegmentGridVertexIndices64(
+    int n,
+    int segmentIndex,
+    ffi.Pointer<ffi.Int64> outVertexIndex,
+  ) {
+    return _GetSegmentGridVertexIndices64(
+      n,
+      segmentIndex,
+      outVertexIndex,
+    );
+  }
+
+  late final _GetSegmentGridVertexIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>)>>('GetSegmentGridVertexIndices64');
+  late final _GetSegmentGridVertexIndices64 = _GetSegmentGridVertexIndices64Ptr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Int64>)>();
+
+  /// The 3 edges of a segment; edge c joins corner c and corner (c + 1) % 3.
+  int GetSegmentGridEdgeIndices64(
+    int n,
+    int segmentIndex,
+    ffi.Pointer<ffi.Int64> outEdgeIndex,
+  ) {
+    return _GetSegmentGridEdgeIndices64(
+      n,
+      segmentIndex,
+      outEdgeIndex,
+    );
+  }
+
+  late final _GetSegmentGridEdgeIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>)>>('GetSegmentGridEdgeIndices64');
+  late final _GetSegmentGridEdgeIndices64 = _GetSegmentGridEdgeIndices64Ptr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Int64>)>();
+
+  /// The segments sharing a vertex, ascending. outSegmentIndex must hold 6; returns 5 at the 12 icosahedron corners.
+  int GetGridVertexSegmentIndices64(
+    int n,
+    int vertexIndex,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+  ) {
+    return _GetGridVertexSegmentIndices64(
+      n,
+      vertexIndex,
+      outSegmentIndex,
+    );
+  }
+
+  late final _GetGridVertexSegmentIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>)>>('GetGridVertexSegmentIndices64');
+  late final _GetGridVertexSegmentIndices64 = _GetGridVertexSegmentIndices64Ptr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Int64>)>();
+
+  /// The 2 end vertices of an edge.
+  int GetGridEdgeVertexIndices64(
+    int n,
+    int edgeIndex,
+    ffi.Pointer<ffi.Int64> outVertexIndex,
+  ) {
+    return _GetGridEdgeVertexIndices64(
+      n,
+      edgeIndex,
+      outVertexIndex,
+    );
+  }
+
+  late final _GetGridEdgeVertexIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>)>>('GetGridEdgeVertexIndices64');
+  late final _GetGridEdgeVertexIndices64 = _GetGridEdgeVertexIndices64Ptr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Int64>)>();
+
+  /// The 2 segments sharing an edge, ascending.
+  int GetGridEdgeSegmentIndices64(
+    int n,
+    int edgeIndex,
+    ffi.Pointer<ffi.Int64> outSegmentIndex,
+  ) {
+    return _GetGridEdgeSegmentIndices64(
+      n,
+      edgeIndex,
+      outSegmentIndex,
+    );
+  }
+
+  late final _GetGridEdgeSegmentIndices64Ptr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>)>>('GetGridEdgeSegmentIndices64');
+  late final _GetGridEdgeSegmentIndices64 = _GetGridEdgeSegmentIndices64Ptr
+      .asFunction<int Function(int, int, ffi.Pointer<ffi.Int64>)>();
+
+  /// Position of a vertex. (0, 0) for an out-of-range n or id.
+  GpsCoords CalculateGridVertexLatLng64(
+    int n,
+    int vertexIndex,
+  ) {
+    return _CalculateGridVertexLatLng64(
+      n,
+      vertexIndex,
+    );
+  }
+
+  late final _CalculateGridVertexLatLng64Ptr =
+      _lookup<ffi.NativeFunction<GpsCoords Function(ffi.Int, ffi.Int64)>>(
+          'CalculateGridVertexLatLng64');
+  late final _CalculateGridVertexLatLng64 = _CalculateGridVertexLatLng64Ptr
+      .asFunction<GpsCoords Function(int, int)>();
+
+  /// Outline of a set of segments (duplicates allowed) as closed loops of grid vertices, for drawing territory borders
+  /// instead of every triangle edge. A loop edge is a segment edge whose segment on the other side is not in the set, so
+  /// loops follow holes and cross face boundaries like any other edge. Every loop keeps the region on its left seen from
+  /// outside the sphere: outer boundaries run counter-clockwise and holes clockwise. Where the region touches itself at a
+  /// single vertex the loops are split there, so no loop visits a vertex twice. The last vertex of a loop connects back
+  /// to its first, which is not repeated. Runs in time linear in count. Needs n <= 1048576; returns NULL for an
+  /// out-of-range n or segment index, or when out of memory.
+  ffi.Pointer<SegmentRegionBoundary> ExtractSegmentRegionBoundary(
+    int n,
+    int count,
+    ffi.Pointer<ffi.Int64> segmentIndex,
+  ) {
+    return _ExtractSegmentRegionBoundary(
+      n,
+      count,
+      segmentIndex,
+    );
+  }
+
+  late final _ExtractSegmentRegionBoundaryPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<SegmentRegionBoundary> Function(ffi.Int, ffi.Int64,
+              ffi.Pointer<ffi.Int64>)>>('ExtractSegmentRegionBoundary');
+  late final _ExtractSegmentRegionBoundary =
+      _ExtractSegmentRegionBoundaryPtr.asFunction<
+          ffi.Pointer<SegmentRegionBoundary> Function(int, int,
+              ffi.Pointer<ffi.Int64>)>();
+
+  void DestroySegmentRegionBoundary(
+    ffi.Pointer<SegmentRegionBoundary> boundary,
+  ) {
+    return _DestroySegmentRegionBoundary(
+      boundary,
+    );
+  }
+
+  late final _DestroySegmentRegionBoundaryPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Void Function(ffi.Pointer<SegmentRegionBoundary>)>>(
+      'DestroySegmentRegionBoundary');
+  late final _DestroySegmentRegionBoundary = _DestroySegmentRegionBoundaryPtr
+      .asFunction<void Function(ffi.Pointer<SegmentRegionBoundary>)>();
+
+  int GetSegmentRegionBoundaryLoopCount(
+    ffi.Pointer<SegmentRegionBoundary> boundary,
+  ) {
+    return _GetSegmentRegionBoundaryLoopCount(
+      boundary,
+    );
+  }
+
+  late final _GetSegmentRegionBoundaryLoopCountPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<SegmentRegionBoundary>)>>(
+      'GetSegmentRegionBoundaryLoopCount');
+  late final _GetSegmentRegionBoundaryLoopCount =
+      _GetSegmentRegionBoundaryLoopCountPtr.asFunction<
+          int Function(ffi.Pointer<SegmentRegionBoundary>)>();
+
+  /// Total number of loop vertices over all loops.
+  int GetSegmentRegionBoundaryVertexCount(
+    ffi.Pointer<SegmentRegionBoundary> boundary,
+  ) {
+    return _GetSegmentRegionBoundaryVertexCount(
+      boundary,
+    );
+  }
+
+  late final _GetSegmentRegionBoundaryVertexCountPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<SegmentRegionBoundary>)>>(
+      'GetSegmentRegionBoundaryVertexCount');
+  late final _GetSegmentRegionBoundaryVertexCount =
+      _GetSegmentRegionBoundaryVertexCountPtr.asFunction<
+          int Function(ffi.Pointer<SegmentRegionBoundary>)>();
+
+  /// Loop l is vertices [offsets[l], offsets[l + 1]); LoopCount + 1 entries.
+  ffi.Pointer<ffi.Int64> GetSegmentRegionBoundaryLoopOffsets(
+    ffi.Pointer<SegmentRegionBoundary> boundary,
+  ) {
+    return _GetSegmentRegionBoundaryLoopOffsets(
+      boundary,
+    );
+  }
+
+  late final _GetSegmentRegionBoundaryLoopOffsetsPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentRegionBoundary>)>>(
+      'GetSegmentRegionBoundaryLoopOffsets');
+  late final _GetSegmentRegionBoundaryLoopOffsets =
+      _GetSegmentRegionBoundaryLoopOffsetsPtr.asFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentRegionBoundary>)>();
+
+  /// Grid vertex ids (GetSegmentGridVertexIndices64()) of the loops, back to back.
+  ffi.Pointer<ffi.Int64> GetSegmentRegionBoundaryVertexIndices(
+    ffi.Pointer<SegmentRegionBoundary> boundary,
+  ) {
+    return _GetSegmentRegionBoundaryVertexIndices(
+      boundary,
+    );
+  }
+
+  late final _GetSegmentRegionBoundaryVertexIndicesPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentRegionBoundary>)>>(
+      'GetSegmentRegionBoundaryVertexIndices');
+  late final _GetSegmentRegionBoundaryVertexIndices =
+      _GetSegmentRegionBoundaryVertexIndicesPtr.asFunction<
+          ffi.Pointer<ffi.Int64> Function(ffi.Pointer<SegmentRegionBoundary>)>();
+
+  /// Lat/lng and unit-sphere position of each loop vertex. Either output may be NULL; with both NULL, returns the count
+  /// needed. outCapacity counts vertices.
+  int GetSegmentRegionBoundaryPoints(
+    ffi.Pointer<SegmentRegionBoundary> boundary,
+    ffi.Pointer<GpsCoords> outLatLng,
+    ffi.Pointer<Vector3> outPosition,
+    int outCapacity,
+  ) {
+    return _GetSegmentRegionBoundaryPoints(
+      boundary,
+      outLatLng,
+      outPosition,
+      outCapacity,
+    );
+  }
+
+  late final _GetSegmentRegionBoundaryPointsPtr = _lookup<
+      ffi.NativeFunction<
+          ffi.Int64 Function(ffi.Pointer<SegmentRegionBoundary>,
+              ffi.Pointer<GpsCoords>, ffi.Pointer<Vector3>,
+              ffi.Int64)>>('GetSegmentRegionBoundaryPoints');
+  late final _GetSegmentRegionBoundaryPoints =
+      _GetSegmentRegionBoundaryPointsPtr.asFunction<
+          int Function(ffi.Pointer<SegmentRegionBoundary>,
+              ffi.Pointer<GpsCoords>, ffi.Pointer<Vector3>, int)>();
+
+  /// A longer lived native function, which occupies the thread calling it.
+  ///
+  /// Do not call these kind of native functions in the main isolate. They will
+  /// block Dart execution. This will cause dropped frames in Flutter applications.
+  /// Instead, call these native functions on a separate isolate.
+  int sum_long_running(
+    int a,
+    int b,
+  ) {
+    return _sum_long_running(
+      a,
+      b,
+    );
+  }
+
+  late final _sum_long_runningPtr =
+      _lookup<ffi.NativeFunction<ffi.IntPtr Function(ffi.IntPtr, ffi.IntPtr)>>(
+          'sum_long_running');
+  late final _sum_long_running =
+      _sum_long_runningPtr.asFunction<int Function(int, int)>();
+}
+
+final class Vector3 extends ffi.Struct {
+  @ffi.Double()
+  external double x;
+
+  @ffi.Double()
+  external double y;
+
+  @ffi.Double()
+  external double z;
+}
+
+final class NeighborSegIdList extends ffi.Struct {
+  @ffi.Array.multi([12])
+  external ffi.Array<ffi.Int> neighborSegId;
+
+  @ffi.Int()
+  external int count;
+}
+
+final class SegGroupAndLocalSegIndex extends ffi.Struct {
+  @ffi.Int()
+  external int segGroup;
+
+  @ffi.Int()
+  external int localSegIndex;
+}
+
+final class NeighborSegIdList64 extends ffi.Struct {
+  @ffi.Array.multi([12])
+  external ffi.Array<ffi.Int64> neighborSegId;
+
+  @ffi.Int()
+  external int count;
+}
+
+final class SegGroupAndLocalSegIndex64 extends ffi.Struct {
+  @ffi.Int()
+  external int segGroup;
+
+  @ffi.Int64()
+  external int localSegIndex;
+}
+
+final class GpsCoords extends ffi.Struct {
+  @ffi.Double()
+  external double lat;
+
+  @ffi.Double()
+  external double lng;
+}
+
+final class SegmentCornersInLatLng extends ffi.Struct {
+  @ffi.Array.multi([3])
+  external ffi.Array<GpsCoords> points;
+}
+
+abstract class ErrorCode {
+  static const int ErrorCode_None = 0;
+  static const int ErrorCode_LogicError_NoIntersection = -1;
+  static const int ErrorCode_NullPtr = -2;
+  static const int ErrorCode_Argument_NullPtr = -3;
+  static const int ErrorCode_ArgumentOutOfRangeException = -4;
+  static const int ErrorCode_BufferTooSmall = -5;
+  static const int ErrorCode_OutOfMemory = -6;
+  static const int ErrorCode_IoError = -7;
+}
+
+/// How segment center/corner positions are converted to lat/lng. See CreateGeocodingContextWithPrecision().
+abstract class LatLngPrecision {
+  static const int LatLngPrecision_Exact = 0;
+  static const int LatLngPrecision_Fast = 1;
+}
+
+/// Which segments GetSegmentIndicesInPolygon() and GetSegmentIndicesInLatLngBox() return.
+abstract class PolygonFillMode {
+  static const int PolygonFillMode_Center = 0;
+  static const int PolygonFillMode_Overlap = 1;
+}
+
+/// Which segments GetSegmentIndicesInCap() returns.
+abstract class CapQueryMode {
+  static const int CapQueryMode_Exact = 0;
+  static const int CapQueryMode_Conservative = 1;
+}
+
+/// Per-n precomputed tables. Create once with CreateGeocodingContext() and pass to the *WithContext functions.
+final class GeocodingContext extends ffi.Opaque {}
+
+/// A memory-mapped adjacency table file. Open with OpenAdjacencyTable() and release with CloseAdjacencyTable().
+final class AdjacencyTable extends ffi.Opaque {}
+
+/// Worker threads with per-worker task queues and work stealing. See CreateThreadPool().
+final class ThreadPool extends ffi.Opaque {}
+
+/// Per-segment point counts and weight sums from AggregatePointsBySegment(). Release with DestroySegmentAggregation().
+final class SegmentAggregation extends ffi.Opaque {}
+
+/// Outline of a segment set from ExtractSegmentRegionBoundary(). Release with DestroySegmentRegionBoundary().
+final class SegmentRegionBoundary extends ffi.Opaque {}
+
+final class AggregationThreadStats extends ffi.Struct {
+  @ffi.Int64()
+  external int pointCount;
+
+  @ffi.Int64()
+  external int skippedCount;
+
+  @ffi.Double()
+  external double seconds;
 }
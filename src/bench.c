@@ -0,0 +1,402 @@
+// 내보낸 함수들의 처리량을 재현 가능한 작업량으로 측정한다. 결과는 CSV 또는 JSON으로 출력한다.
+// 라이브러리의 정적 빌드에 링크하고, 내부 스레드 도구(RunParallel 등)는 sphere_uniform_geocoding_internal.h로 쓴다.
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // pthread_setaffinity_np
+#endif
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sphere_uniform_geocoding.h"
+#include "sphere_uniform_geocoding_internal.h"
+
+// 32비트 세그먼트 인덱스로 표현할 수 있는 최대 n (20 * n^2 <= 2^32). INT_MAX를 넘는 인덱스는 같은 비트 패턴의 int로 넘긴다.
+#define BenchMaxN (14654)
+
+// 기본으로 측정하는 n
+static const int DefaultBenchN[] = {1, 2, 4, 16, 64, 256, 1024, 4096, 8192, 14654};
+
+// 도시 밀집 작업량의 도시 수와 도시 주변으로 퍼지는 반경(라디안, 약 0.5도)
+#define BenchCityCount (64)
+#define BenchCitySpread (0.00872664626)
+
+typedef enum {
+    BenchWorkloadUniform,
+    BenchWorkloadCity,
+    BenchWorkloadSequential,
+    BenchWorkloadRandom,
+} BenchWorkload;
+
+static const char *const BenchWorkloadNames[] = {"uniform", "city", "sequential", "random"};
+
+typedef enum {
+    BenchFuncGeocode,
+    BenchFuncCenter,
+    BenchFuncCorners,
+    BenchFuncNeighbors,
+    // 같은 계산을 미리 만든 GeocodingContext로 한다. 위의 함수들과의 차이가 호출마다 면 상수를 계산하는 비용이다.
+    BenchFuncGeocodeWithContext,
+    BenchFuncCenterWithContext,
+    BenchFuncCornersWithContext,
+} BenchFunc;
+
+static const char *const BenchFuncNames[] = {
+    "CalculateSegmentIndexFromLatLng",
+    "CalculateSegmentCenterLatLng",
+    "CalculateSegmentCornersInLatLng",
+    "GetNeighborsOfSegmentIndex",
+    "CalculateSegmentIndexFromLatLngWithContext",
+    "CalculateSegmentCenterLatLngWithContext",
+    "CalculateSegmentCornersInLatLngWithContext",
+};
+
+typedef enum {
+    BenchModeSingle, // 스레드 1개
+    BenchModePinned, // 스레드마다 코어 하나에 고정
+    BenchModeMulti,  // 스레드를 고정하지 않음
+} BenchMode;
+
+static const char *const BenchModeNames[] = {"single", "pinned", "multi"};
+
+// 작업량마다 고정된 시드에서 입력을 만들어, 같은 인자로 실행하면 항상 같은 입력을 측정한다.
+typedef struct {
+    uint64_t state;
+} BenchRandom;
+
+static uint64_t NextBenchRandom(BenchRandom *random) {
+    random->state ^= random->state >> 12;
+    random->state ^= random->state << 25;
+    random->state ^= random->state >> 27;
+    return random->state * 0x2545F4914F6CDD1DULL;
+}
+
+// [0, 1) 범위의 난수
+static double NextBenchRandomUnit(BenchRandom *random) {
+    return (double) (NextBenchRandom(random) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// 구면 위에 균일하게 분포하는 위도, 경도(라디안)
+static GpsCoords NextBenchUniformLatLng(BenchRandom *random) {
+    const double lat = asin(2 * NextBenchRandomUnit(random) - 1);
+    return (GpsCoords) {.lat = lat, .lng = 2 * M_PI * NextBenchRandomUnit(random) - M_PI};
+}
+
+// 위치 입력(uniform, city)을 채운다. city는 BenchCityCount개 도시 주변에 몰린 지점이다.
+static void FillBenchPoints(BenchWorkload workload, int count, double *lat, double *lng) {
+    BenchRandom random = {0x9E3779B97F4A7C15ULL + (uint64_t) workload};
+    GpsCoords cities[BenchCityCount];
+    for (int i = 0; i < BenchCityCount; i++) {
+        cities[i] = NextBenchUniformLatLng(&random);
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (workload == BenchWorkloadUniform) {
+            const GpsCoords p = NextBenchUniformLatLng(&random);
+            lat[i] = p.lat;
+            lng[i] = p.lng;
+            continue;
+        }
+
+        // 도시 중심에서 무작위 방향으로 [0, BenchCitySpread) 만큼 떨어진 지점
+        const GpsCoords city = cities[NextBenchRandom(&random) % BenchCityCount];
+        const double distance = BenchCitySpread * NextBenchRandomUnit(&random);
+        const double bearing = 2 * M_PI * NextBenchRandomUnit(&random);
+        double pointLat = city.lat + distance * cos(bearing);
+        if (pointLat > M_PI / 2) {
+            pointLat = M_PI - pointLat;
+        } else if (pointLat < -M_PI / 2) {
+            pointLat = -M_PI - pointLat;
+        }
+        double pointLng = city.lng + distance * sin(bearing) / fmax(cos(city.lat), 1e-3);
+        pointLng = remainder(pointLng, 2 * M_PI);
+        lat[i] = pointLat;
+        lng[i] = pointLng;
+    }
+}
+
+// 인덱스 입력(sequential, random)을 채운다. sequential은 0부터 차례대로 돌고 전체 수를 넘으면 다시 0부터 돈다.
+static void FillBenchSegmentIndices(BenchWorkload workload, int n, int count, int *segmentIndex) {
+    const int64_t segmentCount = CalculateSegmentCountPerGroup64(n) * GroupCount;
+    BenchRandom random = {0x9E3779B97F4A7C15ULL + (uint64_t) workload};
+    for (int i = 0; i < count; i++) {
+        segmentIndex[i] = workload == BenchWorkloadSequential
+                              ? (int) (i % segmentCount)
+                              : (int) (NextBenchRandom(&random) % (uint64_t) segmentCount);
+    }
+}
+
+typedef struct {
+    BenchFunc func;
+    BenchMode mode;
+    int n;
+    int count;
+    const GeocodingContext *context;
+    const double *lat;
+    const double *lng;
+    const int *segmentIndex;
+    double seconds[ParallelMaxThreadCount];
+    double checksum[ParallelMaxThreadCount];
+    int pinned[ParallelMaxThreadCount];
+} BenchJob;
+
+// 호출한 스레드를 threadIndex번 코어에 고정한다. 지원하지 않는 플랫폼이면 0을 반환한다.
+static int PinCurrentThread(int threadIndex) {
+    const int cpu = threadIndex % GetProcessorCount();
+#if _WIN32
+    return cpu < 64 && SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR) 1 << cpu) != 0;
+#elif defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void) cpu;
+    return 0;
+#endif
+}
+
+// 결과가 최적화로 사라지지 않도록 모든 출력을 체크섬에 더한다.
+static double RunBenchLoop(const BenchJob *job, int count) {
+    const int n = job->n;
+    double checksum = 0;
+    switch (job->func) {
+        case BenchFuncGeocode:
+            for (int i = 0; i < count; i++) {
+                checksum += CalculateSegmentIndexFromLatLng(n, job->lat[i], job->lng[i]);
+            }
+            break;
+        case BenchFuncCenter:
+            for (int i = 0; i < count; i++) {
+                const GpsCoords c = CalculateSegmentCenterLatLng(n, job->segmentIndex[i]);
+                checksum += c.lat + c.lng;
+            }
+            break;
+        case BenchFuncCorners:
+            for (int i = 0; i < count; i++) {
+                const SegmentCornersInLatLng c = CalculateSegmentCornersInLatLng(n, job->segmentIndex[i]);
+                checksum += c.points[0].lat + c.points[1].lng + c.points[2].lat;
+            }
+            break;
+        case BenchFuncNeighbors:
+            for (int i = 0; i < count; i++) {
+                const NeighborSegIdList list = GetNeighborsOfSegmentIndex(n, job->segmentIndex[i]);
+                checksum += list.count > 0 ? list.neighborSegId[0] + list.neighborSegId[list.count - 1] : 0;
+            }
+            break;
+        case BenchFuncGeocodeWithContext:
+            for (int i = 0; i < count; i++) {
+                checksum += CalculateSegmentIndexFromLatLngWithContext(job->context, job->lat[i], job->lng[i]);
+            }
+            break;
+        case BenchFuncCenterWithContext:
+            for (int i = 0; i < count; i++) {
+                const GpsCoords c = CalculateSegmentCenterLatLngWithContext(job->context, job->segmentIndex[i]);
+                checksum += c.lat + c.lng;
+            }
+            break;
+        case BenchFuncCornersWithContext:
+            for (int i = 0; i < count; i++) {
+                const SegmentCornersInLatLng c = CalculateSegmentCornersInLatLngWithContext(job->context,
+                                                                                            job->segmentIndex[i]);
+                checksum += c.points[0].lat + c.points[1].lng + c.points[2].lat;
+            }
+            break;
+    }
+    return checksum;
+}
+
+// 모든 스레드가 같은 입력 전체를 처리한다. 예열 1회 뒤 측정 구간만 잰다.
+static void RunBenchThread(void *arg, int threadIndex) {
+    BenchJob *job = arg;
+    job->pinned[threadIndex] = job->mode == BenchModePinned ? PinCurrentThread(threadIndex) : 0;
+    job->checksum[threadIndex] = RunBenchLoop(job, job->count < 65536 ? job->count : 65536);
+    const double t0 = GetMonotonicSeconds();
+    job->checksum[threadIndex] += RunBenchLoop(job, job->count);
+    job->seconds[threadIndex] = GetMonotonicSeconds() - t0;
+}
+
+typedef enum {
+    BenchFormatCsv,
+    BenchFormatJson,
+} BenchFormat;
+
+typedef struct {
+    BenchFormat format;
+    int rowCount;
+} BenchOutput;
+
+// ns_per_op는 스레드 하나가 연산 하나에 쓴 시간, ops_per_sec는 모든 스레드를 합친 처리량이다.
+// 여러 스레드일 때 경과 시간은 가장 늦게 끝난 스레드의 시간이다.
+static void PrintBenchRow(BenchOutput *output, const BenchJob *job, BenchWorkload workload, int threadCount) {
+    double seconds = 0;
+    double checksum = 0;
+    int pinned = job->mode == BenchModePinned;
+    for (int i = 0; i < threadCount; i++) {
+        seconds = fmax(seconds, job->seconds[i]);
+        checksum += job->checksum[i];
+        pinned &= job->pinned[i];
+    }
+    const double ops = (double) job->count * threadCount;
+    const double nsPerOp = seconds * 1e9 * threadCount / ops;
+    const double opsPerSec = seconds > 0 ? ops / seconds : 0;
+
+    if (output->format == BenchFormatCsv) {
+        if (output->rowCount == 0) {
+            printf("function,workload,n,mode,threads,pinned,ops,seconds,ns_per_op,ops_per_sec,checksum\n");
+        }
+        printf("%s,%s,%d,%s,%d,%d,%.0f,%.6f,%.3f,%.0f,%.17g\n", BenchFuncNames[job->func],
+               BenchWorkloadNames[workload], job->n, BenchModeNames[job->mode], threadCount, pinned, ops, seconds,
+               nsPerOp, opsPerSec, checksum);
+    } else {
+        printf("%s\n  {\"function\": \"%s\", \"workload\": \"%s\", \"n\": %d, \"mode\": \"%s\", \"threads\": %d, "
+               "\"pinned\": %s, \"ops\": %.0f, \"seconds\": %.6f, \"ns_per_op\": %.3f, \"ops_per_sec\": %.0f, "
+               "\"checksum\": %.17g}",
+               output->rowCount == 0 ? "[" : ",", BenchFuncNames[job->func], BenchWorkloadNames[workload], job->n,
+               BenchModeNames[job->mode], threadCount, pinned ? "true" : "false", ops, seconds, nsPerOp, opsPerSec,
+               checksum);
+    }
+    fflush(stdout);
+    output->rowCount++;
+}
+
+static void PrintBenchUsage(void) {
+    fprintf(stderr, "usage: sphere_uniform_geocoding_bench [options]\n");
+    fprintf(stderr, "  --format csv|json    output format (default csv)\n");
+    fprintf(stderr, "  --n 1,1024,14654     comma separated n values (default 1,2,4,16,64,256,1024,4096,8192,14654)\n");
+    fprintf(stderr, "  --ops count          operations per thread per measurement (default 200000)\n");
+    fprintf(stderr, "  --threads count      thread count of the pinned/multi modes (default: processor count)\n");
+    fprintf(stderr, "  --mode single|pinned|multi|all  thread modes to run (default all)\n");
+    fprintf(stderr, "  --func name          only measure functions whose name contains this text\n");
+}
+
+// 쉼표로 구분한 n 목록을 읽는다. 잘못된 값이 있으면 -1을 반환한다.
+static int ParseBenchNList(const char *text, int *nList, int capacity) {
+    int count = 0;
+    while (*text != '\0') {
+        char *end;
+        const long n = strtol(text, &end, 10);
+        if (end == text || n < 1 || n > BenchMaxN || count == capacity) {
+            return -1;
+        }
+        nList[count++] = (int) n;
+        text = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0') {
+            return -1;
+        }
+    }
+    return count;
+}
+
+int main(int argc, char **argv) {
+    BenchOutput output = {.format = BenchFormatCsv};
+    int nList[64];
+    int nCount = (int) NELEMS(DefaultBenchN);
+    memcpy(nList, DefaultBenchN, sizeof(DefaultBenchN));
+    int ops = 200000;
+    int threadCount = GetProcessorCount();
+    int modeMask = 1 << BenchModeSingle | 1 << BenchModePinned | 1 << BenchModeMulti;
+    const char *funcFilter = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int valid = value != NULL;
+        if (valid && strcmp(argv[i], "--format") == 0) {
+            output.format = strcmp(value, "json") == 0 ? BenchFormatJson : BenchFormatCsv;
+            valid = output.format == BenchFormatJson || strcmp(value, "csv") == 0;
+        } else if (valid && strcmp(argv[i], "--n") == 0) {
+            nCount = ParseBenchNList(value, nList, (int) NELEMS(nList));
+            valid = nCount > 0;
+        } else if (valid && strcmp(argv[i], "--ops") == 0) {
+            ops = atoi(value);
+            valid = ops > 0;
+        } else if (valid && strcmp(argv[i], "--threads") == 0) {
+            threadCount = atoi(value);
+            valid = threadCount > 0 && threadCount <= ParallelMaxThreadCount;
+        } else if (valid && strcmp(argv[i], "--mode") == 0) {
+            modeMask = strcmp(value, "single") == 0   ? 1 << BenchModeSingle
+                       : strcmp(value, "pinned") == 0 ? 1 << BenchModePinned
+                       : strcmp(value, "multi") == 0  ? 1 << BenchModeMulti
+                       : strcmp(value, "all") == 0    ? modeMask
+                                                      : 0;
+            valid = modeMask != 0;
+        } else if (valid && strcmp(argv[i], "--func") == 0) {
+            funcFilter = value;
+        } else {
+            valid = 0;
+        }
+
+        if (!valid) {
+            PrintBenchUsage();
+            return 1;
+        }
+        i++;
+    }
+
+    double *lat = malloc(sizeof(double) * ops);
+    double *lng = malloc(sizeof(double) * ops);
+    int *segmentIndex = malloc(sizeof(int) * ops);
+    BenchJob *job = calloc(1, sizeof(BenchJob));
+    if (lat == NULL || lng == NULL || segmentIndex == NULL || job == NULL) {
+        free(lat);
+        free(lng);
+        free(segmentIndex);
+        free(job);
+        return 1;
+    }
+
+    for (int ni = 0; ni < nCount; ni++) {
+        GeocodingContext *context = CreateGeocodingContext(nList[ni]);
+        for (BenchFunc func = BenchFuncGeocode; func <= BenchFuncCornersWithContext; func++) {
+            if (funcFilter != NULL && strstr(BenchFuncNames[func], funcFilter) == NULL) {
+                continue;
+            }
+
+            const int geocode = func == BenchFuncGeocode || func == BenchFuncGeocodeWithContext;
+            const BenchWorkload first = geocode ? BenchWorkloadUniform : BenchWorkloadSequential;
+            for (BenchWorkload workload = first; workload <= first + 1; workload++) {
+                if (geocode) {
+                    FillBenchPoints(workload, ops, lat, lng);
+                } else {
+                    FillBenchSegmentIndices(workload, nList[ni], ops, segmentIndex);
+                }
+
+                for (BenchMode mode = BenchModeSingle; mode <= BenchModeMulti; mode++) {
+                    const int modeThreadCount = mode == BenchModeSingle ? 1 : threadCount;
+                    if ((modeMask & 1 << mode) == 0) {
+                        continue;
+                    }
+                    // 스레드가 1개면 multi는 single과 같은 측정이다.
+                    if (mode == BenchModeMulti && threadCount == 1 && (modeMask & 1 << BenchModeSingle)) {
+                        continue;
+                    }
+
+                    *job = (BenchJob) {
+                        .func = func,
+                        .mode = mode,
+                        .n = nList[ni],
+                        .count = ops,
+                        .context = context,
+                        .lat = lat,
+                        .lng = lng,
+                        .segmentIndex = segmentIndex,
+                    };
+                    RunParallel(modeThreadCount, RunBenchThread, job);
+                    PrintBenchRow(&output, job, workload, modeThreadCount);
+                }
+            }
+        }
+        DestroyGeocodingContext(context);
+    }
+
+    if (output.format == BenchFormatJson) {
+        printf(output.rowCount == 0 ? "[]\n" : "\n]\n");
+    }
+
+    free(lat);
+    free(lng);
+    free(segmentIndex);
+    free(job);
+    return 0;
+}
@@ -1,8 +1,2793 @@
-#include "sphere_uniform_geocoding.h"
+// 라이브러리 구현을 직접 포함하여, 내보내지 않는 내부 경로까지 검증하고 측정한다.
+#include <string.h>
+#include <time.h>
 
-int main()
-{
-    printf("Hello~\n");
-    Vector3 v = CalculateSegmentCenter(4, 0);
+#include "sphere_uniform_geocoding.c"
+
+static uint64_t RandomState = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t NextRandom(void) {
+    RandomState ^= RandomState >> 12;
+    RandomState ^= RandomState << 25;
+    RandomState ^= RandomState >> 27;
+    return RandomState * 0x2545F4914F6CDD1DULL;
+}
+
+// [0, 1) 범위의 난수
+static double NextRandomUnit(void) {
+    return (double) (NextRandom() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// 구면 위에 균일하게 분포하는 위도, 경도(라디안)
+static GpsCoords NextRandomLatLng(void) {
+    return (GpsCoords) {.lat = asin(2 * NextRandomUnit() - 1), .lng = 2 * M_PI * NextRandomUnit() - M_PI};
+}
+
+static double NowSeconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+}
+
+// 면 선택(FindSegmentGroup)이 전체 순회(FindSegmentGroupByScan)와 같은 결과를 내는지 기존 표와 정확한 표 모두에서
+// 확인하고 속도를 비교한다. 무작위 지점 외에 면 경계(정이십면체 모서리) 바로 근처의 지점도 검사한다.
+// 속도는 기존 표와 무작위 지점으로만 잰다.
+static int RunFaceSelection(int count) {
+    const int edgeCount = count / 4;
+    Vector3 *rays = malloc(sizeof(Vector3) * (count + edgeCount));
+    if (rays == NULL) {
+        return 1;
+    }
+
+    for (int i = 0; i < count + edgeCount; i++) {
+        if (i >= count) {
+            // 면의 한 변 위의 점을 아주 조금 흔든다.
+            const int *face = VertIndexPerFaces[NextRandom() % GroupCount];
+            const int k = (int) (NextRandom() % 3);
+            const Vector3 v0 = Vertices[face[k]];
+            const Vector3 v1 = Vertices[face[(k + 1) % 3]];
+            const double s = NextRandomUnit();
+            const double jitter = (NextRandomUnit() - 0.5) * 1e-5;
+            Vector3 p = AddVector3(ScalarMultiplyVector(1 - s, v0), ScalarMultiplyVector(s, v1));
+            p = AddVector3(p, (Vector3) {jitter, -jitter, jitter});
+            rays[i] = ScalarMultiplyVector(2, NormalizeVector3(p));
+        } else {
+            const GpsCoords ll = NextRandomLatLng();
+            rays[i] = ScalarMultiplyVector(2, CalculateUnitSpherePosition(ll.lat, ll.lng));
+        }
+    }
+
+    const IcosahedronGeometry *geometries[] = {&TableIcosahedron, &ExactIcosahedron};
+    int mismatch = 0;
+    for (int g = 0; g < NELEMS(geometries); g++) {
+        for (int i = 0; i < count + edgeCount; i++) {
+            Vector3 intersectScan = {0, 0, 0}, intersect = {0, 0, 0};
+            const int scan = FindSegmentGroupByScan(geometries[g], &intersectScan, rays[i]);
+            const int fast = FindSegmentGroup(geometries[g], &intersect, rays[i]);
+            if (scan != fast || memcmp(&intersectScan, &intersect, sizeof(Vector3)) != 0) {
+                if (mismatch < 10) {
+                    printf("mismatch #%d (%s tables): scan=%d fast=%d\n", i, g == 0 ? "7-digit" : "exact", scan,
+                           fast);
+                }
+                mismatch++;
+            }
+        }
+    }
+
+    int64_t checksum = 0;
+    double t0 = NowSeconds();
+    for (int i = 0; i < count; i++) {
+        Vector3 intersect;
+        checksum += FindSegmentGroupByScan(&TableIcosahedron, &intersect, rays[i]);
+    }
+    double t1 = NowSeconds();
+    for (int i = 0; i < count; i++) {
+        Vector3 intersect;
+        checksum -= FindSegmentGroup(&TableIcosahedron, &intersect, rays[i]);
+    }
+    double t2 = NowSeconds();
+
+    printf("face-selection: %d points (+%d near edges), %d mismatches (checksum %lld)\n", count, edgeCount, mismatch,
+           (long long) checksum);
+    printf("  scan  : %8.2f ns/op\n", (t1 - t0) * 1e9 / count);
+    printf("  direct: %8.2f ns/op (x%.2f)\n", (t2 - t1) * 1e9 / count, (t1 - t0) / (t2 - t1));
+
+    free(rays);
+    return mismatch != 0;
+}
+
+// 행을 차례로 걸으며 (행 b는 서브 인덱스 b * (2n - b)부터 2(n - b) - 1개) 모든 서브 인덱스의 닫힌 식 B 계산
+// (CalculateBFromLocalSegmentIndex)이 그 행과 같은지, 분해한 ABT 좌표가 다시 같은 서브 인덱스로 돌아오는지 확인하고
+// B 계산 속도를 잰다.
+static int RunAbtDecoding(int n) {
+    if (n < 1 || (int64_t) n * n > INT_MAX) {
+        printf("abt-decoding: n out of range\n");
+        return 1;
+    }
+
+    const int count = n * n;
+    int64_t mismatch = 0;
+    for (int row = 0; row < n; row++) {
+        const int rowStart = row * (2 * n - row);
+        for (int i = rowStart; i < rowStart + 2 * (n - row) - 1; i++) {
+            const int b = CalculateBFromLocalSegmentIndex(n, i);
+            const AbtCoords abt = SplitLocalSegmentIndexToAbt(n, i);
+            if (row != b || ConvertToLocalSegmentIndex2(n, abt) != i) {
+                if (mismatch < 10) {
+                    printf("mismatch at local index %d: row=%d closed-form=%d\n", i, row, b);
+                }
+                mismatch++;
+            }
+        }
+    }
+
+    const int sampleCount = 10000000;
+    int *samples = malloc(sizeof(int) * sampleCount);
+    if (samples == NULL) {
+        return 1;
+    }
+    for (int i = 0; i < sampleCount; i++) {
+        samples[i] = (int) (NextRandom() % count);
+    }
+
+    int64_t checksum = 0;
+    double t0 = NowSeconds();
+    for (int i = 0; i < sampleCount; i++) {
+        checksum += CalculateBFromLocalSegmentIndex(n, samples[i]);
+    }
+    double t1 = NowSeconds();
+
+    printf("abt-decoding: n=%d, %d local indices, %lld mismatches (checksum %lld)\n", n, count, (long long) mismatch,
+           (long long) checksum);
+    printf("  closed form: %8.2f ns/op\n", (t1 - t0) * 1e9 / sampleCount);
+
+    free(samples);
+    return mismatch != 0;
+}
+
+// 64비트 API가 32비트 API와 같은 번호를 내는지 확인하고, 32비트 한계를 넘는 n에서
+// 세그먼트 중심의 위도, 경도가 같은 인덱스로 돌아오는지와 이웃 관계가 대칭인지 확인한다.
+static int RunIndex64(int n) {
+    if (n < 1 || n > MaxSubdivisionCount64) {
+        printf("index64: n out of range\n");
+        return 1;
+    }
+
+    const int sampleCount = 100000;
+    int64_t mismatch = 0;
+    if ((int64_t) n * n * GroupCount <= (int64_t) UINT_MAX + 1) {
+        for (int i = 0; i < sampleCount; i++) {
+            const GpsCoords ll = NextRandomLatLng();
+            const int64_t segmentIndex = CalculateSegmentIndexFromLatLng64(n, ll.lat, ll.lng);
+            if ((uint32_t) CalculateSegmentIndexFromLatLng(n, ll.lat, ll.lng) != segmentIndex) {
+                mismatch++;
+            }
+
+            const NeighborSegIdList neighbors = GetNeighborsOfSegmentIndex(n, (int) segmentIndex);
+            const NeighborSegIdList64 neighbors64 = GetNeighborsOfSegmentIndex64(n, segmentIndex);
+            if (neighbors.count != neighbors64.count) {
+                mismatch++;
+                continue;
+            }
+            for (int j = 0; j < neighbors.count; j++) {
+                if ((uint32_t) neighbors.neighborSegId[j] != neighbors64.neighborSegId[j]) {
+                    mismatch++;
+                }
+            }
+        }
+    }
+
+    const int64_t segmentCount = (int64_t) n * n * GroupCount;
+    int64_t roundTripFailure = 0;
+    int64_t asymmetric = 0;
+    for (int i = 0; i < sampleCount; i++) {
+        const int64_t segmentIndex = (int64_t) (NextRandom() % (uint64_t) segmentCount);
+        const double lat = CalculateSegmentCenterLat64(n, segmentIndex);
+        const double lng = CalculateSegmentCenterLng64(n, segmentIndex);
+        if (CalculateSegmentIndexFromLatLng64(n, lat, lng) != segmentIndex) {
+            roundTripFailure++;
+        }
+
+        const NeighborSegIdList64 neighbors = GetNeighborsOfSegmentIndex64(n, segmentIndex);
+        for (int j = 0; j < neighbors.count; j++) {
+            const NeighborSegIdList64 back = GetNeighborsOfSegmentIndex64(n, neighbors.neighborSegId[j]);
+            int found = 0;
+            for (int k = 0; k < back.count; k++) {
+                found |= back.neighborSegId[k] == segmentIndex;
+            }
+            asymmetric += !found;
+        }
+    }
+
+    printf("index64: n=%d, %lld segments, %lld 32/64 mismatches, %lld center round-trip failures, "
+           "%lld asymmetric neighbors\n", n, (long long) segmentCount, (long long) mismatch,
+           (long long) roundTripFailure, (long long) asymmetric);
+    return mismatch != 0 || asymmetric != 0;
+}
+
+typedef struct {
+    const char *name;
+    double nsPerOp;
+    double maxLatError;
+    double maxLngError;
+} LatLngPrecisionResult;
+
+// 두 경도의 차이를 -pi ~ pi 범위로 감아서 반환한다.
+static double LngDifference(double a, double b) {
+    const double d = fmod(fabs(a - b), 2 * M_PI);
+    return d > M_PI ? 2 * M_PI - d : d;
+}
+
+static LatLngPrecisionResult MeasureLatLngPrecision(const char *name, GpsCoords (*calculate)(Vector3),
+                                                    const Vector3 *points, const GpsCoords *reference, int count) {
+    GpsCoords *result = malloc(sizeof(GpsCoords) * count);
+    LatLngPrecisionResult ret = {.name = name};
+    if (result == NULL) {
+        return ret;
+    }
+
+    const double t0 = NowSeconds();
+    for (int i = 0; i < count; i++) {
+        result[i] = calculate(points[i]);
+    }
+    ret.nsPerOp = (NowSeconds() - t0) * 1e9 / count;
+
+    for (int i = 0; i < count; i++) {
+        const double latError = fabs(result[i].lat - reference[i].lat);
+        const double lngError = LngDifference(result[i].lng, reference[i].lng);
+        ret.maxLatError = latError > ret.maxLatError ? latError : ret.maxLatError;
+        ret.maxLngError = lngError > ret.maxLngError ? lngError : ret.maxLngError;
+    }
+    free(result);
+    return ret;
+}
+
+static GpsCoords CalculateLatLngExact(Vector3 p) {
+    return CalculateLatLngWithPrecision(p, LatLngPrecision_Exact);
+}
+
+static GpsCoords CalculateLatLngFast(Vector3 p) {
+    return CalculateLatLngWithPrecision(p, LatLngPrecision_Fast);
+}
+
+// 위도, 경도 변환 방식별로 오차(long double 기준값 대비 최대 오차)와 속도를 비교한다.
+// 입력은 세그먼트 꼭짓점처럼 단위 구 안쪽에 있는 정규화되지 않은 점들이다.
+static int RunLatLngPrecision(int count) {
+    Vector3 *points = malloc(sizeof(Vector3) * count);
+    GpsCoords *reference = malloc(sizeof(GpsCoords) * count);
+    if (points == NULL || reference == NULL) {
+        free(points);
+        free(reference);
+        return 1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        const GpsCoords ll = NextRandomLatLng();
+        points[i] = ScalarMultiplyVector(0.8 + 0.2 * NextRandomUnit(), CalculateUnitSpherePosition(ll.lat, ll.lng));
+        const long double x = points[i].x, y = points[i].y, z = points[i].z;
+        reference[i].lat = (double) atan2l(y, sqrtl(x * x + z * z));
+        reference[i].lng = (double) atan2l(z, x);
+    }
+
+    const LatLngPrecisionResult results[] = {
+            MeasureLatLngPrecision("exact", CalculateLatLngExact, points, reference, count),
+            MeasureLatLngPrecision("fast", CalculateLatLngFast, points, reference, count),
+    };
+
+    // 지구 평균 반지름 (m)
+    const double earthRadius = 6371008.8;
+    printf("latlng-precision: %d points\n", count);
+    printf("  %-12s %10s %14s %14s %12s\n", "mode", "ns/op", "max lat err", "max lng err", "max err (m)");
+    for (int i = 0; i < NELEMS(results); i++) {
+        const LatLngPrecisionResult *r = &results[i];
+        const double maxError = r->maxLatError > r->maxLngError ? r->maxLatError : r->maxLngError;
+        printf("  %-12s %10.2f %14.3e %14.3e %12.3e\n", r->name, r->nsPerOp, r->maxLatError, r->maxLngError,
+               maxError * earthRadius);
+    }
+
+    // 계산 방식은 컨텍스트마다 정해진다. 빠른 방식의 컨텍스트가 정확한 방식과 오차 범위 안에서 같은지,
+    // 컨텍스트 없는 함수는 정확한 방식을 그대로 쓰는지 본다.
+    const int n = 4095;
+    GeocodingContext *exact = CreateGeocodingContext(n);
+    GeocodingContext *fast = CreateGeocodingContextWithPrecision(n, LatLngPrecision_Fast);
+    int mismatch = exact == NULL || fast == NULL || CreateGeocodingContextWithPrecision(n, 2) != NULL;
+    double maxContextError = 0;
+    for (int i = 0; i < 100000 && !mismatch; i++) {
+        const int segmentIndex = (int) (NextRandom() % ((uint64_t) n * n * GroupCount));
+        const GpsCoords e = CalculateSegmentCenterLatLngWithContext(exact, segmentIndex);
+        const GpsCoords f = CalculateSegmentCenterLatLngWithContext(fast, segmentIndex);
+        const GpsCoords plain = CalculateSegmentCenterLatLng(n, segmentIndex);
+        const double error = fmax(fabs(e.lat - f.lat), LngDifference(e.lng, f.lng));
+        maxContextError = error > maxContextError ? error : maxContextError;
+        mismatch += plain.lat != e.lat || plain.lng != e.lng;
+    }
+    mismatch += maxContextError > 1e-10;
+    printf("  fast context vs exact context: max error %.3e, %d mismatches\n", maxContextError, mismatch);
+    DestroyGeocodingContext(exact);
+    DestroyGeocodingContext(fast);
+
+    free(points);
+    free(reference);
+    return mismatch != 0;
+}
+
+// CSR 일괄 이웃 조회가 한 개씩 조회한 결과와 같은지, 중복 제거 결과가 중복 없는 합집합인지 확인하고 속도를 비교한다.
+static int RunNeighborCsr(int n) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1) {
+        printf("neighbor-csr: n out of range\n");
+        return 1;
+    }
+
+    const int count = 200000;
+    int *segments = malloc(sizeof(int) * count);
+    int *offsets = malloc(sizeof(int) * (count + 1));
+    int *neighbors = malloc(sizeof(int) * count * 12);
+    if (segments == NULL || offsets == NULL || neighbors == NULL) {
+        free(segments);
+        free(offsets);
+        free(neighbors);
+        return 1;
+    }
+
+    // 스무딩처럼 서로 붙어 있는 세그먼트들을 조회하는 경우를 흉내 내어 한 면의 연속 구간을 고른다.
+    const uint32_t segmentCount = (uint32_t) ((int64_t) n * n * GroupCount);
+    const uint32_t start = (uint32_t) (NextRandom() % segmentCount);
+    for (int i = 0; i < count; i++) {
+        segments[i] = (int) ((start + (uint32_t) i) % segmentCount);
+    }
+
+    int64_t mismatch = 0;
+    const int total = GetNeighborsOfSegmentIndexCsr(NULL, n, count, segments, 0, offsets, neighbors, count * 12);
+    for (int i = 0; i < count && total >= 0; i++) {
+        const NeighborSegIdList list = GetNeighborsOfSegmentIndex(n, segments[i]);
+        if (offsets[i + 1] - offsets[i] != list.count ||
+            memcmp(neighbors + offsets[i], list.neighborSegId, sizeof(int) * list.count) != 0) {
+            mismatch++;
+        }
+    }
+
+    const int dedupeTotal =
+            GetNeighborsOfSegmentIndexCsr(NULL, n, count, segments, 1, offsets, neighbors, count * 12);
+    const int dedupeSize = GetNeighborsOfSegmentIndexCsr(NULL, n, count, segments, 1, NULL, NULL, 0);
+    SegmentIndexSet seen;
+    InitSegmentIndexSet(&seen, dedupeTotal);
+    for (int i = 0; i < dedupeTotal; i++) {
+        if (!InsertSegmentIndexSet(&seen, (uint32_t) neighbors[i])) {
+            mismatch++;
+        }
+    }
+    FreeSegmentIndexSet(&seen);
+    if (total < 0 || dedupeTotal < 0 || dedupeSize != dedupeTotal) {
+        mismatch++;
+    }
+
+    int64_t checksum = 0;
+    double t0 = NowSeconds();
+    for (int i = 0; i < count; i++) {
+        const NeighborSegIdList list = GetNeighborsOfSegmentIndex(n, segments[i]);
+        for (int j = 0; j < list.count; j++) {
+            checksum += list.neighborSegId[j];
+        }
+    }
+    double t1 = NowSeconds();
+    checksum -= GetNeighborsOfSegmentIndexCsr(NULL, n, count, segments, 0, offsets, neighbors, count * 12);
+    double t2 = NowSeconds();
+    checksum -= GetNeighborsOfSegmentIndexCsr(NULL, n, count, segments, 1, offsets, neighbors, count * 12);
+    double t3 = NowSeconds();
+
+    printf("neighbor-csr: n=%d, %d segments, %d neighbors (%d unique), %lld mismatches (checksum %lld)\n", n, count,
+           total, dedupeTotal, (long long) mismatch, (long long) checksum);
+    printf("  single calls: %8.2f ns/segment\n", (t1 - t0) * 1e9 / count);
+    printf("  csr         : %8.2f ns/segment\n", (t2 - t1) * 1e9 / count);
+    printf("  csr dedupe  : %8.2f ns/segment\n", (t3 - t2) * 1e9 / count);
+
+    free(segments);
+    free(offsets);
+    free(neighbors);
+    return mismatch != 0;
+}
+
+// 직접 계산과 인접 표 조회를 같은 세그먼트 순서로 재서 조회당 시간을 돌려준다.
+static void MeasureAdjacencyLookup(int n, const AdjacencyTable *table, const int64_t *samples, int sampleCount,
+                                   double *outComputed, double *outTable, int64_t *checksum) {
+    double t0 = NowSeconds();
+    for (int i = 0; i < sampleCount; i++) {
+        *checksum += GetNeighborsOfSegmentIndex64(n, samples[i]).neighborSegId[0];
+    }
+    double t1 = NowSeconds();
+    for (int i = 0; i < sampleCount; i++) {
+        *checksum -= GetNeighborsFromAdjacencyTable64(table, samples[i]).neighborSegId[0];
+    }
+    double t2 = NowSeconds();
+    *outComputed = (t1 - t0) * 1e9 / sampleCount;
+    *outTable = (t2 - t1) * 1e9 / sampleCount;
+}
+
+// n의 인접 표 파일을 만들고 매핑해서, 모든 세그먼트의 이웃이 직접 계산한 결과와 같은지 확인하고
+// 무작위 순서와 순차 순서의 조회 속도를 직접 계산과 비교한다.
+static int RunAdjacencyTableForN(int n, const char *path) {
+    double t0 = NowSeconds();
+    const int writeResult = WriteAdjacencyTableFile(n, path);
+    double t1 = NowSeconds();
+    if (writeResult != ErrorCode_None) {
+        printf("adjacency-table: failed to write %s (%d)\n", path, writeResult);
+        return 1;
+    }
+
+    AdjacencyTable *table = OpenAdjacencyTable(path);
+    double t2 = NowSeconds();
+    if (table == NULL) {
+        printf("adjacency-table: failed to open %s\n", path);
+        return 1;
+    }
+
+    // 전체 확인이 모든 페이지를 한 번씩 건드리므로 아래 측정은 페이지 캐시에 올라온 상태에서 이뤄진다.
+    const int64_t segmentCount = (int64_t) n * n * GroupCount;
+    int64_t mismatch = 0;
+    for (int64_t i = 0; i < segmentCount; i++) {
+        const NeighborSegIdList64 computed = GetNeighborsOfSegmentIndex64(n, i);
+        const NeighborSegIdList64 loaded = GetNeighborsFromAdjacencyTable64(table, i);
+        if (computed.count != loaded.count ||
+            memcmp(computed.neighborSegId, loaded.neighborSegId, sizeof(int64_t) * computed.count) != 0) {
+            mismatch++;
+        }
+    }
+
+    const int sampleCount = 1000000;
+    int64_t *samples = malloc(sizeof(int64_t) * sampleCount);
+    if (samples == NULL) {
+        CloseAdjacencyTable(table);
+        return 1;
+    }
+
+    int64_t checksum = 0;
+    double randomComputed, randomTable, sequentialComputed, sequentialTable;
+    for (int i = 0; i < sampleCount; i++) {
+        samples[i] = (int64_t) (NextRandom() % (uint64_t) segmentCount);
+    }
+    MeasureAdjacencyLookup(n, table, samples, sampleCount, &randomComputed, &randomTable, &checksum);
+    for (int i = 0; i < sampleCount; i++) {
+        samples[i] = i % segmentCount;
+    }
+    MeasureAdjacencyLookup(n, table, samples, sampleCount, &sequentialComputed, &sequentialTable, &checksum);
+
+    printf("adjacency-table: n=%d, %lld segments, %d-byte slots, %.1f MiB, %lld mismatches (checksum %lld)\n", n,
+           (long long) segmentCount, GetAdjacencyTableSlotWidth(table),
+           (double) segmentCount * 12 * GetAdjacencyTableSlotWidth(table) / (1 << 20), (long long) mismatch,
+           (long long) checksum);
+    printf("  write     : %8.3f s\n", t1 - t0);
+    printf("  open      : %8.3f ms\n", (t2 - t1) * 1e3);
+    printf("  random    : computed %8.2f ns/op, table %8.2f ns/op (x%.2f)\n", randomComputed, randomTable,
+           randomComputed / randomTable);
+    printf("  sequential: computed %8.2f ns/op, table %8.2f ns/op (x%.2f)\n", sequentialComputed, sequentialTable,
+           sequentialComputed / sequentialTable);
+
+    free(samples);
+    CloseAdjacencyTable(table);
+    return mismatch != 0;
+}
+
+// n을 주지 않으면 표가 캐시에 들어가는 크기부터 주 메모리를 넘나드는 크기까지 차례로 잰다.
+static int RunAdjacencyTable(int n, const char *path) {
+    if (n > 0) {
+        return RunAdjacencyTableForN(n, path);
+    }
+
+    const int benchN[] = {16, 64, 256, 1024};
+    int failed = 0;
+    for (int i = 0; i < NELEMS(benchN); i++) {
+        failed |= RunAdjacencyTableForN(benchN[i], path);
+    }
+    return failed;
+}
+
+// 내부 세그먼트 빠른 경로가 일반 경로와 같은 이웃을 같은 순서로 주는지 몇 가지 n에서 모든 세그먼트로 확인하고,
+// 내부/경계 세그먼트의 처리량을 따로 잰다.
+static int RunNeighborInterior(int n) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1) {
+        printf("neighbor-interior: n out of range\n");
+        return 1;
+    }
+
+    const int checkN[] = {1, 2, 3, 4, 5, 7, 16, 33, 100};
+    int64_t mismatch = 0;
+    int64_t checkedCount = 0;
+    int64_t interiorCount = 0;
+    for (int k = 0; k < NELEMS(checkN); k++) {
+        const int cn = checkN[k];
+        for (int segGroup = 0; segGroup < GroupCount; segGroup++) {
+            for (int64_t local = 0; local < (int64_t) cn * cn; local++) {
+                const AbtCoords abt = SplitLocalSegmentIndexToAbt(cn, local);
+                const NeighborSegIdList64 general = GetNeighborsOfSegGroupAndAbtGeneral(cn, segGroup, abt);
+                const NeighborSegIdList64 actual = GetNeighborsOfSegGroupAndLocalSegIndex64(cn, segGroup, local);
+                if (general.count != actual.count ||
+                    memcmp(general.neighborSegId, actual.neighborSegId, sizeof(int64_t) * general.count) != 0) {
+                    mismatch++;
+                }
+                checkedCount++;
+                interiorCount += IsInteriorAbt(cn, abt);
+            }
+        }
+    }
+
+    // 내부와 경계 세그먼트를 따로 모아 잰다.
+    const int sampleCount = 1000000;
+    int64_t *interior = malloc(sizeof(int64_t) * sampleCount);
+    int64_t *boundary = malloc(sizeof(int64_t) * sampleCount);
+    if (interior == NULL || boundary == NULL) {
+        free(interior);
+        free(boundary);
+        return 1;
+    }
+    const int64_t segmentCount = (int64_t) n * n * GroupCount;
+    int interiorSamples = 0;
+    int boundarySamples = 0;
+    for (int tries = 0; tries < sampleCount * 64 && (interiorSamples < sampleCount || boundarySamples < sampleCount);
+         tries++) {
+        const int64_t segmentIndex = (int64_t) (NextRandom() % (uint64_t) segmentCount);
+        const SegGroupAndAbt sga = SplitSegIndexToSegGroupAndAbt64(n, segmentIndex);
+        if (IsInteriorAbt(n, sga.abt)) {
+            if (interiorSamples < sampleCount) {
+                interior[interiorSamples++] = segmentIndex;
+            }
+        } else if (boundarySamples < sampleCount) {
+            boundary[boundarySamples++] = segmentIndex;
+        }
+    }
+
+    const int64_t *sets[2] = {interior, boundary};
+    const int setCounts[2] = {interiorSamples, boundarySamples};
+    const char *setNames[2] = {"interior", "boundary"};
+    int64_t checksum = 0;
+    printf("neighbor-interior: %lld segments checked (%lld interior), %lld mismatches\n", (long long) checkedCount,
+           (long long) interiorCount, (long long) mismatch);
+    for (int k = 0; k < 2; k++) {
+        if (setCounts[k] == 0) {
+            printf("  %-8s: no samples at n=%d\n", setNames[k], n);
+            continue;
+        }
+        double t0 = NowSeconds();
+        for (int i = 0; i < setCounts[k]; i++) {
+            checksum += GetNeighborsOfSegmentIndex64(n, sets[k][i]).neighborSegId[11];
+        }
+        double t1 = NowSeconds();
+        for (int i = 0; i < setCounts[k]; i++) {
+            const SegGroupAndAbt sga = SplitSegIndexToSegGroupAndAbt64(n, sets[k][i]);
+            checksum -= GetNeighborsOfSegGroupAndAbtGeneral(n, sga.segGroup, sga.abt).neighborSegId[11];
+        }
+        double t2 = NowSeconds();
+        printf("  %-8s: %8.2f ns/op, general path %8.2f ns/op (x%.2f) at n=%d\n", setNames[k],
+               (t1 - t0) * 1e9 / setCounts[k], (t2 - t1) * 1e9 / setCounts[k], (t2 - t1) / (t1 - t0), n);
+    }
+    printf("  checksum %lld\n", (long long) checksum);
+
+    free(interior);
+    free(boundary);
+    return mismatch != 0;
+}
+
+// 이웃 조회를 반복하는 단순한 너비 우선 탐색으로 모든 세그먼트의 거리를 구한다. 작은 n의 검증용이다.
+static int *CalculateHopDistances(int n, int center) {
+    const int segmentCount = n * n * GroupCount;
+    int *distance = malloc(sizeof(int) * segmentCount);
+    int *queue = malloc(sizeof(int) * segmentCount);
+    if (distance == NULL || queue == NULL) {
+        free(distance);
+        free(queue);
+        return NULL;
+    }
+
+    for (int i = 0; i < segmentCount; i++) {
+        distance[i] = -1;
+    }
+    int head = 0;
+    int tail = 0;
+    distance[center] = 0;
+    queue[tail++] = center;
+    while (head < tail) {
+        const int current = queue[head++];
+        const NeighborSegIdList neighbors = GetNeighborsOfSegmentIndex(n, current);
+        for (int j = 0; j < neighbors.count; j++) {
+            if (distance[neighbors.neighborSegId[j]] < 0) {
+                distance[neighbors.neighborSegId[j]] = distance[current] + 1;
+                queue[tail++] = neighbors.neighborSegId[j];
+            }
+        }
+    }
+    free(queue);
+    return distance;
+}
+
+// k-ring/hollow ring 결과가 단순한 너비 우선 탐색 결과와 같은지 작은 n에서 확인하고,
+// 이웃 조회를 반복하며 집합으로 중복을 거르는 방식과 속도를 비교한다.
+static int RunKRing(int n, int k) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1 || k < 0) {
+        printf("k-ring: n or k out of range\n");
+        return 1;
+    }
+
+    const int checkN[] = {1, 2, 3, 5, 8, 13};
+    const int maxCheckK = 7;
+    int buffer[20 * 13 * 13];
+    int64_t buffer64[20 * 13 * 13];
+    int64_t mismatch = 0;
+    int64_t checkedCount = 0;
+    int maxInteriorCount[8] = {0};
+    for (int c = 0; c < NELEMS(checkN); c++) {
+        const int cn = checkN[c];
+        const int segmentCount = cn * cn * GroupCount;
+        for (int center = 0; center < segmentCount; center++) {
+            int *distance = CalculateHopDistances(cn, center);
+            if (distance == NULL) {
+                return 1;
+            }
+            const SegGroupAndAbt sga = SplitSegIndexToSegGroupAndAbt(cn, center);
+            for (int kk = 0; kk <= maxCheckK; kk++) {
+                for (int hollow = 0; hollow < 2; hollow++) {
+                    const int needed = hollow ? GetHollowRingOfSegmentIndex(cn, center, kk, NULL, 0)
+                                              : GetKRingOfSegmentIndex(cn, center, kk, NULL, 0);
+                    const int written = hollow ? GetHollowRingOfSegmentIndex(cn, center, kk, buffer, segmentCount)
+                                               : GetKRingOfSegmentIndex(cn, center, kk, buffer, segmentCount);
+                    const int64_t written64 = hollow ? GetHollowRingOfSegmentIndex64(cn, center, kk, buffer64,
+                                                                                     segmentCount)
+                                                     : GetKRingOfSegmentIndex64(cn, center, kk, buffer64,
+                                                                                segmentCount);
+                    int expected = 0;
+                    for (int i = 0; i < segmentCount; i++) {
+                        const int inRing = hollow ? distance[i] == kk : distance[i] <= kk;
+                        if (inRing) {
+                            // 결과는 오름차순이므로 expected번째 값과 바로 비교할 수 있다.
+                            if (expected >= written || buffer[expected] != i || buffer64[expected] != i) {
+                                mismatch++;
+                            }
+                            expected++;
+                        }
+                    }
+                    if (needed != expected || written != expected || written64 != expected) {
+                        mismatch++;
+                    }
+                    if (!hollow && IsKRingInsideSegGroup(cn, sga.abt, kk) && expected > maxInteriorCount[kk]) {
+                        maxInteriorCount[kk] = expected;
+                    }
+                    checkedCount++;
+                }
+            }
+            free(distance);
+        }
+    }
+    if (GetKRingOfSegmentIndex(3, 0, 2, buffer, 1) != ErrorCode_BufferTooSmall ||
+        GetKRingOfSegmentIndex(3, 0, -1, buffer, 1) != ErrorCode_ArgumentOutOfRangeException ||
+        GetKRingOfSegmentIndex(3, 180, 1, buffer, 1) != ErrorCode_ArgumentOutOfRangeException) {
+        mismatch++;
+    }
+
+    printf("k-ring: %lld rings checked, %lld mismatches, interior k-ring sizes", (long long) checkedCount,
+           (long long) mismatch);
+    for (int kk = 0; kk <= maxCheckK; kk++) {
+        printf(" %d", maxInteriorCount[kk]);
+    }
+    printf("\n");
+
+    // 같은 결과를 이웃 조회 반복 + 집합 중복 제거로 구하는 경우와 비교한다.
+    const int sampleCount = 2000;
+    const int capacity = 12 * k * k + 12 * k + 1;
+    int *ring = malloc(sizeof(int) * capacity);
+    int *frontier = malloc(sizeof(int) * capacity);
+    if (ring == NULL || frontier == NULL) {
+        free(ring);
+        free(frontier);
+        return 1;
+    }
+    const uint32_t segmentCount = (uint32_t) ((int64_t) n * n * GroupCount);
+    int64_t checksum = 0;
+    int64_t totalSize = 0;
+    uint64_t seed = NextRandom();
+    double t0 = NowSeconds();
+    for (int i = 0; i < sampleCount; i++) {
+        const int center = (int) (uint32_t) ((seed + (uint64_t) i * 2654435761u) % segmentCount);
+        const int count = GetKRingOfSegmentIndex(n, center, k, ring, capacity);
+        totalSize += count;
+        checksum += count > 0 ? (uint32_t) ring[count - 1] : count;
+    }
+    double t1 = NowSeconds();
+    for (int i = 0; i < sampleCount; i++) {
+        const int center = (int) (uint32_t) ((seed + (uint64_t) i * 2654435761u) % segmentCount);
+        SegmentIndexSet seen;
+        InitSegmentIndexSet(&seen, capacity);
+        InsertSegmentIndexSet(&seen, (uint32_t) center);
+        int found = 1;
+        int ringStart = 0;
+        frontier[0] = center;
+        for (int d = 0; d < k; d++) {
+            const int ringEnd = found;
+            for (int j = ringStart; j < ringEnd; j++) {
+                const NeighborSegIdList neighbors = GetNeighborsOfSegmentIndex(n, frontier[j]);
+                for (int m = 0; m < neighbors.count; m++) {
+                    if (InsertSegmentIndexSet(&seen, (uint32_t) neighbors.neighborSegId[m]) && found < capacity) {
+                        frontier[found++] = neighbors.neighborSegId[m];
+                    }
+                }
+            }
+            ringStart = ringEnd;
+        }
+        uint32_t maxIndex = 0;
+        for (int j = 0; j < found; j++) {
+            maxIndex = (uint32_t) frontier[j] > maxIndex ? (uint32_t) frontier[j] : maxIndex;
+        }
+        checksum -= maxIndex;
+        FreeSegmentIndexSet(&seen);
+    }
+    double t2 = NowSeconds();
+
+    printf("  n=%d k=%d, %.1f segments per ring (checksum %lld)\n", n, k, (double) totalSize / sampleCount,
+           (long long) checksum);
+    printf("  k-ring         : %10.2f us/ring, %6.2f ns/segment\n", (t1 - t0) * 1e6 / sampleCount,
+           (t1 - t0) * 1e9 / totalSize);
+    printf("  neighbor + set : %10.2f us/ring, %6.2f ns/segment\n", (t2 - t1) * 1e6 / sampleCount,
+           (t2 - t1) * 1e9 / totalSize);
+
+    free(ring);
+    free(frontier);
+    return mismatch != 0;
+}
+
+// 검증용 폴리곤. center를 중심으로 한 별 모양 외곽선(반지름 radius)과, 그 안의 별 모양 구멍 하나.
+typedef struct {
+    Vector3 center;
+    Vector3 e1;
+    Vector3 e2;
+    GpsCoords vertices[48];
+    int ringVertexCounts[2];
+    int ringCount;
+} TestPolygon;
+
+static Vector3 OffsetOnSphere(const TestPolygon *polygon, double distance, double bearing) {
+    const Vector3 dir = AddVector3(ScalarMultiplyVector(cos(bearing), polygon->e1),
+                                   ScalarMultiplyVector(sin(bearing), polygon->e2));
+    return AddVector3(ScalarMultiplyVector(cos(distance), polygon->center), ScalarMultiplyVector(sin(distance), dir));
+}
+
+static GpsCoords ToLatLng(Vector3 v) {
+    return (GpsCoords) {.lat = asin(fmax(-1, fmin(1, v.y))), .lng = atan2(v.z, v.x)};
+}
+
+static void MakeTestPolygon(TestPolygon *polygon, double radius, int withHole) {
+    const GpsCoords c = NextRandomLatLng();
+    polygon->center = CalculateUnitSpherePosition(c.lat, c.lng);
+    const Vector3 helper = fabs(polygon->center.y) < 0.9 ? (Vector3) {0, 1, 0} : (Vector3) {1, 0, 0};
+    polygon->e1 = NormalizeVector3(Cross(polygon->center, helper));
+    polygon->e2 = Cross(polygon->center, polygon->e1);
+
+    const int outerCount = 32;
+    const int holeCount = withHole ? 16 : 0;
+    for (int i = 0; i < outerCount; i++) {
+        const double r = radius * (0.4 + 0.6 * NextRandomUnit());
+        polygon->vertices[i] = ToLatLng(OffsetOnSphere(polygon, r, 2 * M_PI * i / outerCount));
+    }
+    // 구멍은 반대 방향으로 돈다. 짝-홀 규칙이므로 방향은 결과에 영향이 없다.
+    for (int i = 0; i < holeCount; i++) {
+        const double r = radius * (0.1 + 0.2 * NextRandomUnit());
+        polygon->vertices[outerCount + i] = ToLatLng(OffsetOnSphere(polygon, r, -2 * M_PI * i / holeCount));
+    }
+    polygon->ringVertexCounts[0] = outerCount;
+    polygon->ringVertexCounts[1] = holeCount;
+    polygon->ringCount = withHole ? 2 : 1;
+}
+
+// 폴리곤 중심의 접평면으로 중심 투영한 좌표. 대원 호가 직선이 되므로 평면에서 검사할 수 있다.
+static int ProjectToTestPlane(const TestPolygon *polygon, Vector3 v, double *x, double *y) {
+    const double d = Dot(v, polygon->center);
+    if (d <= 0.1) {
+        return 0;
+    }
+    *x = Dot(v, polygon->e1) / d;
+    *y = Dot(v, polygon->e2) / d;
+    return 1;
+}
+
+static int IsInsideTestPolygonPlane(const double *px, const double *py, const TestPolygon *polygon, double x,
+                                    double y) {
+    int inside = 0;
+    int offset = 0;
+    for (int r = 0; r < polygon->ringCount; r++) {
+        const int count = polygon->ringVertexCounts[r];
+        for (int i = 0; i < count; i++) {
+            const int j = offset + (i + 1) % count;
+            if ((py[offset + i] <= y) != (py[j] <= y) &&
+                x < px[offset + i] + (y - py[offset + i]) * (px[j] - px[offset + i]) / (py[j] - py[offset + i])) {
+                inside = !inside;
+            }
+        }
+        offset += count;
+    }
+    return inside;
+}
+
+static int SegmentsIntersect2D(double ax, double ay, double bx, double by, double cx, double cy, double dx,
+                               double dy) {
+    const double d1 = (dx - cx) * (ay - cy) - (dy - cy) * (ax - cx);
+    const double d2 = (dx - cx) * (by - cy) - (dy - cy) * (bx - cx);
+    const double d3 = (bx - ax) * (cy - ay) - (by - ay) * (cx - ax);
+    const double d4 = (bx - ax) * (dy - ay) - (by - ay) * (dx - ax);
+    return ((d1 > 0) != (d2 > 0)) && ((d3 > 0) != (d4 > 0));
+}
+
+// 세그먼트를 하나씩 검사하는 기준 구현. 중심이 폴리곤 안에 있는지, 또는 세그먼트 삼각형이 폴리곤과 겹치는지 본다.
+// 판단할 수 없으면 -1을 반환한다.
+static int IsSegmentInTestPolygon(const TestPolygon *polygon, const double *px, const double *py, int n,
+                                  int64_t segmentIndex, int mode) {
+    double x, y;
+    if (!ProjectToTestPlane(polygon, CalculateSegmentCenter64(n, segmentIndex), &x, &y)) {
+        return 0;
+    }
+    if (IsInsideTestPolygonPlane(px, py, polygon, x, y)) {
+        return 1;
+    }
+    if (mode == PolygonFillMode_Center) {
+        return 0;
+    }
+
+    const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng64(n, segmentIndex);
+    double cx[3], cy[3];
+    for (int k = 0; k < 3; k++) {
+        const Vector3 v = CalculateUnitSpherePosition(corners.points[k].lat, corners.points[k].lng);
+        if (!ProjectToTestPlane(polygon, v, &cx[k], &cy[k])) {
+            // 큰 세그먼트가 접평면에 다 들어오지 않으면 판단하지 않는다.
+            return -1;
+        }
+        if (IsInsideTestPolygonPlane(px, py, polygon, cx[k], cy[k])) {
+            return 1;
+        }
+    }
+    int offset = 0;
+    for (int r = 0; r < polygon->ringCount; r++) {
+        const int count = polygon->ringVertexCounts[r];
+        for (int i = 0; i < count; i++) {
+            const int j = offset + (i + 1) % count;
+            for (int k = 0; k < 3; k++) {
+                if (SegmentsIntersect2D(px[offset + i], py[offset + i], px[j], py[j], cx[k], cy[k], cx[(k + 1) % 3],
+                                        cy[(k + 1) % 3])) {
+                    return 1;
+                }
+            }
+            // 폴리곤 꼭짓점이 세그먼트 안에 있는 경우 (세그먼트보다 작은 폴리곤)
+            const double s0 = (cx[1] - cx[0]) * (py[offset + i] - cy[0]) - (cy[1] - cy[0]) * (px[offset + i] - cx[0]);
+            const double s1 = (cx[2] - cx[1]) * (py[offset + i] - cy[1]) - (cy[2] - cy[1]) * (px[offset + i] - cx[1]);
+            const double s2 = (cx[0] - cx[2]) * (py[offset + i] - cy[2]) - (cy[0] - cy[2]) * (px[offset + i] - cx[2]);
+            if ((s0 > 0 && s1 > 0 && s2 > 0) || (s0 < 0 && s1 < 0 && s2 < 0)) {
+                return 1;
+            }
+        }
+        offset += count;
+    }
     return 0;
-}
\ No newline at end of file
+}
+
+// 폴리곤 채우기 결과를 모든 세그먼트를 하나씩 검사한 결과와 비교하고, 나눠 받은 결과가 한 번에 받은 결과와 같은지 확인한다.
+static int RunPolygonFill(int n) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1) {
+        printf("polygon-fill: n out of range\n");
+        return 1;
+    }
+
+    const int checkN[] = {1, 3, 16, 64, 150};
+    const double radii[] = {0.002, 0.05, 0.3, 0.8};
+    int64_t missing = 0;
+    int64_t extra = 0;
+    int64_t unknown = 0;
+    int64_t mismatch = 0;
+    int64_t checkedCount = 0;
+    int64_t filledCount = 0;
+    for (int c = 0; c < NELEMS(checkN); c++) {
+        const int cn = checkN[c];
+        const int64_t segmentCount = (int64_t) cn * cn * GroupCount;
+        int *full = malloc(sizeof(int) * segmentCount);
+        int64_t *full64 = malloc(sizeof(int64_t) * segmentCount);
+        int *pieces = malloc(sizeof(int) * segmentCount);
+        signed char *expected = malloc((size_t) segmentCount);
+        for (int trial = 0; trial < 24; trial++) {
+            TestPolygon polygon;
+            MakeTestPolygon(&polygon, radii[trial % NELEMS(radii)], trial % 3 != 0);
+            double px[48], py[48];
+            for (int i = 0; i < polygon.ringVertexCounts[0] + polygon.ringVertexCounts[1]; i++) {
+                ProjectToTestPlane(&polygon, CalculateUnitSpherePosition(polygon.vertices[i].lat,
+                                                                         polygon.vertices[i].lng), &px[i], &py[i]);
+            }
+
+            for (int mode = 0; mode < 2; mode++) {
+                int64_t cursor = 0;
+                const int needed = GetSegmentIndicesInPolygon(cn, polygon.vertices, polygon.ringVertexCounts,
+                                                              polygon.ringCount, mode, &cursor, NULL, 0);
+                const int count = GetSegmentIndicesInPolygon(cn, polygon.vertices, polygon.ringVertexCounts,
+                                                             polygon.ringCount, mode, &cursor, full,
+                                                             (int) segmentCount);
+                int64_t cursor64 = 0;
+                const int64_t count64 = GetSegmentIndicesInPolygon64(cn, polygon.vertices, polygon.ringVertexCounts,
+                                                                     polygon.ringCount, mode, &cursor64, full64,
+                                                                     segmentCount);
+                if (needed != count || count != count64 || cursor != -1 || cursor64 != -1) {
+                    mismatch++;
+                    continue;
+                }
+
+                // 작은 버퍼로 이어 받기
+                int pieceCount = 0;
+                int64_t pieceCursor = 0;
+                while (pieceCursor != -1 && pieceCount <= count) {
+                    const int written = GetSegmentIndicesInPolygon(cn, polygon.vertices, polygon.ringVertexCounts,
+                                                                   polygon.ringCount, mode, &pieceCursor,
+                                                                   pieces + pieceCount, 7);
+                    if (written < 0) {
+                        break;
+                    }
+                    pieceCount += written;
+                }
+
+                memset(expected, 0, (size_t) segmentCount);
+                for (int64_t i = 0; i < segmentCount; i++) {
+                    expected[i] = (signed char) IsSegmentInTestPolygon(&polygon, px, py, cn, i, mode);
+                }
+                for (int i = 0; i < count; i++) {
+                    if (full64[i] != full[i] || (i > 0 && full[i] <= full[i - 1]) || pieces[i] != full[i]) {
+                        mismatch++;
+                    }
+                    if (expected[full[i]] == 0) {
+                        extra++;
+                    }
+                    expected[full[i]] = 2;
+                }
+                for (int64_t i = 0; i < segmentCount; i++) {
+                    missing += expected[i] == 1;
+                    unknown += expected[i] < 0;
+                }
+                mismatch += pieceCount != count;
+                filledCount += count;
+                checkedCount++;
+            }
+        }
+        free(full);
+        free(full64);
+        free(pieces);
+        free(expected);
+    }
+
+    printf("polygon-fill: %lld fills checked, %lld segments, %lld missing, %lld extra, %lld mismatches "
+           "(%lld segments too large to check)\n", (long long) checkedCount, (long long) filledCount,
+           (long long) missing, (long long) extra, (long long) mismatch, (long long) unknown);
+
+    // 덮는 넓이에 비례하는지 보기 위해 크기를 바꿔 가며 잰다.
+    const double benchRadii[] = {0.01, 0.03, 0.1};
+    int *out = malloc(sizeof(int) * 4000000);
+    for (int i = 0; i < NELEMS(benchRadii) && out != NULL; i++) {
+        TestPolygon polygon;
+        MakeTestPolygon(&polygon, benchRadii[i], 1);
+        for (int mode = 0; mode < 2; mode++) {
+            int64_t cursor = 0;
+            double t0 = NowSeconds();
+            const int count = GetSegmentIndicesInPolygon(n, polygon.vertices, polygon.ringVertexCounts,
+                                                         polygon.ringCount, mode, &cursor, out, 4000000);
+            double t1 = NowSeconds();
+            printf("  n=%d radius %.2f %-7s: %8d segments, %8.3f ms, %6.2f ns/segment\n", n, benchRadii[i],
+                   mode == PolygonFillMode_Center ? "center" : "overlap", count, (t1 - t0) * 1e3,
+                   (t1 - t0) * 1e9 / (count > 0 ? count : 1));
+        }
+    }
+
+    // 나라 경계처럼 꼭짓점이 많은 외곽선. 행마다 그 행에 걸친 변만 보면 시간이 꼭짓점 수에 덜 민감하다.
+    const int detailedCount = 20000;
+    GpsCoords *detailed = malloc(sizeof(GpsCoords) * detailedCount);
+    if (out != NULL && detailed != NULL) {
+        TestPolygon frame;
+        MakeTestPolygon(&frame, 0.1, 0);
+        for (int i = 0; i < detailedCount; i++) {
+            const double r = 0.1 * (0.9 + 0.1 * NextRandomUnit());
+            detailed[i] = ToLatLng(OffsetOnSphere(&frame, r, 2 * M_PI * i / detailedCount));
+        }
+        for (int mode = 0; mode < 2; mode++) {
+            int64_t cursor = 0;
+            double t0 = NowSeconds();
+            const int count = GetSegmentIndicesInPolygon(n, detailed, &detailedCount, 1, mode, &cursor, out, 4000000);
+            double t1 = NowSeconds();
+            printf("  n=%d %d vertices %-7s: %8d segments, %8.3f ms, %6.2f ns/segment\n", n, detailedCount,
+                   mode == PolygonFillMode_Center ? "center" : "overlap", count, (t1 - t0) * 1e3,
+                   (t1 - t0) * 1e9 / (count > 0 ? count : 1));
+        }
+    }
+    free(detailed);
+    free(out);
+    return missing != 0 || extra != 0 || mismatch != 0;
+}
+
+// 캡 중심에서 구면 삼각형까지의 각거리. 삼각 함수로 직접 계산하는 검증용 구현이다.
+static double AngularDistanceToTriangle(Vector3 c, const Vector3 *corners) {
+    const double orientation = Dot(corners[0], Cross(corners[1], corners[2])) < 0 ? -1 : 1;
+    int inside = 1;
+    for (int i = 0; i < 3; i++) {
+        inside &= orientation * Dot(c, Cross(corners[i], corners[(i + 1) % 3])) >= 0;
+    }
+    if (inside) {
+        return 0;
+    }
+
+    double best = M_PI;
+    for (int i = 0; i < 3; i++) {
+        const Vector3 p = corners[i];
+        const Vector3 q = corners[(i + 1) % 3];
+        best = fmin(best, acos(fmax(-1, fmin(1, Dot(c, p)))));
+        const Vector3 m = NormalizeVector3(Cross(p, q));
+        if (Dot(Cross(p, c), m) >= 0 && Dot(Cross(c, q), m) >= 0) {
+            best = fmin(best, asin(fmin(1, fabs(Dot(c, m)))));
+        }
+    }
+    return best;
+}
+
+// 캡 질의 결과를 모든 세그먼트의 각거리를 직접 잰 결과와 비교하고, k-ring으로 후보를 뽑아 중심을 거르는 방식과 속도를 비교한다.
+static int RunCap(int n) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1) {
+        printf("cap: n out of range\n");
+        return 1;
+    }
+
+    const int checkN[] = {1, 2, 5, 16, 64, 200};
+    const double radii[] = {0, 1e-4, 0.01, 0.1, 0.5, 1.2, 2.0, 3.2};
+    int64_t missing = 0;
+    int64_t extra = 0;
+    int64_t mismatch = 0;
+    int64_t checkedCount = 0;
+    int64_t capSegmentCount = 0;
+    for (int ci = 0; ci < NELEMS(checkN); ci++) {
+        const int cn = checkN[ci];
+        const int segmentCount = cn * cn * GroupCount;
+        int *out = malloc(sizeof(int) * segmentCount);
+        int64_t *out64 = malloc(sizeof(int64_t) * segmentCount);
+        signed char *expected = malloc((size_t) segmentCount);
+        for (int trial = 0; trial < 16; trial++) {
+            const GpsCoords ll = NextRandomLatLng();
+            const Vector3 c = CalculateUnitSpherePosition(ll.lat, ll.lng);
+            const double radius = radii[trial % NELEMS(radii)];
+            for (int mode = 0; mode < 2; mode++) {
+                for (int i = 0; i < segmentCount; i++) {
+                    if (mode == CapQueryMode_Exact) {
+                        const Vector3 center = CalculateSegmentCenter64(cn, i);
+                        expected[i] = acos(fmax(-1, fmin(1, Dot(center, c)))) <= radius;
+                    } else {
+                        const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng64(cn, i);
+                        Vector3 v[3];
+                        for (int k = 0; k < 3; k++) {
+                            v[k] = CalculateUnitSpherePosition(corners.points[k].lat, corners.points[k].lng);
+                        }
+                        expected[i] = AngularDistanceToTriangle(c, v) <= radius;
+                    }
+                }
+
+                const int needed = GetSegmentIndicesInCap(cn, ll.lat, ll.lng, radius, mode, NULL, 0);
+                const int count = GetSegmentIndicesInCap(cn, ll.lat, ll.lng, radius, mode, out, segmentCount);
+                const int64_t count64 = GetSegmentIndicesInCap64(cn, ll.lat, ll.lng, radius, mode, out64,
+                                                                 segmentCount);
+                if (count < 0 || needed != count || count64 != count) {
+                    mismatch++;
+                    continue;
+                }
+                for (int i = 0; i < count; i++) {
+                    if (out64[i] != out[i] || (i > 0 && out[i] <= out[i - 1])) {
+                        mismatch++;
+                    }
+                    extra += expected[out[i]] == 0;
+                    expected[out[i]] = 2;
+                }
+                for (int i = 0; i < segmentCount; i++) {
+                    missing += expected[i] == 1;
+                }
+                capSegmentCount += count;
+                checkedCount++;
+            }
+        }
+        free(out);
+        free(out64);
+        free(expected);
+    }
+    printf("cap: %lld caps checked, %lld segments, %lld missing, %lld extra, %lld mismatches\n",
+           (long long) checkedCount, (long long) capSegmentCount, (long long) missing, (long long) extra,
+           (long long) mismatch);
+
+    // k-ring으로 후보를 넉넉히 뽑고 중심 위경도로 거리를 재서 거르는 방식과 비교한다.
+    const double earthRadius = 6371008.8;
+    const double benchMeters[] = {500, 5000, 50000};
+    const double hopAngle = 1.1071487 / n * 0.5;
+    for (int i = 0; i < NELEMS(benchMeters); i++) {
+        const double radius = benchMeters[i] / earthRadius;
+        const int k = (int) ceil(radius / hopAngle) + 1;
+        const int ringCapacity = 6 * k * k + 6 * k + 1;
+        const int capCapacity = ringCapacity;
+        int *ring = malloc(sizeof(int) * ringCapacity);
+        int *out = malloc(sizeof(int) * capCapacity);
+        const int sampleCount = benchMeters[i] > 10000 ? 20 : 200;
+        int64_t total = 0;
+        int64_t filtered = 0;
+        double capTime = 0;
+        double ringTime = 0;
+        for (int s = 0; s < sampleCount && ring != NULL && out != NULL; s++) {
+            const GpsCoords ll = NextRandomLatLng();
+            double t0 = NowSeconds();
+            const int count = GetSegmentIndicesInCap(n, ll.lat, ll.lng, radius, CapQueryMode_Exact, out,
+                                                     capCapacity);
+            double t1 = NowSeconds();
+            const int center = CalculateSegmentIndexFromLatLng(n, ll.lat, ll.lng);
+            const int ringCount = GetKRingOfSegmentIndex(n, center, k, ring, ringCapacity);
+            const Vector3 c = CalculateUnitSpherePosition(ll.lat, ll.lng);
+            for (int j = 0; j < ringCount; j++) {
+                const double lat = CalculateSegmentCenterLat(n, ring[j]);
+                const double lng = CalculateSegmentCenterLng(n, ring[j]);
+                filtered += acos(fmin(1, Dot(CalculateUnitSpherePosition(lat, lng), c))) <= radius;
+            }
+            double t2 = NowSeconds();
+            total += count;
+            capTime += t1 - t0;
+            ringTime += t2 - t1;
+        }
+        printf("  n=%d radius %6.0f m: %8.1f segments, cap %9.2f us (%5.2f ns/segment), k-ring + filter %9.2f us "
+               "(%lld filtered)\n", n, benchMeters[i], (double) total / sampleCount, capTime * 1e6 / sampleCount,
+               capTime * 1e9 / (total > 0 ? total : 1), ringTime * 1e6 / sampleCount, (long long) (filtered - total));
+        free(ring);
+        free(out);
+    }
+    return missing != 0 || extra != 0 || mismatch != 0;
+}
+
+typedef struct {
+    double minLat, minLng, maxLat, maxLng;
+} TestBox;
+
+// 위경도로 직접 비교하는 검증용 구현. 경계에서 eps 안쪽이면 판단하지 않는다(-1).
+static int IsLatLngInTestBox(double lat, double lng, const TestBox *box, double eps) {
+    const double width = box->maxLng >= box->minLng ? box->maxLng - box->minLng
+                                                    : box->maxLng - box->minLng + 2 * M_PI;
+    double offset = lng - box->minLng;
+    offset -= 2 * M_PI * floor(offset / (2 * M_PI));
+    const double latMargin = fmin(lat - box->minLat, box->maxLat - lat);
+    // 극 근처에서는 경도가 의미를 잃는다.
+    const double lngMargin = width >= 2 * M_PI || fabs(lat) > M_PI / 2 - eps
+                             ? INFINITY
+                             : fmin(fmin(offset, 2 * M_PI - offset), fabs(width - offset)) * cos(lat);
+    if (fabs(latMargin) < eps || lngMargin < eps) {
+        return -1;
+    }
+    return latMargin > 0 && (width >= 2 * M_PI || offset <= width);
+}
+
+// 세그먼트 삼각형 위의 점들을 무게중심 좌표로 고르게 뽑아 하나라도 상자에 드는지 본다.
+// 0: 드는 점 없음, 1: 있음, -1: 경계에 너무 가까운 점만 있음
+static int SampleTriangleInTestBox(const Vector3 *v, const TestBox *box, int steps) {
+    int result = 0;
+    for (int i = 0; i <= steps; i++) {
+        for (int j = 0; i + j <= steps; j++) {
+            const double wa = (double) i / steps;
+            const double wb = (double) j / steps;
+            const Vector3 p = AddVector3(ScalarMultiplyVector(1 - wa - wb, v[0]),
+                                         AddVector3(ScalarMultiplyVector(wa, v[1]), ScalarMultiplyVector(wb, v[2])));
+            const double lat = asin(fmax(-1, fmin(1, p.y / sqrt(SqrMagnitude(p)))));
+            const int inside = IsLatLngInTestBox(lat, atan2(p.z, p.x), box, 1e-9);
+            if (inside == 1) {
+                return 1;
+            }
+            result = inside < 0 ? -1 : result;
+        }
+    }
+    return result;
+}
+
+// 두 대원 호(각각 반원보다 짧은)가 만나는지 본다.
+static int ArcsIntersect(Vector3 a, Vector3 b, Vector3 c, Vector3 d) {
+    const Vector3 n1 = Cross(a, b);
+    const Vector3 n2 = Cross(c, d);
+    return Dot(c, n1) * Dot(d, n1) <= 0 && Dot(a, n2) * Dot(b, n2) <= 0 && Dot(AddVector3(a, b), AddVector3(c, d)) > 0;
+}
+
+// 상자 경계가 세그먼트 삼각형을 지나는지 본다. 자오선 변은 호끼리 교차로 정확히 보고, 위도선 변은 점들을 고르게 뽑아
+// 삼각형 안에 드는지 본다. 가는 상자가 큰 세그먼트를 가로지르는 경우는 삼각형 쪽 표본으로는 잡히지 않는다.
+static int SampleTestBoxBoundaryInTriangle(const Vector3 *v, const TestBox *box, int steps) {
+    const double width = box->maxLng >= box->minLng ? box->maxLng - box->minLng
+                                                    : box->maxLng - box->minLng + 2 * M_PI;
+    const double orientation = Dot(v[0], Cross(v[1], v[2])) < 0 ? -1 : 1;
+    if (box->maxLat - box->minLat < 3) {
+        for (int side = 0; side < 2; side++) {
+            const double lng = box->minLng + side * width;
+            const Vector3 from = CalculateUnitSpherePosition(box->minLat, lng);
+            const Vector3 to = CalculateUnitSpherePosition(box->maxLat, lng);
+            for (int e = 0; e < 3; e++) {
+                if (ArcsIntersect(from, to, v[e], v[(e + 1) % 3])) {
+                    return 1;
+                }
+            }
+        }
+    }
+    for (int i = 0; i <= steps; i++) {
+        const double u = (double) i / steps;
+        const GpsCoords points[4] = {
+                {box->minLat, box->minLng + u * width},
+                {box->maxLat, box->minLng + u * width},
+                {box->minLat + u * (box->maxLat - box->minLat), box->minLng},
+                {box->minLat + u * (box->maxLat - box->minLat), box->minLng + width},
+        };
+        for (int k = 0; k < 4; k++) {
+            const Vector3 p = CalculateUnitSpherePosition(points[k].lat, points[k].lng);
+            int inside = 1;
+            for (int e = 0; e < 3; e++) {
+                inside &= orientation * Dot(p, Cross(v[e], v[(e + 1) % 3])) >= -1e-12;
+            }
+            if (inside) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+static TestBox NextRandomTestBox(void) {
+    const double halfSizes[] = {1e-3, 0.05, 0.3, 1.0, 2.0};
+    const GpsCoords center = NextRandomLatLng();
+    const double halfLat = halfSizes[NextRandom() % NELEMS(halfSizes)] * NextRandomUnit();
+    const double halfLng = halfSizes[NextRandom() % NELEMS(halfSizes)] * 2 * NextRandomUnit();
+    double minLng = center.lng - halfLng;
+    double maxLng = center.lng + halfLng;
+    minLng += minLng < -M_PI ? 2 * M_PI : 0;
+    maxLng -= maxLng > M_PI ? 2 * M_PI : 0;
+    return (TestBox) {
+            .minLat = fmax(-M_PI / 2, center.lat - halfLat),
+            .minLng = minLng,
+            .maxLat = fmin(M_PI / 2, center.lat + halfLat),
+            .maxLng = maxLng,
+    };
+}
+
+// 위경도 상자 질의 결과를 세그먼트마다 위경도로 직접 비교한 결과와 맞춰 보고, 작은 버퍼로 나눠 받은 결과가 같은지,
+// 큰 n에서 고정 크기 버퍼로 흘려받는 속도를 잰다.
+static int RunLatLngBox(int n) {
+    if (n < 1) {
+        printf("latlng-box: n out of range\n");
+        return 1;
+    }
+
+    const TestBox specialBoxes[] = {
+            {0.2, 3.0, 0.5, -3.0},                  // 날짜변경선을 건넌다
+            {1.2, -M_PI, M_PI / 2, M_PI},           // 북극 모자
+            {-M_PI / 2, 1.0, -1.3, 2.0},            // 남극까지 닿는 부채꼴
+            {-0.1, -M_PI, 0.1, M_PI},               // 적도 띠
+            {-M_PI / 2, -M_PI, M_PI / 2, M_PI},     // 전체
+            {-0.5, 0.5, 0.7, 0.4},                  // 경도 폭이 2 pi에 가까운 상자
+            {0, -1.0, 0.3, 2.5},                    // 위도 0에서 시작, 경도 폭 > pi
+            {-1.0, 0.3, 0.0, 0.3},                  // 자오선 하나
+    };
+    const int checkN[] = {1, 2, 5, 16, 64, 200};
+    int64_t missing = 0;
+    int64_t extra = 0;
+    int64_t mismatch = 0;
+    int64_t unknown = 0;
+    int64_t checkedCount = 0;
+    int64_t boxSegmentCount = 0;
+    for (int ci = 0; ci < NELEMS(checkN); ci++) {
+        const int cn = checkN[ci];
+        const int segmentCount = cn * cn * GroupCount;
+        int *out = malloc(sizeof(int) * segmentCount);
+        int64_t *out64 = malloc(sizeof(int64_t) * segmentCount);
+        int *pieces = malloc(sizeof(int) * segmentCount);
+        signed char *expected = malloc((size_t) segmentCount);
+        for (int trial = 0; trial < 24; trial++) {
+            const TestBox box = trial < NELEMS(specialBoxes) ? specialBoxes[trial] : NextRandomTestBox();
+            for (int mode = 0; mode < 2; mode++) {
+                for (int i = 0; i < segmentCount; i++) {
+                    if (mode == PolygonFillMode_Center) {
+                        const Vector3 c = CalculateSegmentCenter64(cn, i);
+                        expected[i] = (signed char) IsLatLngInTestBox(asin(c.y / sqrt(SqrMagnitude(c))),
+                                                                      atan2(c.z, c.x), &box, 1e-9);
+                    } else {
+                        const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng64(cn, i);
+                        Vector3 v[3];
+                        for (int k = 0; k < 3; k++) {
+                            v[k] = CalculateUnitSpherePosition(corners.points[k].lat, corners.points[k].lng);
+                        }
+                        expected[i] = (signed char) SampleTriangleInTestBox(v, &box, cn <= 16 ? 24 : 6);
+                    }
+                }
+
+                int64_t cursor = 0;
+                const int needed = GetSegmentIndicesInLatLngBox(cn, box.minLat, box.minLng, box.maxLat, box.maxLng,
+                                                                mode, &cursor, NULL, 0);
+                const int count = GetSegmentIndicesInLatLngBox(cn, box.minLat, box.minLng, box.maxLat, box.maxLng,
+                                                               mode, &cursor, out, segmentCount);
+                int64_t cursor64 = 0;
+                const int64_t count64 = GetSegmentIndicesInLatLngBox64(cn, box.minLat, box.minLng, box.maxLat,
+                                                                       box.maxLng, mode, &cursor64, out64,
+                                                                       segmentCount);
+                if (count < 0 || needed != count || count64 != count || cursor != -1 || cursor64 != -1) {
+                    mismatch++;
+                    continue;
+                }
+
+                // 작은 버퍼로 나눠 받아도 같아야 한다.
+                int pieceCount = 0;
+                cursor = 0;
+                while (cursor != -1) {
+                    const int got = GetSegmentIndicesInLatLngBox(cn, box.minLat, box.minLng, box.maxLat, box.maxLng,
+                                                                 mode, &cursor, pieces + pieceCount, 7);
+                    if (got < 0 || pieceCount + got > count) {
+                        mismatch++;
+                        break;
+                    }
+                    pieceCount += got;
+                }
+                mismatch += pieceCount != count || memcmp(pieces, out, sizeof(int) * count) != 0;
+
+                for (int i = 0; i < count; i++) {
+                    if (out64[i] != out[i] || (i > 0 && (unsigned) out[i] <= (unsigned) out[i - 1])) {
+                        mismatch++;
+                    }
+                    if (expected[out[i]] == 0 && mode == PolygonFillMode_Overlap) {
+                        // 상자에 살짝 걸친 세그먼트는 촘촘하게 다시 본다. 그래도 없으면 판단하지 않는다.
+                        const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng64(cn, out[i]);
+                        Vector3 v[3];
+                        for (int k = 0; k < 3; k++) {
+                            v[k] = CalculateUnitSpherePosition(corners.points[k].lat, corners.points[k].lng);
+                        }
+                        expected[out[i]] = (signed char) (SampleTestBoxBoundaryInTriangle(v, &box, 20000)
+                                                          ? 1 : SampleTriangleInTestBox(v, &box, 400));
+                    }
+                    extra += expected[out[i]] == 0;
+                    unknown += expected[out[i]] == -1;
+                    expected[out[i]] = 2;
+                }
+                for (int i = 0; i < segmentCount; i++) {
+                    missing += expected[i] == 1;
+                    unknown += expected[i] == -1;
+                }
+                boxSegmentCount += count;
+                checkedCount++;
+            }
+        }
+        free(out);
+        free(out64);
+        free(pieces);
+        free(expected);
+    }
+    printf("latlng-box: %lld boxes checked, %lld segments, %lld missing, %lld extra, %lld mismatches "
+           "(%lld segments on the boundary not checked)\n", (long long) checkedCount, (long long) boxSegmentCount,
+           (long long) missing, (long long) extra, (long long) mismatch, (long long) unknown);
+
+    // 고정 크기 버퍼로 끝까지 흘려받는다. 64비트 형식으로 32비트 범위를 넘는 n도 잰다.
+    const TestBox benchBoxes[] = {
+            {0.60, 2.10, 0.61, 2.11},
+            {0.60, 2.10, 0.70, 2.20},
+            {-0.3, 3.0, 0.3, -2.9},
+            {1.3, -M_PI, M_PI / 2, M_PI},
+    };
+    const int benchN[] = {n, 1000000};
+    enum { BenchBufferSize = 4096 };
+    int64_t *buffer = malloc(sizeof(int64_t) * BenchBufferSize);
+    for (int ni = 0; ni < NELEMS(benchN) && buffer != NULL; ni++) {
+        for (int i = 0; i < NELEMS(benchBoxes); i++) {
+            const TestBox box = benchBoxes[i];
+            // 결과가 너무 많은 조합은 건너뛴다. 개수는 대략 20 n^2 x (상자 넓이 / 4 pi)이다.
+            const double width = box.maxLng >= box.minLng ? box.maxLng - box.minLng
+                                                           : box.maxLng - box.minLng + 2 * M_PI;
+            const double area = width * (sin(box.maxLat) - sin(box.minLat));
+            if (20.0 * benchN[ni] * benchN[ni] * area / (4 * M_PI) > 2e8) {
+                continue;
+            }
+            for (int mode = 0; mode < 2; mode++) {
+                int64_t cursor = 0;
+                int64_t total = 0;
+                int64_t calls = 0;
+                double t0 = NowSeconds();
+                while (cursor != -1) {
+                    const int64_t got = GetSegmentIndicesInLatLngBox64(benchN[ni], box.minLat, box.minLng, box.maxLat,
+                                                                       box.maxLng, mode, &cursor, buffer,
+                                                                       BenchBufferSize);
+                    if (got < 0) {
+                        mismatch++;
+                        break;
+                    }
+                    total += got;
+                    calls++;
+                }
+                double t1 = NowSeconds();
+                printf("  n=%-7d box %d %-7s: %10lld segments in %6lld calls, %9.3f ms, %6.2f ns/segment\n",
+                       benchN[ni], i, mode == PolygonFillMode_Center ? "center" : "overlap", (long long) total,
+                       (long long) calls, (t1 - t0) * 1e3, (t1 - t0) * 1e9 / (total > 0 ? total : 1));
+            }
+        }
+    }
+    free(buffer);
+    return missing != 0 || extra != 0 || mismatch != 0;
+}
+
+// 부모/자식 변환을 확인한다. 모든 부모의 자식이 k·n 격자를 겹치지 않게 빈틈없이 덮는지, 자식의 부모가 원래 부모인지,
+// 자식 중심이 부모 삼각형 안에 있는지 보고, 위경도를 거쳐 다시 지오코딩하는 방식과 속도를 비교한다.
+static int RunParentChild(int n, int k) {
+    if (n < 1 || k < 1 || (int64_t) n * k * n * k * GroupCount > (int64_t) UINT_MAX + 1) {
+        printf("parent-child: n * k out of range\n");
+        return 1;
+    }
+
+    const int checkN[] = {1, 2, 3, 7, 16};
+    const int checkK[] = {1, 2, 3, 5, 8};
+    int64_t mismatch = 0;
+    int64_t outside = 0;
+    int64_t checkedCount = 0;
+    for (int ni = 0; ni < NELEMS(checkN); ni++) {
+        for (int ki = 0; ki < NELEMS(checkK); ki++) {
+            const int cn = checkN[ni];
+            const int ck = checkK[ki];
+            const int parentCount = cn * cn * GroupCount;
+            const int childCount = parentCount * ck * ck;
+            unsigned char *covered = calloc((size_t) childCount, 1);
+            int *children = malloc(sizeof(int) * childCount);
+            int64_t *children64 = malloc(sizeof(int64_t) * ck * ck);
+            int *parents = malloc(sizeof(int) * childCount);
+            for (int p = 0; p < parentCount; p++) {
+                const int count = GetChildSegmentIndices(cn, ck, p, children + p * ck * ck, ck * ck);
+                const int64_t count64 = GetChildSegmentIndices64(cn, ck, p, children64, ck * ck);
+                if (count != ck * ck || count64 != count || GetChildSegmentIndices(cn, ck, p, NULL, 0) != count ||
+                    GetChildSegmentIndices(cn, ck, p, children, count - 1) != ErrorCode_BufferTooSmall) {
+                    mismatch++;
+                    continue;
+                }
+
+                const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng(cn, p);
+                Vector3 v[3];
+                for (int c = 0; c < 3; c++) {
+                    v[c] = CalculateUnitSpherePosition(corners.points[c].lat, corners.points[c].lng);
+                }
+                const double orientation = Dot(v[0], Cross(v[1], v[2])) < 0 ? -1 : 1;
+                for (int i = 0; i < count; i++) {
+                    const int child = children[p * ck * ck + i];
+                    if (child < 0 || child >= childCount || children64[i] != child ||
+                        (i > 0 && child <= children[p * ck * ck + i - 1]) ||
+                        GetParentSegmentIndex(cn, ck, child) != p || GetParentSegmentIndex64(cn, ck, child) != p) {
+                        mismatch++;
+                        continue;
+                    }
+                    covered[child]++;
+
+                    const Vector3 center = CalculateSegmentCenter(cn * ck, child);
+                    for (int e = 0; e < 3; e++) {
+                        if (orientation * Dot(center, Cross(v[e], v[(e + 1) % 3])) < -1e-9) {
+                            outside++;
+                            break;
+                        }
+                    }
+                }
+            }
+            for (int i = 0; i < childCount; i++) {
+                mismatch += covered[i] != 1;
+            }
+
+            // 일괄 변환은 하나씩 부른 결과와 같아야 한다.
+            for (int i = 0; i < childCount; i++) {
+                parents[i] = i;
+            }
+            if (GetParentSegmentIndexBatch(NULL, cn, ck, childCount, parents, parents) != ErrorCode_None) {
+                mismatch++;
+            }
+            for (int i = 0; i < childCount; i++) {
+                mismatch += parents[i] != GetParentSegmentIndex(cn, ck, i);
+            }
+            const int batchCount =
+                    GetChildSegmentIndicesBatch(NULL, cn, ck, childCount / (ck * ck), parents, NULL, 0);
+            mismatch += batchCount != childCount;
+            free(covered);
+            free(children);
+            free(children64);
+            free(parents);
+            checkedCount += parentCount;
+        }
+    }
+    mismatch += GetParentSegmentIndex(2, 3, 36 * GroupCount) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetChildSegmentIndices(2, 3, 4 * GroupCount, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    printf("parent-child: %lld parents checked, %lld mismatches, %lld children outside their parent\n",
+           (long long) checkedCount, (long long) mismatch, (long long) outside);
+
+    // n 격자 자료를 k·n 격자로 내리고(자식), 다시 n 격자로 올린다(부모).
+    const int childN = n * k;
+    const int count = 1 << 20;
+    int *input = malloc(sizeof(int) * count);
+    int *parents = malloc(sizeof(int) * count);
+    double *lat = malloc(sizeof(double) * count);
+    double *lng = malloc(sizeof(double) * count);
+    int *children = malloc(sizeof(int) * k * k * 1024);
+    if (input != NULL && parents != NULL && lat != NULL && lng != NULL && children != NULL) {
+        for (int i = 0; i < count; i++) {
+            input[i] = (int) (NextRandom() % ((uint64_t) childN * childN * GroupCount));
+        }
+
+        double t0 = NowSeconds();
+        GetParentSegmentIndexBatch(NULL, n, k, count, input, parents);
+        double t1 = NowSeconds();
+        for (int i = 0; i < count; i++) {
+            const GpsCoords center = CalculateSegmentCenterLatLng(childN, input[i]);
+            lat[i] = center.lat;
+            lng[i] = center.lng;
+        }
+        CalculateSegmentIndexFromLatLngBatch(NULL, n, count, lat, lng, input);
+        double t2 = NowSeconds();
+        int64_t differ = 0;
+        for (int i = 0; i < count; i++) {
+            differ += input[i] != parents[i];
+        }
+        printf("  parent n=%d k=%d: %7.2f ns/segment, via lat/lng %7.2f ns/segment (%lld differ)\n", n, k,
+               (t1 - t0) * 1e9 / count, (t2 - t1) * 1e9 / count, (long long) differ);
+
+        int64_t total = 0;
+        t0 = NowSeconds();
+        for (int i = 0; i + 1024 <= count; i += 1024) {
+            total += GetChildSegmentIndicesBatch(NULL, n, k, 1024, parents + i, children, k * k * 1024);
+        }
+        t1 = NowSeconds();
+        printf("  children n=%d k=%d: %7.2f ns/child\n", n, k, (t1 - t0) * 1e9 / (total > 0 ? total : 1));
+    }
+    free(input);
+    free(parents);
+    free(lat);
+    free(lng);
+    free(children);
+    return mismatch != 0 || outside != 0;
+}
+
+// 여러 해상도로 압축한 집합이 원래 집합으로 정확히 풀리는지, 남긴 칸이 가장 적은지(자식이 모두 든 칸은 반드시
+// 부모로 합쳐졌는지), 포함 여부 검사가 맞는지, 잘린 입력을 거부하는지 확인하고, 크기와 속도를 잰다.
+static int64_t CheckCompactSet(const int *levelN, int levelCount, const int64_t *set, int64_t count) {
+    const int fineN = levelN[levelCount - 1];
+    const int64_t fineCount = (int64_t) fineN * fineN * GroupCount;
+    int64_t mismatch = 0;
+    const int64_t size = CompactSegmentIndices64(levelN, levelCount, set, count, NULL, 0);
+    uint8_t *encoded = malloc((size_t) (size > 0 ? size : 1));
+    unsigned char *present = calloc((size_t) fineCount, 1);
+    int64_t *decoded = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    int *cellN = malloc(sizeof(int) * (count > 0 ? count : 1));
+    int64_t *cells = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    if (size <= 0 || CompactSegmentIndices64(levelN, levelCount, set, count, encoded, size) != size ||
+        CompactSegmentIndices64(levelN, levelCount, set, count, encoded, size - 1) != ErrorCode_BufferTooSmall) {
+        mismatch++;
+        goto done;
+    }
+    for (int64_t i = 0; i < count; i++) {
+        present[set[i]] = 1;
+    }
+
+    if (UncompactSegmentIndices64(encoded, size, NULL, 0) != count ||
+        UncompactSegmentIndices64(encoded, size, decoded, count) != count) {
+        mismatch++;
+        goto done;
+    }
+    mismatch += count > 0 && memcmp(decoded, set, sizeof(int64_t) * count) != 0;
+    for (int64_t i = 0; i < fineCount; i++) {
+        mismatch += IsSegmentInCompactSet64(encoded, size, i) != present[i];
+    }
+
+    // 칸 i는 자손이 모두 들어 있고, 부모(한 단계 거친 해상도)는 그렇지 않을 때에만 남아야 한다.
+    const int64_t cellCount = GetCompactSegmentCells64(encoded, size, NULL, NULL, 0);
+    if (cellCount < 0 || cellCount > count || GetCompactSegmentCells64(encoded, size, cellN, cells, count) != cellCount) {
+        mismatch++;
+        goto done;
+    }
+    int64_t expected = 0;
+    int64_t *children = malloc(sizeof(int64_t) * fineN * fineN);
+    for (int level = 0; level < levelCount; level++) {
+        const int n = levelN[level];
+        const int k = fineN / n;
+        for (int64_t c = 0; c < (int64_t) n * n * GroupCount; c++) {
+            const int64_t childCount = GetChildSegmentIndices64(n, k, c, children, (int64_t) k * k);
+            int full = 1;
+            for (int64_t i = 0; i < childCount && full; i++) {
+                full = present[children[i]];
+            }
+            int parentFull = 0;
+            if (full && level > 0) {
+                const int parentN = levelN[level - 1];
+                const int parentK = fineN / parentN;
+                const int64_t parentChildCount =
+                        GetChildSegmentIndices64(parentN, parentK, GetParentSegmentIndex64(parentN, n / parentN, c),
+                                                 children, (int64_t) fineN * fineN);
+                parentFull = 1;
+                for (int64_t i = 0; i < parentChildCount && parentFull; i++) {
+                    parentFull = present[children[i]];
+                }
+            }
+            if (full && !parentFull) {
+                if (expected >= cellCount || cellN[expected] != n || cells[expected] != c) {
+                    mismatch++;
+                }
+                expected++;
+            }
+        }
+    }
+    free(children);
+    mismatch += expected != cellCount;
+
+    // 잘린 입력은 모두 거부되어야 한다 (마지막 칸 수가 0인 경우처럼 짧아도 올바른 입력이 될 수는 없다).
+    for (int64_t s = 0; s < size; s++) {
+        mismatch += UncompactSegmentIndices64(encoded, s, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    }
+
+done:
+    free(encoded);
+    free(present);
+    free(decoded);
+    free(cellN);
+    free(cells);
+    return mismatch;
+}
+
+static int RunCompactSet(int n) {
+    if (n < 8 || n % 8 != 0 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1) {
+        printf("compact-set: n must be a multiple of 8 up to 14648\n");
+        return 1;
+    }
+
+    // 작은 격자에서는 무작위 집합과 원 영역을 전수 검사한다.
+    const int checkLevels[][4] = {{12, 0, 0, 0}, {1, 2, 4, 12}, {3, 6, 0, 0}, {2, 10, 20, 0}};
+    const int checkLevelCounts[] = {1, 4, 2, 3};
+    int64_t mismatch = 0;
+    int checkedCount = 0;
+    for (int li = 0; li < NELEMS(checkLevelCounts); li++) {
+        const int *levelN = checkLevels[li];
+        const int levelCount = checkLevelCounts[li];
+        const int fineN = levelN[levelCount - 1];
+        const int64_t fineCount = (int64_t) fineN * fineN * GroupCount;
+        int64_t *set = malloc(sizeof(int64_t) * fineCount);
+        for (int trial = 0; trial < 40; trial++) {
+            int64_t count;
+            if (trial < 2) {
+                // 빈 집합과 전체 집합
+                count = trial == 0 ? 0 : fineCount;
+                for (int64_t i = 0; i < count; i++) {
+                    set[i] = i;
+                }
+            } else if (trial % 2 == 0) {
+                const uint64_t density = NextRandom() % 1024;
+                count = 0;
+                for (int64_t i = 0; i < fineCount; i++) {
+                    if (NextRandom() % 1024 < density) {
+                        set[count++] = i;
+                    }
+                }
+            } else {
+                const GpsCoords center = NextRandomLatLng();
+                count = GetSegmentIndicesInCap64(fineN, center.lat, center.lng, NextRandomUnit() * 2,
+                                                 CapQueryMode_Exact, set, fineCount);
+            }
+            mismatch += CheckCompactSet(levelN, levelCount, set, count);
+            checkedCount++;
+        }
+        free(set);
+    }
+
+    // 잘못된 입력
+    const int badLevels[] = {4, 6};
+    const int64_t unsorted[] = {5, 3};
+    uint8_t garbage[] = {CompactSegmentSetVersion, 1, 4, 1, 1, 0x80};
+    mismatch += CompactSegmentIndices64(badLevels, 2, NULL, 0, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += CompactSegmentIndices64(badLevels, 1, unsorted, 2, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += UncompactSegmentIndices64(garbage, sizeof(garbage), NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += IsSegmentInCompactSet64(garbage, sizeof(garbage), 0) != ErrorCode_ArgumentOutOfRangeException;
+    printf("compact-set: %d sets checked, %lld mismatches\n", checkedCount, (long long) mismatch);
+
+    // 큰 격자: 원 영역을 n/8, n/4, n/2, n 네 해상도로 압축한다.
+    const int levelN[] = {n / 8, n / 4, n / 2, n};
+    const double radius[] = {0.001, 0.01, 0.1, 0.5};
+    for (int ri = 0; ri < NELEMS(radius); ri++) {
+        const int64_t count = GetSegmentIndicesInCap64(n, 0.6, 2.1, radius[ri], CapQueryMode_Exact, NULL, 0);
+        int64_t *set = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+        int64_t *decoded = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+        if (set == NULL || decoded == NULL) {
+            free(set);
+            free(decoded);
+            continue;
+        }
+        GetSegmentIndicesInCap64(n, 0.6, 2.1, radius[ri], CapQueryMode_Exact, set, count);
+
+        const int64_t size = CompactSegmentIndices64(levelN, NELEMS(levelN), set, count, NULL, 0);
+        uint8_t *encoded = malloc((size_t) (size > 0 ? size : 1));
+        double t0 = NowSeconds();
+        CompactSegmentIndices64(levelN, NELEMS(levelN), set, count, encoded, size);
+        double t1 = NowSeconds();
+        const int64_t decodedCount = UncompactSegmentIndices64(encoded, size, decoded, count);
+        double t2 = NowSeconds();
+        // 포함 검사는 해상도마다 블록 색인을 이진 탐색하고 블록 하나만 읽는다. 빈 집합이면 고를 세그먼트가 없다.
+        const int probes = count > 0 ? 1 << 10 : 0;
+        int64_t hits = 0;
+        for (int i = 0; i < probes; i++) {
+            hits += IsSegmentInCompactSet64(encoded, size, set[NextRandom() % count]);
+        }
+        double t3 = NowSeconds();
+        if (decodedCount != count || memcmp(decoded, set, sizeof(int64_t) * count) != 0 || hits != probes) {
+            mismatch++;
+        }
+        if (count == 0) {
+            // 작은 n에서는 작은 원에 중심이 드는 세그먼트가 없다. 빈 집합이 그대로 돌아오는지만 확인한다.
+            printf("  n=%d radius %.3f: no segments, %lld bytes, empty round trip %s\n", n, radius[ri], (long long) size,
+                   decodedCount == 0 ? "ok" : "FAILED");
+            free(encoded);
+            free(set);
+            free(decoded);
+            continue;
+        }
+        printf("  n=%d radius %.3f: %10lld segments, %7lld cells, %9lld bytes (%6.2f%% of raw), "
+               "compact %7.2f ns/segment, uncompact %6.2f ns/segment, lookup %8.1f ns\n",
+               n, radius[ri], (long long) count, (long long) GetCompactSegmentCells64(encoded, size, NULL, NULL, 0),
+               (long long) size, 100.0 * size / (8.0 * count), (t1 - t0) * 1e9 / count, (t2 - t1) * 1e9 / count,
+               (t3 - t2) * 1e9 / probes);
+        free(encoded);
+        free(set);
+        free(decoded);
+    }
+    return mismatch != 0;
+}
+
+typedef struct {
+    int64_t segmentIndex;
+    int64_t point;
+} AggregateReferenceEntry;
+
+static int CompareAggregateReferenceEntry(const void *lhs, const void *rhs) {
+    const AggregateReferenceEntry *a = lhs;
+    const AggregateReferenceEntry *b = rhs;
+    if (a->segmentIndex != b->segmentIndex) {
+        return (a->segmentIndex > b->segmentIndex) - (a->segmentIndex < b->segmentIndex);
+    }
+    return (a->point > b->point) - (a->point < b->point);
+}
+
+// 집계 결과를 한 스레드로 지점마다 지오코딩해 정렬한 결과와 비교한다. 첫 가중치 열은 정수라 합계가 정확히 같아야 한다.
+static int64_t CheckAggregation(const SegmentAggregation *aggregation, int n, int64_t count, const double *lat,
+                                const double *lng, const double *const *weights, int weightCount) {
+    AggregateReferenceEntry *entries = malloc(sizeof(AggregateReferenceEntry) * (count > 0 ? count : 1));
+    int64_t valid = 0;
+    for (int64_t i = 0; i < count; i++) {
+        const int64_t segmentIndex = CalculateSegmentIndexFromLatLng64(n, lat[i], lng[i]);
+        if (segmentIndex >= 0) {
+            entries[valid++] = (AggregateReferenceEntry) {.segmentIndex = segmentIndex, .point = i};
+        }
+    }
+    qsort(entries, (size_t) valid, sizeof(AggregateReferenceEntry), CompareAggregateReferenceEntry);
+
+    const int64_t segmentCount = GetSegmentAggregationSegmentCount(aggregation);
+    const int64_t *segmentIndex = GetSegmentAggregationSegmentIndices(aggregation);
+    const int64_t *counts = GetSegmentAggregationCounts(aggregation);
+    int64_t mismatch = 0;
+    int64_t s = 0;
+    for (int64_t i = 0; i < valid; s++) {
+        int64_t j = i;
+        double sums[4] = {0};
+        while (j < valid && entries[j].segmentIndex == entries[i].segmentIndex) {
+            for (int c = 0; c < weightCount; c++) {
+                sums[c] += weights[c][entries[j].point];
+            }
+            j++;
+        }
+        if (s >= segmentCount || segmentIndex[s] != entries[i].segmentIndex || counts[s] != j - i) {
+            mismatch++;
+            break;
+        }
+        for (int c = 0; c < weightCount; c++) {
+            const double sum = GetSegmentAggregationSums(aggregation, c)[s];
+            mismatch += c == 0 ? sum != sums[c] : fabs(sum - sums[c]) > 1e-9 * (1 + fabs(sums[c]));
+        }
+        i = j;
+    }
+    mismatch += s != segmentCount;
+
+    int64_t skipped = 0;
+    for (int t = 0; t < GetSegmentAggregationThreadCount(aggregation); t++) {
+        skipped += GetSegmentAggregationThreadStats(aggregation, t).skippedCount;
+    }
+    mismatch += skipped != count - valid;
+    free(entries);
+    return mismatch;
+}
+
+// 여러 스레드로 지점을 세그먼트별로 집계한 결과를 한 스레드 기준과 비교하고, 스레드 수에 따른 처리량을 잰다.
+static int RunAggregate(int n, int count) {
+    if (n < 1 || n > MaxSubdivisionCount64 || count < 1) {
+        printf("aggregate: invalid n or count\n");
+        return 1;
+    }
+
+    // 지점의 절반은 몇몇 도시 주변에 몰리게 하여 실제 GPS 자료처럼 치우치게 한다.
+    double *lat = malloc(sizeof(double) * count);
+    double *lng = malloc(sizeof(double) * count);
+    double *weight0 = malloc(sizeof(double) * count);
+    double *weight1 = malloc(sizeof(double) * count);
+    const double *weights[] = {weight0, weight1};
+    for (int i = 0; i < count; i++) {
+        GpsCoords p = NextRandomLatLng();
+        if (i % 2 == 1) {
+            const GpsCoords city = {.lat = 0.6 - 0.1 * (int) (NextRandom() % 8),
+                                    .lng = 2.1 - 0.3 * (int) (NextRandom() % 8)};
+            p.lat = city.lat + 0.01 * (NextRandomUnit() - 0.5);
+            p.lng = city.lng + 0.01 * (NextRandomUnit() - 0.5);
+        }
+        lat[i] = p.lat;
+        lng[i] = p.lng;
+        weight0[i] = (double) (NextRandom() % 100);
+        weight1[i] = NextRandomUnit();
+    }
+    lat[0] = NAN;
+
+    // 조밀/해시 히스토그램 양쪽과 스레드 수가 지점 수보다 많은 경우를 확인한다.
+    const int checkN[] = {1, 16, 256, 362, 4096, MaxSubdivisionCount64};
+    const int checkThreads[] = {1, 3, 8};
+    const int checkCount = count < 200000 ? count : 200000;
+    int64_t mismatch = 0;
+    for (int ni = 0; ni < NELEMS(checkN); ni++) {
+        for (int ti = 0; ti < NELEMS(checkThreads); ti++) {
+            SegmentAggregation *aggregation =
+                    AggregatePointsBySegment(checkN[ni], checkCount, lat, lng, weights, 2, checkThreads[ti]);
+            if (aggregation == NULL) {
+                mismatch++;
+                continue;
+            }
+            mismatch += CheckAggregation(aggregation, checkN[ni], checkCount, lat, lng, weights, 2);
+            DestroySegmentAggregation(aggregation);
+        }
+    }
+    SegmentAggregation *tiny = AggregatePointsBySegment(64, 2, lat + 1, lng + 1, NULL, 0, 16);
+    mismatch += tiny == NULL || GetSegmentAggregationThreadCount(tiny) != 2 || GetSegmentAggregationSums(tiny, 0) != NULL;
+    DestroySegmentAggregation(tiny);
+    mismatch += AggregatePointsBySegment(0, 1, lat, lng, NULL, 0, 1) != NULL;
+    mismatch += AggregatePointsBySegment(64, 1, lat, lng, NULL, 1, 1) != NULL;
+    printf("aggregate: %d configurations checked, %lld mismatches\n", (int) (NELEMS(checkN) * NELEMS(checkThreads)),
+           (long long) mismatch);
+
+    double singleThreadSeconds = 0;
+    for (int threadCount = 1; threadCount <= GetProcessorCount() * 2; threadCount *= 2) {
+        const double t0 = NowSeconds();
+        SegmentAggregation *aggregation = AggregatePointsBySegment(n, count, lat, lng, weights, 2, threadCount);
+        const double seconds = NowSeconds() - t0;
+        if (aggregation == NULL) {
+            mismatch++;
+            break;
+        }
+        singleThreadSeconds = threadCount == 1 ? seconds : singleThreadSeconds;
+
+        // 스레드별 처리량 (지점 수 / 그 스레드가 걸린 시간)의 최솟값과 최댓값
+        double slowest = INFINITY;
+        double fastest = 0;
+        for (int t = 0; t < GetSegmentAggregationThreadCount(aggregation); t++) {
+            const AggregationThreadStats stats = GetSegmentAggregationThreadStats(aggregation, t);
+            const double rate = stats.pointCount / (stats.seconds > 0 ? stats.seconds : 1e-9);
+            slowest = rate < slowest ? rate : slowest;
+            fastest = rate > fastest ? rate : fastest;
+        }
+        printf("  n=%-7d %3d threads: %10lld segments, %7.3f s total (merge %6.3f s), %7.2f Mpoints/s, "
+               "per thread %6.2f-%6.2f Mpoints/s, speedup %5.2f\n",
+               n, threadCount, (long long) GetSegmentAggregationSegmentCount(aggregation), seconds,
+               GetSegmentAggregationMergeSeconds(aggregation), count / seconds * 1e-6, slowest * 1e-6,
+               fastest * 1e-6, singleThreadSeconds / seconds);
+        DestroySegmentAggregation(aggregation);
+    }
+
+    free(lat);
+    free(lng);
+    free(weight0);
+    free(weight1);
+    return mismatch != 0;
+}
+
+// 풀에서 나누어 처리한 일괄 함수의 출력이 한 스레드로 처리한 것과 바이트까지 같은지 비교한다.
+// 출력 버퍼는 미리 같은 값으로 채워, 쓰지 말아야 할 곳을 건드렸는지도 드러나게 한다.
+typedef struct {
+    int n;
+    int count;
+    const double *lat;
+    const double *lng;
+    const int *segmentIndex;
+    const int64_t *segmentIndex64;
+    const int *parentIndex;
+    const GeocodingContext *context;
+} ThreadPoolCheckInput;
+
+static int64_t CheckBatchOnPool(const ThreadPoolCheckInput *in, ThreadPool *pool) {
+    const int count = in->count;
+    const int n = in->n;
+    const int k = 3;
+    const size_t maxSize = sizeof(NeighborSegIdList64) * count + sizeof(int64_t) * k * k * count;
+    uint8_t *serial = malloc(maxSize);
+    uint8_t *parallel = malloc(maxSize);
+    int64_t *serialOffsets = malloc(sizeof(int64_t) * (count + 1));
+    int64_t *parallelOffsets = malloc(sizeof(int64_t) * (count + 1));
+    int64_t mismatch = 0;
+    for (int api = 0; api < 14; api++) {
+        size_t size = 0;
+        int64_t results[2];
+        for (int pass = 0; pass < 2; pass++) {
+            uint8_t *out = pass == 0 ? serial : parallel;
+            int64_t *offsets = pass == 0 ? serialOffsets : parallelOffsets;
+            memset(out, 0xA5, maxSize);
+            memset(offsets, 0xA5, sizeof(int64_t) * (count + 1));
+            ThreadPool *batchPool = pass == 0 ? NULL : pool;
+            switch (api) {
+                case 0:
+                    size = sizeof(int) * count;
+                    results[pass] = CalculateSegmentIndexFromLatLngBatch(batchPool, n, count, in->lat, in->lng,
+                                                                         (int *) out);
+                    break;
+                case 1:
+                    size = sizeof(int64_t) * count;
+                    results[pass] = CalculateSegmentIndexFromLatLngBatch64(batchPool, n, count, in->lat, in->lng,
+                                                                           (int64_t *) out);
+                    break;
+                case 2:
+                    size = sizeof(int) * count;
+                    results[pass] = CalculateSegmentIndexFromLatLngBatchWithContext(in->context, batchPool, count,
+                                                                                    in->lat, in->lng, (int *) out);
+                    break;
+                case 3:
+                    size = (sizeof(GpsCoords) + sizeof(Vector3)) * count;
+                    results[pass] = CalculateSegmentCenterBatch(batchPool, n, count, in->segmentIndex,
+                                                                (GpsCoords *) out,
+                                                                (Vector3 *) (out + sizeof(GpsCoords) * count));
+                    break;
+                case 4:
+                    size = sizeof(GpsCoords) * count;
+                    results[pass] = CalculateSegmentCenterBatch64(batchPool, n, count, in->segmentIndex64,
+                                                                  (GpsCoords *) out, NULL);
+                    break;
+                case 5:
+                    size = sizeof(Vector3) * count;
+                    results[pass] = CalculateSegmentCenterBatchWithContext(in->context, batchPool, count,
+                                                                           in->segmentIndex, NULL, (Vector3 *) out);
+                    break;
+                case 6:
+                    size = sizeof(SegmentCornersInLatLng) * count;
+                    results[pass] = CalculateSegmentCornersInLatLngBatch64(batchPool, n, count, in->segmentIndex64,
+                                                                           (SegmentCornersInLatLng *) out);
+                    break;
+                case 7:
+                    size = sizeof(NeighborSegIdList64) * count;
+                    results[pass] = GetNeighborsOfSegmentIndexBatch64(batchPool, n, count, in->segmentIndex64,
+                                                                      (NeighborSegIdList64 *) out);
+                    break;
+                case 8:
+                    size = sizeof(int) * count;
+                    results[pass] = GetParentSegmentIndexBatch(batchPool, n / k, k, count, in->segmentIndex,
+                                                               (int *) out);
+                    break;
+                case 9:
+                    size = sizeof(int64_t) * count;
+                    results[pass] = GetParentSegmentIndexBatch64(batchPool, n / k, k, count, in->segmentIndex64,
+                                                                 (int64_t *) out);
+                    break;
+                case 10:
+                    size = sizeof(int) * k * k * count;
+                    results[pass] = GetChildSegmentIndicesBatch(batchPool, n / k, k, count, in->parentIndex,
+                                                                (int *) out, k * k * count);
+                    break;
+                case 11: {
+                    size = sizeof(int64_t) * k * k * count;
+                    int64_t *parents64 = malloc(sizeof(int64_t) * count);
+                    for (int i = 0; i < count; i++) {
+                        parents64[i] = in->parentIndex[i];
+                    }
+                    results[pass] = GetChildSegmentIndicesBatch64(batchPool, n / k, k, count, parents64,
+                                                                  (int64_t *) out, (int64_t) k * k * count);
+                    free(parents64);
+                    break;
+                }
+                case 12:
+                    results[pass] = GetNeighborsOfSegmentIndexCsr(batchPool, n, count, in->segmentIndex, 0,
+                                                                  (int *) offsets, (int *) out, 12 * count);
+                    size = sizeof(int) * (results[pass] > 0 ? results[pass] : 0);
+                    break;
+                default:
+                    results[pass] = GetNeighborsOfSegmentIndexCsr64(batchPool, n, count, in->segmentIndex64, 0,
+                                                                    offsets, (int64_t *) out, 12 * (int64_t) count);
+                    size = sizeof(int64_t) * (results[pass] > 0 ? results[pass] : 0);
+                    break;
+            }
+        }
+        // CSR은 풀에서 세그먼트마다 12칸 자리에 먼저 쓰므로, 돌려준 개수 뒤의 버퍼 내용은 비교하지 않는다.
+        const size_t compared = api >= 12 ? size : maxSize;
+        if (results[0] != results[1] || memcmp(serial, parallel, compared) != 0 ||
+            memcmp(serialOffsets, parallelOffsets, sizeof(int64_t) * (count + 1)) != 0) {
+            printf("  api %d differs on the pool (result %lld vs %lld, %zu bytes)\n", api, (long long) results[0],
+                   (long long) results[1], size);
+            mismatch++;
+        }
+    }
+    free(serial);
+    free(parallel);
+    free(serialOffsets);
+    free(parallelOffsets);
+    return mismatch;
+}
+
+typedef struct {
+    const ThreadPoolCheckInput *input;
+    ThreadPool *pool;
+    int64_t mismatch[8];
+} ConcurrentPoolCheck;
+
+// 여러 스레드가 같은 풀에 동시에 일괄 처리를 맡겨도 서로의 결과가 섞이지 않는지 본다.
+static void RunConcurrentPoolCheck(void *arg, int threadIndex) {
+    ConcurrentPoolCheck *check = arg;
+    const ThreadPoolCheckInput *in = check->input;
+    int *expected = malloc(sizeof(int) * in->count);
+    int *actual = malloc(sizeof(int) * in->count);
+    for (int round = 0; round < 20; round++) {
+        const int n = in->n + threadIndex * 7 + round;
+        for (int i = 0; i < in->count; i++) {
+            expected[i] = CalculateSegmentIndexFromLatLng(n, in->lat[i], in->lng[i]);
+        }
+        CalculateSegmentIndexFromLatLngBatch(check->pool, n, in->count, in->lat, in->lng, actual);
+        check->mismatch[threadIndex] += memcmp(expected, actual, sizeof(int) * in->count) != 0;
+    }
+    free(expected);
+    free(actual);
+}
+
+static int RunThreadPool(int count) {
+    if (count < 1) {
+        printf("thread-pool: count must be positive\n");
+        return 1;
+    }
+
+    const int n = 4095;
+    double *lat = malloc(sizeof(double) * count);
+    double *lng = malloc(sizeof(double) * count);
+    int *segmentIndex = malloc(sizeof(int) * count);
+    int64_t *segmentIndex64 = malloc(sizeof(int64_t) * count);
+    int *parentIndex = malloc(sizeof(int) * count);
+    for (int i = 0; i < count; i++) {
+        const GpsCoords p = NextRandomLatLng();
+        lat[i] = p.lat;
+        lng[i] = p.lng;
+        segmentIndex[i] = (int) (NextRandom() % ((uint64_t) n * n * GroupCount));
+        segmentIndex64[i] = segmentIndex[i];
+        parentIndex[i] = (int) (NextRandom() % ((uint64_t) (n / 3) * (n / 3) * GroupCount));
+    }
+    // 잘못된 입력도 같은 자리에 같은 오류로 나와야 한다.
+    lat[count / 2] = NAN;
+    segmentIndex[count / 3] = -5;
+    segmentIndex64[count / 3] = -5;
+
+    GeocodingContext *context = CreateGeocodingContext(n);
+    const ThreadPoolCheckInput input = {
+            .n = n, .count = count, .lat = lat, .lng = lng, .segmentIndex = segmentIndex,
+            .segmentIndex64 = segmentIndex64, .parentIndex = parentIndex, .context = context};
+    int64_t mismatch = 0;
+    const int poolSizes[] = {1, 2, 3, 8};
+    for (int pi = 0; pi < NELEMS(poolSizes); pi++) {
+        ThreadPool *pool = CreateThreadPool(poolSizes[pi]);
+        if (pool == NULL || GetThreadPoolThreadCount(pool) != poolSizes[pi]) {
+            mismatch++;
+            DestroyThreadPool(pool);
+            continue;
+        }
+        // 조각 하나보다 작은 입력, 조각 경계에 걸치는 입력, 전체 입력
+        const int sizes[] = {1, 2 * BatchMinChunkSize + 1, count};
+        for (int si = 0; si < NELEMS(sizes); si++) {
+            ThreadPoolCheckInput part = input;
+            part.count = sizes[si] < count ? sizes[si] : count;
+            mismatch += CheckBatchOnPool(&part, pool);
+        }
+
+        ThreadPoolCheckInput concurrentInput = input;
+        concurrentInput.count = count < 20000 ? count : 20000;
+        ConcurrentPoolCheck concurrent = {.input = &concurrentInput, .pool = pool};
+        RunParallel(NELEMS(concurrent.mismatch), RunConcurrentPoolCheck, &concurrent);
+        for (int i = 0; i < NELEMS(concurrent.mismatch); i++) {
+            mismatch += concurrent.mismatch[i];
+        }
+        DestroyThreadPool(pool);
+    }
+    // 만들고 바로 없애기를 반복해도 작업자가 모두 깨끗이 끝나야 한다.
+    for (int i = 0; i < 50; i++) {
+        DestroyThreadPool(CreateThreadPool(4));
+    }
+    printf("thread-pool: %d pool sizes checked, %lld mismatches\n", (int) NELEMS(poolSizes), (long long) mismatch);
+
+    int *out = malloc(sizeof(int) * count);
+    double serialSeconds = 0;
+    for (int threadCount = 0; threadCount <= GetProcessorCount() * 2;
+         threadCount = threadCount > 0 ? threadCount * 2 : 1) {
+        ThreadPool *pool = threadCount > 0 ? CreateThreadPool(threadCount) : NULL;
+        const double t0 = NowSeconds();
+        CalculateSegmentIndexFromLatLngBatchWithContext(context, pool, count, lat, lng, out);
+        const double t1 = NowSeconds();
+        DestroyThreadPool(pool);
+        serialSeconds = threadCount == 0 ? t1 - t0 : serialSeconds;
+        printf("  geocode batch, %s%2d threads: %7.2f ns/point, speedup %5.2f\n",
+               threadCount == 0 ? "no pool, " : "pool,    ", threadCount > 0 ? threadCount : 1,
+               (t1 - t0) * 1e9 / count, serialSeconds / (t1 - t0));
+    }
+
+    free(out);
+    DestroyGeocodingContext(context);
+    free(lat);
+    free(lng);
+    free(segmentIndex);
+    free(segmentIndex64);
+    free(parentIndex);
+    return mismatch != 0;
+}
+
+// 모서리 하나를 (작은 번호, 큰 번호, 방향)으로 나타낸 항목. 닫힌 메시라면 같은 모서리가 반대 방향으로 두 번 나온다.
+typedef struct {
+    uint32_t lo;
+    uint32_t hi;
+    int forward;
+} MeshEdgeEntry;
+
+static int CompareMeshEdgeEntry(const void *lhs, const void *rhs) {
+    const MeshEdgeEntry *a = lhs;
+    const MeshEdgeEntry *b = rhs;
+    if (a->lo != b->lo) {
+        return a->lo < b->lo ? -1 : 1;
+    }
+    if (a->hi != b->hi) {
+        return a->hi < b->hi ? -1 : 1;
+    }
+    return a->forward - b->forward;
+}
+
+static Vector3 ReadMeshPosition(const float *positions, uint32_t vertex) {
+    return (Vector3) {positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2]};
+}
+
+// 면별 메시를 이어 붙인 전체 메시가 세그먼트 꼭짓점과 같은 위치를 가리키는지, 정점이 모두 쓰이고 5개 또는 6개
+// 삼각형이 공유하는지, 모든 모서리가 반대 방향으로 정확히 두 번 나오는지(닫힌 메시, 일관된 감김), 삼각형이 바깥을
+// 향하는지 확인한다. 생성 속도를 세그먼트마다 CalculateSegmentCornersInLatLng()를 부르는 것과 비교한다.
+static int RunGlobeMesh(int n) {
+    const int64_t vertexCount = GetGlobeMeshVertexCount(n);
+    if (vertexCount < 0) {
+        printf("globe-mesh: n must be in [1, 14654]\n");
+        return 1;
+    }
+
+    const int64_t triangleCount = (int64_t) n * n * GroupCount;
+    float *positions = malloc(sizeof(float) * 3 * vertexCount);
+    uint32_t *indices = malloc(sizeof(uint32_t) * 3 * triangleCount);
+    MeshEdgeEntry *edges = malloc(sizeof(MeshEdgeEntry) * 3 * triangleCount);
+    uint8_t *useCount = calloc(vertexCount, 1);
+    if (positions == NULL || indices == NULL || edges == NULL || useCount == NULL) {
+        free(positions);
+        free(indices);
+        free(edges);
+        free(useCount);
+        return 1;
+    }
+
+    int64_t mismatch = 0;
+    const double t0 = NowSeconds();
+    for (int face = 0; face < GroupCount; face++) {
+        const int64_t start = GetGlobeMeshFaceVertexStart(n, face);
+        const int64_t count = GetGlobeMeshFaceVertices(n, face, NULL, 0);
+        mismatch += start + count != GetGlobeMeshFaceVertexStart(n, face + 1);
+        mismatch += GetGlobeMeshFaceVertices(n, face, positions + start * 3, count) != count;
+        mismatch += GetGlobeMeshFaceTriangles(n, face, indices + (int64_t) face * n * n * 3, (int64_t) n * n) !=
+                    (int64_t) n * n;
+    }
+    const double t1 = NowSeconds();
+    double checksum = 0;
+    for (int64_t s = 0; s < triangleCount; s++) {
+        const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng(n, (int) s);
+        checksum += fabs(corners.points[0].lat) + fabs(corners.points[1].lat) + fabs(corners.points[2].lat);
+    }
+    const double t2 = NowSeconds();
+    mismatch += GetGlobeMeshFaceTriangles(n, 0, indices, (int64_t) n * n - 1) != ErrorCode_BufferTooSmall;
+    mismatch += GetGlobeMeshFaceVertices(n, 20, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetGlobeMeshVertexCount(14655) != ErrorCode_ArgumentOutOfRangeException;
+
+    double maxError = 0;
+    for (int64_t s = 0; s < triangleCount; s++) {
+        const uint32_t *tri = indices + s * 3;
+        const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng(n, (int) s);
+        Vector3 v[3];
+        for (int c = 0; c < 3; c++) {
+            if (tri[c] >= vertexCount) {
+                mismatch++;
+                v[c] = (Vector3) {0, 0, 0};
+                continue;
+            }
+            v[c] = ReadMeshPosition(positions, tri[c]);
+            useCount[tri[c]]++;
+            edges[s * 3 + c] = (MeshEdgeEntry) {
+                    .lo = tri[c] < tri[(c + 1) % 3] ? tri[c] : tri[(c + 1) % 3],
+                    .hi = tri[c] < tri[(c + 1) % 3] ? tri[(c + 1) % 3] : tri[c],
+                    .forward = tri[c] < tri[(c + 1) % 3]};
+        }
+
+        // 첫 꼭짓점은 같고, 나머지 둘은 순서가 바뀌었을 수 있다.
+        Vector3 expected[3];
+        for (int c = 0; c < 3; c++) {
+            expected[c] = CalculateUnitSpherePosition(corners.points[c].lat, corners.points[c].lng);
+        }
+        const double e0 = Magnitude(DiffVector3(v[0], expected[0]));
+        const double same = fmax(Magnitude(DiffVector3(v[1], expected[1])), Magnitude(DiffVector3(v[2], expected[2])));
+        const double swapped = fmax(Magnitude(DiffVector3(v[1], expected[2])), Magnitude(DiffVector3(v[2], expected[1])));
+        maxError = fmax(maxError, fmax(e0, fmin(same, swapped)));
+        mismatch += Dot(Cross(DiffVector3(v[1], v[0]), DiffVector3(v[2], v[0])), v[0]) <= 0;
+    }
+
+    int64_t fiveCount = 0;
+    for (int64_t v = 0; v < vertexCount; v++) {
+        fiveCount += useCount[v] == 5;
+        mismatch += useCount[v] != 5 && useCount[v] != 6;
+    }
+    mismatch += fiveCount != 12;
+
+    qsort(edges, triangleCount * 3, sizeof(MeshEdgeEntry), CompareMeshEdgeEntry);
+    for (int64_t i = 0; i < triangleCount * 3; i += 2) {
+        mismatch += edges[i].lo != edges[i + 1].lo || edges[i].hi != edges[i + 1].hi || edges[i].forward != 0 ||
+                    edges[i + 1].forward != 1;
+    }
+    mismatch += maxError > 1e-6;
+
+    printf("globe-mesh: n=%d, %lld vertices, %lld triangles, max corner error %.2e, %lld mismatches\n", n,
+           (long long) vertexCount, (long long) triangleCount, maxError, (long long) mismatch);
+    printf("  mesh %.2f ns/triangle, CalculateSegmentCornersInLatLng %.2f ns/segment (checksum %.3f)\n",
+           (t1 - t0) * 1e9 / (double) triangleCount, (t2 - t1) * 1e9 / (double) triangleCount, checksum);
+
+    free(positions);
+    free(indices);
+    free(edges);
+    free(useCount);
+    return mismatch != 0;
+}
+
+// 모든 patchN(n의 약수)과 detailN에서 패치가 전체 메시와 맞는지 확인한다. 전체 해상도 패치의 삼각형은 대응하는
+// 세그먼트의 메시 삼각형과 같은 정점을 같은 감김으로 가리키고, 패치들의 세그먼트는 모든 세그먼트를 한 번씩 덮으며,
+// 각 세그먼트의 부모(GetParentSegmentIndex)가 그 패치다. 낮은 해상도의 정점도 메시 정점과 위치가 같아야 한다.
+static int RunGlobePatch(int n) {
+    const int64_t vertexCount = GetGlobeMeshVertexCount(n);
+    if (vertexCount < 0 || n > 1024) {
+        printf("globe-patch: n must be in [1, 1024]\n");
+        return 1;
+    }
+
+    const int64_t segmentCount = (int64_t) n * n * GroupCount;
+    float *meshPositions = malloc(sizeof(float) * 3 * vertexCount);
+    uint32_t *meshIndices = malloc(sizeof(uint32_t) * 3 * segmentCount);
+    float *positions = malloc(sizeof(float) * 3 * (n + 1) * (n + 2) / 2);
+    uint32_t *vertexIndex = malloc(sizeof(uint32_t) * (n + 1) * (n + 2) / 2);
+    uint32_t *triangles = malloc(sizeof(uint32_t) * 3 * n * n);
+    int *segments = malloc(sizeof(int) * n * n);
+    uint8_t *covered = malloc(segmentCount);
+    if (meshPositions == NULL || meshIndices == NULL || positions == NULL || vertexIndex == NULL ||
+        triangles == NULL || segments == NULL || covered == NULL) {
+        free(meshPositions);
+        free(meshIndices);
+        free(positions);
+        free(vertexIndex);
+        free(triangles);
+        free(segments);
+        free(covered);
+        return 1;
+    }
+    for (int face = 0; face < GroupCount; face++) {
+        GetGlobeMeshFaceVertices(n, face, meshPositions + GetGlobeMeshFaceVertexStart(n, face) * 3,
+                                 GetGlobeMeshFaceVertices(n, face, NULL, 0));
+        GetGlobeMeshFaceTriangles(n, face, meshIndices + (int64_t) face * n * n * 3, (int64_t) n * n);
+    }
+
+    int64_t mismatch = 0;
+    int64_t patchCount = 0;
+    for (int patchN = 1; patchN <= n; patchN++) {
+        if (n % patchN != 0) {
+            continue;
+        }
+        const int s = n / patchN;
+        memset(covered, 0, segmentCount);
+        for (int detailN = 1; detailN <= s; detailN++) {
+            if (s % detailN != 0) {
+                continue;
+            }
+            const int triangleCount = GetGlobePatchTriangles(detailN, triangles, detailN * detailN);
+            mismatch += triangleCount != detailN * detailN;
+            for (int patch = 0; patch < patchN * patchN * GroupCount; patch++, patchCount++) {
+                const int count = GetGlobePatchVertices(n, patchN, patch, detailN, positions, vertexIndex,
+                                                        (n + 1) * (n + 2) / 2);
+                mismatch += count != (detailN + 1) * (detailN + 2) / 2;
+                for (int v = 0; v < count; v++) {
+                    const float *p = positions + v * 3;
+                    const float *q = meshPositions + (int64_t) vertexIndex[v] * 3;
+                    mismatch += vertexIndex[v] >= vertexCount || p[0] != q[0] || p[1] != q[1] || p[2] != q[2];
+                }
+                if (detailN != s) {
+                    continue;
+                }
+
+                mismatch += GetGlobePatchSegmentIndices(n, patchN, patch, segments, s * s) != s * s;
+                for (int t = 0; t < s * s; t++) {
+                    const int64_t segment = (uint32_t) segments[t];
+                    if (segment >= segmentCount) {
+                        mismatch++;
+                        continue;
+                    }
+                    mismatch += covered[segment]++ != 0;
+                    mismatch += GetParentSegmentIndex(patchN, s, segments[t]) != patch;
+
+                    // 같은 정점들을 같은 순환 순서로 가리켜야 한다.
+                    const uint32_t *mesh = meshIndices + segment * 3;
+                    const uint32_t local[3] = {vertexIndex[triangles[t * 3]], vertexIndex[triangles[t * 3 + 1]],
+                                               vertexIndex[triangles[t * 3 + 2]]};
+                    int rotated = 0;
+                    for (int r = 0; r < 3; r++) {
+                        rotated |= local[0] == mesh[r] && local[1] == mesh[(r + 1) % 3] && local[2] == mesh[(r + 2) % 3];
+                    }
+                    mismatch += !rotated;
+                }
+            }
+        }
+        for (int64_t i = 0; i < segmentCount; i++) {
+            mismatch += covered[i] != 1;
+        }
+    }
+    mismatch += GetGlobePatchVertices(n, n + 1, 0, 1, NULL, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetGlobePatchVertices(n, 1, 20, 1, NULL, NULL, 0) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetGlobePatchTriangles(2, triangles, 3) != ErrorCode_BufferTooSmall;
+
+    printf("globe-patch: n=%d, %lld patches checked, %lld mismatches\n", n, (long long) patchCount,
+           (long long) mismatch);
+
+    free(meshPositions);
+    free(meshIndices);
+    free(positions);
+    free(vertexIndex);
+    free(triangles);
+    free(segments);
+    free(covered);
+    return mismatch != 0;
+}
+
+static int ContainsInt64(const int64_t *values, int count, int64_t value) {
+    for (int i = 0; i < count; i++) {
+        if (values[i] == value) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 세그먼트 s의 꼭짓점/모서리 번호와 그 역방향 질의(정점 -> 세그먼트, 모서리 -> 끝점, 세그먼트)가 서로 맞는지 확인한다.
+// 어긋난 항목 수를 반환한다.
+static int64_t CheckGridTopologySegment(int n, int64_t s, int64_t *vertices, int64_t *edges) {
+    // 번호를 얻지 못했으면 출력 배열이 채워지지 않았으므로 더 비교하지 않는다.
+    if (GetSegmentGridVertexIndices64(n, s, vertices) != 3 || GetSegmentGridEdgeIndices64(n, s, edges) != 3) {
+        return 1;
+    }
+
+    int64_t mismatch = 0;
+    for (int c = 0; c < 3; c++) {
+        int64_t incident[6];
+        const int count = GetGridVertexSegmentIndices64(n, vertices[c], incident);
+        mismatch += (count != 5 && count != 6) || !ContainsInt64(incident, count, s);
+        for (int i = 1; i < count; i++) {
+            mismatch += incident[i - 1] >= incident[i];
+        }
+
+        // 모서리 c는 꼭짓점 c와 (c + 1) % 3을 잇는다.
+        int64_t ends[2];
+        int64_t sides[2];
+        mismatch += GetGridEdgeVertexIndices64(n, edges[c], ends) != 2 ||
+                    (!(ends[0] == vertices[c] && ends[1] == vertices[(c + 1) % 3]) &&
+                     !(ends[1] == vertices[c] && ends[0] == vertices[(c + 1) % 3]));
+        mismatch += GetGridEdgeSegmentIndices64(n, edges[c], sides) != 2 || sides[0] == sides[1] ||
+                    !ContainsInt64(sides, 2, s);
+    }
+    return mismatch;
+}
+
+// 모든 세그먼트에서 정점/모서리 번호가 전단사인지(정점은 5개 또는 6개, 모서리는 정확히 두 세그먼트가 공유),
+// 정점 위치가 세그먼트 꼭짓점과 같은지, 모서리를 공유하는 두 세그먼트가 서로의 이웃인지 확인한다. 큰 n에서는
+// 무작위 세그먼트, 정점, 모서리로 같은 왕복 검사를 하고 질의 시간을 잰다.
+static int RunGridTopology(int n) {
+    const int64_t vertexCount = GetGridVertexCount64(n);
+    const int64_t edgeCount = GetGridEdgeCount64(n);
+    if (vertexCount < 0 || n > 4096) {
+        printf("grid-topology: n must be in [1, 4096]\n");
+        return 1;
+    }
+
+    const int64_t segmentCount = (int64_t) n * n * GroupCount;
+    uint8_t *vertexUse = calloc(vertexCount, 1);
+    uint8_t *edgeUse = calloc(edgeCount, 1);
+    if (vertexUse == NULL || edgeUse == NULL) {
+        free(vertexUse);
+        free(edgeUse);
+        return 1;
+    }
+
+    int64_t mismatch = 0;
+    mismatch += vertexCount != 10 * (int64_t) n * n + 2 || edgeCount != 30 * (int64_t) n * n;
+    double maxError = 0;
+    for (int64_t s = 0; s < segmentCount; s++) {
+        // 질의가 실패해도 아래 범위 검사에 걸리도록 유효하지 않은 번호로 채워 둔다.
+        int64_t vertices[3] = {-1, -1, -1};
+        int64_t edges[3] = {-1, -1, -1};
+        mismatch += CheckGridTopologySegment(n, s, vertices, edges);
+        const SegmentCornersInLatLng corners = CalculateSegmentCornersInLatLng64(n, s);
+        for (int c = 0; c < 3; c++) {
+            if (vertices[c] < 0 || vertices[c] >= vertexCount || edges[c] < 0 || edges[c] >= edgeCount) {
+                mismatch++;
+                continue;
+            }
+            vertexUse[vertices[c]]++;
+            edgeUse[edges[c]]++;
+            const GpsCoords p = CalculateGridVertexLatLng64(n, vertices[c]);
+            maxError = fmax(maxError, Magnitude(DiffVector3(CalculateUnitSpherePosition(p.lat, p.lng),
+                                                            CalculateUnitSpherePosition(corners.points[c].lat,
+                                                                                        corners.points[c].lng))));
+        }
+    }
+    mismatch += maxError > 1e-6;
+
+    int64_t fiveCount = 0;
+    for (int64_t v = 0; v < vertexCount; v++) {
+        int64_t incident[6];
+        fiveCount += vertexUse[v] == 5;
+        mismatch += (vertexUse[v] != 5 && vertexUse[v] != 6) ||
+                    GetGridVertexSegmentIndices64(n, v, incident) != vertexUse[v];
+    }
+    mismatch += fiveCount != 12;
+    for (int64_t e = 0; e < edgeCount; e++) {
+        int64_t sides[2];
+        mismatch += edgeUse[e] != 2 || GetGridEdgeSegmentIndices64(n, e, sides) != 2;
+        const NeighborSegIdList64 neighbors = GetNeighborsOfSegmentIndex64(n, sides[0]);
+        int found = 0;
+        for (int i = 0; i < neighbors.count; i++) {
+            found |= neighbors.neighborSegId[i] == sides[1];
+        }
+        mismatch += !found;
+    }
+
+    int64_t out[6];
+    mismatch += GetGridVertexSegmentIndices64(n, vertexCount, out) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetGridEdgeSegmentIndices64(n, -1, out) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetSegmentGridEdgeIndices64(n, segmentCount, out) != ErrorCode_ArgumentOutOfRangeException;
+    mismatch += GetSegmentGridVertexIndices64(n, 0, NULL) != ErrorCode_Argument_NullPtr;
+    mismatch += GetGridEdgeCount64(MaxSubdivisionCount64 + 1) != ErrorCode_ArgumentOutOfRangeException;
+    printf("grid-topology: n=%d, %lld vertices, %lld edges, max corner error %.2e, %lld mismatches\n", n,
+           (long long) vertexCount, (long long) edgeCount, maxError, (long long) mismatch);
+
+    // 큰 n의 무작위 표본
+    const int sampleN[] = {14655, 80000, MaxSubdivisionCount64};
+    const int sampleCount = 200000;
+    for (int i = 0; i < (int) (sizeof(sampleN) / sizeof(sampleN[0])); i++) {
+        const int m = sampleN[i];
+        const int64_t mSegmentCount = (int64_t) m * m * GroupCount;
+        int64_t sampleMismatch = 0;
+        const double t0 = NowSeconds();
+        for (int k = 0; k < sampleCount; k++) {
+            int64_t vertices[3];
+            int64_t edges[3];
+            sampleMismatch += CheckGridTopologySegment(m, (int64_t) (NextRandom() % (uint64_t) mSegmentCount),
+                                                       vertices, edges);
+        }
+        const double t1 = NowSeconds();
+        for (int k = 0; k < sampleCount; k++) {
+            const int64_t v = (int64_t) (NextRandom() % (uint64_t) GetGridVertexCount64(m));
+            int64_t incident[6];
+            int64_t vertices[3];
+            const int count = GetGridVertexSegmentIndices64(m, v, incident);
+            sampleMismatch += count != 5 && count != 6;
+            for (int x = 0; x < count; x++) {
+                GetSegmentGridVertexIndices64(m, incident[x], vertices);
+                sampleMismatch += !ContainsInt64(vertices, 3, v);
+            }
+
+            const int64_t e = (int64_t) (NextRandom() % (uint64_t) GetGridEdgeCount64(m));
+            int64_t sides[2];
+            int64_t edges[3];
+            sampleMismatch += GetGridEdgeSegmentIndices64(m, e, sides) != 2;
+            for (int x = 0; x < 2; x++) {
+                GetSegmentGridEdgeIndices64(m, sides[x], edges);
+                sampleMismatch += !ContainsInt64(edges, 3, e);
+            }
+        }
+        const double t2 = NowSeconds();
+        printf("  n=%d: %d random segments, vertices and edges, %lld mismatches, %.0f ns/segment round trip, "
+               "%.0f ns/vertex+edge round trip\n", m, sampleCount, (long long) sampleMismatch,
+               (t1 - t0) * 1e9 / sampleCount, (t2 - t1) * 1e9 / sampleCount);
+        mismatch += sampleMismatch;
+    }
+
+    free(vertexUse);
+    free(edgeUse);
+    return mismatch != 0;
+}
+
+static int CompareInt64Value(const void *lhs, const void *rhs) {
+    const int64_t a = *(const int64_t *) lhs;
+    const int64_t b = *(const int64_t *) rhs;
+    return a < b ? -1 : a > b;
+}
+
+// 경계 고리가 집합의 경계 모서리를 빠짐없이 한 번씩 지나는지, 각 모서리의 왼쪽(바깥에서 볼 때)이 집합 안인지, 한 고리가
+// 같은 정점을 두 번 지나지 않는지 확인한다. 경계 모서리는 모서리 번호를 정렬해서 한 번만 나온 것으로 따로 센다.
+// 어긋난 항목 수를 반환하고, 고리 수를 outLoopCount에 쓴다.
+static int64_t CheckRegionBoundary(int n, const int64_t *segments, int64_t count, int64_t *outLoopCount) {
+    int64_t *set = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    int64_t *edgeIds = malloc(sizeof(int64_t) * (count > 0 ? count * 3 : 1));
+    SegmentRegionBoundary *boundary = ExtractSegmentRegionBoundary(n, count, segments);
+    if (set == NULL || edgeIds == NULL || boundary == NULL) {
+        free(set);
+        free(edgeIds);
+        DestroySegmentRegionBoundary(boundary);
+        *outLoopCount = -1;
+        return 1;
+    }
+
+    memcpy(set, segments, sizeof(int64_t) * count);
+    qsort(set, count, sizeof(int64_t), CompareInt64Value);
+    int64_t unique = 0;
+    for (int64_t i = 0; i < count; i++) {
+        if (unique == 0 || set[unique - 1] != set[i]) {
+            set[unique++] = set[i];
+        }
+    }
+    for (int64_t i = 0; i < unique; i++) {
+        GetSegmentGridEdgeIndices64(n, set[i], edgeIds + i * 3);
+    }
+    qsort(edgeIds, unique * 3, sizeof(int64_t), CompareInt64Value);
+    int64_t expectedEdgeCount = 0;
+    for (int64_t i = 0; i < unique * 3;) {
+        const int repeated = i + 1 < unique * 3 && edgeIds[i + 1] == edgeIds[i];
+        expectedEdgeCount += !repeated;
+        i += repeated ? 2 : 1;
+    }
+
+    int64_t mismatch = 0;
+    const int64_t loopCount = GetSegmentRegionBoundaryLoopCount(boundary);
+    const int64_t *offsets = GetSegmentRegionBoundaryLoopOffsets(boundary);
+    const int64_t *vertices = GetSegmentRegionBoundaryVertexIndices(boundary);
+    mismatch += offsets[0] != 0 || offsets[loopCount] != GetSegmentRegionBoundaryVertexCount(boundary);
+    mismatch += offsets[loopCount] != expectedEdgeCount;
+    GpsCoords *points = malloc(sizeof(GpsCoords) * (offsets[loopCount] + 1));
+    if (points == NULL || GetSegmentRegionBoundaryPoints(boundary, points, NULL, offsets[loopCount]) !=
+                                  offsets[loopCount]) {
+        mismatch++;
+    } else {
+        for (int64_t i = 0; i < offsets[loopCount]; i++) {
+            const GpsCoords expected = CalculateGridVertexLatLng64(n, vertices[i]);
+            mismatch += points[i].lat != expected.lat || points[i].lng != expected.lng;
+        }
+    }
+    free(points);
+    for (int64_t loop = 0; loop < loopCount; loop++) {
+        const int64_t begin = offsets[loop];
+        const int64_t end = offsets[loop + 1];
+        mismatch += end - begin < 3;
+        int64_t *sorted = malloc(sizeof(int64_t) * (end - begin));
+        if (sorted == NULL) {
+            mismatch++;
+            continue;
+        }
+        memcpy(sorted, vertices + begin, sizeof(int64_t) * (end - begin));
+        qsort(sorted, end - begin, sizeof(int64_t), CompareInt64Value);
+        for (int64_t i = begin + 1; i < end; i++) {
+            mismatch += sorted[i - begin - 1] == sorted[i - begin];
+        }
+        free(sorted);
+
+        for (int64_t i = begin; i < end; i++) {
+            const int64_t u = vertices[i];
+            const int64_t v = vertices[i + 1 < end ? i + 1 : begin];
+            int64_t incident[6];
+            const int incidentCount = GetGridVertexSegmentIndices64(n, u, incident);
+            int insideCount = 0;
+            int leftCount = 0;
+            for (int x = 0; x < incidentCount; x++) {
+                int64_t corners[3];
+                GetSegmentGridVertexIndices64(n, incident[x], corners);
+                const int cu = corners[0] == u ? 0 : corners[1] == u ? 1 : 2;
+                const int cv = corners[0] == v ? 0 : corners[1] == v ? 1 : corners[2] == v ? 2 : -1;
+                if (cv < 0 || !bsearch(&incident[x], set, unique, sizeof(int64_t), CompareInt64Value)) {
+                    continue;
+                }
+                // 아래 삼각형의 꼭짓점 순서는 반시계 방향, 위 삼각형은 시계 방향이다.
+                const int top = SplitSegIndexToSegGroupAndAbt64(n, incident[x]).abt.t == Parallelogram_Top;
+                insideCount++;
+                leftCount += (cv == (cu + 1) % 3) != top;
+            }
+            mismatch += insideCount != 1 || leftCount != 1;
+        }
+    }
+
+    *outLoopCount = loopCount;
+    free(set);
+    free(edgeIds);
+    DestroySegmentRegionBoundary(boundary);
+    return mismatch;
+}
+
+// 꼭짓점 근처의 원판과 고리, 면 경계를 넘는 큰 원판, 흩어진 무작위 집합(한 점에서만 맞닿는 곳이 많다), 구 전체와 그
+// 여집합의 경계를 확인하고, 원판 크기를 키워 가며 세그먼트당 시간이 일정한지 잰다.
+static int RunRegionBoundary(int n) {
+    if (n < 8 || n > MaxSubdivisionCount64) {
+        printf("region-boundary: n must be in [8, 1048576]\n");
+        return 1;
+    }
+
+    const int64_t capacity = 4 * 1024 * 1024;
+    int64_t *segments = malloc(sizeof(int64_t) * capacity);
+    if (segments == NULL) {
+        return 1;
+    }
+
+    int64_t mismatch = 0;
+    int64_t loopCount;
+    int64_t cornerSegments[6];
+    GetGridVertexSegmentIndices64(n, 0, cornerSegments);
+
+    // 세그먼트 하나
+    mismatch += CheckRegionBoundary(n, cornerSegments, 1, &loopCount);
+    mismatch += loopCount != 1;
+
+    // 정이십면체 꼭짓점의 다섯 세그먼트, 그리고 그 자리의 원판과 원판 두 배 (중복 입력)
+    mismatch += CheckRegionBoundary(n, cornerSegments, 5, &loopCount);
+    mismatch += loopCount != 1;
+    int64_t count = GetKRingOfSegmentIndex64(n, cornerSegments[0], 5, segments, capacity);
+    memcpy(segments + count, segments, sizeof(int64_t) * count);
+    mismatch += CheckRegionBoundary(n, segments, count * 2, &loopCount);
+    mismatch += loopCount != 1;
+
+    // 구멍 하나가 있는 고리: 거리 3 .. 5인 세그먼트
+    count = 0;
+    for (int k = 3; k <= 5; k++) {
+        count += GetHollowRingOfSegmentIndex64(n, cornerSegments[0], k, segments + count, capacity - count);
+    }
+    mismatch += CheckRegionBoundary(n, segments, count, &loopCount);
+    mismatch += loopCount != 2;
+
+    // 흩어진 무작위 집합
+    for (int trial = 0; trial < 20; trial++) {
+        const int64_t disk = GetKRingOfSegmentIndex64(n, cornerSegments[trial % 5], 4 + trial, segments, capacity);
+        count = 0;
+        for (int64_t i = 0; i < disk; i++) {
+            if (NextRandom() % 3 == 0) {
+                segments[count++] = segments[i];
+            }
+        }
+        mismatch += CheckRegionBoundary(n, segments, count, &loopCount);
+    }
+
+    // 구 전체(고리 없음)와 세그먼트 하나를 뺀 여집합 (시계 방향 고리 하나)
+    const int smallN = 8;
+    const int64_t smallCount = (int64_t) smallN * smallN * GroupCount;
+    for (int64_t i = 0; i < smallCount; i++) {
+        segments[i] = i;
+    }
+    mismatch += CheckRegionBoundary(smallN, segments, smallCount, &loopCount);
+    mismatch += loopCount != 0;
+    mismatch += CheckRegionBoundary(smallN, segments + 1, smallCount - 1, &loopCount);
+    mismatch += loopCount != 1;
+
+    mismatch += ExtractSegmentRegionBoundary(n, 1, (const int64_t[]) {(int64_t) n * n * GroupCount}) != NULL;
+    mismatch += ExtractSegmentRegionBoundary(0, 0, NULL) != NULL;
+    printf("region-boundary: n=%d, %lld mismatches\n", n, (long long) mismatch);
+
+    const int64_t center = cornerSegments[0] + (int64_t) n * n / 2;
+    for (int k = 50; k <= 800 && mismatch == 0; k *= 2) {
+        count = GetKRingOfSegmentIndex64(n, center, k, segments, capacity);
+        if (count < 0) {
+            break;
+        }
+        const double t0 = NowSeconds();
+        SegmentRegionBoundary *boundary = ExtractSegmentRegionBoundary(n, count, segments);
+        const double t1 = NowSeconds();
+        printf("  k=%d: %lld segments -> %lld loops, %lld vertices in %.2f ms (%.1f ns/segment)\n", k,
+               (long long) count, (long long) GetSegmentRegionBoundaryLoopCount(boundary),
+               (long long) GetSegmentRegionBoundaryVertexCount(boundary), (t1 - t0) * 1e3,
+               (t1 - t0) * 1e9 / (double) count);
+        DestroySegmentRegionBoundary(boundary);
+    }
+
+    free(segments);
+    return mismatch != 0;
+}
+
+static void PrintUsage(void) {
+    printf("usage: sphere_uniform_geocoding_test <command> [args]\n");
+    printf("  face-selection [count]    compare direct face selection against the full face scan\n");
+    printf("  abt-decoding [n]          check closed-form local index decoding against a row walk for every index\n");
+    printf("  index64 [n]               check the 64-bit index API against the 32-bit one and for self-consistency\n");
+    printf("  latlng-precision [count]  compare accuracy and throughput of the lat/lng conversion modes\n");
+    printf("  neighbor-csr [n]          check the CSR batch neighbor query against single calls\n");
+    printf("  adjacency-table [n] [path] write, map and verify an adjacency table file and time lookups (n = 16..1024)\n");
+    printf("  k-ring [n] [k]            check k-ring/hollow ring queries against a plain traversal and time them\n");
+    printf("  polygon-fill [n]          check polygon fill against a per-segment test and time it\n");
+    printf("  cap [n]                   check spherical cap queries against per-segment distances and time them\n");
+    printf("  latlng-box [n]            check lat/lng box queries against per-segment tests and time streaming\n");
+    printf("  parent-child [n] [k]      check n <-> k*n parent/child mapping and time it against re-geocoding\n");
+    printf("  compact-set [n]           check multi-resolution compaction round trips and measure its size\n");
+    printf("  aggregate [n] [count]     check multithreaded point aggregation and measure per-thread throughput\n");
+    printf("  thread-pool [count]       check batch functions on the work-stealing pool against one thread\n");
+    printf("  globe-mesh [n]            check the shared-vertex globe mesh against segment corners and time it\n");
+    printf("  globe-patch [n]           check LOD patches at every patchN/detailN against the globe mesh\n");
+    printf("  grid-topology [n]         check vertex/edge ids and incidence queries for every segment\n");
+    printf("  region-boundary [n]       check region outlines of segment sets and time them\n");
+    printf("  neighbor-interior [n]     check the interior neighbor fast path and time interior/boundary segments\n");
+}
+
+int main(int argc, char **argv) {
+    if (argc >= 2 && strcmp(argv[1], "face-selection") == 0) {
+        return RunFaceSelection(argc >= 3 ? atoi(argv[2]) : 1000000);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "abt-decoding") == 0) {
+        return RunAbtDecoding(argc >= 3 ? atoi(argv[2]) : 8192);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "index64") == 0) {
+        return RunIndex64(argc >= 3 ? atoi(argv[2]) : MaxSubdivisionCount64);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "latlng-precision") == 0) {
+        return RunLatLngPrecision(argc >= 3 ? atoi(argv[2]) : 10000000);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "neighbor-csr") == 0) {
+        return RunNeighborCsr(argc >= 3 ? atoi(argv[2]) : 1024);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "adjacency-table") == 0) {
+        return RunAdjacencyTable(argc >= 3 ? atoi(argv[2]) : 0, argc >= 4 ? argv[3] : "adjacency.bin");
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "neighbor-interior") == 0) {
+        return RunNeighborInterior(argc >= 3 ? atoi(argv[2]) : 1024);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "k-ring") == 0) {
+        return RunKRing(argc >= 3 ? atoi(argv[2]) : 1024, argc >= 4 ? atoi(argv[3]) : 10);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "polygon-fill") == 0) {
+        return RunPolygonFill(argc >= 3 ? atoi(argv[2]) : 4096);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "cap") == 0) {
+        return RunCap(argc >= 3 ? atoi(argv[2]) : 14654);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "latlng-box") == 0) {
+        return RunLatLngBox(argc >= 3 ? atoi(argv[2]) : 14654);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "parent-child") == 0) {
+        return RunParentChild(argc >= 3 ? atoi(argv[2]) : 512, argc >= 4 ? atoi(argv[3]) : 8);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "compact-set") == 0) {
+        return RunCompactSet(argc >= 3 ? atoi(argv[2]) : 4096);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "aggregate") == 0) {
+        return RunAggregate(argc >= 3 ? atoi(argv[2]) : 4096, argc >= 4 ? atoi(argv[3]) : 20000000);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "thread-pool") == 0) {
+        return RunThreadPool(argc >= 3 ? atoi(argv[2]) : 1000000);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "globe-mesh") == 0) {
+        return RunGlobeMesh(argc >= 3 ? atoi(argv[2]) : 256);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "globe-patch") == 0) {
+        return RunGlobePatch(argc >= 3 ? atoi(argv[2]) : 48);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "grid-topology") == 0) {
+        return RunGridTopology(argc >= 3 ? atoi(argv[2]) : 64);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "region-boundary") == 0) {
+        return RunRegionBoundary(argc >= 3 ? atoi(argv[2]) : 4096);
+    }
+
+    PrintUsage();
+    return argc >= 2;
+}
@@ -1,7 +1,16 @@
 #include <math.h>
 #include <limits.h>
+#include <string.h>
+
+#if !_WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#endif
 
 #include "sphere_uniform_geocoding.h"
+#include "sphere_uniform_geocoding_internal.h"
 
 // A very short-lived native function.
 //
@@ -25,14 +34,7 @@ FFI_PLUGIN_EXPORT intptr_t sum_long_running(intptr_t a, intptr_t b) {
     return a + b;
 }
 
-#define NELEMS(x)  (sizeof(x) / sizeof((x)[0]))
-
 #define Deg2Rad (0.017453292)
-#ifndef M_PI
-#    define M_PI (3.14159265358979323846)
-#endif
-
-#define GroupCount (20)
 
 //void calculate_wh(void) {
 //    Hh = 2 / sqrt(10 + 2 * sqrt_5);
@@ -65,14 +67,6 @@ typedef enum {
     Parallelogram_Error,
 } Parallelogram;
 
-typedef enum {
-    ErrorCode_None,
-    ErrorCode_LogicError_NoIntersection = -1,
-    ErrorCode_NullPtr = -2,
-    ErrorCode_Argument_NullPtr = -3,
-    ErrorCode_ArgumentOutOfRangeException = -4,
-} ErrorCode;
-
 typedef struct {
     int segGroupIndex;
     EdgeNeighbor edgeNeighbor;
@@ -91,6 +85,37 @@ typedef struct {
     AbtCoords abt;
 } SegGroupAndAbt;
 
+#if _WIN32
+#define CACHE_ALIGNED __declspec(align(64))
+#else
+#define CACHE_ALIGNED __attribute__((aligned(64)))
+#endif
+
+// n과 세그먼트 그룹만으로 정해지는 값들. 좌표 변환을 할 때마다 다시 계산하지 않도록 묶어 둔다.
+typedef struct CACHE_ALIGNED {
+    // CalculateAbCoords()에서 쓰는 값 (IcosahedronGeometry의 segGroupTriList 기준)
+    Vector3 ip0;
+    Vector3 p01;
+    Vector3 p02;
+    double p01SqrMagnitude;
+    double p02SqrMagnitude;
+    double p01TanDeltaMagnitude;
+    double p02TanDeltaMagnitude;
+    // 세그먼트 중심, 꼭짓점 계산에서 쓰는 값 (IcosahedronGeometry의 vertices 기준)
+    Vector3 origin;
+    Vector3 axisA;
+    Vector3 axisB;
+} SegmentGroupConstants;
+
+struct GeocodingContext {
+    SegmentGroupConstants segGroupConstants[20];
+    int n;
+    int segmentCountPerGroup;
+    int64_t segmentCount;
+    // 중심, 꼭짓점의 위도, 경도 계산 방식. 만들 때 정하고 바꾸지 않으므로 여러 스레드가 함께 써도 된다.
+    LatLngPrecision precision;
+};
+
 const int VertIndexPerFaces[20][3] = {
         {0, 1,  7}, // Face 0
         {0, 4,  1}, // Face 1
@@ -232,6 +257,130 @@ const Vector3 SegmentGroupTriList[20][3] = {
         },
 };
 
+// 각 면(세그먼트 그룹)의 중심 방향 단위 벡터. SegmentGroupTriList 세 꼭짓점의 합을 정규화한 값이다.
+const Vector3 SegmentGroupNormalList[20] = {
+        {0.3568221,  0,          -0.9341724}, // Face 0
+        {-0.3568221, 0,          -0.9341724}, // Face 1
+        {0.5773503,  -0.5773503, -0.5773503}, // Face 2
+        {-0.5773503, -0.5773503, -0.5773503}, // Face 3
+        {0,          -0.9341724, -0.3568221}, // Face 4
+        {0,          0.9341724,  -0.3568221}, // Face 5
+        {0.5773503,  0.5773503,  -0.5773503}, // Face 6
+        {-0.5773503, 0.5773503,  -0.5773503}, // Face 7
+        {0.3568221,  0,          0.9341724}, // Face 8
+        {-0.3568221, 0,          0.9341724}, // Face 9
+        {0.5773503,  0.5773503,  0.5773503}, // Face 10
+        {0,          0.9341724,  0.3568221}, // Face 11
+        {-0.5773503, 0.5773503,  0.5773503}, // Face 12
+        {-0.5773503, -0.5773503, 0.5773503}, // Face 13
+        {0,          -0.9341724, 0.3568221}, // Face 14
+        {0.5773503,  -0.5773503, 0.5773503}, // Face 15
+        {-0.9341724, 0.3568221,  0}, // Face 16
+        {-0.9341724, -0.3568221, 0}, // Face 17
+        {0.9341724,  0.3568221,  0}, // Face 18
+        {0.9341724,  -0.3568221, 0}, // Face 19
+};
+
+// 정이십면체 꼭짓점 (0, ±1, ±φ)의 순환을 정규화한 좌표 성분과, 면 중심 방향 단위 벡터의 좌표 성분
+#define IcosahedronVertexShort (0.52573111211913359)
+#define IcosahedronVertexLong (0.85065080835203988)
+#define IcosahedronFaceNormalShort (0.35682208977308993)
+#define IcosahedronFaceNormalLong (0.93417235896271567)
+#define IcosahedronFaceNormalDiagonal (0.57735026918962573)
+
+#define ExactVertex0 {0, -IcosahedronVertexShort, -IcosahedronVertexLong}
+#define ExactVertex1 {0, IcosahedronVertexShort, -IcosahedronVertexLong}
+#define ExactVertex2 {0, IcosahedronVertexShort, IcosahedronVertexLong}
+#define ExactVertex3 {0, -IcosahedronVertexShort, IcosahedronVertexLong}
+#define ExactVertex4 {-IcosahedronVertexLong, 0, -IcosahedronVertexShort}
+#define ExactVertex5 {-IcosahedronVertexLong, 0, IcosahedronVertexShort}
+#define ExactVertex6 {IcosahedronVertexLong, 0, IcosahedronVertexShort}
+#define ExactVertex7 {IcosahedronVertexLong, 0, -IcosahedronVertexShort}
+#define ExactVertex8 {-IcosahedronVertexShort, -IcosahedronVertexLong, 0}
+#define ExactVertex9 {IcosahedronVertexShort, -IcosahedronVertexLong, 0}
+#define ExactVertex10 {IcosahedronVertexShort, IcosahedronVertexLong, 0}
+#define ExactVertex11 {-IcosahedronVertexShort, IcosahedronVertexLong, 0}
+
+// Vertices, SegmentGroupTriList, SegmentGroupNormalList를 배정밀도로 정확하게 다시 계산한 표.
+// 기존 표는 유효숫자가 7자리이고 서로 1e-6 정도 어긋나 있어서, n이 커지면 세그먼트 중심과 꼭짓점이 이웃 세그먼트로
+// 지오코딩된다. 32비트 인덱스가 이미 쓰이는 n에서는 번호를 바꾸지 않도록 기존 표를 그대로 쓰고,
+// 64비트 API에서만 쓰는 n(MaxSubdivisionCount32 초과)에서는 세 계산 모두 이 표를 쓴다.
+static const Vector3 ExactVertices[] = {
+        ExactVertex0,
+        ExactVertex1,
+        ExactVertex2,
+        ExactVertex3,
+        ExactVertex4,
+        ExactVertex5,
+        ExactVertex6,
+        ExactVertex7,
+        ExactVertex8,
+        ExactVertex9,
+        ExactVertex10,
+        ExactVertex11,
+};
+
+static const Vector3 ExactSegmentGroupTriList[20][3] = {
+        {ExactVertex0, ExactVertex1, ExactVertex7}, // Face 0
+        {ExactVertex0, ExactVertex4, ExactVertex1}, // Face 1
+        {ExactVertex0, ExactVertex7, ExactVertex9}, // Face 2
+        {ExactVertex0, ExactVertex8, ExactVertex4}, // Face 3
+        {ExactVertex0, ExactVertex9, ExactVertex8}, // Face 4
+        {ExactVertex1, ExactVertex11, ExactVertex10}, // Face 5
+        {ExactVertex1, ExactVertex10, ExactVertex7}, // Face 6
+        {ExactVertex1, ExactVertex4, ExactVertex11}, // Face 7
+        {ExactVertex2, ExactVertex3, ExactVertex6}, // Face 8
+        {ExactVertex2, ExactVertex5, ExactVertex3}, // Face 9
+        {ExactVertex2, ExactVertex6, ExactVertex10}, // Face 10
+        {ExactVertex2, ExactVertex10, ExactVertex11}, // Face 11
+        {ExactVertex2, ExactVertex11, ExactVertex5}, // Face 12
+        {ExactVertex3, ExactVertex5, ExactVertex8}, // Face 13
+        {ExactVertex3, ExactVertex8, ExactVertex9}, // Face 14
+        {ExactVertex3, ExactVertex9, ExactVertex6}, // Face 15
+        {ExactVertex4, ExactVertex5, ExactVertex11}, // Face 16
+        {ExactVertex4, ExactVertex8, ExactVertex5}, // Face 17
+        {ExactVertex6, ExactVertex7, ExactVertex10}, // Face 18
+        {ExactVertex6, ExactVertex9, ExactVertex7}, // Face 19
+};
+
+static const Vector3 ExactSegmentGroupNormalList[20] = {
+        {IcosahedronFaceNormalShort, 0, -IcosahedronFaceNormalLong}, // Face 0
+        {-IcosahedronFaceNormalShort, 0, -IcosahedronFaceNormalLong}, // Face 1
+        {IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal}, // Face 2
+        {-IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal}, // Face 3
+        {0, -IcosahedronFaceNormalLong, -IcosahedronFaceNormalShort}, // Face 4
+        {0, IcosahedronFaceNormalLong, -IcosahedronFaceNormalShort}, // Face 5
+        {IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal}, // Face 6
+        {-IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal}, // Face 7
+        {IcosahedronFaceNormalShort, 0, IcosahedronFaceNormalLong}, // Face 8
+        {-IcosahedronFaceNormalShort, 0, IcosahedronFaceNormalLong}, // Face 9
+        {IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal}, // Face 10
+        {0, IcosahedronFaceNormalLong, IcosahedronFaceNormalShort}, // Face 11
+        {-IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal}, // Face 12
+        {-IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal}, // Face 13
+        {0, -IcosahedronFaceNormalLong, IcosahedronFaceNormalShort}, // Face 14
+        {IcosahedronFaceNormalDiagonal, -IcosahedronFaceNormalDiagonal, IcosahedronFaceNormalDiagonal}, // Face 15
+        {-IcosahedronFaceNormalLong, IcosahedronFaceNormalShort, 0}, // Face 16
+        {-IcosahedronFaceNormalLong, -IcosahedronFaceNormalShort, 0}, // Face 17
+        {IcosahedronFaceNormalLong, IcosahedronFaceNormalShort, 0}, // Face 18
+        {IcosahedronFaceNormalLong, -IcosahedronFaceNormalShort, 0}, // Face 19
+};
+
+// 면 판정(SegmentGroupTriList, SegmentGroupNormalList)과 세그먼트 중심, 꼭짓점 계산(Vertices)이 함께 쓰는 표 묶음
+typedef struct {
+    const Vector3 *vertices;
+    const Vector3 (*segGroupTriList)[3];
+    const Vector3 *segGroupNormalList;
+} IcosahedronGeometry;
+
+static const IcosahedronGeometry TableIcosahedron = {Vertices, SegmentGroupTriList, SegmentGroupNormalList};
+static const IcosahedronGeometry ExactIcosahedron = {ExactVertices, ExactSegmentGroupTriList,
+                                                     ExactSegmentGroupNormalList};
+
+static const IcosahedronGeometry *GetIcosahedronGeometry(int n) {
+    return n > MaxSubdivisionCount32 ? &ExactIcosahedron : &TableIcosahedron;
+}
+
 const AxisOrientation FaceAxisOrientationList[20] = {
         AxisOrientation_CW,
         AxisOrientation_CW,
@@ -358,7 +507,7 @@ const NeighborInfo NeighborFaceInfoList[20][3] = {
         },
 };
 
-static Vector3 CalculateUnitSpherePosition(double lat, double lng) {
+INTERNAL_EXPORT Vector3 CalculateUnitSpherePosition(double lat, double lng) {
     double cLat = cos(lat);
     double sLat = sin(lat);
 
@@ -372,19 +521,19 @@ static Vector3 NegateVector3(Vector3 v) {
     return (Vector3) {.x = -v.x, .y = -v.y, .z = -v.z};
 }
 
-static Vector3 AddVector3(Vector3 a, Vector3 b) {
+INTERNAL_EXPORT Vector3 AddVector3(Vector3 a, Vector3 b) {
     return (Vector3) {.x = a.x + b.x, .y = a.y + b.y, .z = a.z + b.z};
 }
 
-static Vector3 DiffVector3(Vector3 a, Vector3 b) {
+INTERNAL_EXPORT Vector3 DiffVector3(Vector3 a, Vector3 b) {
     return (Vector3) {.x = a.x - b.x, .y = a.y - b.y, .z = a.z - b.z};
 }
 
-static double Dot(Vector3 v1, Vector3 v2) {
+INTERNAL_EXPORT double Dot(Vector3 v1, Vector3 v2) {
     return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
 }
 
-static Vector3 Cross(Vector3 v1, Vector3 v2) {
+INTERNAL_EXPORT Vector3 Cross(Vector3 v1, Vector3 v2) {
     return (Vector3) {
             v1.y * v2.z - v1.z * v2.y,
             v1.z * v2.x - v1.x * v2.z,
@@ -408,10 +557,42 @@ static double Magnitude(Vector3 v) {
     return sqrt(SqrMagnitude(v));
 }
 
-static Vector3 ScalarMultiplyVector(double s, Vector3 v) {
+INTERNAL_EXPORT Vector3 ScalarMultiplyVector(double s, Vector3 v) {
     return (Vector3) {.x = s * v.x, .y = s * v.y, .z = s * v.z};
 }
 
+// CalculateAbCoords()에서 쓰는 값만 채운다. n은 어느 표를 쓸지만 정하며, 위도, 경도에서 세그먼트를 찾을 때만 필요하다.
+static void CalculateSegmentGroupAbConstants(SegmentGroupConstants *out, int n, int segGroupIndex) {
+    const Vector3 *triList = GetIcosahedronGeometry(n)->segGroupTriList[segGroupIndex];
+    out->ip0 = triList[0];
+    out->p01 = DiffVector3(triList[1], triList[0]);
+    out->p02 = DiffVector3(triList[2], triList[0]);
+    out->p01SqrMagnitude = SqrMagnitude(out->p01);
+    out->p02SqrMagnitude = SqrMagnitude(out->p02);
+
+    const double tanDelta = Magnitude(Cross(out->p01, out->p02)) / Dot(out->p01, out->p02);
+    out->p01TanDeltaMagnitude = tanDelta * Magnitude(out->p01);
+    out->p02TanDeltaMagnitude = tanDelta * Magnitude(out->p02);
+}
+
+// 세그먼트 중심, 꼭짓점 계산에서 쓰는 값(origin, axisA, axisB)만 채운다.
+static void CalculateSegmentGroupAxisConstants(SegmentGroupConstants *out, int n, int segGroupIndex) {
+    const Vector3 *vertices = GetIcosahedronGeometry(n)->vertices;
+    const Vector3 segGroupVerts[] = {
+            vertices[VertIndexPerFaces[segGroupIndex][0]],
+            vertices[VertIndexPerFaces[segGroupIndex][1]],
+            vertices[VertIndexPerFaces[segGroupIndex][2]],
+    };
+    out->origin = segGroupVerts[0];
+    out->axisA = ScalarMultiplyVector(1.0 / n, DiffVector3(segGroupVerts[1], segGroupVerts[0]));
+    out->axisB = ScalarMultiplyVector(1.0 / n, DiffVector3(segGroupVerts[2], segGroupVerts[0]));
+}
+
+static void CalculateSegmentGroupConstants(SegmentGroupConstants *out, int n, int segGroupIndex) {
+    CalculateSegmentGroupAbConstants(out, n, segGroupIndex);
+    CalculateSegmentGroupAxisConstants(out, n, segGroupIndex);
+}
+
 #define Epsilon (0.000001)
 
 static ErrorCode GetTimeAndUvCoord(Vector3 *output, Vector3 rayOrigin, Vector3 rayDirection, const Vector3 *vert0,
@@ -462,19 +643,15 @@ static ErrorCode GetTimeAndUvCoord(Vector3 *output, Vector3 rayOrigin, Vector3 r
     return ErrorCode_None;
 }
 
-static AbtCoords
-CalculateAbCoords(int n, const Vector3 *ip0, const Vector3 *ip1, const Vector3 *ip2, Vector3 intersect) {
-    Vector3 p = DiffVector3(intersect, *ip0);
-    Vector3 p01 = DiffVector3(*ip1, *ip0);
-    Vector3 p02 = DiffVector3(*ip2, *ip0);
-
-    double a = Dot(p, p01) / SqrMagnitude(p01);
-    double b = Dot(p, p02) / SqrMagnitude(p02);
+static AbtCoords CalculateAbCoords(int n, const SegmentGroupConstants *segGroupConstants, Vector3 intersect) {
+    const SegmentGroupConstants *c = segGroupConstants;
+    Vector3 p = DiffVector3(intersect, c->ip0);
 
-    double tanDelta = Magnitude(Cross(p01, p02)) / Dot(p01, p02);
+    double a = Dot(p, c->p01) / c->p01SqrMagnitude;
+    double b = Dot(p, c->p02) / c->p02SqrMagnitude;
 
-    double ap = a - Magnitude(DiffVector3(p, ScalarMultiplyVector(a, p01))) / (tanDelta * Magnitude(p01));
-    double bp = b - Magnitude(DiffVector3(p, ScalarMultiplyVector(b, p02))) / (tanDelta * Magnitude(p02));
+    double ap = a - Magnitude(DiffVector3(p, ScalarMultiplyVector(a, c->p01))) / c->p01TanDeltaMagnitude;
+    double bp = b - Magnitude(DiffVector3(p, ScalarMultiplyVector(b, c->p02))) / c->p02TanDeltaMagnitude;
 
     double api, bpi;
     double apf = modf(ap * n, &api);
@@ -485,7 +662,7 @@ CalculateAbCoords(int n, const Vector3 *ip0, const Vector3 *ip1, const Vector3 *
 }
 
 // n(분할 횟수), AB 좌표, top여부 세 개를 조합해 세그먼트 그룹 내 인덱스를 계산하여 반환한다.
-static int ConvertToLocalSegmentIndex(int n, int a, int b, Parallelogram top) {
+static int64_t ConvertToLocalSegmentIndex(int n, int a, int b, Parallelogram top) {
     if (n <= 0) {
         //throw new ArgumentOutOfRangeException(nameof(n));
         return ErrorCode_ArgumentOutOfRangeException;
@@ -502,11 +679,11 @@ static int ConvertToLocalSegmentIndex(int n, int a, int b, Parallelogram top) {
         return ErrorCode_ArgumentOutOfRangeException;
     }
 
-    const int parallelogramIndex = b * n - (b - 1) * b / 2 + a;
+    const int64_t parallelogramIndex = (int64_t) b * n - (int64_t) (b - 1) * b / 2 + a;
     return parallelogramIndex * 2 - b + (top ? 1 : 0);
 }
 
-static int ConvertToLocalSegmentIndex2(int n, AbtCoords abtCoords) {
+static int64_t ConvertToLocalSegmentIndex2(int n, AbtCoords abtCoords) {
     return ConvertToLocalSegmentIndex(n, abtCoords.a, abtCoords.b, abtCoords.t);
 }
 
@@ -514,6 +691,10 @@ static int CalculateSegmentCountPerGroup(int n) {
     return n * n;
 }
 
+INTERNAL_EXPORT int64_t CalculateSegmentCountPerGroup64(int n) {
+    return (int64_t) n * n;
+}
+
 FFI_PLUGIN_EXPORT int ConvertToSegmentIndex2(const int n, int segmentGroupIndex, int localSegmentIndex) {
     uint32_t segmentCountPerGroup = CalculateSegmentCountPerGroup(n);
     if (segmentGroupIndex < 0 || segmentGroupIndex >= GroupCount) {
@@ -529,105 +710,586 @@ FFI_PLUGIN_EXPORT int ConvertToSegmentIndex2(const int n, int segmentGroupIndex,
 
 // 세그먼트 그룹 인덱스, n(분할 횟수), AB 좌표, top여부 네 개를 조합 해 전역 세그먼트 인덱스를 계산하여 반환한다.
 static int ConvertToSegmentIndex(int segmentGroupIndex, int n, int a, int b, Parallelogram top) {
-    const int localSegmentIndex = ConvertToLocalSegmentIndex(n, a, b, top);
+    const int localSegmentIndex = (int) ConvertToLocalSegmentIndex(n, a, b, top);
 
     return ConvertToSegmentIndex2(n, segmentGroupIndex, localSegmentIndex);
 }
 
-FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLng(int n, double userPosLat, double userPosLng) {
-    Vector3 userPosFromLatLng = ScalarMultiplyVector(2, CalculateUnitSpherePosition(userPosLat, userPosLng));
+// ConvertToSegmentIndex2()의 64비트 버전. 번호 체계가 같으므로 32비트로 표현되는 n에서는 값도 같다.
+FFI_PLUGIN_EXPORT int64_t ConvertToSegmentIndex64(const int n, int segmentGroupIndex, int64_t localSegmentIndex) {
+    if (n < 1 || n > MaxSubdivisionCount64) {
+        return -1;
+    }
 
-    int segGroupIndex = -1;
-    Vector3 intersect = {0, 0, 0};
-    for (int index = 0; index < NELEMS(SegmentGroupTriList); index++) {
-        const Vector3 *segTriList = SegmentGroupTriList[index];
+    if (segmentGroupIndex < 0 || segmentGroupIndex >= GroupCount) {
+        return -1;
+    }
+
+    const int64_t segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    if (localSegmentIndex < 0 || localSegmentIndex >= segmentCountPerGroup) {
+        return -1;
+    }
+
+    return segmentCountPerGroup * segmentGroupIndex + localSegmentIndex;
+}
+
+// 모든 세그먼트 그룹을 순서대로 검사하여 ray가 처음으로 만나는 세그먼트 그룹 인덱스를 반환한다.
+// 만나는 세그먼트 그룹이 없으면 ErrorCode_LogicError_NoIntersection을 반환한다.
+static int FindSegmentGroupByScan(const IcosahedronGeometry *geometry, Vector3 *intersect, Vector3 rayOrigin) {
+    const Vector3 rayDirection = NegateVector3(rayOrigin);
+    for (int index = 0; index < GroupCount; index++) {
+        const Vector3 *segTriList = geometry->segGroupTriList[index];
         Vector3 intersectTuv;
-        if (GetTimeAndUvCoord(&intersectTuv, userPosFromLatLng, NegateVector3(userPosFromLatLng), segTriList + 0,
-                              segTriList + 1, segTriList + 2) != ErrorCode_NullPtr) {
-            segGroupIndex = index;
-            intersect =
-                    GetTrilinearCoordinateOfTheHit(intersectTuv.x, userPosFromLatLng,
-                                                   NegateVector3(userPosFromLatLng));
-            break;
+        if (GetTimeAndUvCoord(&intersectTuv, rayOrigin, rayDirection, segTriList + 0, segTriList + 1,
+                              segTriList + 2) != ErrorCode_NullPtr) {
+            *intersect = GetTrilinearCoordinateOfTheHit(intersectTuv.x, rayOrigin, rayDirection);
+            return index;
         }
     }
+    return ErrorCode_LogicError_NoIntersection;
+}
 
-    if (segGroupIndex < 0 || segGroupIndex >= 20) {
-        return ErrorCode_LogicError_NoIntersection;
+// 가장 큰 내적과 두 번째로 큰 내적의 차이가 이 값보다 작으면 면 경계 근처로 보고 전체 순회로 되돌아간다.
+// 경계 근처에서는 여러 면과 동시에 교차할 수 있고, 이때 전체 순회가 고르는 면(가장 앞선 인덱스)을 유지하기 위함이다.
+#define SegmentGroupSelectionMargin (1e-5)
+
+// 면 중심 방향과의 내적이 가장 큰 세그먼트 그룹을 바로 골라 교차 검사를 한 번만 수행한다.
+// 결과는 FindSegmentGroupByScan()과 항상 같다.
+static int FindSegmentGroup(const IcosahedronGeometry *geometry, Vector3 *intersect, Vector3 rayOrigin) {
+    double bestDot = -2;
+    double secondDot = -2;
+    int best = 0;
+    for (int index = 0; index < GroupCount; index++) {
+        const double d = Dot(rayOrigin, geometry->segGroupNormalList[index]);
+        const int isBest = d > bestDot;
+        secondDot = isBest ? bestDot : (d > secondDot ? d : secondDot);
+        bestDot = isBest ? d : bestDot;
+        best = isBest ? index : best;
     }
 
-    const Vector3 *triList = SegmentGroupTriList[segGroupIndex];
+    if (bestDot - secondDot < SegmentGroupSelectionMargin * Magnitude(rayOrigin)) {
+        return FindSegmentGroupByScan(geometry, intersect, rayOrigin);
+    }
 
-    AbtCoords abtCoords = CalculateAbCoords(n, triList + 0, triList + 1, triList + 2, intersect);
+    const Vector3 rayDirection = NegateVector3(rayOrigin);
+    const Vector3 *segTriList = geometry->segGroupTriList[best];
+    Vector3 intersectTuv;
+    if (GetTimeAndUvCoord(&intersectTuv, rayOrigin, rayDirection, segTriList + 0, segTriList + 1,
+                          segTriList + 2) != ErrorCode_None) {
+        return FindSegmentGroupByScan(geometry, intersect, rayOrigin);
+    }
 
-    return ConvertToSegmentIndex(segGroupIndex, n, abtCoords.a, abtCoords.b, abtCoords.t);
+    *intersect = GetTrilinearCoordinateOfTheHit(intersectTuv.x, rayOrigin, rayDirection);
+    return best;
 }
 
-// AB 좌표의 B 좌표로 시작되는 세그먼트 서브 인덱스의 시작값을 계산한다.
-static int CalculateLocalSegmentIndexForB(int n, int b) {
-    if (n <= 0) {
-        //throw new IndexOutOfRangeException(nameof(n));
-        return ErrorCode_ArgumentOutOfRangeException;
+// 위도, 경도가 가리키는 세그먼트 그룹과 그 안의 ABT 좌표를 계산한다.
+// 만나는 세그먼트 그룹이 없으면 segGroup에 ErrorCode_LogicError_NoIntersection을 담아 반환한다.
+static SegGroupAndAbt CalculateSegGroupAndAbtFromLatLng(int n, double userPosLat, double userPosLng) {
+    Vector3 userPosFromLatLng = ScalarMultiplyVector(2, CalculateUnitSpherePosition(userPosLat, userPosLng));
+
+    Vector3 intersect = {0, 0, 0};
+    const int segGroupIndex = FindSegmentGroup(GetIcosahedronGeometry(n), &intersect, userPosFromLatLng);
+
+    if (segGroupIndex < 0 || segGroupIndex >= 20) {
+        return (SegGroupAndAbt) {.segGroup = ErrorCode_LogicError_NoIntersection};
     }
 
-    return ConvertToLocalSegmentIndex(n, 0, b, Parallelogram_Bottom);
+    SegmentGroupConstants segGroupConstants;
+    CalculateSegmentGroupAbConstants(&segGroupConstants, n, segGroupIndex);
+
+    return (SegGroupAndAbt) {.segGroup = segGroupIndex, .abt = CalculateAbCoords(n, &segGroupConstants, intersect)};
 }
 
-// 세그먼트 서브 인덱스가 주어졌을 때, B 좌표를 이진 탐색 방법으로 찾아낸다.
-// 단, 찾아낸 B 좌표는 b0 ~ b1 범위에 있다고 가정한다.
-static int SearchForB(int n, int b0, int b1, int localSegmentIndex) {
-    if (n <= 0) {
-        //throw new IndexOutOfRangeException(nameof(n));
-        return ErrorCode_ArgumentOutOfRangeException;
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLng(int n, double userPosLat, double userPosLng) {
+    const SegGroupAndAbt segGroupAndAbt = CalculateSegGroupAndAbtFromLatLng(n, userPosLat, userPosLng);
+    if (segGroupAndAbt.segGroup < 0) {
+        return segGroupAndAbt.segGroup;
     }
 
-    if (b0 < 0) {
-        //throw new IndexOutOfRangeException(nameof(b0));
+    const AbtCoords abtCoords = segGroupAndAbt.abt;
+    return ConvertToSegmentIndex(segGroupAndAbt.segGroup, n, abtCoords.a, abtCoords.b, abtCoords.t);
+}
+
+FFI_PLUGIN_EXPORT int64_t CalculateSegmentIndexFromLatLng64(int n, double userPosLat, double userPosLng) {
+    if (n < 1 || n > MaxSubdivisionCount64) {
         return ErrorCode_ArgumentOutOfRangeException;
     }
 
-    if (b1 >= n) {
-        //throw new IndexOutOfRangeException(nameof(b1));
-        return ErrorCode_ArgumentOutOfRangeException;
+    const SegGroupAndAbt segGroupAndAbt = CalculateSegGroupAndAbtFromLatLng(n, userPosLat, userPosLng);
+    if (segGroupAndAbt.segGroup < 0) {
+        return segGroupAndAbt.segGroup;
     }
 
-    if (b0 > b1) {
-        //throw new IndexOutOfRangeException($"{nameof(b0)}, {nameof(b1)}");
-        return ErrorCode_ArgumentOutOfRangeException;
+    return ConvertToSegmentIndex64(n, segGroupAndAbt.segGroup, ConvertToLocalSegmentIndex2(n, segGroupAndAbt.abt));
+}
+
+typedef struct {
+    ParallelTaskFunc func;
+    void *arg;
+    int threadIndex;
+} ParallelTask;
+
+#if _WIN32
+static DWORD WINAPI RunParallelTaskThread(LPVOID param) {
+    const ParallelTask *task = param;
+    task->func(task->arg, task->threadIndex);
+    return 0;
+}
+#else
+static void *RunParallelTaskThread(void *param) {
+    const ParallelTask *task = param;
+    task->func(task->arg, task->threadIndex);
+    return NULL;
+}
+#endif
+
+// func(arg, 0) ~ func(arg, threadCount - 1)을 각자의 스레드에서 실행하고 모두 끝날 때까지 기다린다.
+// 0번은 호출한 스레드에서 실행하며, 스레드를 만들지 못한 몫도 호출한 스레드가 이어서 실행한다.
+INTERNAL_EXPORT void RunParallel(int threadCount, ParallelTaskFunc func, void *arg) {
+    ParallelTask tasks[ParallelMaxThreadCount];
+    int started[ParallelMaxThreadCount] = {0};
+#if _WIN32
+    HANDLE threads[ParallelMaxThreadCount];
+#else
+    pthread_t threads[ParallelMaxThreadCount];
+#endif
+    for (int i = 1; i < threadCount; i++) {
+        tasks[i] = (ParallelTask) {.func = func, .arg = arg, .threadIndex = i};
+#if _WIN32
+        threads[i] = CreateThread(NULL, 0, RunParallelTaskThread, &tasks[i], 0, NULL);
+        started[i] = threads[i] != NULL;
+#else
+        started[i] = pthread_create(&threads[i], NULL, RunParallelTaskThread, &tasks[i]) == 0;
+#endif
+    }
+
+    func(arg, 0);
+    for (int i = 1; i < threadCount; i++) {
+        if (!started[i]) {
+            func(arg, i);
+            continue;
+        }
+#if _WIN32
+        WaitForSingleObject(threads[i], INFINITE);
+        CloseHandle(threads[i]);
+#else
+        pthread_join(threads[i], NULL);
+#endif
     }
+}
 
-    int localIndex0 = CalculateLocalSegmentIndexForB(n, b0);
-    int localIndex1 = CalculateLocalSegmentIndexForB(n, b1);
+INTERNAL_EXPORT int GetProcessorCount(void) {
+#if _WIN32
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int) info.dwNumberOfProcessors;
+#else
+    const long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int) count : 1;
+#endif
+}
 
-    if (localIndex0 > localSegmentIndex || localIndex1 < localSegmentIndex) {
-        //throw new IndexOutOfRangeException(nameof(localSegmentIndex));
-        return ErrorCode_ArgumentOutOfRangeException;
+INTERNAL_EXPORT double GetMonotonicSeconds(void) {
+#if _WIN32
+    LARGE_INTEGER frequency, counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double) counter.QuadPart / (double) frequency.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double) ts.tv_sec + (double) ts.tv_nsec * 1e-9;
+#endif
+}
+
+// 일괄 처리 함수가 스레드 풀에서 나누어 실행하는 구간 함수. [begin, end)를 처리하고 ErrorCode를 반환한다.
+typedef int (*BatchRangeFunc)(void *arg, int64_t begin, int64_t end);
+
+// 일괄 처리를 이 개수보다 작은 조각으로는 나누지 않는다. 조각 하나가 수십 마이크로초는 걸리도록 잡은 값이다.
+#define BatchMinChunkSize (1024)
+// 훔쳐 갈 일감이 남도록 스레드마다 이만큼의 조각으로 나눈다.
+#define BatchChunksPerThread (8)
+
+#if _WIN32
+typedef CRITICAL_SECTION PoolMutex;
+typedef CONDITION_VARIABLE PoolCond;
+
+static void InitPoolMutex(PoolMutex *mutex) { InitializeCriticalSection(mutex); }
+static void InitPoolCond(PoolCond *cond) { InitializeConditionVariable(cond); }
+static void DestroyPoolMutex(PoolMutex *mutex) { DeleteCriticalSection(mutex); }
+static void DestroyPoolCond(PoolCond *cond) { (void) cond; }
+static void LockPoolMutex(PoolMutex *mutex) { EnterCriticalSection(mutex); }
+static void UnlockPoolMutex(PoolMutex *mutex) { LeaveCriticalSection(mutex); }
+static void WaitPoolCond(PoolCond *cond, PoolMutex *mutex) { SleepConditionVariableCS(cond, mutex, INFINITE); }
+static void BroadcastPoolCond(PoolCond *cond) { WakeAllConditionVariable(cond); }
+#else
+typedef pthread_mutex_t PoolMutex;
+typedef pthread_cond_t PoolCond;
+
+static void InitPoolMutex(PoolMutex *mutex) { pthread_mutex_init(mutex, NULL); }
+static void InitPoolCond(PoolCond *cond) { pthread_cond_init(cond, NULL); }
+static void DestroyPoolMutex(PoolMutex *mutex) { pthread_mutex_destroy(mutex); }
+static void DestroyPoolCond(PoolCond *cond) { pthread_cond_destroy(cond); }
+static void LockPoolMutex(PoolMutex *mutex) { pthread_mutex_lock(mutex); }
+static void UnlockPoolMutex(PoolMutex *mutex) { pthread_mutex_unlock(mutex); }
+static void WaitPoolCond(PoolCond *cond, PoolMutex *mutex) { pthread_cond_wait(cond, mutex); }
+static void BroadcastPoolCond(PoolCond *cond) { pthread_cond_broadcast(cond); }
+#endif
+
+// 일괄 처리 호출 하나. 조각이 모두 끝나면 호출한 스레드가 깨어난다.
+typedef struct {
+    BatchRangeFunc func;
+    void *arg;
+    // 아직 끝나지 않은 조각 수 (풀 뮤텍스로 보호)
+    int64_t remaining;
+    // 오류가 난 조각 중 가장 앞선 것의 결과. 한 스레드로 처리했을 때와 같은 오류를 돌려주기 위함이다.
+    int error;
+    int64_t errorChunk;
+} PoolJob;
+
+typedef struct {
+    PoolJob *job;
+    int64_t chunk;
+    int64_t begin;
+    int64_t end;
+} PoolTask;
+
+// 작업자마다 하나씩 있는 큐. 일감은 RunBatch()를 부른 스레드만 넣으므로 주인도, 훔치는 스레드도 앞에서 꺼낸다.
+typedef struct {
+    PoolMutex mutex;
+    PoolTask *tasks;
+    int64_t capacity;
+    int64_t head;
+    int64_t count;
+} WorkerDeque;
+
+typedef struct {
+    ThreadPool *pool;
+    int workerIndex;
+} PoolWorkerStart;
+
+struct ThreadPool {
+    int threadCount;
+    WorkerDeque *deques;
+    PoolWorkerStart *starts;
+#if _WIN32
+    HANDLE *threads;
+#else
+    pthread_t *threads;
+#endif
+    PoolMutex mutex;
+    // 큐에 들어 있는 일감 수의 상한. 넣기 전에 늘리고 꺼낸 뒤에 줄이므로 실제보다 작아지지 않는다.
+    int64_t queuedCount;
+    int shuttingDown;
+    // 조각을 나누어 넣기 시작할 큐 (호출마다 돌아가며 바꾼다)
+    int nextDeque;
+    PoolCond workAvailable;
+    PoolCond jobDone;
+};
+
+static int PushPoolTask(WorkerDeque *deque, PoolTask task) {
+    LockPoolMutex(&deque->mutex);
+    if (deque->count == deque->capacity) {
+        const int64_t capacity = deque->capacity > 0 ? deque->capacity * 2 : 64;
+        PoolTask *tasks = malloc(sizeof(PoolTask) * capacity);
+        if (tasks == NULL) {
+            UnlockPoolMutex(&deque->mutex);
+            return 0;
+        }
+        for (int64_t i = 0; i < deque->count; i++) {
+            tasks[i] = deque->tasks[(deque->head + i) % deque->capacity];
+        }
+        free(deque->tasks);
+        deque->tasks = tasks;
+        deque->capacity = capacity;
+        deque->head = 0;
     }
+    deque->tasks[(deque->head + deque->count) % deque->capacity] = task;
+    deque->count++;
+    UnlockPoolMutex(&deque->mutex);
+    return 1;
+}
+
+static int PopPoolTask(WorkerDeque *deque, PoolTask *task) {
+    LockPoolMutex(&deque->mutex);
+    const int found = deque->count > 0;
+    if (found) {
+        *task = deque->tasks[deque->head];
+        deque->head = (deque->head + 1) % deque->capacity;
+        deque->count--;
+    }
+    UnlockPoolMutex(&deque->mutex);
+    return found;
+}
 
-    if (localIndex0 == localSegmentIndex) {
-        return b0;
+// 자기 큐(self)에서 먼저 꺼내고, 비어 있으면 다음 큐들을 차례로 훔쳐 본다. self가 -1이면 훔치기만 한다.
+static int TakePoolTask(ThreadPool *pool, int self, PoolTask *task) {
+    int found = self >= 0 && PopPoolTask(&pool->deques[self], task);
+    const int start = self >= 0 ? self : 0;
+    for (int i = 1; i <= pool->threadCount && !found; i++) {
+        found = PopPoolTask(&pool->deques[(start + i) % pool->threadCount], task);
     }
+    if (found) {
+        LockPoolMutex(&pool->mutex);
+        pool->queuedCount--;
+        UnlockPoolMutex(&pool->mutex);
+    }
+    return found;
+}
 
-    if (localIndex1 == localSegmentIndex) {
-        return b1;
+static void RunPoolTask(ThreadPool *pool, const PoolTask *task) {
+    const int result = task->job->func(task->job->arg, task->begin, task->end);
+
+    LockPoolMutex(&pool->mutex);
+    PoolJob *job = task->job;
+    if (result != ErrorCode_None && (job->error == ErrorCode_None || task->chunk < job->errorChunk)) {
+        job->error = result;
+        job->errorChunk = task->chunk;
+    }
+    if (--job->remaining == 0) {
+        BroadcastPoolCond(&pool->jobDone);
     }
+    UnlockPoolMutex(&pool->mutex);
+}
 
-    while (b1 - b0 > 1) {
-        int bMid = (b0 + b1) / 2;
-        int v = CalculateLocalSegmentIndexForB(n, bMid) - localSegmentIndex;
-        if (v < 0) {
-            b0 = bMid;
+#if _WIN32
+static DWORD WINAPI RunPoolWorker(LPVOID param) {
+#else
+static void *RunPoolWorker(void *param) {
+#endif
+    const PoolWorkerStart *start = param;
+    ThreadPool *pool = start->pool;
+    for (;;) {
+        PoolTask task;
+        if (TakePoolTask(pool, start->workerIndex, &task)) {
+            RunPoolTask(pool, &task);
             continue;
         }
-        if (v > 0) {
-            b1 = bMid;
-            continue;
+
+        LockPoolMutex(&pool->mutex);
+        while (pool->queuedCount == 0 && !pool->shuttingDown) {
+            WaitPoolCond(&pool->workAvailable, &pool->mutex);
+        }
+        const int exit = pool->shuttingDown && pool->queuedCount == 0;
+        UnlockPoolMutex(&pool->mutex);
+        if (exit) {
+            break;
+        }
+    }
+#if _WIN32
+    return 0;
+#else
+    return NULL;
+#endif
+}
+
+// 작업자 startedCount개를 멈추고 기다린 뒤 풀을 해제한다.
+static void FreeThreadPool(ThreadPool *pool, int startedCount) {
+    LockPoolMutex(&pool->mutex);
+    pool->shuttingDown = 1;
+    BroadcastPoolCond(&pool->workAvailable);
+    UnlockPoolMutex(&pool->mutex);
+    for (int i = 0; i < startedCount; i++) {
+#if _WIN32
+        WaitForSingleObject(pool->threads[i], INFINITE);
+        CloseHandle(pool->threads[i]);
+#else
+        pthread_join(pool->threads[i], NULL);
+#endif
+    }
+
+    for (int i = 0; i < pool->threadCount; i++) {
+        DestroyPoolMutex(&pool->deques[i].mutex);
+        free(pool->deques[i].tasks);
+    }
+    DestroyPoolMutex(&pool->mutex);
+    DestroyPoolCond(&pool->workAvailable);
+    DestroyPoolCond(&pool->jobDone);
+    free(pool->deques);
+    free(pool->starts);
+    free(pool->threads);
+    free(pool);
+}
+
+// 작업자 스레드 threadCount개(0 이하이면 프로세서 수)와 작업자마다 큐 하나를 가진 풀을 만든다.
+// 스레드를 만들지 못하거나 메모리가 부족하면 NULL을 반환한다.
+FFI_PLUGIN_EXPORT ThreadPool *CreateThreadPool(int threadCount) {
+    if (threadCount <= 0) {
+        threadCount = GetProcessorCount();
+    }
+    threadCount = threadCount > ParallelMaxThreadCount ? ParallelMaxThreadCount : threadCount;
+
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->deques = calloc((size_t) threadCount, sizeof(WorkerDeque));
+    pool->starts = calloc((size_t) threadCount, sizeof(PoolWorkerStart));
+    pool->threads = calloc((size_t) threadCount, sizeof(pool->threads[0]));
+    if (pool->deques == NULL || pool->starts == NULL || pool->threads == NULL) {
+        free(pool->deques);
+        free(pool->starts);
+        free(pool->threads);
+        free(pool);
+        return NULL;
+    }
+
+    pool->threadCount = threadCount;
+    InitPoolMutex(&pool->mutex);
+    InitPoolCond(&pool->workAvailable);
+    InitPoolCond(&pool->jobDone);
+    for (int i = 0; i < threadCount; i++) {
+        InitPoolMutex(&pool->deques[i].mutex);
+    }
+
+    for (int i = 0; i < threadCount; i++) {
+        pool->starts[i] = (PoolWorkerStart) {.pool = pool, .workerIndex = i};
+#if _WIN32
+        pool->threads[i] = CreateThread(NULL, 0, RunPoolWorker, &pool->starts[i], 0, NULL);
+        const int started = pool->threads[i] != NULL;
+#else
+        const int started = pthread_create(&pool->threads[i], NULL, RunPoolWorker, &pool->starts[i]) == 0;
+#endif
+        if (!started) {
+            FreeThreadPool(pool, i);
+            return NULL;
+        }
+    }
+    return pool;
+}
+
+// 남은 일감을 모두 처리한 뒤 작업자들을 멈춘다. 이 풀을 넘긴 일괄 처리 호출이 모두 돌아온 뒤에 불러야 한다.
+FFI_PLUGIN_EXPORT void DestroyThreadPool(ThreadPool *pool) {
+    if (pool != NULL) {
+        FreeThreadPool(pool, pool->threadCount);
+    }
+}
+
+FFI_PLUGIN_EXPORT int GetThreadPoolThreadCount(const ThreadPool *pool) {
+    return pool == NULL ? ErrorCode_Argument_NullPtr : pool->threadCount;
+}
+
+// 일괄 처리 하나를 조각으로 나누는 크기. 조각 경계는 입력 개수와 풀의 스레드 수로만 정해진다.
+static int64_t CalculateBatchChunkSize(const ThreadPool *pool, int64_t count) {
+    const int64_t chunkCount = (int64_t) pool->threadCount * BatchChunksPerThread;
+    const int64_t chunkSize = (count + chunkCount - 1) / chunkCount;
+    return chunkSize > BatchMinChunkSize ? chunkSize : BatchMinChunkSize;
+}
+
+// [0, count)를 func로 처리한다. 풀이 있으면 조각으로 나누어 작업자 큐에 돌아가며 넣고, 호출한 스레드도 일감을
+// 훔쳐 돕다가 모두 끝나면 돌아온다. 조각마다 출력 위치가 정해져 있으므로 결과 순서는 스레드 수와 무관하다.
+// 오류가 나면 가장 앞선 조각의 오류를 반환한다.
+static int RunBatch(ThreadPool *pool, int64_t count, BatchRangeFunc func, void *arg) {
+    if (pool == NULL || count < 2 * BatchMinChunkSize) {
+        return count > 0 ? func(arg, 0, count) : ErrorCode_None;
+    }
+
+    const int64_t chunkSize = CalculateBatchChunkSize(pool, count);
+    const int64_t chunkCount = (count + chunkSize - 1) / chunkSize;
+    PoolJob job = {.func = func, .arg = arg, .remaining = chunkCount};
+
+    LockPoolMutex(&pool->mutex);
+    const int first = pool->nextDeque;
+    pool->nextDeque = (pool->nextDeque + 1) % pool->threadCount;
+    pool->queuedCount += chunkCount;
+    UnlockPoolMutex(&pool->mutex);
+
+    // 큐에 넣지 못한 조각은 호출한 스레드가 바로 처리한다.
+    int64_t runInline = 0;
+    for (int64_t c = 0; c < chunkCount; c++) {
+        const int64_t end = (c + 1) * chunkSize < count ? (c + 1) * chunkSize : count;
+        const PoolTask task = {.job = &job, .chunk = c, .begin = c * chunkSize, .end = end};
+        if (!PushPoolTask(&pool->deques[(first + c) % pool->threadCount], task)) {
+            RunPoolTask(pool, &task);
+            runInline++;
+        }
+    }
+
+    LockPoolMutex(&pool->mutex);
+    pool->queuedCount -= runInline;
+    BroadcastPoolCond(&pool->workAvailable);
+    UnlockPoolMutex(&pool->mutex);
+
+    // 이 호출이 끝날 때까지만 돕는다. 다른 호출의 일감을 집을 수도 있지만 그것도 결국 누군가 해야 하는 일이다.
+    for (;;) {
+        LockPoolMutex(&pool->mutex);
+        const int done = job.remaining == 0;
+        UnlockPoolMutex(&pool->mutex);
+        PoolTask task;
+        if (done || !TakePoolTask(pool, -1, &task)) {
+            break;
         }
+        RunPoolTask(pool, &task);
+    }
+
+    LockPoolMutex(&pool->mutex);
+    while (job.remaining > 0) {
+        WaitPoolCond(&pool->jobDone, &pool->mutex);
+    }
+    UnlockPoolMutex(&pool->mutex);
+    return job.error;
+}
+
+// 일괄 처리 함수들이 구간 함수에 넘기는 인자. 함수마다 쓰는 것만 채운다.
+typedef struct {
+    int n;
+    int k;
+    const GeocodingContext *context;
+    const double *lat;
+    const double *lng;
+    const int *segmentIndex;
+    const int64_t *segmentIndex64;
+    void *out;
+    void *out2;
+} BatchArgs;
+
+static int GeocodeBatchRange(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    int *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = CalculateSegmentIndexFromLatLng(args->n, args->lat[i], args->lng[i]);
+    }
+    return ErrorCode_None;
+}
+
+static int GeocodeBatchRange64(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    int64_t *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = CalculateSegmentIndexFromLatLng64(args->n, args->lat[i], args->lng[i]);
+    }
+    return ErrorCode_None;
+}
+
+// 위도, 경도 배열(SoA)을 한 번에 세그먼트 인덱스로 변환해 outSegmentIndex에 쓴다.
+// 개별 지점의 오류는 해당 위치에 음수 ErrorCode로 기록된다.
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLngBatch(ThreadPool *pool, int n, int count, const double *lat,
+                                                           const double *lng, int *outSegmentIndex) {
+    if (lat == NULL || lng == NULL || outSegmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .lat = lat, .lng = lng, .out = outSegmentIndex};
+    return RunBatch(pool, count, GeocodeBatchRange, &args);
+}
+
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLngBatch64(ThreadPool *pool, int n, int count, const double *lat,
+                                                             const double *lng, int64_t *outSegmentIndex) {
+    if (lat == NULL || lng == NULL || outSegmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
 
-        return bMid;
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
     }
 
-    return b0;
+    BatchArgs args = {.n = n, .lat = lat, .lng = lng, .out = outSegmentIndex};
+    return RunBatch(pool, count, GeocodeBatchRange64, &args);
 }
 
 FFI_PLUGIN_EXPORT SegGroupAndLocalSegIndex
@@ -664,16 +1326,62 @@ SplitSegIndexToSegGroupAndLocalSegmentIndex(const int n, const int segmentIndex)
     return (SegGroupAndLocalSegIndex) {.segGroup = quotient, .localSegIndex = remainder};
 }
 
-static AbtCoords SplitLocalSegmentIndexToAbt(int n, int localSegmentIndex) {
+// SplitSegIndexToSegGroupAndLocalSegmentIndex()의 64비트 버전. 세그먼트 인덱스를 부호 없는 32비트로 해석하지 않는다.
+FFI_PLUGIN_EXPORT SegGroupAndLocalSegIndex64
+SplitSegIndexToSegGroupAndLocalSegmentIndex64(const int n, const int64_t segmentIndex) {
+    if (n < 1 || n > MaxSubdivisionCount64) {
+        return (SegGroupAndLocalSegIndex64) {.segGroup = -1, .localSegIndex = -1};
+    }
+
+    const int64_t segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    if (segmentIndex < 0 || segmentIndex >= segmentCountPerGroup * GroupCount) {
+        return (SegGroupAndLocalSegIndex64) {.segGroup = -1, .localSegIndex = -1};
+    }
+
+    return (SegGroupAndLocalSegIndex64) {
+            .segGroup = (int) (segmentIndex / segmentCountPerGroup),
+            .localSegIndex = segmentIndex % segmentCountPerGroup,
+    };
+}
+
+// 세그먼트 서브 인덱스가 주어졌을 때, B 좌표를 이진 탐색 없이 바로 계산한다.
+// B 행의 시작 서브 인덱스는 b * (2n - b) = n^2 - (n - b)^2 이므로,
+// 이 값이 localSegmentIndex 이하가 되는 가장 큰 b는 n - ceil(sqrt(n^2 - localSegmentIndex))이다.
+static int CalculateBFromLocalSegmentIndex(int n, int64_t localSegmentIndex) {
     if (n <= 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t nn = (int64_t) n * n;
+    if (localSegmentIndex < 0 || localSegmentIndex >= nn) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t d = nn - localSegmentIndex;
+    int64_t s = (int64_t) sqrt((double) d);
+    // sqrt() 반올림 오차 보정 (s = floor(sqrt(d)))
+    if (s * s > d) {
+        s--;
+    } else if ((s + 1) * (s + 1) <= d) {
+        s++;
+    }
+    // 올림
+    if (s * s < d) {
+        s++;
+    }
+    return (int) (n - s);
+}
+
+static AbtCoords SplitLocalSegmentIndexToAbt(int n, int64_t localSegmentIndex) {
+    const int b = CalculateBFromLocalSegmentIndex(n, localSegmentIndex);
+    if (b < 0) {
         return (AbtCoords) {.a = INT32_MIN, .b = INT32_MIN, .t = Parallelogram_Error};
     }
 
-    int b = SearchForB(n, 0, n - 1, localSegmentIndex);
-    int a = (localSegmentIndex - CalculateLocalSegmentIndexForB(n, b)) / 2;
-    Parallelogram t = !((b % 2 == 0 && localSegmentIndex % 2 == 0) || (b % 2 == 1 && localSegmentIndex % 2 == 1))
-                      ? Parallelogram_Top
-                      : Parallelogram_Bottom;
+    // B 행의 시작 서브 인덱스 b * (2n - b)는 b와 홀짝이 같다.
+    const int rowOffset = (int) (localSegmentIndex - (int64_t) b * (2 * n - b));
+    const int a = rowOffset / 2;
+    const Parallelogram t = rowOffset % 2 == 1 ? Parallelogram_Top : Parallelogram_Bottom;
     return (AbtCoords) {.a = a, .b = b, .t = t};
 }
 
@@ -683,117 +1391,226 @@ static SegGroupAndAbt SplitSegIndexToSegGroupAndAbt(const int n, const int segme
     return (SegGroupAndAbt) {.segGroup = segGroupAndLocalSegIndex.segGroup, .abt = abt};
 }
 
+static SegGroupAndAbt SplitSegIndexToSegGroupAndAbt64(const int n, const int64_t segmentIndex) {
+    SegGroupAndLocalSegIndex64 segGroupAndLocalSegIndex = SplitSegIndexToSegGroupAndLocalSegmentIndex64(n,
+                                                                                                        segmentIndex);
+    AbtCoords abt = SplitLocalSegmentIndexToAbt(n, segGroupAndLocalSegIndex.localSegIndex);
+    return (SegGroupAndAbt) {.segGroup = segGroupAndLocalSegIndex.segGroup, .abt = abt};
+}
+
 static Vector3 NormalizeVector3(Vector3 v) {
     double m = Magnitude(v);
     return ScalarMultiplyVector(1.0 / m, v);
 }
 
-// Seg Index의 중심 좌표를 계산해서 반환
-FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenter(const int n, const int segmentIndex) {
-    const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbt(n, segmentIndex);
-    //Vector3 segGroupVerts[] = { VertIndexPerFaces[segGroupIndex].Select(e => Vertices[e]).ToArray();
-    const Vector3 segGroupVerts[] = {
-            Vertices[VertIndexPerFaces[segGroupAndAbt.segGroup][0]],
-            Vertices[VertIndexPerFaces[segGroupAndAbt.segGroup][1]],
-            Vertices[VertIndexPerFaces[segGroupAndAbt.segGroup][2]],
-    };
-    const Vector3 axisA = ScalarMultiplyVector(1.0 / n, DiffVector3(segGroupVerts[1], segGroupVerts[0]));
-    const Vector3 axisB = ScalarMultiplyVector(1.0 / n, DiffVector3(segGroupVerts[2], segGroupVerts[0]));
+// 세그먼트 그룹 내 ABT 좌표가 가리키는 세그먼트의 중심 좌표를 계산해서 반환
+static Vector3 CalculateSegmentCenterFromAbt(const SegmentGroupConstants *segGroupConstants, AbtCoords abt) {
+    const Vector3 axisA = segGroupConstants->axisA;
+    const Vector3 axisB = segGroupConstants->axisB;
 
     //Vector3 parallelogramCorner = segGroupVerts[0] + ScalarMultiplyVector(ab.x, axisA) + ScalarMultiplyVector(ab.y * axisB);
     Vector3 parallelogramCorner = {0, 0, 0};
-    parallelogramCorner = AddVector3(parallelogramCorner, segGroupVerts[0]);
-    parallelogramCorner = AddVector3(parallelogramCorner, ScalarMultiplyVector(segGroupAndAbt.abt.a, axisA));
-    parallelogramCorner = AddVector3(parallelogramCorner, ScalarMultiplyVector(segGroupAndAbt.abt.b, axisB));
+    parallelogramCorner = AddVector3(parallelogramCorner, segGroupConstants->origin);
+    parallelogramCorner = AddVector3(parallelogramCorner, ScalarMultiplyVector(abt.a, axisA));
+    parallelogramCorner = AddVector3(parallelogramCorner, ScalarMultiplyVector(abt.b, axisB));
     //Vector3 offset = axisA + axisB;
     const Vector3 offset = AddVector3(axisA, axisB);
     return NormalizeVector3(AddVector3(parallelogramCorner,
-                                       ScalarMultiplyVector(
-                                               1.0 / 3 * (segGroupAndAbt.abt.t == Parallelogram_Top ? 2 : 1), offset)));
+                                       ScalarMultiplyVector(1.0 / 3 * (abt.t == Parallelogram_Top ? 2 : 1), offset)));
 }
 
-// https://stackoverflow.com/questions/1628386/normalise-orientation-between-0-and-360
-// Normalizes any number to an arbitrary range
-// by assuming the range wraps around when going below min or above max
-static double Normalize(double value, double start, double end) {
-    double width = end - start; //
-    double offsetValue = value - start; // value relative to 0
+static Vector3 CalculateSegmentCenterFromSegGroupAndAbt(const int n, const SegGroupAndAbt segGroupAndAbt) {
+    if (segGroupAndAbt.segGroup < 0) {
+        return (Vector3) {0, 0, 0};
+    }
+
+    SegmentGroupConstants segGroupConstants;
+    CalculateSegmentGroupAxisConstants(&segGroupConstants, n, segGroupAndAbt.segGroup);
+    return CalculateSegmentCenterFromAbt(&segGroupConstants, segGroupAndAbt.abt);
+}
 
-    return (offsetValue - (floor(offsetValue / width) * width)) + start;
-    // + start to reset back to start of original range
+// Seg Index의 중심 좌표를 계산해서 반환
+FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenter(const int n, const int segmentIndex) {
+    return CalculateSegmentCenterFromSegGroupAndAbt(n, SplitSegIndexToSegGroupAndAbt(n, segmentIndex));
 }
 
-static double Sign(double v) {
-    return (v > 0) - (v < 0);
+FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenter64(const int n, const int64_t segmentIndex) {
+    return CalculateSegmentCenterFromSegGroupAndAbt(n, SplitSegIndexToSegGroupAndAbt64(n, segmentIndex));
 }
 
-static double Clamp(double v, double lo, double hi) {
-    if (v < lo) return lo;
-    if (v > hi) return hi;
-    return v;
+#define TanPiOver8 (0.41421356237309503)
+#define PiOver4 (0.78539816339744831)
+#define PiOver2 (1.5707963267948966)
+
+// |t| <= tan(pi/8) 범위에서 atan(t)를 근사하는 홀수 다항식.
+// t^2에 대한 6차 다항식을 체비쇼프 노드에서 보간해서 얻은 계수이며, 이 범위에서 오차는 8e-12 라디안 이하다.
+// 의존 사슬을 줄이기 위해 Horner 대신 Estrin 방식으로 계산한다.
+static double AtanPolynomial(double t) {
+    const double z = t * t;
+    const double z2 = z * z;
+    const double z4 = z2 * z2;
+    const double p01 = 0.999999999978399 + z * -0.3333333209761372;
+    const double p23 = 0.19999883856763245 + z * -0.14281588776843818;
+    const double p45 = 0.11040489267749592 + z * -0.08456193078344247;
+    const double p6 = 0.04707348494717238;
+    return t * ((p01 + z2 * p23) + z4 * (p45 + z2 * p6));
 }
 
-static double Angle(Vector3 from, Vector3 to) {
-    const double num = sqrt(SqrMagnitude(from) * SqrMagnitude(to));
-    return num < 1.0000000036274937E-15 ? 0.0 : acos(Clamp(Dot(from, to) / num, -1, 1)) * 57.29578;
+// atan2(y, x)의 다항식 근사. 나눗셈 한 번으로 인자를 |t| <= tan(pi/8) 범위로 줄인 뒤 AtanPolynomial()을 쓴다.
+// 사분면, 팔분면 처리는 분기 대신 선택으로 하여 입력 분포와 관계없이 일정한 속도를 낸다.
+// 최대 오차는 약 1e-11 라디안(지구 표면에서 0.1mm 미만)이다.
+static double FastAtan2(double y, double x) {
+    const double ax = fabs(x);
+    const double ay = fabs(y);
+    const int swap = ay > ax;
+    const double mx = swap ? ay : ax;
+    const double mn = swap ? ax : ay;
+
+    // 0 ~ pi/4 범위의 각. (0, 0)에서는 0을 반환한다.
+    const int reduce = mn > TanPiOver8 * mx;
+    const double num = reduce ? mn - mx : mn;
+    const double den = reduce ? mn + mx : (mx == 0 ? 1 : mx);
+    double r = (reduce ? PiOver4 : 0) + AtanPolynomial(num / den);
+
+    r = swap ? PiOver2 - r : r;
+    r = x < 0 ? M_PI - r : r;
+    return y < 0 ? -r : r;
 }
 
-// 임의의 지점 p의 위도, 경도를 계산하여 라디안으로 반환한다.
+// 임의의 지점 p의 위도, 경도를 정해진 방식으로 계산하여 라디안으로 반환한다.
+// 위도는 atan2(y, sqrt(x^2 + z^2))로 계산하므로 p를 정규화할 필요가 없고, 극 근처에서도 asin()보다 정확하다.
 // 위도는 -pi/2 ~ +pi/2 범위
-// 경도는 -pi ~ pi 범위다.
-static GpsCoords CalculateLatLng(Vector3 p) {
-    const Vector3 pNormalized = NormalizeVector3(p);
-
-    const double lng = Normalize(atan2(pNormalized.z, pNormalized.x), -M_PI, M_PI);
+// 경도는 -pi ~ pi 범위다. (pi는 -pi로 바꾼다)
+static GpsCoords CalculateLatLngWithPrecision(Vector3 p, LatLngPrecision precision) {
+    const double horizontal = sqrt(p.x * p.x + p.z * p.z);
+    double lat, lng;
+    if (precision == LatLngPrecision_Fast) {
+        lat = FastAtan2(p.y, horizontal);
+        lng = FastAtan2(p.z, p.x);
+    } else {
+        lat = atan2(p.y, horizontal);
+        lng = atan2(p.z, p.x);
+    }
+    return (GpsCoords) {lat, lng >= M_PI ? -M_PI : lng};
+}
 
-    const Vector3 lngVec = {cos(lng), 0, sin(lng)};
+// 임의의 지점 p의 위도, 경도를 계산하여 라디안으로 반환한다. 컨텍스트 없는 함수들은 항상 정확한 방식을 쓴다.
+INTERNAL_EXPORT GpsCoords CalculateLatLng(Vector3 p) {
+    return CalculateLatLngWithPrecision(p, LatLngPrecision_Exact);
+}
 
-    const double lat = Normalize(Sign(pNormalized.y) * Angle(lngVec, pNormalized) * Deg2Rad, -M_PI / 2,
-                                 M_PI / 2);
-    return (GpsCoords) {lat, lng};
+// Seg Index의 중심 좌표의 위도, 경도를 한 번에 계산해서 반환
+FFI_PLUGIN_EXPORT GpsCoords CalculateSegmentCenterLatLng(int n, int segmentIndex) {
+    return CalculateLatLng(CalculateSegmentCenter(n, segmentIndex));
 }
 
 // Seg Index의 중심 좌표의 위도를 계산해서 반환
 FFI_PLUGIN_EXPORT double CalculateSegmentCenterLat(int n, int segmentIndex) {
-    return CalculateLatLng(CalculateSegmentCenter(n, segmentIndex)).lat;
+    return CalculateSegmentCenterLatLng(n, segmentIndex).lat;
 }
 
-// Seg Index의 중심 좌표의 위도를 계산해서 반환
+// Seg Index의 중심 좌표의 경도를 계산해서 반환
 FFI_PLUGIN_EXPORT double CalculateSegmentCenterLng(int n, int segmentIndex) {
-    return CalculateLatLng(CalculateSegmentCenter(n, segmentIndex)).lng;
+    return CalculateSegmentCenterLatLng(n, segmentIndex).lng;
 }
 
-// Seg Index의 중심 좌표의 X축을 계산해서 반환
-FFI_PLUGIN_EXPORT double CalculateSegmentCenterX(int n, int segmentIndex) {
-    return CalculateSegmentCenter(n, segmentIndex).x;
+FFI_PLUGIN_EXPORT GpsCoords CalculateSegmentCenterLatLng64(int n, int64_t segmentIndex) {
+    return CalculateLatLng(CalculateSegmentCenter64(n, segmentIndex));
 }
 
-// Seg Index의 중심 좌표의 Y축을 계산해서 반환
-FFI_PLUGIN_EXPORT double CalculateSegmentCenterY(int n, int segmentIndex) {
-    return CalculateSegmentCenter(n, segmentIndex).y;
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLat64(int n, int64_t segmentIndex) {
+    return CalculateSegmentCenterLatLng64(n, segmentIndex).lat;
 }
 
-// Seg Index의 중심 좌표의 Y축을 계산해서 반환
-FFI_PLUGIN_EXPORT double CalculateSegmentCenterZ(int n, int segmentIndex) {
-    return CalculateSegmentCenter(n, segmentIndex).z;
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLng64(int n, int64_t segmentIndex) {
+    return CalculateSegmentCenterLatLng64(n, segmentIndex).lng;
 }
 
-// Seg Index의 세 정점 위치를 계산해서 반환
-static void CalculateSegmentCorners(Vector3 *out, int n, int segmentIndex, int normalize) {
-    const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbt(n, segmentIndex);
-    const Vector3 segGroupVerts[] = {
-            Vertices[VertIndexPerFaces[segGroupAndAbt.segGroup][0]],
-            Vertices[VertIndexPerFaces[segGroupAndAbt.segGroup][1]],
-            Vertices[VertIndexPerFaces[segGroupAndAbt.segGroup][2]],
-    };
-    const Vector3 axisA = ScalarMultiplyVector(1.0 / n, DiffVector3(segGroupVerts[1], segGroupVerts[0]));
-    const Vector3 axisB = ScalarMultiplyVector(1.0 / n, DiffVector3(segGroupVerts[2], segGroupVerts[0]));
+// 중심 좌표 하나를 요청된 출력(위도, 경도 / 위치)에 나눠 쓴다. 둘 중 하나는 NULL일 수 있다.
+static void WriteSegmentCenter(Vector3 center, int i, LatLngPrecision precision, GpsCoords *outLatLng,
+                               Vector3 *outCenter) {
+    if (outLatLng != NULL) {
+        outLatLng[i] = CalculateLatLngWithPrecision(center, precision);
+    }
+    if (outCenter != NULL) {
+        outCenter[i] = center;
+    }
+}
 
-    const Vector3 parallelogramCorner = AddVector3(segGroupVerts[0],
-                                                   AddVector3(ScalarMultiplyVector(segGroupAndAbt.abt.a, axisA),
-                                                              ScalarMultiplyVector(segGroupAndAbt.abt.b, axisB)));
+static int CenterBatchRange(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    for (int64_t i = begin; i < end; i++) {
+        WriteSegmentCenter(CalculateSegmentCenter(args->n, args->segmentIndex[i]), (int) i, LatLngPrecision_Exact,
+                           args->out, args->out2);
+    }
+    return ErrorCode_None;
+}
 
-    if (segGroupAndAbt.abt.t == Parallelogram_Top) {
+static int CenterBatchRange64(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    for (int64_t i = begin; i < end; i++) {
+        WriteSegmentCenter(CalculateSegmentCenter64(args->n, args->segmentIndex64[i]), (int) i, LatLngPrecision_Exact,
+                           args->out, args->out2);
+    }
+    return ErrorCode_None;
+}
+
+// 세그먼트 인덱스 배열의 중심 좌표를 한 번에 계산해 outLatLng(위도, 경도)와 outCenter(위치)에 쓴다.
+// 세그먼트마다 분해와 중심 계산은 한 번만 하며, 필요 없는 출력은 NULL로 넘긴다.
+// 유효하지 않은 세그먼트 인덱스의 위치에는 (0, 0, 0)과 그에 해당하는 위도, 경도가 기록된다.
+FFI_PLUGIN_EXPORT int CalculateSegmentCenterBatch(ThreadPool *pool, int n, int count, const int *segmentIndex,
+                                                  GpsCoords *outLatLng, Vector3 *outCenter) {
+    if (segmentIndex == NULL || (outLatLng == NULL && outCenter == NULL)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .segmentIndex = segmentIndex, .out = outLatLng, .out2 = outCenter};
+    return RunBatch(pool, count, CenterBatchRange, &args);
+}
+
+FFI_PLUGIN_EXPORT int CalculateSegmentCenterBatch64(ThreadPool *pool, int n, int count, const int64_t *segmentIndex,
+                                                    GpsCoords *outLatLng, Vector3 *outCenter) {
+    if (segmentIndex == NULL || (outLatLng == NULL && outCenter == NULL)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .segmentIndex64 = segmentIndex, .out = outLatLng, .out2 = outCenter};
+    return RunBatch(pool, count, CenterBatchRange64, &args);
+}
+
+// Seg Index의 중심 좌표의 X축을 계산해서 반환
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterX(int n, int segmentIndex) {
+    return CalculateSegmentCenter(n, segmentIndex).x;
+}
+
+// Seg Index의 중심 좌표의 Y축을 계산해서 반환
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterY(int n, int segmentIndex) {
+    return CalculateSegmentCenter(n, segmentIndex).y;
+}
+
+// Seg Index의 중심 좌표의 Y축을 계산해서 반환
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterZ(int n, int segmentIndex) {
+    return CalculateSegmentCenter(n, segmentIndex).z;
+}
+
+// 세그먼트 그룹 내 ABT 좌표가 가리키는 세그먼트의 세 정점 위치를 계산해서 반환
+static void CalculateSegmentCornersFromAbt(Vector3 *out, const SegmentGroupConstants *segGroupConstants, AbtCoords abt) {
+    const Vector3 axisA = segGroupConstants->axisA;
+    const Vector3 axisB = segGroupConstants->axisB;
+
+    const Vector3 parallelogramCorner = AddVector3(segGroupConstants->origin,
+                                                   AddVector3(ScalarMultiplyVector(abt.a, axisA),
+                                                              ScalarMultiplyVector(abt.b, axisB)));
+
+    if (abt.t == Parallelogram_Top) {
         out[0] = AddVector3(parallelogramCorner, AddVector3(axisA, axisB));
     } else {
         out[0] = parallelogramCorner;
@@ -801,6 +1618,18 @@ static void CalculateSegmentCorners(Vector3 *out, int n, int segmentIndex, int n
     }
     out[1] = AddVector3(parallelogramCorner, axisA);
     out[2] = AddVector3(parallelogramCorner, axisB);
+}
+
+// 세그먼트 그룹과 ABT 좌표가 가리키는 세그먼트의 세 정점 위치를 계산해서 반환
+static void CalculateSegmentCorners(Vector3 *out, int n, const SegGroupAndAbt segGroupAndAbt, int normalize) {
+    if (segGroupAndAbt.segGroup < 0) {
+        out[0] = out[1] = out[2] = (Vector3) {0, 0, 0};
+        return;
+    }
+
+    SegmentGroupConstants segGroupConstants;
+    CalculateSegmentGroupAxisConstants(&segGroupConstants, n, segGroupAndAbt.segGroup);
+    CalculateSegmentCornersFromAbt(out, &segGroupConstants, segGroupAndAbt.abt);
 
     if (normalize) {
         NormalizeVector3(out[0]);
@@ -809,17 +1638,49 @@ static void CalculateSegmentCorners(Vector3 *out, int n, int segmentIndex, int n
     }
 }
 
-// Seg Index의 세 정점 위치를 계산해서 반환 (위도, 경도)
-FFI_PLUGIN_EXPORT SegmentCornersInLatLng CalculateSegmentCornersInLatLng(int n, int segmentIndex) {
+static SegmentCornersInLatLng CalculateSegmentCornersInLatLngFromSegGroupAndAbt(int n, SegGroupAndAbt segGroupAndAbt) {
     SegmentCornersInLatLng ret = {0};
     Vector3 points[3];
-    CalculateSegmentCorners(points, n, segmentIndex, 0);
+    CalculateSegmentCorners(points, n, segGroupAndAbt, 0);
     for (int i = 0; i < 3; i++) {
         ret.points[i] = CalculateLatLng(points[i]);
     }
     return ret;
 }
 
+// Seg Index의 세 정점 위치를 계산해서 반환 (위도, 경도)
+FFI_PLUGIN_EXPORT SegmentCornersInLatLng CalculateSegmentCornersInLatLng(int n, int segmentIndex) {
+    return CalculateSegmentCornersInLatLngFromSegGroupAndAbt(n, SplitSegIndexToSegGroupAndAbt(n, segmentIndex));
+}
+
+FFI_PLUGIN_EXPORT SegmentCornersInLatLng CalculateSegmentCornersInLatLng64(int n, int64_t segmentIndex) {
+    return CalculateSegmentCornersInLatLngFromSegGroupAndAbt(n, SplitSegIndexToSegGroupAndAbt64(n, segmentIndex));
+}
+
+static int CornersBatchRange64(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    SegmentCornersInLatLng *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = CalculateSegmentCornersInLatLng64(args->n, args->segmentIndex64[i]);
+    }
+    return ErrorCode_None;
+}
+
+FFI_PLUGIN_EXPORT int CalculateSegmentCornersInLatLngBatch64(ThreadPool *pool, int n, int count,
+                                                             const int64_t *segmentIndex,
+                                                             SegmentCornersInLatLng *outCorners) {
+    if (segmentIndex == NULL || outCorners == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .segmentIndex64 = segmentIndex, .out = outCorners};
+    return RunBatch(pool, count, CornersBatchRange64, &args);
+}
+
 const AbtCoords NeighborOffsetSubdivisionOne[] = {
         // 하단 행
         {0,  -1, Parallelogram_Bottom},
@@ -1048,7 +1909,7 @@ static LocalNeighborSegList GetLocalSegmentIndexNeighborsAsAbtCase3Bottom(int n,
     return ret;
 }
 
-static LocalNeighborSegList GetLocalSegmentIndexNeighborsAsAbt(int n, int localSegmentIndex) {
+static LocalNeighborSegList GetLocalSegmentIndexNeighborsAsAbt(int n, AbtCoords abtCoords) {
 
     if (n < 1) {
         //throw new ArgumentOutOfRangeException(nameof(n));
@@ -1056,7 +1917,6 @@ static LocalNeighborSegList GetLocalSegmentIndexNeighborsAsAbt(int n, int localS
     }
 
     LocalNeighborSegList ret = {.count = 0};
-    const AbtCoords abtCoords = SplitLocalSegmentIndexToAbt(n, localSegmentIndex);
 
     // i) 정이십면체 그대로인 상태일 때는 특수한 케이스이다. (테스트 안해봄)
     if (n == 1) {
@@ -1157,16 +2017,16 @@ ConvertCoordinate2(AxisOrientation baseAxisOrientation, NeighborInfo neighborInf
                              neighborInfo.axisOrientation, n, abtCoords);
 }
 
-static int
+static int64_t
 ConvertCoordinateByNeighborInfo(const AxisOrientation baseAxisOrientation, const NeighborInfo neighborInfo, int n,
                                 AbtCoords neighborAbt) {
     const AbtCoords convertedAbt = ConvertCoordinate(baseAxisOrientation, neighborInfo.edgeNeighbor,
                                                      neighborInfo.edgeNeighborOrigin, neighborInfo.axisOrientation, n,
                                                      neighborAbt);
-    const int convertedNeighborLocalSegIndex = ConvertToLocalSegmentIndex(n, convertedAbt.a, convertedAbt.b,
-                                                                          convertedAbt.t);
-    const int convertedNeighborSegIndex = ConvertToSegmentIndex2(n, neighborInfo.segGroupIndex,
-                                                                 convertedNeighborLocalSegIndex);
+    const int64_t convertedNeighborLocalSegIndex = ConvertToLocalSegmentIndex(n, convertedAbt.a, convertedAbt.b,
+                                                                              convertedAbt.t);
+    const int64_t convertedNeighborSegIndex = ConvertToSegmentIndex64(n, neighborInfo.segGroupIndex,
+                                                                      convertedNeighborLocalSegIndex);
     return convertedNeighborSegIndex;
 }
 
@@ -1231,26 +2091,23 @@ static NeighborInfo GetNeighborInfoOfSegGroupIndex(const int segGroupIndex, cons
 // 세그먼트 그룹 경계를 벗어나는 이웃이 포함되는 경우에
 // 이웃 세그먼트 인덱스를 모두 반환한다.
 // 여러 세그먼트 그룹에 걸쳐야하므로, 세그먼트 서브 인덱스로 조회할 수는 없다.
-FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsOfSegmentIndex(const int n, const int segmentIndex) {
-    const SegGroupAndLocalSegIndex segGroupAndLocalSegIndex = SplitSegIndexToSegGroupAndLocalSegmentIndex(n,
-                                                                                                          segmentIndex);
-    const int segGroupIndex = segGroupAndLocalSegIndex.segGroup;
-    const int localSegmentIndex = segGroupAndLocalSegIndex.localSegIndex;
-
+// 모든 세그먼트에 쓸 수 있지만, 내부 세그먼트는 GetInteriorNeighborsOfSegGroupAndAbt()가 더 빠르다.
+static NeighborSegIdList64
+GetNeighborsOfSegGroupAndAbtGeneral(const int n, const int segGroupIndex, const AbtCoords abtCoords) {
     const AxisOrientation baseAxisOrientation = FaceAxisOrientationList[segGroupIndex];
 
-    NeighborSegIdList neighborSegIndexList = {.count = 0};
+    NeighborSegIdList64 neighborSegIndexList = {.count = 0};
     const NeighborInfo *neighborInfo = NeighborFaceInfoList[segGroupIndex];
 
-    LocalNeighborSegList neighborsAsRelativeAbt = GetLocalSegmentIndexNeighborsAsAbt(n, localSegmentIndex);
+    LocalNeighborSegList neighborsAsRelativeAbt = GetLocalSegmentIndexNeighborsAsAbt(n, abtCoords);
 
     for (int i = 0; i < neighborsAsRelativeAbt.count; i++) {
         const SegmentGroupNeighbor neighbor = neighborsAsRelativeAbt.segGroupNeighborAbt[i].segGroupNeighbor;
         const AbtCoords neighborAbt = neighborsAsRelativeAbt.segGroupNeighborAbt[i].abt;
         switch (neighbor) {
             case SegmentGroupNeighbor_Inside: {
-                int neighborSegIndex = ConvertToSegmentIndex2(n, segGroupIndex,
-                                                              ConvertToLocalSegmentIndex2(n, neighborAbt));
+                int64_t neighborSegIndex = ConvertToSegmentIndex64(n, segGroupIndex,
+                                                                   ConvertToLocalSegmentIndex2(n, neighborAbt));
 
                 neighborSegIndexList.neighborSegId[neighborSegIndexList.count] = neighborSegIndex;
                 neighborSegIndexList.count++;
@@ -1306,10 +2163,5046 @@ FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsOfSegmentIndex(const int n, cons
             }
             case SegmentGroupNeighbor_Outside:
             default:
-                neighborSegIndexList.neighborSegId[neighborSegIndexList.count] = INT32_MIN;
+                neighborSegIndexList.neighborSegId[neighborSegIndexList.count] = INT64_MIN;
                 neighborSegIndexList.count++;
         }
     }
 
     return neighborSegIndexList;
-}
\ No newline at end of file
+}
+
+// 이웃 12개가 모두 같은 세그먼트 그룹 안에 있는지 판단한다.
+// 가장자리의 모든 변에서 한 칸 이상 떨어져 있으면 (a >= 1, b >= 1, a + b + t <= n - 2) 그렇다.
+static int IsInteriorAbt(int n, AbtCoords abtCoords) {
+    return abtCoords.a >= 1 && abtCoords.b >= 1 &&
+           abtCoords.a + abtCoords.b + (abtCoords.t == Parallelogram_Top ? 1 : 0) <= n - 2;
+}
+
+// 내부 세그먼트의 이웃을 분류 없이 정수 연산만으로 계산한다. 순서는 NeighborOffsetTop/Bottom 표와 같다.
+// 서브 인덱스는 2a + t + b(2n - b)이므로, 이웃의 서브 인덱스는 (a, t)에 대한 차이와
+// 행 시작값의 차이 b(2n - b)의 변화량(한 행 위로 2n - 2b - 1, 한 행 아래로 -(2n - 2b + 1))의 합이다.
+static NeighborSegIdList64
+GetInteriorNeighborsOfSegGroupAndAbt(const int n, const int segGroupIndex, const AbtCoords abtCoords) {
+    const int topValue = abtCoords.t == Parallelogram_Top ? 1 : 0;
+    const int64_t rowStart = (int64_t) abtCoords.b * (2 * n - abtCoords.b);
+    // t = 0, a = 0 위치를 기준으로 한 전역 세그먼트 인덱스
+    const int64_t base = CalculateSegmentCountPerGroup64(n) * segGroupIndex + rowStart + 2 * abtCoords.a;
+    const int64_t rowDelta[3] = {-(2 * n - 2 * abtCoords.b + 1), 0, 2 * n - 2 * abtCoords.b - 1};
+
+    const AbtCoords *offsets = topValue ? NeighborOffsetTop : NeighborOffsetBottom;
+    NeighborSegIdList64 ret = {.count = 12};
+    for (int i = 0; i < 12; i++) {
+        const AbtCoords d = offsets[i];
+        ret.neighborSegId[i] = base + rowDelta[d.b + 1] + 2 * d.a + (d.t == Parallelogram_Top ? 1 : 0);
+    }
+    return ret;
+}
+
+// 이웃 세그먼트 인덱스는 64비트로 계산한다. 32비트 API는 GetNeighborsOfSegGroupAndLocalSegIndex()로 변환해 쓴다.
+static NeighborSegIdList64
+GetNeighborsOfSegGroupAndLocalSegIndex64(const int n, const int segGroupIndex, const int64_t localSegmentIndex) {
+    const AbtCoords abtCoords = SplitLocalSegmentIndexToAbt(n, localSegmentIndex);
+    if (IsInteriorAbt(n, abtCoords)) {
+        return GetInteriorNeighborsOfSegGroupAndAbt(n, segGroupIndex, abtCoords);
+    }
+
+    return GetNeighborsOfSegGroupAndAbtGeneral(n, segGroupIndex, abtCoords);
+}
+
+// 32비트 세그먼트 인덱스로 변환한다. 번호가 같으므로 잘라내기만 하면 되고, 찾을 수 없는 이웃만 INT32_MIN으로 바꾼다.
+static NeighborSegIdList
+GetNeighborsOfSegGroupAndLocalSegIndex(const int n, const int segGroupIndex, const int localSegmentIndex) {
+    const NeighborSegIdList64 neighborSegIndexList64 = GetNeighborsOfSegGroupAndLocalSegIndex64(n, segGroupIndex,
+                                                                                                localSegmentIndex);
+
+    NeighborSegIdList neighborSegIndexList = {.count = neighborSegIndexList64.count};
+    for (int i = 0; i < neighborSegIndexList64.count; i++) {
+        const int64_t neighborSegIndex = neighborSegIndexList64.neighborSegId[i];
+        neighborSegIndexList.neighborSegId[i] = neighborSegIndex == INT64_MIN ? INT32_MIN : (int) neighborSegIndex;
+    }
+    return neighborSegIndexList;
+}
+
+FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsOfSegmentIndex(const int n, const int segmentIndex) {
+    const SegGroupAndLocalSegIndex segGroupAndLocalSegIndex = SplitSegIndexToSegGroupAndLocalSegmentIndex(n,
+                                                                                                          segmentIndex);
+    if (segGroupAndLocalSegIndex.segGroup < 0) {
+        return (NeighborSegIdList) {.count = 0};
+    }
+
+    return GetNeighborsOfSegGroupAndLocalSegIndex(n, segGroupAndLocalSegIndex.segGroup,
+                                                  segGroupAndLocalSegIndex.localSegIndex);
+}
+
+FFI_PLUGIN_EXPORT NeighborSegIdList64 GetNeighborsOfSegmentIndex64(const int n, const int64_t segmentIndex) {
+    const SegGroupAndLocalSegIndex64 segGroupAndLocalSegIndex = SplitSegIndexToSegGroupAndLocalSegmentIndex64(
+            n, segmentIndex);
+    if (segGroupAndLocalSegIndex.segGroup < 0) {
+        return (NeighborSegIdList64) {.count = 0};
+    }
+
+    return GetNeighborsOfSegGroupAndLocalSegIndex64(n, segGroupAndLocalSegIndex.segGroup,
+                                                    segGroupAndLocalSegIndex.localSegIndex);
+}
+
+static int NeighborsBatchRange64(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    NeighborSegIdList64 *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = GetNeighborsOfSegmentIndex64(args->n, args->segmentIndex64[i]);
+    }
+    return ErrorCode_None;
+}
+
+FFI_PLUGIN_EXPORT int GetNeighborsOfSegmentIndexBatch64(ThreadPool *pool, int n, int count, const int64_t *segmentIndex,
+                                                        NeighborSegIdList64 *outNeighbors) {
+    if (segmentIndex == NULL || outNeighbors == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .segmentIndex64 = segmentIndex, .out = outNeighbors};
+    return RunBatch(pool, count, NeighborsBatchRange64, &args);
+}
+
+// 세그먼트 인덱스 집합. 선형 탐사 방식의 해시 집합이며, 빈 칸은 0으로 표시하기 위해 키에 1을 더해 저장한다.
+typedef struct {
+    uint64_t *slots;
+    uint64_t mask;
+    int64_t size;
+} SegmentIndexSet;
+
+// expectedCount개를 넣어도 채움률이 1/2를 넘지 않도록 잡는다. 메모리가 부족하면 ErrorCode_OutOfMemory를 반환한다.
+static int InitSegmentIndexSet(SegmentIndexSet *set, int64_t expectedCount) {
+    uint64_t capacity = 16;
+    while (capacity < (uint64_t) expectedCount * 2) {
+        capacity <<= 1;
+    }
+
+    set->slots = calloc(capacity, sizeof(uint64_t));
+    set->mask = capacity - 1;
+    set->size = 0;
+    return set->slots == NULL ? ErrorCode_OutOfMemory : ErrorCode_None;
+}
+
+static void FreeSegmentIndexSet(SegmentIndexSet *set) {
+    free(set->slots);
+    set->slots = NULL;
+}
+
+// 이웃 세그먼트들은 인덱스가 이어져 있는 경우가 많으므로, 연속한 8개 키를 같은 캐시 줄의 연속한 칸에 둔다.
+// 8개 묶음의 위치만 흩어 놓는다.
+static uint64_t CalculateSegmentIndexSetSlot(const SegmentIndexSet *set, uint64_t stored) {
+    return ((stored >> 3) * 0x9E3779B97F4A7C15ULL >> 17 << 3 | (stored & 7)) & set->mask;
+}
+
+// key를 집합에 넣는다. 새로 들어갔으면 1, 이미 있었으면 0을 반환한다.
+// 채움률이 1/2을 넘으면 두 배로 키우며, 메모리가 부족하면 ErrorCode_OutOfMemory를 반환한다.
+static int InsertSegmentIndexSet(SegmentIndexSet *set, uint64_t key) {
+    if ((uint64_t) (set->size + 1) * 2 > set->mask + 1) {
+        SegmentIndexSet grown;
+        if (InitSegmentIndexSet(&grown, set->size + 1) != ErrorCode_None) {
+            return ErrorCode_OutOfMemory;
+        }
+        for (uint64_t i = 0; i <= set->mask; i++) {
+            if (set->slots[i] != 0) {
+                InsertSegmentIndexSet(&grown, set->slots[i] - 1);
+            }
+        }
+        FreeSegmentIndexSet(set);
+        *set = grown;
+    }
+
+    const uint64_t stored = key + 1;
+    uint64_t slot = CalculateSegmentIndexSetSlot(set, stored);
+    while (set->slots[slot] != 0) {
+        if (set->slots[slot] == stored) {
+            return 0;
+        }
+        slot = (slot + 1) & set->mask;
+    }
+    set->slots[slot] = stored;
+    set->size++;
+    return 1;
+}
+
+// key가 집합에 있으면 1을 반환한다.
+static int ContainsSegmentIndexSet(const SegmentIndexSet *set, uint64_t key) {
+    const uint64_t stored = key + 1;
+    uint64_t slot = CalculateSegmentIndexSetSlot(set, stored);
+    while (set->slots[slot] != 0) {
+        if (set->slots[slot] == stored) {
+            return 1;
+        }
+        slot = (slot + 1) & set->mask;
+    }
+    return 0;
+}
+
+// 세그먼트 i의 이웃을 outNeighbors[12 * i]부터 쓰고, 그 수를 outOffsets[i + 1]에 둔다.
+// 나누어 처리한 뒤 CompactNeighborsCsr()가 앞으로 당겨 붙인다.
+static int NeighborsCsrRange(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    for (int64_t i = begin; i < end; i++) {
+        if (args->segmentIndex != NULL) {
+            const NeighborSegIdList neighbors = GetNeighborsOfSegmentIndex(args->n, args->segmentIndex[i]);
+            memcpy((int *) args->out + 12 * i, neighbors.neighborSegId, sizeof(int) * neighbors.count);
+            ((int *) args->out2)[i + 1] = neighbors.count;
+        } else {
+            const NeighborSegIdList64 neighbors = GetNeighborsOfSegmentIndex64(args->n, args->segmentIndex64[i]);
+            memcpy((int64_t *) args->out + 12 * i, neighbors.neighborSegId, sizeof(int64_t) * neighbors.count);
+            ((int64_t *) args->out2)[i + 1] = neighbors.count;
+        }
+    }
+    return ErrorCode_None;
+}
+
+// 세그먼트마다 12칸씩 띄어 쓴 이웃을 앞에서부터 당겨 붙이고 개수를 누적해 오프셋으로 바꾼다.
+// 당겨 오는 위치는 항상 원래 위치보다 앞이므로 아직 옮기지 않은 뒤쪽 이웃을 덮어쓰지 않는다.
+static int64_t CompactNeighborsCsr(int count, void *outNeighbors, void *outOffsets, size_t width) {
+    int64_t written = 0;
+    for (int64_t i = 0; i < count; i++) {
+        const int64_t neighborCount =
+                width == sizeof(int) ? ((int *) outOffsets)[i + 1] : ((int64_t *) outOffsets)[i + 1];
+        memmove((uint8_t *) outNeighbors + written * width, (uint8_t *) outNeighbors + 12 * i * width,
+                neighborCount * width);
+        written += neighborCount;
+        if (width == sizeof(int)) {
+            ((int *) outOffsets)[i + 1] = (int) written;
+        } else {
+            ((int64_t *) outOffsets)[i + 1] = written;
+        }
+    }
+    if (width == sizeof(int)) {
+        ((int *) outOffsets)[0] = 0;
+    } else {
+        ((int64_t *) outOffsets)[0] = 0;
+    }
+    return written;
+}
+
+// 세그먼트 인덱스 배열의 이웃을 CSR(compressed sparse row) 형태로 쓴다.
+// i번째 세그먼트의 이웃은 outNeighbors[outOffsets[i]] ~ outNeighbors[outOffsets[i + 1] - 1]이다.
+// dedupe가 0이 아니면 같은 이웃은 전체 출력에서 한 번만, 처음 만난 행에 나온다.
+// outNeighbors가 NULL이면 필요한 크기만 계산해 반환한다. 성공하면 쓴 이웃 수를 반환한다.
+FFI_PLUGIN_EXPORT int GetNeighborsOfSegmentIndexCsr(ThreadPool *pool, int n, int count, const int *segmentIndex,
+                                                    int dedupe, int *outOffsets, int *outNeighbors,
+                                                    int outNeighborsCapacity) {
+    if (segmentIndex == NULL || (outNeighbors != NULL && outOffsets == NULL)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0 || count > INT_MAX / 12 || outNeighborsCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    // 중복 제거 없이 버퍼가 넉넉하면 세그먼트마다 12칸 자리에 나누어 쓴 뒤 당겨 붙인다.
+    // 중복 제거는 "처음 만난 행"이 앞 세그먼트에 달려 있으므로 한 스레드로 처리한다.
+    if (!dedupe && outNeighbors != NULL && (int64_t) count * 12 <= outNeighborsCapacity && pool != NULL) {
+        BatchArgs args = {.n = n, .segmentIndex = segmentIndex, .out = outNeighbors, .out2 = outOffsets};
+        RunBatch(pool, count, NeighborsCsrRange, &args);
+        return (int) CompactNeighborsCsr(count, outNeighbors, outOffsets, sizeof(int));
+    }
+
+    // 붙어 있는 세그먼트들의 이웃은 대부분 겹치므로 세그먼트 수만큼으로 시작해 필요할 때 키운다.
+    SegmentIndexSet seen = {NULL, 0};
+    if (dedupe && InitSegmentIndexSet(&seen, count) != ErrorCode_None) {
+        return ErrorCode_OutOfMemory;
+    }
+
+    int written = 0;
+    for (int i = 0; i < count; i++) {
+        if (outOffsets != NULL) {
+            outOffsets[i] = written;
+        }
+
+        const NeighborSegIdList neighbors = GetNeighborsOfSegmentIndex(n, segmentIndex[i]);
+        for (int j = 0; j < neighbors.count; j++) {
+            const int neighbor = neighbors.neighborSegId[j];
+            const int inserted = dedupe ? InsertSegmentIndexSet(&seen, (uint32_t) neighbor) : 1;
+            if (inserted < 0) {
+                FreeSegmentIndexSet(&seen);
+                return inserted;
+            }
+            if (!inserted) {
+                continue;
+            }
+
+            if (outNeighbors != NULL) {
+                if (written >= outNeighborsCapacity) {
+                    FreeSegmentIndexSet(&seen);
+                    return ErrorCode_BufferTooSmall;
+                }
+                outNeighbors[written] = neighbor;
+            }
+            written++;
+        }
+    }
+
+    if (outOffsets != NULL) {
+        outOffsets[count] = written;
+    }
+    FreeSegmentIndexSet(&seen);
+    return written;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetNeighborsOfSegmentIndexCsr64(ThreadPool *pool, int n, int count,
+                                                          const int64_t *segmentIndex, int dedupe, int64_t *outOffsets,
+                                                          int64_t *outNeighbors, int64_t outNeighborsCapacity) {
+    if (segmentIndex == NULL || (outNeighbors != NULL && outOffsets == NULL)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0 || outNeighborsCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    if (!dedupe && outNeighbors != NULL && (int64_t) count * 12 <= outNeighborsCapacity && pool != NULL) {
+        BatchArgs args = {.n = n, .segmentIndex64 = segmentIndex, .out = outNeighbors, .out2 = outOffsets};
+        RunBatch(pool, count, NeighborsCsrRange, &args);
+        return CompactNeighborsCsr(count, outNeighbors, outOffsets, sizeof(int64_t));
+    }
+
+    // 붙어 있는 세그먼트들의 이웃은 대부분 겹치므로 세그먼트 수만큼으로 시작해 필요할 때 키운다.
+    SegmentIndexSet seen = {NULL, 0};
+    if (dedupe && InitSegmentIndexSet(&seen, count) != ErrorCode_None) {
+        return ErrorCode_OutOfMemory;
+    }
+
+    int64_t written = 0;
+    for (int i = 0; i < count; i++) {
+        if (outOffsets != NULL) {
+            outOffsets[i] = written;
+        }
+
+        const NeighborSegIdList64 neighbors = GetNeighborsOfSegmentIndex64(n, segmentIndex[i]);
+        for (int j = 0; j < neighbors.count; j++) {
+            const int64_t neighbor = neighbors.neighborSegId[j];
+            const int inserted = dedupe ? InsertSegmentIndexSet(&seen, (uint64_t) neighbor) : 1;
+            if (inserted < 0) {
+                FreeSegmentIndexSet(&seen);
+                return inserted;
+            }
+            if (!inserted) {
+                continue;
+            }
+
+            if (outNeighbors != NULL) {
+                if (written >= outNeighborsCapacity) {
+                    FreeSegmentIndexSet(&seen);
+                    return ErrorCode_BufferTooSmall;
+                }
+                outNeighbors[written] = neighbor;
+            }
+            written++;
+        }
+    }
+
+    if (outOffsets != NULL) {
+        outOffsets[count] = written;
+    }
+    FreeSegmentIndexSet(&seen);
+    return written;
+}
+
+// 세그먼트 인덱스를 호출자의 버퍼에 차례로 쓰는 출력기. out32/out64 중 하나를 쓰고, 둘 다 NULL이면 개수만 센다.
+typedef struct {
+    int *out32;
+    int64_t *out64;
+    int64_t capacity;
+    int64_t count;
+} SegmentIndexWriter;
+
+static int WriteSegmentIndex(SegmentIndexWriter *writer, int64_t segmentIndex) {
+    if (writer->out32 != NULL || writer->out64 != NULL) {
+        if (writer->count >= writer->capacity) {
+            return ErrorCode_BufferTooSmall;
+        }
+        if (writer->out32 != NULL) {
+            writer->out32[writer->count] = (int) segmentIndex;
+        } else {
+            writer->out64[writer->count] = segmentIndex;
+        }
+    }
+    writer->count++;
+    return ErrorCode_None;
+}
+
+// k 홉 안의 세그먼트가 모두 같은 세그먼트 그룹 안에 있고, 다른 그룹을 거치는 더 짧은 경로도 없는지 판단한다.
+// k - 1 격자 거리 안의 꼭짓점이 모두 그룹 경계선 안쪽에 있으면 (a >= k, b >= k, a + b + t + k <= n - 1) 그렇다.
+static int IsKRingInsideSegGroup(int n, AbtCoords center, int k) {
+    return center.a >= k && center.b >= k &&
+           (int64_t) center.a + center.b + (center.t == Parallelogram_Top ? 1 : 0) + k <= (int64_t) n - 1;
+}
+
+// 세그먼트 그룹 하나의 꼭짓점 격자에서 k-ring이 닿는 범위. 꼭짓점 (i, j)의 i, j, i + j 각각에 대한 [min, max]로
+// 나타나는 육각형이다. 꼭짓점 하나라도 공유하면 이웃이므로, k >= 1이면 중심 삼각형의 꼭짓점에서 격자 거리 k - 1
+// 이내인 꼭짓점(육각형들의 합)을 하나라도 가진 세그먼트가 k 홉 안에 든다.
+// k = 0이면 whole을 켜서 중심 삼각형의 꼭짓점만 담고, 꼭짓점이 모두 범위 안에 있는 세그먼트(중심 자신)만 고른다.
+typedef struct {
+    int64_t iMin;
+    int64_t iMax;
+    int64_t jMin;
+    int64_t jMax;
+    int64_t sMin;
+    int64_t sMax;
+    int whole;
+} KRingRegion;
+
+// 세그먼트의 세 꼭짓점을 꼭짓점 격자 좌표로 구한다.
+// (a, b, Bottom)의 꼭짓점은 (a, b), (a+1, b), (a, b+1)이고, Top은 (a+1, b), (a, b+1), (a+1, b+1)이다.
+static void CalculateSegmentVertexCoords(AbtCoords abt, int64_t *outI, int64_t *outJ) {
+    const int top = abt.t == Parallelogram_Top ? 1 : 0;
+    outI[0] = abt.a + top;
+    outJ[0] = abt.b;
+    outI[1] = abt.a + 1 - top;
+    outJ[1] = abt.b + top;
+    outI[2] = abt.a + top;
+    outJ[2] = abt.b + 1;
+}
+
+// 중심 삼각형의 세 꼭짓점 좌표로 k-ring 범위를 만든다.
+static KRingRegion MakeKRingRegion(const int64_t *i, const int64_t *j, int k) {
+    KRingRegion region = {INT64_MAX, INT64_MIN, INT64_MAX, INT64_MIN, INT64_MAX, INT64_MIN, k == 0};
+    for (int v = 0; v < 3; v++) {
+        region.iMin = i[v] < region.iMin ? i[v] : region.iMin;
+        region.iMax = i[v] > region.iMax ? i[v] : region.iMax;
+        region.jMin = j[v] < region.jMin ? j[v] : region.jMin;
+        region.jMax = j[v] > region.jMax ? j[v] : region.jMax;
+        region.sMin = i[v] + j[v] < region.sMin ? i[v] + j[v] : region.sMin;
+        region.sMax = i[v] + j[v] > region.sMax ? i[v] + j[v] : region.sMax;
+    }
+
+    const int64_t r = k > 0 ? k - 1 : 0;
+    region.iMin -= r;
+    region.iMax += r;
+    region.jMin -= r;
+    region.jMax += r;
+    region.sMin -= r;
+    region.sMax += r;
+    return region;
+}
+
+// b행에서 t 삼각형 중 region에 드는 세그먼트의 a 범위 [*lo, *hi]를 구한다. 없으면 *lo > *hi.
+static void CalculateKRingRowRange(const KRingRegion *region, int64_t b, int t, int64_t *lo, int64_t *hi) {
+    *lo = region->whole ? INT64_MIN : INT64_MAX;
+    *hi = region->whole ? INT64_MAX : INT64_MIN;
+    // 삼각형의 아래 변(j = b)과 위 꼭짓점 줄(j = b + 1)을 차례로 본다.
+    for (int dj = 0; dj < 2; dj++) {
+        const int64_t j = b + dj;
+        const int64_t rowLo = region->iMin > region->sMin - j ? region->iMin : region->sMin - j;
+        const int64_t rowHi = region->iMax < region->sMax - j ? region->iMax : region->sMax - j;
+        if (j < region->jMin || j > region->jMax || rowLo > rowHi) {
+            if (region->whole) {
+                *lo = 1;
+                *hi = 0;
+                return;
+            }
+            continue;
+        }
+
+        // 이 줄에서 삼각형이 가지는 꼭짓점의 i는 a + minOffset ~ a + maxOffset이다.
+        // Bottom은 아래 줄 {a, a+1}, 위 줄 {a}이고, Top은 아래 줄 {a+1}, 위 줄 {a, a+1}이다.
+        const int minOffset = t == 1 && dj == 0 ? 1 : 0;
+        const int maxOffset = t == 0 && dj == 1 ? 0 : 1;
+        if (region->whole) {
+            *lo = rowLo - minOffset > *lo ? rowLo - minOffset : *lo;
+            *hi = rowHi - maxOffset < *hi ? rowHi - maxOffset : *hi;
+        } else {
+            *lo = rowLo - maxOffset < *lo ? rowLo - maxOffset : *lo;
+            *hi = rowHi - minOffset > *hi ? rowHi - minOffset : *hi;
+        }
+    }
+}
+
+// 중심 삼각형의 꼭짓점에서 그룹의 corner번째 꼭짓점(정이십면체 꼭짓점)까지의 격자 거리.
+// 꼭짓점 격자의 이웃은 (±1, 0), (0, ±1), ±(1, -1) 방향이므로 (di, dj)의 거리는 max(|di|, |dj|, |di + dj|)이다.
+static int64_t CalculateCornerDistance(int n, int corner, const int64_t *centerI, const int64_t *centerJ) {
+    const int64_t cornerI = corner == 1 ? n : 0;
+    const int64_t cornerJ = corner == 2 ? n : 0;
+    int64_t distance = INT64_MAX;
+    for (int v = 0; v < 3; v++) {
+        const int64_t di = cornerI - centerI[v];
+        const int64_t dj = cornerJ - centerJ[v];
+        const int64_t ai = di < 0 ? -di : di;
+        const int64_t aj = dj < 0 ? -dj : dj;
+        const int64_t as = di + dj < 0 ? -(di + dj) : di + dj;
+        const int64_t vertexDistance = ai > aj ? (ai > as ? ai : as) : (aj > as ? aj : as);
+        distance = vertexDistance < distance ? vertexDistance : distance;
+    }
+    return distance;
+}
+
+// 중심 세그먼트 그룹의 꼭짓점 격자를 이웃 면으로 이어 붙여 펼친 평면에 놓은 면 하나.
+// 면의 꼭짓점 (0, 0), (n, 0), (0, n)이 평면의 (i[0], j[0]), (i[1], j[1]), (i[2], j[2])에 놓인다.
+typedef struct {
+    int segGroup;
+    int64_t i[3];
+    int64_t j[3];
+} UnfoldedSegGroup;
+
+// 중심 그룹의 세 꼭짓점마다 양쪽으로 세 면씩 돌아 펼친 면과 중심 그룹. 변을 맞댄 면은 두 꼭짓점에서 겹친다.
+#define UnfoldedSegGroupMaxCount (19)
+
+static int FindVertexSlot(int segGroup, int vertex) {
+    for (int slot = 0; slot < 3; slot++) {
+        if (VertIndexPerFaces[segGroup][slot] == vertex) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// face의 꼭짓점 slot0, slot1을 잇는 변 건너편 면을 같은 평면에 펼친다. 두 면은 마름모를 이루므로,
+// 건너편 면의 나머지 꼭짓점은 face의 나머지 꼭짓점을 변에 대해 뒤집은 위치(두 끝점의 합 - 나머지 꼭짓점)에 놓인다.
+static UnfoldedSegGroup UnfoldAcrossEdge(const UnfoldedSegGroup *face, int slot0, int slot1) {
+    const int vertex0 = VertIndexPerFaces[face->segGroup][slot0];
+    const int vertex1 = VertIndexPerFaces[face->segGroup][slot1];
+    const int opposite = 3 - slot0 - slot1;
+    UnfoldedSegGroup ret = {.segGroup = face->segGroup};
+    for (int segGroup = 0; segGroup < GroupCount; segGroup++) {
+        if (segGroup != face->segGroup && FindVertexSlot(segGroup, vertex0) >= 0 &&
+            FindVertexSlot(segGroup, vertex1) >= 0) {
+            ret.segGroup = segGroup;
+            break;
+        }
+    }
+
+    for (int slot = 0; slot < 3; slot++) {
+        const int vertex = VertIndexPerFaces[ret.segGroup][slot];
+        if (vertex == vertex0 || vertex == vertex1) {
+            const int from = vertex == vertex0 ? slot0 : slot1;
+            ret.i[slot] = face->i[from];
+            ret.j[slot] = face->j[from];
+        } else {
+            ret.i[slot] = face->i[slot0] + face->i[slot1] - face->i[opposite];
+            ret.j[slot] = face->j[slot0] + face->j[slot1] - face->j[opposite];
+        }
+    }
+    return ret;
+}
+
+// 중심 그룹 둘레의 면들을 펼친다. 정이십면체 꼭짓점에는 면이 다섯 개뿐이라 한 바퀴를 다 펼칠 수 없으므로,
+// 꼭짓점마다 양쪽으로 돌아 가며 세 면씩 펼치고, 두 번 놓이는 면은 두 위치 중 더 가까운 쪽이 실제 거리가 된다.
+// 중심 삼각형에서 격자 거리 k보다 먼 꼭짓점은 그 둘레 면에 k-ring이 닿지 않으므로 변을 맞댄 면만 펼친다.
+static int UnfoldSegGroupsAroundCorners(UnfoldedSegGroup *out, int n, int segGroup, const int64_t *centerI,
+                                        const int64_t *centerJ, int k) {
+    out[0] = (UnfoldedSegGroup) {segGroup, {0, n, 0}, {0, 0, n}};
+    int count = 1;
+    for (int corner = 0; corner < 3; corner++) {
+        const int vertex = VertIndexPerFaces[segGroup][corner];
+        const int stepCount = CalculateCornerDistance(n, corner, centerI, centerJ) <= k ? 3 : 1;
+        for (int direction = 1; direction <= 2; direction++) {
+            UnfoldedSegGroup face = out[0];
+            int edgeSlot = (corner + direction) % 3;
+            for (int step = 0; step < stepCount; step++) {
+                const int edgeVertex = VertIndexPerFaces[face.segGroup][edgeSlot];
+                face = UnfoldAcrossEdge(&face, FindVertexSlot(face.segGroup, vertex), edgeSlot);
+                // 다음에는 꼭짓점과 새로 놓인 꼭짓점을 잇는 변을 건넌다.
+                edgeSlot = 3 - FindVertexSlot(face.segGroup, vertex) - FindVertexSlot(face.segGroup, edgeVertex);
+
+                int duplicate = 0;
+                for (int m = 0; m < count && !duplicate; m++) {
+                    duplicate = memcmp(&out[m], &face, sizeof(UnfoldedSegGroup)) == 0;
+                }
+                if (!duplicate) {
+                    out[count++] = face;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+// 펼친 평면의 꼭짓점 (i, j)를 face의 꼭짓점 격자 좌표로 옮긴다. 면의 두 축은 격자의 단위 방향이라 행렬식이 ±1이다.
+static void ConvertToUnfoldedSegGroupCoords(const UnfoldedSegGroup *face, int n, int64_t i, int64_t j, int64_t *outI,
+                                            int64_t *outJ) {
+    const int64_t ui = (face->i[1] - face->i[0]) / n;
+    const int64_t uj = (face->j[1] - face->j[0]) / n;
+    const int64_t vi = (face->i[2] - face->i[0]) / n;
+    const int64_t vj = (face->j[2] - face->j[0]) / n;
+    const int64_t det = ui * vj - uj * vi;
+    const int64_t di = i - face->i[0];
+    const int64_t dj = j - face->j[0];
+    *outI = (di * vj - dj * vi) * det;
+    *outJ = (ui * dj - uj * di) * det;
+}
+
+// [lo[m], hi[m]] 구간들의 합집합 크기를 구한다. 구간은 몇 개뿐이므로 삽입 정렬로 충분하다.
+static int64_t CountRangeUnion(const int64_t *lo, const int64_t *hi, int count) {
+    int order[UnfoldedSegGroupMaxCount];
+    int sorted = 0;
+    for (int m = 0; m < count; m++) {
+        if (lo[m] > hi[m]) {
+            continue;
+        }
+        int p = sorted++;
+        for (; p > 0 && lo[order[p - 1]] > lo[m]; p--) {
+            order[p] = order[p - 1];
+        }
+        order[p] = m;
+    }
+
+    int64_t total = 0;
+    int64_t end = INT64_MIN;
+    for (int p = 0; p < sorted; p++) {
+        const int64_t from = lo[order[p]] > end + 1 ? lo[order[p]] : end + 1;
+        if (hi[order[p]] >= from) {
+            total += hi[order[p]] - from + 1;
+            end = hi[order[p]];
+        }
+    }
+    return total;
+}
+
+// 세그먼트 그룹 하나에서 k-ring에 드는 세그먼트를 행 단위로 오름차순으로 쓴다. 같은 면을 여러 곳에 펼쳤으면 outer에
+// 그 수만큼 범위가 있고, 어느 하나에라도 들면 k 홉 안이다. inner가 NULL이 아니면 그 범위(k - 1 홉)는 뺀다.
+// 출력 버퍼가 없으면 행마다 구간 길이만 더한다.
+static int WriteKRingInSegGroup(SegmentIndexWriter *writer, int n, int segGroup, const KRingRegion *outer,
+                                const KRingRegion *inner, int regionCount) {
+    int64_t bMin = INT64_MAX;
+    int64_t bMax = INT64_MIN;
+    for (int m = 0; m < regionCount; m++) {
+        bMin = outer[m].jMin - 1 < bMin ? outer[m].jMin - 1 : bMin;
+        bMax = outer[m].jMax > bMax ? outer[m].jMax : bMax;
+    }
+    bMin = bMin < 0 ? 0 : bMin;
+    bMax = bMax > n - 1 ? n - 1 : bMax;
+
+    const int countOnly = writer->out32 == NULL && writer->out64 == NULL;
+    const int64_t groupStart = CalculateSegmentCountPerGroup64(n) * segGroup;
+    for (int64_t b = bMin; b <= bMax; b++) {
+        // 같은 면이 여러 곳에 놓였으면 범위들 사이의 행은 건너뛴다.
+        int64_t nextB = INT64_MAX;
+        int covered = 0;
+        for (int m = 0; m < regionCount && !covered; m++) {
+            covered = b >= outer[m].jMin - 1 && b <= outer[m].jMax;
+            nextB = outer[m].jMin - 1 > b && outer[m].jMin - 1 < nextB ? outer[m].jMin - 1 : nextB;
+        }
+        if (!covered) {
+            if (nextB > bMax) {
+                break;
+            }
+            b = nextB - 1;
+            continue;
+        }
+
+        int64_t lo[2][UnfoldedSegGroupMaxCount], hi[2][UnfoldedSegGroupMaxCount];
+        int64_t innerLo[2][UnfoldedSegGroupMaxCount], innerHi[2][UnfoldedSegGroupMaxCount];
+        int64_t first = INT64_MAX;
+        int64_t last = INT64_MIN;
+        for (int t = 0; t < 2; t++) {
+            // b행의 t 삼각형은 a = 0 ~ n - 1 - b - t 이다.
+            const int64_t aMax = n - 1 - b - t;
+            for (int m = 0; m < regionCount; m++) {
+                CalculateKRingRowRange(&outer[m], b, t, &lo[t][m], &hi[t][m]);
+                lo[t][m] = lo[t][m] < 0 ? 0 : lo[t][m];
+                hi[t][m] = hi[t][m] > aMax ? aMax : hi[t][m];
+                first = lo[t][m] <= hi[t][m] && lo[t][m] < first ? lo[t][m] : first;
+                last = lo[t][m] <= hi[t][m] && hi[t][m] > last ? hi[t][m] : last;
+
+                innerLo[t][m] = 1;
+                innerHi[t][m] = 0;
+                if (inner != NULL) {
+                    CalculateKRingRowRange(&inner[m], b, t, &innerLo[t][m], &innerHi[t][m]);
+                    innerLo[t][m] = innerLo[t][m] < 0 ? 0 : innerLo[t][m];
+                    innerHi[t][m] = innerHi[t][m] > aMax ? aMax : innerHi[t][m];
+                }
+            }
+            if (countOnly) {
+                // inner 범위는 outer 범위 안에 있으므로 합집합 크기의 차가 이 줄의 개수다.
+                writer->count += CountRangeUnion(lo[t], hi[t], regionCount) -
+                                 CountRangeUnion(innerLo[t], innerHi[t], regionCount);
+            }
+        }
+        if (countOnly) {
+            continue;
+        }
+
+        const int64_t rowStart = groupStart + b * (2 * n - b);
+        for (int64_t a = first; a <= last; a++) {
+            for (int t = 0; t < 2; t++) {
+                int inOuter = a >= lo[t][0] && a <= hi[t][0];
+                int inInner = a >= innerLo[t][0] && a <= innerHi[t][0];
+                for (int m = 1; m < regionCount; m++) {
+                    inOuter |= a >= lo[t][m] && a <= hi[t][m];
+                    inInner |= a >= innerLo[t][m] && a <= innerHi[t][m];
+                }
+                if (!inOuter || inInner) {
+                    continue;
+                }
+
+                const int result = WriteSegmentIndex(writer, rowStart + 2 * a + t);
+                if (result != ErrorCode_None) {
+                    return result;
+                }
+            }
+        }
+    }
+    return ErrorCode_None;
+}
+
+static int CompareInt64(const void *lhs, const void *rhs) {
+    const int64_t a = *(const int64_t *) lhs;
+    const int64_t b = *(const int64_t *) rhs;
+    return (a > b) - (a < b);
+}
+
+// 펼친 면들 밖까지 닿는 큰 k-ring은 이웃 그래프를 너비 우선 탐색해서 구하고, 오름차순으로 정렬해 쓴다.
+static int WriteKRingByTraversal(SegmentIndexWriter *writer, int n, int64_t center, int k, int hollow) {
+    int64_t found = 1;
+    int64_t foundCapacity = 64;
+    int64_t *foundList = malloc(sizeof(int64_t) * foundCapacity);
+    SegmentIndexSet seen = {NULL, 0};
+    if (foundList == NULL || InitSegmentIndexSet(&seen, foundCapacity) != ErrorCode_None) {
+        free(foundList);
+        FreeSegmentIndexSet(&seen);
+        return ErrorCode_OutOfMemory;
+    }
+    foundList[0] = center;
+    InsertSegmentIndexSet(&seen, (uint64_t) center);
+
+    // foundList[ringStart, ringEnd)가 거리 ringDistance인 고리다. 구 전체를 덮으면 k 전에 빈 고리가 된다.
+    int64_t ringStart = 0;
+    int64_t ringEnd = 1;
+    int ringDistance = 0;
+    int result = ErrorCode_None;
+    while (ringDistance < k && ringStart < ringEnd && result == ErrorCode_None) {
+        for (int64_t i = ringStart; i < ringEnd && result == ErrorCode_None; i++) {
+            const NeighborSegIdList64 neighbors = GetNeighborsOfSegmentIndex64(n, foundList[i]);
+            for (int j = 0; j < neighbors.count; j++) {
+                const int64_t neighbor = neighbors.neighborSegId[j];
+                if (neighbor < 0 || !InsertSegmentIndexSet(&seen, (uint64_t) neighbor)) {
+                    continue;
+                }
+
+                // 목록과 집합은 다 차기 전에 두 배로 키운다. 집합은 채움률 1/2를 유지하도록 다시 만든다.
+                if (found == foundCapacity) {
+                    int64_t *grown = realloc(foundList, sizeof(int64_t) * foundCapacity * 2);
+                    SegmentIndexSet grownSet;
+                    if (grown == NULL || InitSegmentIndexSet(&grownSet, foundCapacity * 2) != ErrorCode_None) {
+                        foundList = grown == NULL ? foundList : grown;
+                        result = ErrorCode_OutOfMemory;
+                        break;
+                    }
+                    foundList = grown;
+                    foundCapacity *= 2;
+                    for (int64_t m = 0; m < found; m++) {
+                        InsertSegmentIndexSet(&grownSet, (uint64_t) foundList[m]);
+                    }
+                    InsertSegmentIndexSet(&grownSet, (uint64_t) neighbor);
+                    FreeSegmentIndexSet(&seen);
+                    seen = grownSet;
+                }
+                foundList[found++] = neighbor;
+            }
+        }
+        ringStart = ringEnd;
+        ringEnd = found;
+        ringDistance++;
+    }
+    FreeSegmentIndexSet(&seen);
+
+    if (result == ErrorCode_None) {
+        const int64_t first = hollow ? (ringDistance == k ? ringStart : found) : 0;
+        qsort(foundList + first, (size_t) (found - first), sizeof(int64_t), CompareInt64);
+        for (int64_t i = first; i < found && result == ErrorCode_None; i++) {
+            result = WriteSegmentIndex(writer, foundList[i]);
+        }
+    }
+    free(foundList);
+    return result;
+}
+
+// 중심 그룹 둘레를 펼친 면들로 k-ring을 구할 수 있는 최대 k. 펼치지 않은 면에 닿는 k > n은 이웃을 따라 탐색한다.
+// (n = 1 ~ 16의 모든 중심에서 너비 우선 탐색 결과와 비교해, 펼친 면들만으로 k <= n까지 같음을 확인했다.)
+#define KRingUnfoldMaxK(n) (n)
+
+static int WriteKRing(SegmentIndexWriter *writer, int n, int64_t segmentIndex, int k, int hollow) {
+    if (k < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const SegGroupAndAbt center = SplitSegIndexToSegGroupAndAbt64(n, segmentIndex);
+    if (center.segGroup < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int inside = IsKRingInsideSegGroup(n, center.abt, k);
+    if (!inside && k > KRingUnfoldMaxK(n)) {
+        return WriteKRingByTraversal(writer, n, segmentIndex, k, hollow);
+    }
+
+    int64_t centerI[3], centerJ[3];
+    CalculateSegmentVertexCoords(center.abt, centerI, centerJ);
+    if (writer->out32 == NULL && writer->out64 == NULL) {
+        // 그룹의 세 꼭짓점(정이십면체 꼭짓점)이 모두 격자 거리 k보다 멀면 그 꼭짓점에 붙은 세그먼트가 k-ring에 들지
+        // 않아 평면 격자와 모양이 같으므로, 크기는 닫힌 식으로 나온다.
+        int flat = 1;
+        for (int corner = 0; corner < 3; corner++) {
+            flat &= CalculateCornerDistance(n, corner, centerI, centerJ) > k;
+        }
+        if (flat) {
+            writer->count += hollow ? (k == 0 ? 1 : 12 * (int64_t) k) : 6 * (int64_t) k * k + 6 * (int64_t) k + 1;
+            return ErrorCode_None;
+        }
+    }
+
+    UnfoldedSegGroup faces[UnfoldedSegGroupMaxCount];
+    const int faceCount = inside ? 1 : UnfoldSegGroupsAroundCorners(faces, n, center.segGroup, centerI, centerJ, k);
+    if (inside) {
+        faces[0] = (UnfoldedSegGroup) {center.segGroup, {0, n, 0}, {0, 0, n}};
+    }
+
+    // 결과가 오름차순이 되도록 세그먼트 그룹 순서대로, 그 그룹이 놓인 위치마다 중심 삼각형을 옮겨 범위를 만든다.
+    for (int segGroup = 0; segGroup < GroupCount; segGroup++) {
+        KRingRegion outer[UnfoldedSegGroupMaxCount], inner[UnfoldedSegGroupMaxCount];
+        int regionCount = 0;
+        for (int f = 0; f < faceCount; f++) {
+            if (faces[f].segGroup != segGroup) {
+                continue;
+            }
+
+            int64_t i[3], j[3];
+            for (int v = 0; v < 3; v++) {
+                ConvertToUnfoldedSegGroupCoords(&faces[f], n, centerI[v], centerJ[v], &i[v], &j[v]);
+            }
+            outer[regionCount] = MakeKRingRegion(i, j, k);
+            inner[regionCount] = MakeKRingRegion(i, j, k - 1);
+            regionCount++;
+        }
+        if (regionCount == 0) {
+            continue;
+        }
+
+        const int result = WriteKRingInSegGroup(writer, n, segGroup, outer, hollow && k > 0 ? inner : NULL,
+                                                regionCount);
+        if (result != ErrorCode_None) {
+            return result;
+        }
+    }
+    return ErrorCode_None;
+}
+
+// segmentIndex에서 이웃 홉 k 이하(hollow면 정확히 k)인 세그먼트를 오름차순으로 쓴다.
+// outSegmentIndex가 NULL이면 필요한 크기만 계산해 반환한다. 성공하면 쓴 세그먼트 수를 반환한다.
+static int GetKRingOfSegmentIndexImpl(int n, int segmentIndex, int k, int hollow, int *outSegmentIndex,
+                                      int outCapacity) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1 || outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out32 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WriteKRing(&writer, n, (uint32_t) segmentIndex, k, hollow);
+    if (result != ErrorCode_None) {
+        return result;
+    }
+    return writer.count > INT_MAX ? ErrorCode_ArgumentOutOfRangeException : (int) writer.count;
+}
+
+static int64_t GetKRingOfSegmentIndexImpl64(int n, int64_t segmentIndex, int k, int hollow, int64_t *outSegmentIndex,
+                                            int64_t outCapacity) {
+    if (outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out64 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WriteKRing(&writer, n, segmentIndex, k, hollow);
+    return result != ErrorCode_None ? result : writer.count;
+}
+
+FFI_PLUGIN_EXPORT int GetKRingOfSegmentIndex(int n, int segmentIndex, int k, int *outSegmentIndex, int outCapacity) {
+    return GetKRingOfSegmentIndexImpl(n, segmentIndex, k, 0, outSegmentIndex, outCapacity);
+}
+
+FFI_PLUGIN_EXPORT int GetHollowRingOfSegmentIndex(int n, int segmentIndex, int k, int *outSegmentIndex,
+                                                  int outCapacity) {
+    return GetKRingOfSegmentIndexImpl(n, segmentIndex, k, 1, outSegmentIndex, outCapacity);
+}
+
+FFI_PLUGIN_EXPORT int64_t GetKRingOfSegmentIndex64(int n, int64_t segmentIndex, int k, int64_t *outSegmentIndex,
+                                                   int64_t outCapacity) {
+    return GetKRingOfSegmentIndexImpl64(n, segmentIndex, k, 0, outSegmentIndex, outCapacity);
+}
+
+FFI_PLUGIN_EXPORT int64_t GetHollowRingOfSegmentIndex64(int n, int64_t segmentIndex, int k, int64_t *outSegmentIndex,
+                                                        int64_t outCapacity) {
+    return GetKRingOfSegmentIndexImpl64(n, segmentIndex, k, 1, outSegmentIndex, outCapacity);
+}
+
+// 폴리곤 채우기에서 세그먼트 그룹 하나에 대해 미리 계산해 두는 값들.
+// 세그먼트는 평평한 면 삼각형(origin, axisA, axisB) 위의 균일한 격자를 원점으로 투영한 것이므로,
+// 대원 호는 면 평면 위의 직선이 되고, 격자 좌표 (i, j) = (a, b)로 옮기면 행 단위로 훑을 수 있다.
+typedef struct {
+    Vector3 origin;
+    Vector3 axisA;
+    Vector3 axisB;
+    Vector3 normal;
+    double planeDistance;
+    double g11, g12, g22, det;
+    // 면 삼각형을 조금 넓힌 원뿔의 세 경계 평면. 폴리곤을 이 원뿔로 자르면 잘린 변은 면 밖에 놓인다.
+    Vector3 clipPlanes[3];
+} PolygonFillFace;
+
+typedef struct {
+    double x;
+    double y;
+} LatticePoint;
+
+typedef struct {
+    int64_t lo;
+    int64_t hi;
+} Int64Range;
+
+// 잘린 변이 면 바깥쪽 행/열에 놓이도록 면 삼각형을 중심에서 이만큼 (변 길이 비율) 넓혀서 자른다.
+#define PolygonFillClipMargin (0.25)
+// 격자 단위. 변이 세그먼트 경계에 닿기만 해도 겹친 것으로 본다.
+#define PolygonFillTouchEpsilon (1e-9)
+
+static void CalculatePolygonFillFace(PolygonFillFace *out, int n, int segGroup) {
+    SegmentGroupConstants c;
+    CalculateSegmentGroupAxisConstants(&c, n, segGroup);
+    out->origin = c.origin;
+    out->axisA = c.axisA;
+    out->axisB = c.axisB;
+    out->normal = Cross(c.axisA, c.axisB);
+    out->planeDistance = Dot(c.origin, out->normal);
+    out->g11 = Dot(c.axisA, c.axisA);
+    out->g12 = Dot(c.axisA, c.axisB);
+    out->g22 = Dot(c.axisB, c.axisB);
+    out->det = out->g11 * out->g22 - out->g12 * out->g12;
+
+    const Vector3 corners[3] = {
+            c.origin,
+            AddVector3(c.origin, ScalarMultiplyVector(n, c.axisA)),
+            AddVector3(c.origin, ScalarMultiplyVector(n, c.axisB)),
+    };
+    const Vector3 centroid = ScalarMultiplyVector(1.0 / 3, AddVector3(AddVector3(corners[0], corners[1]), corners[2]));
+    Vector3 widened[3];
+    for (int i = 0; i < 3; i++) {
+        widened[i] = AddVector3(corners[i], ScalarMultiplyVector(PolygonFillClipMargin, DiffVector3(corners[i], centroid)));
+    }
+    for (int i = 0; i < 3; i++) {
+        Vector3 plane = Cross(widened[i], widened[(i + 1) % 3]);
+        out->clipPlanes[i] = Dot(plane, centroid) < 0 ? NegateVector3(plane) : plane;
+    }
+}
+
+// 원점을 지나는 평면 하나로 고리(폴리곤의 외곽선 또는 구멍)를 자른다 (Sutherland-Hodgman).
+// 호의 양 끝을 잇는 현 위의 교점은 호와 평면의 교선 위에 있으므로, 중심 투영하면 호 위의 교점과 같다.
+static int ClipRingByPlane(const Vector3 *in, int inCount, Vector3 plane, Vector3 *out) {
+    int outCount = 0;
+    for (int i = 0; i < inCount; i++) {
+        const Vector3 p = in[i];
+        const Vector3 q = in[(i + 1) % inCount];
+        const double dp = Dot(p, plane);
+        const double dq = Dot(q, plane);
+        if (dp >= 0) {
+            out[outCount++] = p;
+        }
+        if ((dp >= 0) != (dq >= 0)) {
+            out[outCount++] = AddVector3(p, ScalarMultiplyVector(dp / (dp - dq), DiffVector3(q, p)));
+        }
+    }
+    return outCount;
+}
+
+static LatticePoint ProjectToLattice(const PolygonFillFace *face, Vector3 v) {
+    const Vector3 onPlane = ScalarMultiplyVector(face->planeDistance / Dot(v, face->normal), v);
+    const Vector3 p = DiffVector3(onPlane, face->origin);
+    const double r1 = Dot(p, face->axisA);
+    const double r2 = Dot(p, face->axisB);
+    return (LatticePoint) {
+            .x = (r1 * face->g22 - r2 * face->g12) / face->det,
+            .y = (r2 * face->g11 - r1 * face->g12) / face->det,
+    };
+}
+
+static int64_t FloorToInt64(double v) {
+    return (int64_t) floor(v);
+}
+
+static int64_t FloorDiv2(int64_t v) {
+    return v >= 0 ? v / 2 : -((-v + 1) / 2);
+}
+
+static int CompareInt64RangeLo(const void *lhs, const void *rhs) {
+    const int64_t a = ((const Int64Range *) lhs)->lo;
+    const int64_t b = ((const Int64Range *) rhs)->lo;
+    return (a > b) - (a < b);
+}
+
+static int CompareDouble(const void *lhs, const void *rhs) {
+    const double a = *(const double *) lhs;
+    const double b = *(const double *) rhs;
+    return (a > b) - (a < b);
+}
+
+// 범위 목록을 정렬하고 겹치거나 붙은 범위를 합친다. 합친 개수를 반환한다.
+static int MergeInt64Ranges(Int64Range *ranges, int count) {
+    qsort(ranges, (size_t) count, sizeof(Int64Range), CompareInt64RangeLo);
+    int merged = 0;
+    for (int i = 0; i < count; i++) {
+        if (ranges[i].lo > ranges[i].hi) {
+            continue;
+        }
+        if (merged > 0 && ranges[i].lo <= ranges[merged - 1].hi + 1) {
+            if (ranges[i].hi > ranges[merged - 1].hi) {
+                ranges[merged - 1].hi = ranges[i].hi;
+            }
+        } else {
+            ranges[merged++] = ranges[i];
+        }
+    }
+    return merged;
+}
+
+// 잘린 고리의 변 하나. p에서 q로 가는 원래 방향을 지켜야 교점 계산이 방향과 무관하게 같은 값을 준다.
+typedef struct {
+    LatticePoint p;
+    LatticePoint q;
+    double yMin;
+    double yMax;
+} PolygonFillEdge;
+
+// 폴리곤 채우기에 쓰는 작업 버퍼. 면마다 다시 쓴다.
+// edges는 yMin 오름차순이고, active는 지금 행의 띠 b <= j <= b + 1에 걸친 변들의 번호이다 (활성 변 표).
+typedef struct {
+    Vector3 *sphere;
+    Vector3 *clipA;
+    Vector3 *clipB;
+    LatticePoint *lattice;
+    int *ringStart;
+    int clippedRingCount;
+    PolygonFillEdge *edges;
+    int edgeCount;
+    int *active;
+    int activeCount;
+    double *crossings;
+    Int64Range *ranges[2];
+    int pointCapacity;
+} PolygonFillScratch;
+
+static int ComparePolygonFillEdgeYMin(const void *lhs, const void *rhs) {
+    const double a = ((const PolygonFillEdge *) lhs)->yMin;
+    const double b = ((const PolygonFillEdge *) rhs)->yMin;
+    return (a > b) - (a < b);
+}
+
+// 잘린 고리들의 변을 모아 yMin 순으로 정렬하고 활성 변 표를 비운다.
+static void BuildPolygonFillEdges(PolygonFillScratch *s) {
+    s->edgeCount = 0;
+    for (int r = 0; r < s->clippedRingCount; r++) {
+        const int start = s->ringStart[r];
+        const int count = s->ringStart[r + 1] - start;
+        for (int i = 0; i < count; i++) {
+            const LatticePoint p = s->lattice[start + i];
+            const LatticePoint q = s->lattice[start + (i + 1) % count];
+            s->edges[s->edgeCount++] = (PolygonFillEdge) {
+                    .p = p, .q = q, .yMin = fmin(p.y, q.y), .yMax = fmax(p.y, q.y)};
+        }
+    }
+    qsort(s->edges, (size_t) s->edgeCount, sizeof(PolygonFillEdge), ComparePolygonFillEdgeYMin);
+    s->activeCount = 0;
+}
+
+// 행 b의 띠에 걸친 변만 남도록 활성 변 표를 고친다. 행은 오름차순으로만 진행하므로, 띠 아래로 지나간 변은 빼고
+// 띠에 새로 닿은 변은 정렬된 변 목록에서 차례로 더한다. *nextEdge는 아직 더하지 않은 첫 변이다.
+static void UpdatePolygonFillActiveEdges(PolygonFillScratch *s, int b, int *nextEdge) {
+    int kept = 0;
+    for (int i = 0; i < s->activeCount; i++) {
+        if (s->edges[s->active[i]].yMax >= b) {
+            s->active[kept++] = s->active[i];
+        }
+    }
+    for (; *nextEdge < s->edgeCount && s->edges[*nextEdge].yMin <= b + 1; ++*nextEdge) {
+        if (s->edges[*nextEdge].yMax >= b) {
+            s->active[kept++] = *nextEdge;
+        }
+    }
+    s->activeCount = kept;
+}
+
+// 한 행(b)의 t 삼각형 중 폴리곤에 드는 a 범위를 모은다. 중심 모드는 중심을 지나는 수평선(j = b + 1/3, b + 2/3)과
+// 변의 교점으로 짝-홀 규칙의 구간을 만들고, 겹침 모드는 여기에 변이 지나가는 세그먼트를 더한다.
+// 행 안의 세그먼트 순번 q = 2a + t는 점 (i, j = b + u)에서 floor(i) + floor(i + u)이고,
+// 세그먼트 사이 경계선들은 행 안에서 서로 만나지 않으므로 직선 조각이 지나는 q는 양 끝점 사이의 연속 구간이다.
+static void CollectPolygonFillRow(PolygonFillScratch *s, int b, int mode, int rangeCount[2]) {
+    rangeCount[0] = 0;
+    rangeCount[1] = 0;
+    for (int t = 0; t < 2; t++) {
+        const double y = b + (t == 0 ? 1.0 / 3 : 2.0 / 3);
+        int crossingCount = 0;
+        for (int e = 0; e < s->activeCount; e++) {
+            const LatticePoint p = s->edges[s->active[e]].p;
+            const LatticePoint q = s->edges[s->active[e]].q;
+            if ((p.y <= y) != (q.y <= y)) {
+                s->crossings[crossingCount++] = p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y);
+            }
+        }
+        qsort(s->crossings, (size_t) crossingCount, sizeof(double), CompareDouble);
+
+        const double centerOffset = t == 0 ? 1.0 / 3 : 2.0 / 3;
+        for (int i = 0; i + 1 < crossingCount; i += 2) {
+            s->ranges[t][rangeCount[t]++] = (Int64Range) {
+                    .lo = (int64_t) ceil(s->crossings[i] - centerOffset),
+                    .hi = FloorToInt64(s->crossings[i + 1] - centerOffset),
+            };
+        }
+    }
+
+    if (mode != PolygonFillMode_Overlap) {
+        return;
+    }
+
+    // 활성 변은 모두 b <= j <= b + 1 띠에 걸쳐 있다.
+    const double eps = PolygonFillTouchEpsilon;
+    for (int i = 0; i < s->activeCount; i++) {
+        const LatticePoint p = s->edges[s->active[i]].p;
+        const LatticePoint q = s->edges[s->active[i]].q;
+
+        // 변을 b <= j <= b + 1 띠로 자른다.
+        double t0 = 0;
+        double t1 = 1;
+        if (p.y != q.y) {
+            const double tb = (b - p.y) / (q.y - p.y);
+            const double tt = (b + 1 - p.y) / (q.y - p.y);
+            t0 = fmax(0, fmin(tb, tt));
+            t1 = fmin(1, fmax(tb, tt));
+        }
+
+        int64_t qLo = INT64_MAX;
+        int64_t qHi = INT64_MIN;
+        for (int e = 0; e < 2; e++) {
+            const double pt = e == 0 ? t0 : t1;
+            const double x = p.x + pt * (q.x - p.x);
+            const double u = fmin(1, fmax(0, p.y + pt * (q.y - p.y) - b));
+            const int64_t lo = FloorToInt64(x - eps) + FloorToInt64(x + u - eps);
+            const int64_t hi = FloorToInt64(x + eps) + FloorToInt64(x + u + eps);
+            qLo = lo < qLo ? lo : qLo;
+            qHi = hi > qHi ? hi : qHi;
+        }
+
+        // q 구간을 t별 a 구간으로 나눈다. q = 2a + t
+        for (int t = 0; t < 2; t++) {
+            s->ranges[t][rangeCount[t]++] = (Int64Range) {
+                    .lo = -FloorDiv2(-(qLo - t)),
+                    .hi = FloorDiv2(qHi - t),
+            };
+        }
+    }
+}
+
+// 세그먼트 그룹 하나에서 폴리곤에 드는 세그먼트를 오름차순으로 쓴다. start보다 작은 인덱스는 건너뛴다.
+static int WritePolygonFillFace(SegmentIndexWriter *writer, PolygonFillScratch *s, int n, int segGroup, int mode,
+                                int64_t start, int64_t *stoppedAt) {
+    double yMin = INFINITY;
+    double yMax = -INFINITY;
+    for (int i = 0; i < s->ringStart[s->clippedRingCount]; i++) {
+        yMin = fmin(yMin, s->lattice[i].y);
+        yMax = fmax(yMax, s->lattice[i].y);
+    }
+
+    const int64_t groupStart = CalculateSegmentCountPerGroup64(n) * segGroup;
+    int64_t firstRow = FloorToInt64(yMin - PolygonFillTouchEpsilon);
+    const int64_t lastRow = FloorToInt64(yMax + PolygonFillTouchEpsilon);
+    firstRow = firstRow < 0 ? 0 : firstRow;
+    if (start > groupStart) {
+        const int startRow = CalculateBFromLocalSegmentIndex(n, start - groupStart);
+        firstRow = startRow > firstRow ? startRow : firstRow;
+    }
+
+    BuildPolygonFillEdges(s);
+    int nextEdge = 0;
+    for (int64_t row = firstRow; row <= lastRow && row < n; row++) {
+        const int b = (int) row;
+        int rangeCount[2];
+        UpdatePolygonFillActiveEdges(s, b, &nextEdge);
+        CollectPolygonFillRow(s, b, mode, rangeCount);
+
+        const int64_t rowStart = groupStart + (int64_t) b * (2 * n - b);
+        const int64_t minQ = start > rowStart ? start - rowStart : 0;
+        for (int t = 0; t < 2; t++) {
+            // 면 삼각형 안의 세그먼트만, 이어서 쓰는 경우 start부터 남긴다.
+            const int64_t minA = -FloorDiv2(-(minQ - t));
+            const int64_t maxA = n - 1 - b - t;
+            for (int i = 0; i < rangeCount[t]; i++) {
+                s->ranges[t][i].lo = s->ranges[t][i].lo < minA ? minA : s->ranges[t][i].lo;
+                s->ranges[t][i].hi = s->ranges[t][i].hi > maxA ? maxA : s->ranges[t][i].hi;
+            }
+            rangeCount[t] = MergeInt64Ranges(s->ranges[t], rangeCount[t]);
+        }
+
+        // 두 t의 구간 목록을 q 순서로 엮어서 쓴다.
+        int index[2] = {0, 0};
+        int64_t a[2] = {
+                rangeCount[0] > 0 ? s->ranges[0][0].lo : 0,
+                rangeCount[1] > 0 ? s->ranges[1][0].lo : 0,
+        };
+        while (index[0] < rangeCount[0] || index[1] < rangeCount[1]) {
+            const int64_t q0 = index[0] < rangeCount[0] ? 2 * a[0] : INT64_MAX;
+            const int64_t q1 = index[1] < rangeCount[1] ? 2 * a[1] + 1 : INT64_MAX;
+            const int t = q0 < q1 ? 0 : 1;
+            const int64_t segmentIndex = rowStart + (t == 0 ? q0 : q1);
+            const int result = WriteSegmentIndex(writer, segmentIndex);
+            if (result != ErrorCode_None) {
+                *stoppedAt = segmentIndex;
+                return result;
+            }
+
+            if (++a[t] > s->ranges[t][index[t]].hi && ++index[t] < rangeCount[t]) {
+                a[t] = s->ranges[t][index[t]].lo;
+            }
+        }
+    }
+    return ErrorCode_None;
+}
+
+static void FreePolygonFillScratch(PolygonFillScratch *s) {
+    free(s->sphere);
+    free(s->clipA);
+    free(s->clipB);
+    free(s->lattice);
+    free(s->ringStart);
+    free(s->edges);
+    free(s->active);
+    free(s->crossings);
+    free(s->ranges[0]);
+    free(s->ranges[1]);
+}
+
+// 이어 쓰기 가능한 질의의 마무리. 버퍼가 찼으면 *cursor를 쓰지 못한 첫 세그먼트로, 끝까지 썼으면 -1로 바꾼다.
+// 개수만 세는 경우(출력 버퍼가 없는 경우)에는 *cursor를 바꾸지 않는다.
+static int FinishResumableWrite(const SegmentIndexWriter *writer, int result, int64_t stoppedAt, int64_t *cursor) {
+    if (writer->out32 == NULL && writer->out64 == NULL) {
+        return result;
+    }
+    if (result == ErrorCode_BufferTooSmall) {
+        *cursor = stoppedAt;
+        return ErrorCode_None;
+    }
+    if (result == ErrorCode_None) {
+        *cursor = -1;
+    }
+    return result;
+}
+
+// 폴리곤에 드는 세그먼트를 *cursor부터 오름차순으로 쓴다.
+static int WritePolygonFill(SegmentIndexWriter *writer, int n, const GpsCoords *vertices, const int *ringVertexCounts,
+                            int ringCount, int mode, int64_t *cursor) {
+    if (vertices == NULL || ringVertexCounts == NULL || cursor == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (n < 1 || n > MaxSubdivisionCount64 || ringCount < 1 ||
+        (mode != PolygonFillMode_Center && mode != PolygonFillMode_Overlap) || *cursor < -1 ||
+        *cursor >= CalculateSegmentCountPerGroup64(n) * GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    if (*cursor == -1) {
+        return ErrorCode_None;
+    }
+
+    int vertexCount = 0;
+    int maxRingVertexCount = 0;
+    for (int r = 0; r < ringCount; r++) {
+        if (ringVertexCounts[r] < 3 || ringVertexCounts[r] > INT_MAX / 16 - vertexCount) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+        vertexCount += ringVertexCounts[r];
+        maxRingVertexCount = ringVertexCounts[r] > maxRingVertexCount ? ringVertexCounts[r] : maxRingVertexCount;
+    }
+
+    // 볼록한 원뿔로 자르면 평면 하나마다 꼭짓점이 많아야 교점 수만큼 늘어난다.
+    PolygonFillScratch s = {.pointCapacity = 8 * vertexCount + 8 * ringCount};
+    const int ringCapacity = 8 * maxRingVertexCount + 8;
+    s.sphere = malloc(sizeof(Vector3) * vertexCount);
+    s.clipA = malloc(sizeof(Vector3) * ringCapacity);
+    s.clipB = malloc(sizeof(Vector3) * ringCapacity);
+    s.lattice = malloc(sizeof(LatticePoint) * s.pointCapacity);
+    s.ringStart = malloc(sizeof(int) * (ringCount + 1));
+    s.edges = malloc(sizeof(PolygonFillEdge) * s.pointCapacity);
+    s.active = malloc(sizeof(int) * s.pointCapacity);
+    s.crossings = malloc(sizeof(double) * s.pointCapacity);
+    s.ranges[0] = malloc(sizeof(Int64Range) * s.pointCapacity * 2);
+    s.ranges[1] = malloc(sizeof(Int64Range) * s.pointCapacity * 2);
+    if (s.sphere == NULL || s.clipA == NULL || s.clipB == NULL || s.lattice == NULL || s.ringStart == NULL ||
+        s.edges == NULL || s.active == NULL || s.crossings == NULL || s.ranges[0] == NULL || s.ranges[1] == NULL) {
+        FreePolygonFillScratch(&s);
+        return ErrorCode_OutOfMemory;
+    }
+    for (int i = 0; i < vertexCount; i++) {
+        s.sphere[i] = CalculateUnitSpherePosition(vertices[i].lat, vertices[i].lng);
+    }
+
+    int result = ErrorCode_None;
+    int64_t stoppedAt = -1;
+    const int64_t start = *cursor;
+    const int64_t segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    for (int segGroup = (int) (start / segmentCountPerGroup); segGroup < GroupCount && result == ErrorCode_None;
+         segGroup++) {
+        PolygonFillFace face;
+        CalculatePolygonFillFace(&face, n, segGroup);
+
+        // 고리마다 면 원뿔로 잘라 격자 좌표로 옮긴다. 외곽선이 면에 닿지 않으면 이 면은 건너뛴다.
+        s.clippedRingCount = 0;
+        s.ringStart[0] = 0;
+        int ringOffset = 0;
+        for (int r = 0; r < ringCount; r++) {
+            int count = ringVertexCounts[r];
+            memcpy(s.clipA, s.sphere + ringOffset, sizeof(Vector3) * count);
+            ringOffset += ringVertexCounts[r];
+            count = ClipRingByPlane(s.clipA, count, face.clipPlanes[0], s.clipB);
+            count = ClipRingByPlane(s.clipB, count, face.clipPlanes[1], s.clipA);
+            count = ClipRingByPlane(s.clipA, count, face.clipPlanes[2], s.clipB);
+            if (count < 3) {
+                if (r == 0) {
+                    break;
+                }
+                continue;
+            }
+
+            const int base = s.ringStart[s.clippedRingCount];
+            for (int i = 0; i < count; i++) {
+                s.lattice[base + i] = ProjectToLattice(&face, s.clipB[i]);
+            }
+            s.ringStart[++s.clippedRingCount] = base + count;
+        }
+
+        if (s.clippedRingCount > 0) {
+            result = WritePolygonFillFace(writer, &s, n, segGroup, mode, start, &stoppedAt);
+        }
+    }
+    FreePolygonFillScratch(&s);
+    return FinishResumableWrite(writer, result, stoppedAt, cursor);
+}
+
+FFI_PLUGIN_EXPORT int GetSegmentIndicesInPolygon(int n, const GpsCoords *vertices, const int *ringVertexCounts,
+                                                 int ringCount, int mode, int64_t *cursor, int *outSegmentIndex,
+                                                 int outCapacity) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1 || outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out32 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WritePolygonFill(&writer, n, vertices, ringVertexCounts, ringCount, mode, cursor);
+    if (result != ErrorCode_None) {
+        return result;
+    }
+    return writer.count > INT_MAX ? ErrorCode_ArgumentOutOfRangeException : (int) writer.count;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentIndicesInPolygon64(int n, const GpsCoords *vertices, const int *ringVertexCounts,
+                                                       int ringCount, int mode, int64_t *cursor,
+                                                       int64_t *outSegmentIndex, int64_t outCapacity) {
+    if (outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out64 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WritePolygonFill(&writer, n, vertices, ringVertexCounts, ringCount, mode, cursor);
+    return result != ErrorCode_None ? result : writer.count;
+}
+
+// 방향 p(길이 무관)가 중심 c, cos(반지름) = k인 구면 캡 안에 있는지 내적만으로 판단한다.
+static int IsDirectionInCap(Vector3 p, Vector3 c, double k) {
+    const double l = Dot(p, c);
+    const double kk = k * k * SqrMagnitude(p);
+    return k >= 0 ? l >= 0 && l * l >= kk : l >= 0 || l * l <= kk;
+}
+
+// 꼭짓점 방향이 p0, p1, p2인 구면 삼각형(변은 대원 호)이 캡과 조금이라도 겹치는지 판단한다. 삼각 함수는 쓰지 않는다.
+static int DoesTriangleOverlapCap(Vector3 p0, Vector3 p1, Vector3 p2, Vector3 c, double k) {
+    if (IsDirectionInCap(p0, c, k) || IsDirectionInCap(p1, c, k) || IsDirectionInCap(p2, c, k)) {
+        return 1;
+    }
+
+    // 반구보다 큰 캡의 여집합은 볼록하므로, 꼭짓점이 모두 여집합에 있으면 삼각형 전체가 여집합에 있다.
+    if (k < 0) {
+        return 0;
+    }
+
+    // 캡 중심이 삼각형 안에 있는 경우
+    const Vector3 p[3] = {p0, p1, p2};
+    const double orientation = Dot(p0, Cross(p1, p2)) < 0 ? -1 : 1;
+    if (orientation * Dot(c, Cross(p0, p1)) >= 0 && orientation * Dot(c, Cross(p1, p2)) >= 0 &&
+        orientation * Dot(c, Cross(p2, p0)) >= 0) {
+        return 1;
+    }
+
+    // 변 위에서 캡 중심에 가장 가까운 점이 캡 안에 있는 경우.
+    // 가장 가까운 점은 c를 호의 평면에 내린 발이고, 발이 호의 두 끝 사이에 있을 때만 끝점보다 가깝다.
+    for (int i = 0; i < 3; i++) {
+        const Vector3 m = Cross(p[i], p[(i + 1) % 3]);
+        if (Dot(Cross(p[i], c), m) < 0 || Dot(Cross(c, p[(i + 1) % 3]), m) < 0) {
+            continue;
+        }
+
+        const double cm = Dot(c, m);
+        const double mm = SqrMagnitude(m);
+        if (mm - cm * cm >= k * k * mm) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 캡 질의에서 세그먼트 그룹 하나에 대해 미리 계산해 두는 값들. 면 평면 위의 점 P(i, j) = origin + i axisA + j axisB
+// 방향이 캡 안에 있을 조건 (P·c)^2 >= k^2 |P|^2 (P·c >= 0)은 격자 좌표 (i, j)에 대한 이차식이다.
+typedef struct {
+    Vector3 origin;
+    Vector3 axisA;
+    Vector3 axisB;
+    // 한 행의 직선 j = 상수 위에서 f(i) = alpha i^2 + (beta0 + beta1 j) i + (gamma0 + gamma1 j + gamma2 j^2)
+    double alpha;
+    double beta0, beta1;
+    double gamma0, gamma1, gamma2;
+    // P·c = c0 + cA i + cB j
+    double c0, cA, cB;
+} CapFace;
+
+static void CalculateCapFace(CapFace *out, const SegmentGroupConstants *segGroupConstants, Vector3 c, double k) {
+    const Vector3 o = segGroupConstants->origin;
+    const Vector3 a = segGroupConstants->axisA;
+    const Vector3 b = segGroupConstants->axisB;
+    const double kk = k * k;
+    out->origin = o;
+    out->axisA = a;
+    out->axisB = b;
+    out->c0 = Dot(o, c);
+    out->cA = Dot(a, c);
+    out->cB = Dot(b, c);
+    out->alpha = out->cA * out->cA - kk * Dot(a, a);
+    out->beta0 = 2 * (out->c0 * out->cA - kk * Dot(o, a));
+    out->beta1 = 2 * (out->cB * out->cA - kk * Dot(a, b));
+    out->gamma0 = out->c0 * out->c0 - kk * Dot(o, o);
+    out->gamma1 = 2 * (out->c0 * out->cB - kk * Dot(o, b));
+    out->gamma2 = out->cB * out->cB - kk * Dot(b, b);
+}
+
+// 직선 j 위에서 캡 안에 드는 i 구간을 구한다 (k > 0). 양의 원뿔은 볼록하므로 직선과의 교집합은 한 구간이다.
+// 구간이 없으면 0을 반환한다. 끝이 열려 있으면 무한대를 담는다.
+static int CalculateCapLineRange(const CapFace *face, double j, double *lo, double *hi) {
+    const double alpha = face->alpha;
+    const double beta = face->beta0 + face->beta1 * j;
+    const double gamma = face->gamma0 + (face->gamma1 + face->gamma2 * j) * j;
+    const double l0 = face->c0 + face->cB * j;
+    const double disc = beta * beta - 4 * alpha * gamma;
+
+    if (alpha == 0) {
+        // f가 일차식인 경우
+        if (beta == 0) {
+            *lo = -INFINITY;
+            *hi = INFINITY;
+            return gamma >= 0 && l0 >= 0;
+        }
+        const double root = -gamma / beta;
+        *lo = beta > 0 ? root : -INFINITY;
+        *hi = beta > 0 ? INFINITY : root;
+    } else if (disc < 0) {
+        // alpha < 0이면 f < 0, alpha > 0이면 직선 전체가 한쪽 원뿔 안이다.
+        if (alpha < 0) {
+            return 0;
+        }
+        *lo = -INFINITY;
+        *hi = INFINITY;
+    } else {
+        const double s = sqrt(disc);
+        const double q = beta >= 0 ? -0.5 * (beta + s) : -0.5 * (beta - s);
+        double r1 = q / alpha;
+        double r2 = q != 0 ? gamma / q : r1;
+        if (r1 > r2) {
+            const double tmp = r1;
+            r1 = r2;
+            r2 = tmp;
+        }
+
+        if (alpha < 0) {
+            *lo = r1;
+            *hi = r2;
+        } else {
+            // 두 반직선 중 P·c >= 0인 쪽만 캡이다.
+            const double probe = face->cA >= 0 ? 1 : -1;
+            *lo = probe > 0 ? r2 : -INFINITY;
+            *hi = probe > 0 ? INFINITY : r1;
+        }
+    }
+
+    // 남은 구간이 음의 원뿔 쪽이면 비어 있다. 구간 안에서 P·c의 부호는 바뀌지 않는다.
+    const double mid = isinf(*lo) ? (isinf(*hi) ? 0 : *hi - 1) : (isinf(*hi) ? *lo + 1 : 0.5 * (*lo + *hi));
+    return l0 + face->cA * mid >= 0;
+}
+
+static int64_t ClampToInt64Range(double v, int64_t lo, int64_t hi) {
+    if (!(v > (double) lo)) {
+        return lo;
+    }
+    return v < (double) hi ? (int64_t) v : hi;
+}
+
+// 캡(k > 0)이 닿는 행 범위를 구한다. 후보 영역이 유계(타원)이면 판별식 Delta(j) = beta(j)^2 - 4 alpha gamma(j) >= 0에서
+// 구하고, 아니면 0..n-1을 그대로 둔다. 닿는 행이 없으면 0을 반환한다.
+static int CalculateCapRowRange(const CapFace *face, int n, int64_t *firstRow, int64_t *lastRow) {
+    *firstRow = 0;
+    *lastRow = n - 1;
+    if (face->alpha >= 0) {
+        return 1;
+    }
+
+    const double d2 = face->beta1 * face->beta1 - 4 * face->alpha * face->gamma2;
+    const double d1 = 2 * face->beta0 * face->beta1 - 4 * face->alpha * face->gamma1;
+    const double d0 = face->beta0 * face->beta0 - 4 * face->alpha * face->gamma0;
+    const double disc = d1 * d1 - 4 * d2 * d0;
+    if (d2 < 0) {
+        if (disc < 0) {
+            return 0;
+        }
+        const double s = sqrt(disc);
+        const double j1 = (-d1 + s) / (2 * d2);
+        const double j2 = (-d1 - s) / (2 * d2);
+        *firstRow = ClampToInt64Range(floor(fmin(j1, j2)) - 1, 0, n - 1);
+        *lastRow = ClampToInt64Range(floor(fmax(j1, j2)) + 1, -1, n - 1);
+    }
+    return 1;
+}
+
+// 캡 후보 세그먼트를 세그먼트 그룹 안에서 행 단위로 훑어 오름차순으로 쓴다.
+// 후보는 candidateK(중심 모드는 캡 그대로, 겹침 모드는 세그먼트 크기만큼 넓힌 캡)로 뽑고, 하나씩 내적으로 확인한다.
+static int WriteCapFace(SegmentIndexWriter *writer, int n, int segGroup, const SegmentGroupConstants *constants,
+                        Vector3 c, double k, double candidateK, int mode) {
+    CapFace face;
+    CalculateCapFace(&face, constants, c, candidateK);
+
+    int64_t firstRow = 0;
+    int64_t lastRow = n - 1;
+    if (candidateK > 0 && !CalculateCapRowRange(&face, n, &firstRow, &lastRow)) {
+        return ErrorCode_None;
+    }
+
+    const int64_t groupStart = CalculateSegmentCountPerGroup64(n) * segGroup;
+    for (int64_t row = firstRow; row <= lastRow; row++) {
+        const int b = (int) row;
+        int64_t lo[2], hi[2];
+        for (int t = 0; t < 2; t++) {
+            const double offset = (1.0 + t) / 3;
+            lo[t] = 0;
+            hi[t] = n - 1 - b - t;
+            double rangeLo, rangeHi;
+            if (candidateK <= 0) {
+                continue;
+            }
+            if (!CalculateCapLineRange(&face, b + offset, &rangeLo, &rangeHi)) {
+                lo[t] = n;
+                hi[t] = -1;
+                continue;
+            }
+            // 부동소수 오차를 감안해 양쪽으로 한 칸씩 더 보고, 내적 검사로 거른다.
+            lo[t] = ClampToInt64Range(ceil(rangeLo - offset) - 1, 0, n);
+            hi[t] = ClampToInt64Range(floor(rangeHi - offset) + 1, -1, n - 1 - b - t);
+        }
+
+        const int64_t rowStart = groupStart + (int64_t) b * (2 * n - b);
+        const int64_t first = lo[0] < lo[1] ? lo[0] : lo[1];
+        const int64_t last = hi[0] > hi[1] ? hi[0] : hi[1];
+        for (int64_t a = first; a <= last; a++) {
+            const Vector3 corner = AddVector3(face.origin, AddVector3(ScalarMultiplyVector((double) a, face.axisA),
+                                                                      ScalarMultiplyVector(b, face.axisB)));
+            for (int t = 0; t < 2; t++) {
+                if (a < lo[t] || a > hi[t]) {
+                    continue;
+                }
+
+                int inside;
+                if (mode == CapQueryMode_Exact) {
+                    const Vector3 center = AddVector3(
+                            corner, ScalarMultiplyVector((1.0 + t) / 3, AddVector3(face.axisA, face.axisB)));
+                    inside = IsDirectionInCap(center, c, k);
+                } else {
+                    const Vector3 pa = AddVector3(corner, face.axisA);
+                    const Vector3 pb = AddVector3(corner, face.axisB);
+                    inside = t == 0 ? DoesTriangleOverlapCap(corner, pa, pb, c, k)
+                                    : DoesTriangleOverlapCap(pa, pb, AddVector3(pa, face.axisB), c, k);
+                }
+                if (!inside) {
+                    continue;
+                }
+
+                const int result = WriteSegmentIndex(writer, rowStart + 2 * a + t);
+                if (result != ErrorCode_None) {
+                    return result;
+                }
+            }
+        }
+    }
+    return ErrorCode_None;
+}
+
+// 면 중심에서 꼭짓점까지의 각도 (acos(sqrt((5 + 2 sqrt 5) / 15)) = 0.65236)에 꼭짓점 표 오차만큼 여유를 둔 값
+#define FaceAngularCircumradius (0.6524)
+
+// 세그먼트 외접원 반지름(각도)의 상한. 평면 위 외접원 반지름을 원점에서 면 평면까지 거리로 나누고 여유를 둔다.
+static double CalculateSegmentAngularCircumradius(const SegmentGroupConstants *constants) {
+    const Vector3 centroid = ScalarMultiplyVector(1.0 / 3, AddVector3(constants->axisA, constants->axisB));
+    const double circumradius = sqrt(fmax(fmax(SqrMagnitude(centroid),
+                                               SqrMagnitude(DiffVector3(centroid, constants->axisA))),
+                                          SqrMagnitude(DiffVector3(centroid, constants->axisB))));
+    const Vector3 normal = NormalizeVector3(Cross(constants->axisA, constants->axisB));
+    const double planeDistance = fabs(Dot(constants->origin, normal));
+    return circumradius / planeDistance * 1.001;
+}
+
+static int WriteCap(SegmentIndexWriter *writer, int n, double lat, double lng, double radius, int mode) {
+    if (n < 1 || n > MaxSubdivisionCount64 || !(radius >= 0) ||
+        (mode != CapQueryMode_Exact && mode != CapQueryMode_Conservative)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const Vector3 c = CalculateUnitSpherePosition(lat, lng);
+    const double k = cos(fmin(radius, M_PI));
+    const double faceReachK = cos(fmin(radius + FaceAngularCircumradius, M_PI));
+    const Vector3 *segGroupNormalList = GetIcosahedronGeometry(n)->segGroupNormalList;
+    for (int segGroup = 0; segGroup < GroupCount; segGroup++) {
+        // 면 외접원에도 닿지 않으면 면 상수를 계산하지 않고 건너뛴다.
+        if (Dot(c, segGroupNormalList[segGroup]) < faceReachK) {
+            continue;
+        }
+
+        SegmentGroupConstants constants;
+        CalculateSegmentGroupConstants(&constants, n, segGroup);
+
+        // 면 전체와 겹치지 않으면 건너뛴다.
+        const Vector3 o = constants.origin;
+        const Vector3 faceA = AddVector3(o, ScalarMultiplyVector(n, constants.axisA));
+        const Vector3 faceB = AddVector3(o, ScalarMultiplyVector(n, constants.axisB));
+        if (!DoesTriangleOverlapCap(o, faceA, faceB, c, k)) {
+            continue;
+        }
+
+        // 겹침 모드의 후보는 세그먼트 외접원 반지름(각도)만큼 넓힌 캡 안의 중심이다.
+        double candidateK = k;
+        if (mode == CapQueryMode_Conservative) {
+            candidateK = cos(fmin(radius + CalculateSegmentAngularCircumradius(&constants), M_PI));
+        }
+
+        const int result = WriteCapFace(writer, n, segGroup, &constants, c, k, candidateK, mode);
+        if (result != ErrorCode_None) {
+            return result;
+        }
+    }
+    return ErrorCode_None;
+}
+
+FFI_PLUGIN_EXPORT int GetSegmentIndicesInCap(int n, double lat, double lng, double radius, int mode,
+                                             int *outSegmentIndex, int outCapacity) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1 || outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out32 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WriteCap(&writer, n, lat, lng, radius, mode);
+    if (result != ErrorCode_None) {
+        return result;
+    }
+    return writer.count > INT_MAX ? ErrorCode_ArgumentOutOfRangeException : (int) writer.count;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentIndicesInCap64(int n, double lat, double lng, double radius, int mode,
+                                                   int64_t *outSegmentIndex, int64_t outCapacity) {
+    if (outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out64 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WriteCap(&writer, n, lat, lng, radius, mode);
+    return result != ErrorCode_None ? result : writer.count;
+}
+
+// 위경도 상자 질의의 조건. 위도 조건은 극을 중심으로 한 캡이고, 경도 조건은 지축을 지나는 평면들의 반공간이다.
+typedef enum {
+    // 경도 조건 없음 (폭 2 pi)
+    LatLngBoxLng_All,
+    // 두 반공간의 교집합 (폭 <= pi)
+    LatLngBoxLng_Narrow,
+    // 두 반공간의 합집합 (폭 > pi)
+    LatLngBoxLng_Wide,
+} LatLngBoxLng;
+
+typedef struct {
+    double minLat, maxLat;
+    double minLng, lngWidth;
+    // 위도 >= minLat은 북극 캡 (k = sin minLat), 위도 <= maxLat은 남극 캡 (k = -sin maxLat)이다. 극까지 열려 있으면 0
+    int hasMinLat, hasMaxLat;
+    double minLatK, maxLatK;
+    LatLngBoxLng lngMode;
+    // minLng에서 동쪽, maxLng에서 서쪽을 향하는 반공간의 법선
+    Vector3 minLngPlane;
+    Vector3 maxLngPlane;
+    // 폭이 pi보다 넓을 때 상자를 볼록한 두 조각으로 나누는 가운데 자오면의 법선. 서쪽 조각을 향한다.
+    Vector3 midLngPlane;
+} LatLngBox;
+
+static const Vector3 NorthPoleDirection = {0, 1, 0};
+static const Vector3 SouthPoleDirection = {0, -1, 0};
+
+// 경도 lng에서 서쪽(경도가 작은 쪽)을 향하는 자오면의 법선
+static Vector3 CalculateWestwardMeridianNormal(double lng) {
+    return (Vector3) {sin(lng), 0, -cos(lng)};
+}
+
+static void CalculateLatLngBox(LatLngBox *out, double minLat, double maxLat, double minLng, double lngWidth) {
+    out->minLat = fmax(minLat, -M_PI / 2);
+    out->maxLat = fmin(maxLat, M_PI / 2);
+    out->minLng = minLng;
+    out->lngWidth = fmin(lngWidth, 2 * M_PI);
+    out->hasMinLat = out->minLat > -M_PI / 2;
+    out->hasMaxLat = out->maxLat < M_PI / 2;
+    out->minLatK = sin(out->minLat);
+    out->maxLatK = -sin(out->maxLat);
+    out->lngMode = out->lngWidth >= 2 * M_PI ? LatLngBoxLng_All
+                   : out->lngWidth <= M_PI  ? LatLngBoxLng_Narrow
+                                            : LatLngBoxLng_Wide;
+    out->minLngPlane = NegateVector3(CalculateWestwardMeridianNormal(minLng));
+    out->maxLngPlane = CalculateWestwardMeridianNormal(minLng + out->lngWidth);
+    out->midLngPlane = CalculateWestwardMeridianNormal(minLng + out->lngWidth / 2);
+}
+
+// 방향 p(길이 무관)가 상자 안에 있는지 내적만으로 판단한다. 극은 모든 경도에 속한다.
+static int IsDirectionInLatLngBox(Vector3 p, const LatLngBox *box) {
+    if ((box->hasMinLat && !IsDirectionInCap(p, NorthPoleDirection, box->minLatK)) ||
+        (box->hasMaxLat && !IsDirectionInCap(p, SouthPoleDirection, box->maxLatK))) {
+        return 0;
+    }
+
+    switch (box->lngMode) {
+        case LatLngBoxLng_Narrow:
+            return Dot(p, box->minLngPlane) >= 0 && Dot(p, box->maxLngPlane) >= 0;
+        case LatLngBoxLng_Wide:
+            return Dot(p, box->minLngPlane) >= 0 || Dot(p, box->maxLngPlane) >= 0;
+        default:
+            return 1;
+    }
+}
+
+// 볼록한 구면 다각형(꼭짓점 count개, 길이 무관) 위에서 sin(위도)의 범위를 구한다. 꼭짓점 말고도 변(대원 호)이
+// 극 쪽으로 부풀어 오른 점이 극값이 될 수 있다. 다각형이 극을 품는 경우는 부르는 쪽에서 따로 다룬다.
+static void CalculateSinLatRange(const Vector3 *p, int count, double *lo, double *hi) {
+    *lo = 1;
+    *hi = -1;
+    for (int i = 0; i < count; i++) {
+        const double s = p[i].y / sqrt(SqrMagnitude(p[i]));
+        *lo = fmin(*lo, s);
+        *hi = fmax(*hi, s);
+    }
+
+    const int edgeCount = count < 3 ? count - 1 : count;
+    for (int i = 0; i < edgeCount; i++) {
+        const Vector3 from = p[i];
+        const Vector3 to = p[(i + 1) % count];
+        const Vector3 m = Cross(from, to);
+        const double mm = SqrMagnitude(m);
+        if (mm == 0) {
+            continue;
+        }
+
+        // 대원 위에서 가장 북쪽인 점 f (|f| = 그 점의 sin 위도)와 가장 남쪽인 점 -f가 호 위에 있는지 본다.
+        const Vector3 f = DiffVector3(NorthPoleDirection, ScalarMultiplyVector(m.y / mm, m));
+        const double top = sqrt(SqrMagnitude(f));
+        if (Dot(Cross(from, f), m) >= 0 && Dot(Cross(f, to), m) >= 0) {
+            *hi = fmax(*hi, top);
+        }
+        if (Dot(Cross(f, from), m) >= 0 && Dot(Cross(to, f), m) >= 0) {
+            *lo = fmin(*lo, -top);
+        }
+    }
+}
+
+// 삼각형(반구보다 작은 구면 삼각형)이 상자와 겹치는지 판단한다. 경계에 닿기만 해도 겹친 것으로 본다.
+// 삼각형을 경도 조건의 볼록한 조각(반공간 두 개)으로 자르고, 잘린 다각형의 위도 범위를 위도 조건과 비교한다.
+static int DoesTriangleOverlapLatLngBox(Vector3 p0, Vector3 p1, Vector3 p2, const LatLngBox *box) {
+    if (IsDirectionInLatLngBox(p0, box) || IsDirectionInLatLngBox(p1, box) || IsDirectionInLatLngBox(p2, box)) {
+        return 1;
+    }
+
+    // 극은 모든 자오면 위에 있으므로, 경도 조각으로 자른 다각형이 극을 품는 것은 삼각형이 극을 품는 것과 같다.
+    const Vector3 triangle[3] = {p0, p1, p2};
+    const double orientation = Dot(p0, Cross(p1, p2)) < 0 ? -1 : 1;
+    int containsNorth = 1;
+    int containsSouth = 1;
+    for (int i = 0; i < 3; i++) {
+        const double side = orientation * Cross(triangle[i], triangle[(i + 1) % 3]).y;
+        containsNorth = containsNorth && side >= 0;
+        containsSouth = containsSouth && side <= 0;
+    }
+
+    // 평면 두 개로 자르면 꼭짓점은 많아야 5개다.
+    Vector3 clipA[5], clipB[5];
+    Vector3 planes[2][2] = {
+            {box->minLngPlane, box->maxLngPlane},
+            {box->minLngPlane, box->maxLngPlane},
+    };
+    int pieceCount = 1;
+    if (box->lngMode == LatLngBoxLng_Wide) {
+        planes[0][1] = box->midLngPlane;
+        planes[1][0] = NegateVector3(box->midLngPlane);
+        pieceCount = 2;
+    }
+
+    for (int piece = 0; piece < pieceCount; piece++) {
+        const Vector3 *polygon = triangle;
+        int count = 3;
+        if (box->lngMode != LatLngBoxLng_All) {
+            count = ClipRingByPlane(triangle, 3, planes[piece][0], clipA);
+            count = ClipRingByPlane(clipA, count, planes[piece][1], clipB);
+            polygon = clipB;
+        }
+        if (count == 0) {
+            continue;
+        }
+
+        double lo, hi;
+        CalculateSinLatRange(polygon, count, &lo, &hi);
+        hi = containsNorth ? 1 : hi;
+        lo = containsSouth ? -1 : lo;
+        if ((!box->hasMinLat || hi >= box->minLatK) && (!box->hasMaxLat || lo <= -box->maxLatK)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 상자를 품는 캡. 상자 가운데에서 가장 먼 상자 위의 점은 모서리 중 하나다 (위도선 위에서는 경도 차가 클수록,
+// 자오선 위에서는 양 끝으로 갈수록 멀어진다). 극을 품은 띠는 극을 중심으로 잡는다. cos(반지름)을 반환한다.
+static double CalculateLatLngBoxBoundingCap(const LatLngBox *box, Vector3 *center) {
+    if (box->lngMode == LatLngBoxLng_All && (!box->hasMinLat || !box->hasMaxLat)) {
+        *center = box->hasMaxLat ? SouthPoleDirection : NorthPoleDirection;
+        return box->hasMaxLat ? box->maxLatK : box->minLatK;
+    }
+
+    *center = CalculateUnitSpherePosition((box->minLat + box->maxLat) / 2, box->minLng + box->lngWidth / 2);
+    double k = 1;
+    for (int i = 0; i < 4; i++) {
+        const Vector3 corner = CalculateUnitSpherePosition(i < 2 ? box->minLat : box->maxLat,
+                                                           box->minLng + (i % 2) * box->lngWidth);
+        k = fmin(k, Dot(*center, corner));
+    }
+    return k;
+}
+
+// 한 행의 직선 위에서 후보 i 구간들. 조건 하나마다 구간이 많아야 하나 늘어난다.
+typedef struct {
+    double lo[8];
+    double hi[8];
+    int count;
+} LineRangeSet;
+
+static void IntersectLineRange(LineRangeSet *s, double lo, double hi) {
+    int count = 0;
+    for (int i = 0; i < s->count; i++) {
+        const double l = fmax(s->lo[i], lo);
+        const double h = fmin(s->hi[i], hi);
+        if (l <= h) {
+            s->lo[count] = l;
+            s->hi[count++] = h;
+        }
+    }
+    s->count = count;
+}
+
+static void SubtractLineRange(LineRangeSet *s, double lo, double hi) {
+    LineRangeSet r = {.count = 0};
+    for (int i = 0; i < s->count; i++) {
+        if (s->hi[i] < lo || s->lo[i] > hi) {
+            r.lo[r.count] = s->lo[i];
+            r.hi[r.count++] = s->hi[i];
+            continue;
+        }
+        if (s->lo[i] < lo) {
+            r.lo[r.count] = s->lo[i];
+            r.hi[r.count++] = lo;
+        }
+        if (s->hi[i] > hi) {
+            r.lo[r.count] = hi;
+            r.hi[r.count++] = s->hi[i];
+        }
+    }
+    *s = r;
+}
+
+// l0 + lA i >= 0인 i 구간. 없으면 0을 반환한다.
+static int CalculateHalfLine(double l0, double lA, double *lo, double *hi) {
+    if (lA == 0) {
+        *lo = -INFINITY;
+        *hi = INFINITY;
+        return l0 >= 0;
+    }
+    const double root = -l0 / lA;
+    *lo = lA > 0 ? root : -INFINITY;
+    *hi = lA > 0 ? INFINITY : root;
+    return 1;
+}
+
+// |k|가 이보다 작은 위도 조건은 판별식이 부동소수 오차에 묻히므로, 넉넉한 반공간으로 후보를 뽑는다.
+#define LatLngBoxHalfSpaceK (1e-4)
+
+// 위도 조건 하나를 행의 직선 위에서 다루는 방법
+typedef enum {
+    LatConstraint_None,
+    // 캡 안 (k > 0)
+    LatConstraint_InsideCap,
+    // 반대쪽 캡 밖 (k < 0)
+    LatConstraint_OutsideCap,
+    // P·c >= offset (k ~ 0)
+    LatConstraint_HalfSpace,
+} LatConstraintKind;
+
+typedef struct {
+    LatConstraintKind kind;
+    CapFace face;
+    double offset;
+} LatConstraint;
+
+// 상자 질의에서 세그먼트 그룹 하나에 대해 미리 계산해 두는 값들
+typedef struct {
+    Vector3 origin;
+    Vector3 axisA;
+    Vector3 axisB;
+    LatConstraint lat[2];
+    // 경도 반공간은 k = 0인 캡과 같다 (c0, cA, cB만 쓴다).
+    CapFace lng[2];
+    LatLngBoxLng lngMode;
+} LatLngBoxFace;
+
+static void CalculateLatConstraint(LatConstraint *out, const SegmentGroupConstants *constants, int has, Vector3 c,
+                                   double k) {
+    out->kind = LatConstraint_None;
+    if (!has) {
+        return;
+    }
+
+    if (fabs(k) < LatLngBoxHalfSpaceK) {
+        // 면 위의 점은 |P|가 면 평면까지 거리와 1 사이이므로, P·c >= k|P|를 품는 반공간으로 넓힌다.
+        const Vector3 normal = NormalizeVector3(Cross(constants->axisA, constants->axisB));
+        const double planeDistance = fabs(Dot(constants->origin, normal));
+        out->kind = LatConstraint_HalfSpace;
+        out->offset = k > 0 ? k * planeDistance : k;
+        CalculateCapFace(&out->face, constants, c, 0);
+    } else if (k > 0) {
+        out->kind = LatConstraint_InsideCap;
+        CalculateCapFace(&out->face, constants, c, k);
+    } else {
+        out->kind = LatConstraint_OutsideCap;
+        CalculateCapFace(&out->face, constants, NegateVector3(c), -k);
+    }
+}
+
+static void CalculateLatLngBoxFace(LatLngBoxFace *out, const SegmentGroupConstants *constants, const LatLngBox *box) {
+    out->origin = constants->origin;
+    out->axisA = constants->axisA;
+    out->axisB = constants->axisB;
+    CalculateLatConstraint(&out->lat[0], constants, box->hasMinLat, NorthPoleDirection, box->minLatK);
+    CalculateLatConstraint(&out->lat[1], constants, box->hasMaxLat, SouthPoleDirection, box->maxLatK);
+    CalculateCapFace(&out->lng[0], constants, box->minLngPlane, 0);
+    CalculateCapFace(&out->lng[1], constants, box->maxLngPlane, 0);
+    out->lngMode = box->lngMode;
+}
+
+// 직선 j 위에서 후보 상자 안에 드는 i 구간들을 구한다.
+static void CalculateLatLngBoxLineRanges(const LatLngBoxFace *face, double j, LineRangeSet *s) {
+    s->lo[0] = -INFINITY;
+    s->hi[0] = INFINITY;
+    s->count = 1;
+
+    double lo, hi;
+    for (int c = 0; c < 2; c++) {
+        const LatConstraint *lat = &face->lat[c];
+        switch (lat->kind) {
+            case LatConstraint_InsideCap:
+                if (!CalculateCapLineRange(&lat->face, j, &lo, &hi)) {
+                    s->count = 0;
+                    return;
+                }
+                IntersectLineRange(s, lo, hi);
+                break;
+            case LatConstraint_OutsideCap:
+                if (CalculateCapLineRange(&lat->face, j, &lo, &hi)) {
+                    SubtractLineRange(s, lo, hi);
+                }
+                break;
+            case LatConstraint_HalfSpace:
+                if (!CalculateHalfLine(lat->face.c0 + lat->face.cB * j - lat->offset, lat->face.cA, &lo, &hi)) {
+                    s->count = 0;
+                    return;
+                }
+                IntersectLineRange(s, lo, hi);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (face->lngMode == LatLngBoxLng_All) {
+        return;
+    }
+
+    double lo0, hi0, lo1, hi1;
+    const int has0 = CalculateHalfLine(face->lng[0].c0 + face->lng[0].cB * j, face->lng[0].cA, &lo0, &hi0);
+    const int has1 = CalculateHalfLine(face->lng[1].c0 + face->lng[1].cB * j, face->lng[1].cA, &lo1, &hi1);
+    if (face->lngMode == LatLngBoxLng_Narrow) {
+        if (!has0 || !has1) {
+            s->count = 0;
+            return;
+        }
+        IntersectLineRange(s, lo0, hi0);
+        IntersectLineRange(s, lo1, hi1);
+        return;
+    }
+
+    // 두 반직선의 합집합 = 두 여집합의 교집합(구간 하나)을 뺀 것
+    double excludedLo = -INFINITY;
+    double excludedHi = INFINITY;
+    const int has[2] = {has0, has1};
+    const double los[2] = {lo0, lo1};
+    const double his[2] = {hi0, hi1};
+    for (int h = 0; h < 2; h++) {
+        if (!has[h]) {
+            continue;
+        }
+        if (isinf(los[h]) && isinf(his[h])) {
+            return;
+        }
+        if (isinf(los[h])) {
+            excludedLo = fmax(excludedLo, his[h]);
+        } else {
+            excludedHi = fmin(excludedHi, los[h]);
+        }
+    }
+    if (excludedLo < excludedHi) {
+        SubtractLineRange(s, excludedLo, excludedHi);
+    }
+}
+
+// 세그먼트 그룹 하나에서 상자에 드는 세그먼트를 오름차순으로 쓴다. start보다 작은 인덱스는 건너뛴다.
+// 후보는 candidate 상자(중심 모드는 상자 그대로, 겹침 모드는 세그먼트 크기만큼 넓힌 상자)로 행마다 뽑고, 하나씩 확인한다.
+static int WriteLatLngBoxFace(SegmentIndexWriter *writer, int n, int segGroup, const SegmentGroupConstants *constants,
+                              const LatLngBox *box, const LatLngBox *candidate, int mode, int64_t start,
+                              int64_t *stoppedAt) {
+    LatLngBoxFace face;
+    CalculateLatLngBoxFace(&face, constants, candidate);
+
+    int64_t firstRow = 0;
+    int64_t lastRow = n - 1;
+    Vector3 boundCenter;
+    const double boundK = CalculateLatLngBoxBoundingCap(candidate, &boundCenter);
+    if (boundK > 0) {
+        CapFace bound;
+        CalculateCapFace(&bound, constants, boundCenter, boundK);
+        if (!CalculateCapRowRange(&bound, n, &firstRow, &lastRow)) {
+            return ErrorCode_None;
+        }
+    }
+
+    const int64_t groupStart = CalculateSegmentCountPerGroup64(n) * segGroup;
+    if (start > groupStart) {
+        const int startRow = CalculateBFromLocalSegmentIndex(n, start - groupStart);
+        firstRow = startRow > firstRow ? startRow : firstRow;
+    }
+
+    for (int64_t row = firstRow; row <= lastRow; row++) {
+        const int b = (int) row;
+        const int64_t rowStart = groupStart + (int64_t) b * (2 * n - b);
+        const int64_t minQ = start > rowStart ? start - rowStart : 0;
+        Int64Range ranges[2][8];
+        int rangeCount[2];
+        for (int t = 0; t < 2; t++) {
+            const double offset = (1.0 + t) / 3;
+            LineRangeSet s;
+            CalculateLatLngBoxLineRanges(&face, b + offset, &s);
+
+            // 부동소수 오차를 감안해 양쪽으로 한 칸씩 더 보고, 하나씩 확인한다.
+            const int64_t minA = -FloorDiv2(-(minQ - t));
+            const int64_t maxA = n - 1 - b - t;
+            for (int i = 0; i < s.count; i++) {
+                ranges[t][i].lo = ClampToInt64Range(ceil(s.lo[i] - offset) - 1, minA, maxA + 1);
+                ranges[t][i].hi = ClampToInt64Range(floor(s.hi[i] - offset) + 1, minA - 1, maxA);
+            }
+            rangeCount[t] = MergeInt64Ranges(ranges[t], s.count);
+        }
+
+        // 두 t의 구간 목록을 q 순서로 엮어서 확인한다.
+        int index[2] = {0, 0};
+        int64_t a[2] = {
+                rangeCount[0] > 0 ? ranges[0][0].lo : 0,
+                rangeCount[1] > 0 ? ranges[1][0].lo : 0,
+        };
+        while (index[0] < rangeCount[0] || index[1] < rangeCount[1]) {
+            const int64_t q0 = index[0] < rangeCount[0] ? 2 * a[0] : INT64_MAX;
+            const int64_t q1 = index[1] < rangeCount[1] ? 2 * a[1] + 1 : INT64_MAX;
+            const int t = q0 < q1 ? 0 : 1;
+            const Vector3 corner = AddVector3(face.origin, AddVector3(ScalarMultiplyVector((double) a[t], face.axisA),
+                                                                      ScalarMultiplyVector(b, face.axisB)));
+            int inside;
+            if (mode == PolygonFillMode_Center) {
+                const Vector3 center = AddVector3(
+                        corner, ScalarMultiplyVector((1.0 + t) / 3, AddVector3(face.axisA, face.axisB)));
+                inside = IsDirectionInLatLngBox(center, box);
+            } else {
+                const Vector3 pa = AddVector3(corner, face.axisA);
+                const Vector3 pb = AddVector3(corner, face.axisB);
+                inside = t == 0 ? DoesTriangleOverlapLatLngBox(corner, pa, pb, box)
+                                : DoesTriangleOverlapLatLngBox(pa, pb, AddVector3(pa, face.axisB), box);
+            }
+
+            if (inside) {
+                const int64_t segmentIndex = rowStart + (t == 0 ? q0 : q1);
+                const int result = WriteSegmentIndex(writer, segmentIndex);
+                if (result != ErrorCode_None) {
+                    *stoppedAt = segmentIndex;
+                    return result;
+                }
+            }
+
+            if (++a[t] > ranges[t][index[t]].hi && ++index[t] < rangeCount[t]) {
+                a[t] = ranges[t][index[t]].lo;
+            }
+        }
+    }
+    return ErrorCode_None;
+}
+
+// 위경도 상자에 드는 세그먼트를 *cursor부터 면 순서, 행 순서(= 오름차순)로 쓴다. 작업 메모리는 면 하나의 상수뿐이다.
+static int WriteLatLngBox(SegmentIndexWriter *writer, int n, double minLat, double minLng, double maxLat,
+                          double maxLng, int mode, int64_t *cursor) {
+    if (cursor == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (n < 1 || n > MaxSubdivisionCount64 || (mode != PolygonFillMode_Center && mode != PolygonFillMode_Overlap) ||
+        !(minLat >= -M_PI / 2 && minLat <= maxLat && maxLat <= M_PI / 2) || !(minLng >= -M_PI && minLng <= M_PI) ||
+        !(maxLng >= -M_PI && maxLng <= M_PI) || *cursor < -1 ||
+        *cursor >= CalculateSegmentCountPerGroup64(n) * GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    if (*cursor == -1) {
+        return ErrorCode_None;
+    }
+
+    // minLng > maxLng이면 날짜변경선을 건너는 상자다.
+    const double lngWidth = maxLng >= minLng ? maxLng - minLng : maxLng - minLng + 2 * M_PI;
+    LatLngBox box;
+    CalculateLatLngBox(&box, minLat, maxLat, minLng, lngWidth);
+
+    Vector3 boundCenter;
+    const double boundK = CalculateLatLngBoxBoundingCap(&box, &boundCenter);
+    const double boundRadius = acos(fmax(-1, fmin(1, boundK)));
+    const double faceReachK = cos(fmin(boundRadius + FaceAngularCircumradius, M_PI));
+
+    int result = ErrorCode_None;
+    int64_t stoppedAt = -1;
+    const int64_t start = *cursor;
+    const int64_t segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    const Vector3 *segGroupNormalList = GetIcosahedronGeometry(n)->segGroupNormalList;
+    for (int segGroup = (int) (start / segmentCountPerGroup); segGroup < GroupCount && result == ErrorCode_None;
+         segGroup++) {
+        // 상자를 품는 캡이 면 외접원에도 닿지 않으면 면 상수를 계산하지 않고 건너뛴다.
+        if (Dot(boundCenter, segGroupNormalList[segGroup]) < faceReachK) {
+            continue;
+        }
+
+        SegmentGroupConstants constants;
+        CalculateSegmentGroupConstants(&constants, n, segGroup);
+
+        const Vector3 o = constants.origin;
+        const Vector3 faceA = AddVector3(o, ScalarMultiplyVector(n, constants.axisA));
+        const Vector3 faceB = AddVector3(o, ScalarMultiplyVector(n, constants.axisB));
+        if (!DoesTriangleOverlapLatLngBox(o, faceA, faceB, &box)) {
+            continue;
+        }
+
+        // 겹침 모드의 후보는 세그먼트 외접원 반지름(각도) r만큼 넓힌 상자 안의 중심이다. 위도 phi에서 각거리 r은
+        // 경도로 asin(sin r / cos phi)까지 벌어지므로, 넓힌 상자에서 가장 극에 가까운 위도로 경도 폭을 넓힌다.
+        LatLngBox candidate = box;
+        if (mode == PolygonFillMode_Overlap) {
+            const double r = CalculateSegmentAngularCircumradius(&constants);
+            const double polarLat = fmax(fabs(minLat), fabs(maxLat)) + r;
+            const double lngMargin = polarLat < M_PI / 2 ? asin(fmin(1, sin(r) / cos(polarLat))) : M_PI;
+            CalculateLatLngBox(&candidate, minLat - r, maxLat + r, minLng - lngMargin, lngWidth + 2 * lngMargin);
+        }
+
+        result = WriteLatLngBoxFace(writer, n, segGroup, &constants, &box, &candidate, mode, start, &stoppedAt);
+    }
+    return FinishResumableWrite(writer, result, stoppedAt, cursor);
+}
+
+FFI_PLUGIN_EXPORT int GetSegmentIndicesInLatLngBox(int n, double minLat, double minLng, double maxLat, double maxLng,
+                                                   int mode, int64_t *cursor, int *outSegmentIndex, int outCapacity) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1 || outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out32 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WriteLatLngBox(&writer, n, minLat, minLng, maxLat, maxLng, mode, cursor);
+    if (result != ErrorCode_None) {
+        return result;
+    }
+    return writer.count > INT_MAX ? ErrorCode_ArgumentOutOfRangeException : (int) writer.count;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentIndicesInLatLngBox64(int n, double minLat, double minLng, double maxLat,
+                                                         double maxLng, int mode, int64_t *cursor,
+                                                         int64_t *outSegmentIndex, int64_t outCapacity) {
+    if (outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    SegmentIndexWriter writer = {.out64 = outSegmentIndex, .capacity = outCapacity};
+    const int result = WriteLatLngBox(&writer, n, minLat, minLng, maxLat, maxLng, mode, cursor);
+    return result != ErrorCode_None ? result : writer.count;
+}
+
+// n 격자와 k·n 격자 사이의 부모/자식 변환. 두 격자는 같은 면 삼각형을 나누므로 n 격자의 점 (a, b)는 k·n 격자의
+// 점 (ka, kb)이고, n 격자의 평행사변형 (a, b)는 k·n 격자의 k x k 평행사변형으로 나뉜다. 그 안의 오프셋
+// (alpha, beta)에서 alpha + beta + t <= k - 1이면 Bottom 삼각형, alpha + beta + t >= k이면 Top 삼각형에 든다.
+static int IsValidParentChildN(int n, int k) {
+    return n >= 1 && k >= 1 && (int64_t) n * k <= MaxSubdivisionCount64;
+}
+
+static int64_t CalculateParentSegmentIndex(int n, int k, int64_t segmentIndex) {
+    if (!IsValidParentChildN(n, k)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const SegGroupAndAbt child = SplitSegIndexToSegGroupAndAbt64(n * k, segmentIndex);
+    if (child.segGroup < 0 || child.abt.t == Parallelogram_Error) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int a = child.abt.a / k;
+    const int b = child.abt.b / k;
+    const int t = child.abt.a % k + child.abt.b % k + (child.abt.t == Parallelogram_Top ? 1 : 0) >= k ? 1 : 0;
+    return CalculateSegmentCountPerGroup64(n) * child.segGroup + (int64_t) b * (2 * n - b) + 2 * a + t;
+}
+
+// 자식 k^2개를 오름차순으로 쓴다. 행 kb + beta마다 연속한 구간 하나씩이다: Bottom 부모는 행 안의 순번
+// 2ka .. 2ka + 2(k - 1 - beta), Top 부모는 2ka + 2(k - beta) - 1 .. 2ka + 2k - 1이다.
+static int WriteChildSegmentIndices(SegmentIndexWriter *writer, int n, int k, int64_t segmentIndex) {
+    if (!IsValidParentChildN(n, k)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const SegGroupAndAbt parent = SplitSegIndexToSegGroupAndAbt64(n, segmentIndex);
+    if (parent.segGroup < 0 || parent.abt.t == Parallelogram_Error) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t childN = (int64_t) n * k;
+    const int64_t groupStart = childN * childN * parent.segGroup;
+    const int64_t q0 = 2 * (int64_t) k * parent.abt.a;
+    for (int beta = 0; beta < k; beta++) {
+        const int64_t row = (int64_t) k * parent.abt.b + beta;
+        const int64_t rowStart = groupStart + row * (2 * childN - row);
+        const int64_t first = parent.abt.t == Parallelogram_Top ? q0 + 2 * (k - beta) - 1 : q0;
+        const int64_t last = parent.abt.t == Parallelogram_Top ? q0 + 2 * k - 1 : q0 + 2 * (k - 1 - beta);
+        for (int64_t q = first; q <= last; q++) {
+            const int result = WriteSegmentIndex(writer, rowStart + q);
+            if (result != ErrorCode_None) {
+                return result;
+            }
+        }
+    }
+    return ErrorCode_None;
+}
+
+static int ParentBatchRange(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    int *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = (int) CalculateParentSegmentIndex(args->n, args->k, (uint32_t) args->segmentIndex[i]);
+    }
+    return ErrorCode_None;
+}
+
+static int ParentBatchRange64(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    int64_t *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = CalculateParentSegmentIndex(args->n, args->k, args->segmentIndex64[i]);
+    }
+    return ErrorCode_None;
+}
+
+// 부모마다 자식 k^2개를 부모 순서대로 쓴다. 조각 begin은 출력의 begin * k^2번째부터 쓰므로 겹치지 않는다.
+static int ChildrenBatchRange(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    const int64_t childCount = (int64_t) args->k * args->k;
+    SegmentIndexWriter writer = {.capacity = (end - begin) * childCount};
+    if (args->segmentIndex != NULL) {
+        writer.out32 = (int *) args->out + begin * childCount;
+    } else {
+        writer.out64 = (int64_t *) args->out + begin * childCount;
+    }
+    for (int64_t i = begin; i < end; i++) {
+        const int result = WriteChildSegmentIndices(
+                &writer, args->n, args->k,
+                args->segmentIndex != NULL ? (uint32_t) args->segmentIndex[i] : args->segmentIndex64[i]);
+        if (result != ErrorCode_None) {
+            return result;
+        }
+    }
+    return ErrorCode_None;
+}
+
+// 32비트 형식은 부모와 자식 격자가 모두 32비트 인덱스로 표현되어야 한다.
+static int IsValidParentChildN32(int n, int k) {
+    return IsValidParentChildN(n, k) && (int64_t) n * k * n * k * GroupCount <= (int64_t) UINT_MAX + 1;
+}
+
+FFI_PLUGIN_EXPORT int GetParentSegmentIndex(int n, int k, int segmentIndex) {
+    if (!IsValidParentChildN32(n, k)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    return (int) CalculateParentSegmentIndex(n, k, (uint32_t) segmentIndex);
+}
+
+FFI_PLUGIN_EXPORT int GetParentSegmentIndexBatch(ThreadPool *pool, int n, int k, int count, const int *segmentIndex,
+                                                 int *outParent) {
+    if (segmentIndex == NULL || outParent == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0 || !IsValidParentChildN32(n, k)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .k = k, .segmentIndex = segmentIndex, .out = outParent};
+    return RunBatch(pool, count, ParentBatchRange, &args);
+}
+
+FFI_PLUGIN_EXPORT int GetChildSegmentIndices(int n, int k, int segmentIndex, int *outSegmentIndex, int outCapacity) {
+    return GetChildSegmentIndicesBatch(NULL, n, k, 1, &segmentIndex, outSegmentIndex, outCapacity);
+}
+
+FFI_PLUGIN_EXPORT int GetChildSegmentIndicesBatch(ThreadPool *pool, int n, int k, int count, const int *segmentIndex,
+                                                  int *outSegmentIndex, int outCapacity) {
+    if (segmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0 || outCapacity < 0 || !IsValidParentChildN32(n, k) || (int64_t) k * k * count > INT_MAX) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    // 출력이 모두 들어가면 부모마다 쓸 위치가 정해져 있으므로 나누어 처리한다.
+    if (outSegmentIndex != NULL && (int64_t) k * k * count <= outCapacity) {
+        BatchArgs args = {.n = n, .k = k, .segmentIndex = segmentIndex, .out = outSegmentIndex};
+        const int result = RunBatch(pool, count, ChildrenBatchRange, &args);
+        return result != ErrorCode_None ? result : k * k * count;
+    }
+
+    SegmentIndexWriter writer = {.out32 = outSegmentIndex, .capacity = outCapacity};
+    for (int i = 0; i < count; i++) {
+        const int result = WriteChildSegmentIndices(&writer, n, k, (uint32_t) segmentIndex[i]);
+        if (result != ErrorCode_None) {
+            return result;
+        }
+    }
+    return (int) writer.count;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetParentSegmentIndex64(int n, int k, int64_t segmentIndex) {
+    return CalculateParentSegmentIndex(n, k, segmentIndex);
+}
+
+FFI_PLUGIN_EXPORT int GetParentSegmentIndexBatch64(ThreadPool *pool, int n, int k, int count,
+                                                   const int64_t *segmentIndex, int64_t *outParent) {
+    if (segmentIndex == NULL || outParent == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0 || !IsValidParentChildN(n, k)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.n = n, .k = k, .segmentIndex64 = segmentIndex, .out = outParent};
+    return RunBatch(pool, count, ParentBatchRange64, &args);
+}
+
+FFI_PLUGIN_EXPORT int64_t GetChildSegmentIndices64(int n, int k, int64_t segmentIndex, int64_t *outSegmentIndex,
+                                                   int64_t outCapacity) {
+    return GetChildSegmentIndicesBatch64(NULL, n, k, 1, &segmentIndex, outSegmentIndex, outCapacity);
+}
+
+FFI_PLUGIN_EXPORT int64_t GetChildSegmentIndicesBatch64(ThreadPool *pool, int n, int k, int count,
+                                                        const int64_t *segmentIndex, int64_t *outSegmentIndex,
+                                                        int64_t outCapacity) {
+    if (segmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0 || outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    if (outSegmentIndex != NULL && IsValidParentChildN(n, k) && (int64_t) k * k * count <= outCapacity) {
+        BatchArgs args = {.n = n, .k = k, .segmentIndex64 = segmentIndex, .out = outSegmentIndex};
+        const int result = RunBatch(pool, count, ChildrenBatchRange, &args);
+        return result != ErrorCode_None ? result : (int64_t) k * k * count;
+    }
+
+    SegmentIndexWriter writer = {.out64 = outSegmentIndex, .capacity = outCapacity};
+    for (int i = 0; i < count; i++) {
+        const int result = WriteChildSegmentIndices(&writer, n, k, segmentIndex[i]);
+        if (result != ErrorCode_None) {
+            return result;
+        }
+    }
+    return writer.count;
+}
+
+// 여러 해상도를 섞은 세그먼트 집합. 해상도 n_0 < n_1 < ... < n_L은 앞의 것이 뒤의 것을 나누고, 가장 고운 n_L 격자의
+// 세그먼트 집합에서 자식이 모두 든 부모를 아래 해상도부터 차례로 합쳐 칸 수가 가장 적은 조합을 만든다.
+// 부호화: 버전 바이트, varint 해상도 수, varint n_i들, 그리고 해상도마다 varint 칸 수, varint 본문 바이트 수,
+// 블록 색인, 본문. 칸은 오름차순으로 CompactSegmentSetBlockSize개씩 블록을 이루고, 색인은 블록마다 첫 칸과
+// 본문 안에서 그 블록이 시작하는 위치를 8바이트 little endian 두 개로 담는다. 본문에는 블록의 나머지 칸을 앞 칸과의
+// 차 - 1로 varint(LEB128, 낮은 자리부터 7비트씩) 부호화한다. 소속 검사는 색인을 이진 탐색해 블록 하나만 읽는다.
+#define CompactSegmentSetVersion (2)
+#define CompactSegmentSetMaxLevels (32)
+#define CompactSegmentSetBlockSize (128)
+#define CompactSegmentSetIndexEntrySize (16)
+
+typedef struct {
+    uint8_t *out;
+    int64_t capacity;
+    int64_t size;
+} ByteWriter;
+
+static int WriteVarint(ByteWriter *writer, uint64_t v) {
+    do {
+        const uint8_t byte = (uint8_t) (v & 0x7F) | (v >= 0x80 ? 0x80 : 0);
+        if (writer->out != NULL) {
+            if (writer->size >= writer->capacity) {
+                return ErrorCode_BufferTooSmall;
+            }
+            writer->out[writer->size] = byte;
+        }
+        writer->size++;
+        v >>= 7;
+    } while (v != 0);
+    return ErrorCode_None;
+}
+
+static int WriteUint64Le(ByteWriter *writer, uint64_t v) {
+    for (int i = 0; i < 8; i++) {
+        if (writer->out != NULL) {
+            if (writer->size >= writer->capacity) {
+                return ErrorCode_BufferTooSmall;
+            }
+            writer->out[writer->size] = (uint8_t) (v >> (8 * i));
+        }
+        writer->size++;
+    }
+    return ErrorCode_None;
+}
+
+static int64_t CalculateVarintSize(uint64_t v) {
+    int64_t size = 1;
+    while (v >= 0x80) {
+        v >>= 7;
+        size++;
+    }
+    return size;
+}
+
+typedef struct {
+    const uint8_t *data;
+    int64_t size;
+    int64_t pos;
+} ByteReader;
+
+// 잘린 입력이나 64비트를 넘는 값이면 0을 반환한다.
+static int ReadVarint(ByteReader *reader, uint64_t *v) {
+    *v = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (reader->pos >= reader->size) {
+            return 0;
+        }
+        const uint8_t byte = reader->data[reader->pos++];
+        *v |= (uint64_t) (byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// 호스트 바이트 순서와 무관하게 리틀 엔디언 값을 읽는다. 리틀 엔디언 호스트에서는 컴파일러가 한 번의 적재로 합친다.
+static uint16_t ReadUint16Le(const uint8_t *data) {
+    return (uint16_t) (data[0] | data[1] << 8);
+}
+
+static uint32_t ReadUint32Le(const uint8_t *data) {
+    return (uint32_t) data[0] | (uint32_t) data[1] << 8 | (uint32_t) data[2] << 16 | (uint32_t) data[3] << 24;
+}
+
+static uint64_t ReadUint64Le(const uint8_t *data) {
+    return (uint64_t) data[0] | (uint64_t) data[1] << 8 | (uint64_t) data[2] << 16 | (uint64_t) data[3] << 24 |
+           (uint64_t) data[4] << 32 | (uint64_t) data[5] << 40 | (uint64_t) data[6] << 48 | (uint64_t) data[7] << 56;
+}
+
+static int IsValidCompactSegmentSetLevels(const int *levelN, int levelCount) {
+    if (levelCount < 1 || levelCount > CompactSegmentSetMaxLevels) {
+        return 0;
+    }
+    for (int i = 0; i < levelCount; i++) {
+        if (levelN[i] < 1 || levelN[i] > MaxSubdivisionCount64 ||
+            (i > 0 && (levelN[i] <= levelN[i - 1] || levelN[i] % levelN[i - 1] != 0))) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// 부호화된 집합의 머리(버전, 해상도 목록)를 읽는다. 형식이 맞지 않으면 0을 반환한다.
+static int ReadCompactSegmentSetHeader(ByteReader *reader, int *levelN, int *levelCount) {
+    uint64_t v;
+    if (reader->data == NULL || reader->size < 1 || reader->data[0] != CompactSegmentSetVersion) {
+        return 0;
+    }
+    reader->pos = 1;
+    if (!ReadVarint(reader, &v) || v < 1 || v > CompactSegmentSetMaxLevels) {
+        return 0;
+    }
+    *levelCount = (int) v;
+    for (int i = 0; i < *levelCount; i++) {
+        if (!ReadVarint(reader, &v) || v > MaxSubdivisionCount64) {
+            return 0;
+        }
+        levelN[i] = (int) v;
+    }
+    return IsValidCompactSegmentSetLevels(levelN, *levelCount);
+}
+
+// 한 해상도의 칸 목록을 차례로 읽는다.
+typedef struct {
+    ByteReader *reader;
+    int64_t count;
+    int64_t remaining;
+    int64_t previous;
+    int64_t segmentCount;
+    // 블록 색인의 시작
+    int64_t index;
+    // 본문의 시작
+    int64_t body;
+    // 이 해상도 본문의 끝 (다음 해상도의 시작)
+    int64_t end;
+} CompactLevelReader;
+
+static int BeginCompactLevel(CompactLevelReader *level, ByteReader *reader, int n) {
+    uint64_t count, byteCount;
+    level->reader = reader;
+    level->previous = -1;
+    level->segmentCount = CalculateSegmentCountPerGroup64(n) * GroupCount;
+    if (!ReadVarint(reader, &count) || count > (uint64_t) level->segmentCount || !ReadVarint(reader, &byteCount)) {
+        return 0;
+    }
+
+    const int64_t indexSize =
+            ((int64_t) count + CompactSegmentSetBlockSize - 1) / CompactSegmentSetBlockSize *
+            CompactSegmentSetIndexEntrySize;
+    if (indexSize > reader->size - reader->pos || byteCount > (uint64_t) (reader->size - reader->pos - indexSize)) {
+        return 0;
+    }
+    level->count = (int64_t) count;
+    level->remaining = (int64_t) count;
+    level->index = reader->pos;
+    level->body = reader->pos + indexSize;
+    level->end = level->body + (int64_t) byteCount;
+    reader->pos = level->body;
+    return 1;
+}
+
+// 다음 해상도로 넘어간다. 본문을 다 읽었으면 끝이 맞는지도 확인한다.
+static int EndCompactLevel(CompactLevelReader *level) {
+    if (level->remaining == 0 && level->reader->pos != level->end) {
+        return 0;
+    }
+    level->reader->pos = level->end;
+    return 1;
+}
+
+// 칸 하나를 읽는다. 다 읽었거나 형식이 맞지 않으면 0을 반환한다 (*malformed로 구분).
+static int ReadCompactLevelCell(CompactLevelReader *level, int64_t *segmentIndex, int *malformed) {
+    uint64_t delta;
+    *malformed = 0;
+    if (level->remaining == 0) {
+        return 0;
+    }
+
+    // 블록의 첫 칸은 색인에서 읽고, 색인이 가리키는 본문 위치가 지금 읽는 곳과 맞는지 확인한다.
+    const int64_t cellIndex = level->count - level->remaining;
+    if (cellIndex % CompactSegmentSetBlockSize == 0) {
+        const uint8_t *entry = level->reader->data + level->index +
+                               cellIndex / CompactSegmentSetBlockSize * CompactSegmentSetIndexEntrySize;
+        const uint64_t cell = ReadUint64Le(entry);
+        if (cell >= (uint64_t) level->segmentCount || (int64_t) cell <= level->previous ||
+            ReadUint64Le(entry + 8) != (uint64_t) (level->reader->pos - level->body)) {
+            *malformed = 1;
+            return 0;
+        }
+        delta = cell - (uint64_t) (level->previous + 1);
+    } else if (!ReadVarint(level->reader, &delta) || level->reader->pos > level->end ||
+               delta >= (uint64_t) (level->segmentCount - 1 - level->previous)) {
+        *malformed = 1;
+        return 0;
+    }
+    level->remaining--;
+    level->previous += (int64_t) delta + 1;
+    *segmentIndex = level->previous;
+    return 1;
+}
+
+// 한 해상도의 칸 목록(오름차순)을 부호화한다.
+static int WriteCompactLevel(ByteWriter *writer, const int64_t *cells, int64_t count) {
+    int64_t byteCount = 0;
+    for (int64_t i = 0; i < count; i++) {
+        if (i % CompactSegmentSetBlockSize != 0) {
+            byteCount += CalculateVarintSize((uint64_t) (cells[i] - cells[i - 1] - 1));
+        }
+    }
+
+    int result = WriteVarint(writer, (uint64_t) count);
+    if (result == ErrorCode_None) {
+        result = WriteVarint(writer, (uint64_t) byteCount);
+    }
+
+    // 블록 색인: 첫 칸과, 그 블록의 나머지 칸이 본문에서 시작하는 위치
+    int64_t offset = 0;
+    for (int64_t i = 0; i < count && result == ErrorCode_None; i++) {
+        if (i % CompactSegmentSetBlockSize == 0) {
+            result = WriteUint64Le(writer, (uint64_t) cells[i]);
+            if (result == ErrorCode_None) {
+                result = WriteUint64Le(writer, (uint64_t) offset);
+            }
+        } else {
+            offset += CalculateVarintSize((uint64_t) (cells[i] - cells[i - 1] - 1));
+        }
+    }
+
+    for (int64_t i = 0; i < count && result == ErrorCode_None; i++) {
+        if (i % CompactSegmentSetBlockSize != 0) {
+            result = WriteVarint(writer, (uint64_t) (cells[i] - cells[i - 1] - 1));
+        }
+    }
+    return result;
+}
+
+FFI_PLUGIN_EXPORT int64_t CompactSegmentIndices64(const int *levelN, int levelCount, const int64_t *segmentIndex,
+                                                  int64_t count, uint8_t *out, int64_t outCapacity) {
+    if (levelN == NULL || (segmentIndex == NULL && count > 0)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (!IsValidCompactSegmentSetLevels(levelN, levelCount) || count < 0 || outCapacity < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t fineSegmentCount = CalculateSegmentCountPerGroup64(levelN[levelCount - 1]) * GroupCount;
+    for (int64_t i = 0; i < count; i++) {
+        if (segmentIndex[i] < 0 || segmentIndex[i] >= fineSegmentCount ||
+            (i > 0 && segmentIndex[i] <= segmentIndex[i - 1])) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+    }
+
+    // 가장 고운 해상도부터 올라가며, 자식 k^2개가 모두 든 부모를 한 칸으로 합친다.
+    // current는 지금 해상도의 칸, parentOf는 각 칸의 부모, full은 합쳐지는 부모 목록이다. 모두 오름차순이다.
+    const size_t bufferSize = sizeof(int64_t) * (count > 0 ? count : 1);
+    int64_t *cells[CompactSegmentSetMaxLevels] = {NULL};
+    int64_t cellCounts[CompactSegmentSetMaxLevels] = {0};
+    int64_t *current = malloc(bufferSize);
+    int64_t *parentOf = malloc(bufferSize);
+    int result = current == NULL || parentOf == NULL ? ErrorCode_OutOfMemory : ErrorCode_None;
+    int64_t currentCount = count;
+    if (result == ErrorCode_None && count > 0) {
+        memcpy(current, segmentIndex, bufferSize);
+    }
+
+    for (int level = levelCount - 1; level > 0 && result == ErrorCode_None; level--) {
+        const int n = levelN[level - 1];
+        const int k = levelN[level] / n;
+        int64_t *full = malloc(bufferSize);
+        cells[level] = malloc(bufferSize);
+        if (full == NULL || cells[level] == NULL) {
+            free(full);
+            result = ErrorCode_OutOfMemory;
+            break;
+        }
+
+        for (int64_t i = 0; i < currentCount; i++) {
+            parentOf[i] = CalculateParentSegmentIndex(n, k, current[i]);
+            full[i] = parentOf[i];
+        }
+        qsort(full, (size_t) currentCount, sizeof(int64_t), CompareInt64);
+        int64_t fullCount = 0;
+        for (int64_t i = 0; i < currentCount;) {
+            int64_t j = i;
+            while (j < currentCount && full[j] == full[i]) {
+                j++;
+            }
+            if (j - i == (int64_t) k * k) {
+                full[fullCount++] = full[i];
+            }
+            i = j;
+        }
+
+        // 합쳐지지 않은 칸은 이 해상도에 남는다.
+        for (int64_t i = 0; i < currentCount; i++) {
+            if (bsearch(&parentOf[i], full, (size_t) fullCount, sizeof(int64_t), CompareInt64) == NULL) {
+                cells[level][cellCounts[level]++] = current[i];
+            }
+        }
+        free(current);
+        current = full;
+        currentCount = fullCount;
+    }
+    cells[0] = current;
+    cellCounts[0] = currentCount;
+
+    ByteWriter writer = {.out = out, .capacity = outCapacity};
+    if (result == ErrorCode_None) {
+        result = WriteVarint(&writer, CompactSegmentSetVersion);
+    }
+    if (result == ErrorCode_None) {
+        result = WriteVarint(&writer, (uint64_t) levelCount);
+    }
+    for (int level = 0; level < levelCount && result == ErrorCode_None; level++) {
+        result = WriteVarint(&writer, (uint64_t) levelN[level]);
+    }
+    for (int level = 0; level < levelCount && result == ErrorCode_None; level++) {
+        result = WriteCompactLevel(&writer, cells[level], cellCounts[level]);
+    }
+
+    for (int level = 0; level < levelCount; level++) {
+        free(cells[level]);
+    }
+    free(parentOf);
+    return result != ErrorCode_None ? result : writer.size;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetCompactSegmentCells64(const uint8_t *encoded, int64_t encodedSize, int *outN,
+                                                   int64_t *outSegmentIndex, int64_t outCapacity) {
+    if ((outN == NULL) != (outSegmentIndex == NULL)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    int levelN[CompactSegmentSetMaxLevels];
+    int levelCount;
+    ByteReader reader = {.data = encoded, .size = encodedSize};
+    if (outCapacity < 0 || !ReadCompactSegmentSetHeader(&reader, levelN, &levelCount)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    int64_t written = 0;
+    for (int level = 0; level < levelCount; level++) {
+        CompactLevelReader cells;
+        if (!BeginCompactLevel(&cells, &reader, levelN[level])) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+        int64_t cell;
+        int malformed;
+        while (ReadCompactLevelCell(&cells, &cell, &malformed)) {
+            if (outN != NULL) {
+                if (written >= outCapacity) {
+                    return ErrorCode_BufferTooSmall;
+                }
+                outN[written] = levelN[level];
+                outSegmentIndex[written] = cell;
+            }
+            written++;
+        }
+        if (malformed || !EndCompactLevel(&cells)) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+    }
+    return written;
+}
+
+FFI_PLUGIN_EXPORT int64_t UncompactSegmentIndices64(const uint8_t *encoded, int64_t encodedSize,
+                                                    int64_t *outSegmentIndex, int64_t outCapacity) {
+    int levelN[CompactSegmentSetMaxLevels];
+    int levelCount;
+    ByteReader reader = {.data = encoded, .size = encodedSize};
+    if (outCapacity < 0 || !ReadCompactSegmentSetHeader(&reader, levelN, &levelCount)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    // 먼저 칸 수를 세어 전체 개수(칸마다 (n_L / n_i)^2개)를 구하고 형식을 확인한다.
+    const int fineN = levelN[levelCount - 1];
+    const int64_t bodyStart = reader.pos;
+    int64_t total = 0;
+    for (int level = 0; level < levelCount; level++) {
+        CompactLevelReader cells;
+        if (!BeginCompactLevel(&cells, &reader, levelN[level])) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+        const int64_t k = fineN / levelN[level];
+        int64_t cell;
+        int malformed;
+        while (ReadCompactLevelCell(&cells, &cell, &malformed)) {
+            total += k * k;
+        }
+        if (malformed || !EndCompactLevel(&cells)) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+    }
+    if (outSegmentIndex == NULL) {
+        return total;
+    }
+    if (total > outCapacity) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    // 칸마다 자식을 펼친다. 해상도가 섞여 있으면 자식 구간들이 서로 엇갈리므로 마지막에 한 번 정렬한다.
+    SegmentIndexWriter writer = {.out64 = outSegmentIndex, .capacity = outCapacity};
+    reader.pos = bodyStart;
+    for (int level = 0; level < levelCount; level++) {
+        CompactLevelReader cells;
+        BeginCompactLevel(&cells, &reader, levelN[level]);
+        int64_t cell;
+        int malformed;
+        while (ReadCompactLevelCell(&cells, &cell, &malformed)) {
+            WriteChildSegmentIndices(&writer, levelN[level], fineN / levelN[level], cell);
+        }
+        EndCompactLevel(&cells);
+    }
+    if (levelCount > 1) {
+        qsort(outSegmentIndex, (size_t) writer.count, sizeof(int64_t), CompareInt64);
+    }
+    return writer.count;
+}
+
+FFI_PLUGIN_EXPORT int IsSegmentInCompactSet64(const uint8_t *encoded, int64_t encodedSize, int64_t segmentIndex) {
+    int levelN[CompactSegmentSetMaxLevels];
+    int levelCount;
+    ByteReader reader = {.data = encoded, .size = encodedSize};
+    if (!ReadCompactSegmentSetHeader(&reader, levelN, &levelCount)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int fineN = levelN[levelCount - 1];
+    if (segmentIndex < 0 || segmentIndex >= CalculateSegmentCountPerGroup64(fineN) * GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    // 해상도마다 조상 칸이 들 수 있는 블록을 색인에서 이진 탐색하고, 그 블록만 읽는다.
+    for (int level = 0; level < levelCount; level++) {
+        CompactLevelReader cells;
+        if (!BeginCompactLevel(&cells, &reader, levelN[level])) {
+            return ErrorCode_ArgumentOutOfRangeException;
+        }
+        const int64_t ancestor = CalculateParentSegmentIndex(levelN[level], fineN / levelN[level], segmentIndex);
+        const int64_t blockCount = (cells.count + CompactSegmentSetBlockSize - 1) / CompactSegmentSetBlockSize;
+
+        // 첫 칸이 ancestor 이하인 마지막 블록
+        int64_t lo = 0;
+        int64_t hi = blockCount;
+        while (lo < hi) {
+            const int64_t mid = lo + (hi - lo) / 2;
+            if (ReadUint64Le(encoded + cells.index + mid * CompactSegmentSetIndexEntrySize) <= (uint64_t) ancestor) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+
+        if (lo > 0) {
+            const int64_t block = lo - 1;
+            const uint8_t *entry = encoded + cells.index + block * CompactSegmentSetIndexEntrySize;
+            const uint64_t offset = ReadUint64Le(entry + 8);
+            if (offset > (uint64_t) (cells.end - cells.body)) {
+                return ErrorCode_ArgumentOutOfRangeException;
+            }
+            cells.remaining = cells.count - block * CompactSegmentSetBlockSize;
+            cells.previous = block > 0 ? (int64_t) ReadUint64Le(entry - CompactSegmentSetIndexEntrySize) : -1;
+            reader.pos = cells.body + (int64_t) offset;
+
+            int64_t cell;
+            int malformed = 0;
+            for (int i = 0; i < CompactSegmentSetBlockSize && ReadCompactLevelCell(&cells, &cell, &malformed) &&
+                            cell <= ancestor; i++) {
+                if (cell == ancestor) {
+                    return 1;
+                }
+            }
+            if (malformed) {
+                return ErrorCode_ArgumentOutOfRangeException;
+            }
+        }
+        reader.pos = cells.end;
+    }
+    return 0;
+}
+
+// n(분할 횟수)마다 한 번 만들어 두고 재사용하는 컨텍스트를 생성한다.
+// 세그먼트 그룹별 상수 표를 미리 계산하므로, 컨텍스트를 받는 함수들은 n 검증과 반복 계산을 건너뛴다.
+// 중심, 꼭짓점의 위도, 경도는 precision(LatLngPrecision) 방식으로 계산한다.
+// n이나 precision이 유효하지 않거나 메모리가 부족하면 NULL을 반환한다.
+FFI_PLUGIN_EXPORT GeocodingContext *CreateGeocodingContextWithPrecision(int n, int precision) {
+    if (n < 1 || (int64_t) n * n * GroupCount > (int64_t) UINT_MAX + 1) {
+        return NULL;
+    }
+
+    if (precision != LatLngPrecision_Exact && precision != LatLngPrecision_Fast) {
+        return NULL;
+    }
+
+    GeocodingContext *context = NULL;
+#if _WIN32
+    context = _aligned_malloc(sizeof(GeocodingContext), 64);
+#else
+    if (posix_memalign((void **) &context, 64, sizeof(GeocodingContext)) != 0) {
+        context = NULL;
+    }
+#endif
+    if (context == NULL) {
+        return NULL;
+    }
+
+    for (int i = 0; i < GroupCount; i++) {
+        CalculateSegmentGroupConstants(&context->segGroupConstants[i], n, i);
+    }
+    context->n = n;
+    context->segmentCountPerGroup = CalculateSegmentCountPerGroup(n);
+    context->segmentCount = (int64_t) context->segmentCountPerGroup * GroupCount;
+    context->precision = (LatLngPrecision) precision;
+    return context;
+}
+
+FFI_PLUGIN_EXPORT GeocodingContext *CreateGeocodingContext(int n) {
+    return CreateGeocodingContextWithPrecision(n, LatLngPrecision_Exact);
+}
+
+FFI_PLUGIN_EXPORT void DestroyGeocodingContext(GeocodingContext *context) {
+#if _WIN32
+    _aligned_free(context);
+#else
+    free(context);
+#endif
+}
+
+FFI_PLUGIN_EXPORT int
+CalculateSegmentIndexFromLatLngWithContext(const GeocodingContext *context, double userPosLat, double userPosLng) {
+    Vector3 userPosFromLatLng = ScalarMultiplyVector(2, CalculateUnitSpherePosition(userPosLat, userPosLng));
+
+    Vector3 intersect = {0, 0, 0};
+    const int segGroupIndex = FindSegmentGroup(GetIcosahedronGeometry(context->n), &intersect, userPosFromLatLng);
+
+    if (segGroupIndex < 0 || segGroupIndex >= 20) {
+        return ErrorCode_LogicError_NoIntersection;
+    }
+
+    AbtCoords abtCoords = CalculateAbCoords(context->n, &context->segGroupConstants[segGroupIndex], intersect);
+
+    return ConvertToSegmentIndex(segGroupIndex, context->n, abtCoords.a, abtCoords.b, abtCoords.t);
+}
+
+static int GeocodeBatchRangeWithContext(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    int *out = args->out;
+    for (int64_t i = begin; i < end; i++) {
+        out[i] = CalculateSegmentIndexFromLatLngWithContext(args->context, args->lat[i], args->lng[i]);
+    }
+    return ErrorCode_None;
+}
+
+FFI_PLUGIN_EXPORT int
+CalculateSegmentIndexFromLatLngBatchWithContext(const GeocodingContext *context, ThreadPool *pool, int count,
+                                                const double *lat, const double *lng, int *outSegmentIndex) {
+    if (context == NULL || lat == NULL || lng == NULL || outSegmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.context = context, .lat = lat, .lng = lng, .out = outSegmentIndex};
+    return RunBatch(pool, count, GeocodeBatchRangeWithContext, &args);
+}
+
+FFI_PLUGIN_EXPORT int
+ConvertToSegmentIndex2WithContext(const GeocodingContext *context, int segmentGroupIndex, int localSegmentIndex) {
+    if (segmentGroupIndex < 0 || segmentGroupIndex >= GroupCount) {
+        return -1;
+    }
+
+    if (localSegmentIndex < 0 || localSegmentIndex >= context->segmentCountPerGroup) {
+        return -1;
+    }
+
+    return (int) ((int64_t) context->segmentCountPerGroup * segmentGroupIndex + localSegmentIndex);
+}
+
+FFI_PLUGIN_EXPORT SegGroupAndLocalSegIndex
+SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext(const GeocodingContext *context, int segmentIndex) {
+    const uint32_t unsignedSegmentIndex = (uint32_t) segmentIndex;
+    if (unsignedSegmentIndex >= context->segmentCount) {
+        return (SegGroupAndLocalSegIndex) {.segGroup = -1, .localSegIndex = -1};
+    }
+
+    const uint32_t segmentCountPerGroup = (uint32_t) context->segmentCountPerGroup;
+    return (SegGroupAndLocalSegIndex) {
+            .segGroup = (int) (unsignedSegmentIndex / segmentCountPerGroup),
+            .localSegIndex = (int) (unsignedSegmentIndex % segmentCountPerGroup),
+    };
+}
+
+static SegGroupAndAbt SplitSegIndexToSegGroupAndAbtWithContext(const GeocodingContext *context, int segmentIndex) {
+    const SegGroupAndLocalSegIndex segGroupAndLocalSegIndex =
+            SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext(context, segmentIndex);
+    if (segGroupAndLocalSegIndex.segGroup < 0) {
+        return (SegGroupAndAbt) {.segGroup = -1, .abt = {INT32_MIN, INT32_MIN, Parallelogram_Error}};
+    }
+
+    const AbtCoords abt = SplitLocalSegmentIndexToAbt(context->n, segGroupAndLocalSegIndex.localSegIndex);
+    return (SegGroupAndAbt) {.segGroup = segGroupAndLocalSegIndex.segGroup, .abt = abt};
+}
+
+FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenterWithContext(const GeocodingContext *context, int segmentIndex) {
+    const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbtWithContext(context, segmentIndex);
+    if (segGroupAndAbt.segGroup < 0) {
+        return (Vector3) {0, 0, 0};
+    }
+
+    return CalculateSegmentCenterFromAbt(&context->segGroupConstants[segGroupAndAbt.segGroup], segGroupAndAbt.abt);
+}
+
+FFI_PLUGIN_EXPORT GpsCoords
+CalculateSegmentCenterLatLngWithContext(const GeocodingContext *context, int segmentIndex) {
+    return CalculateLatLngWithPrecision(CalculateSegmentCenterWithContext(context, segmentIndex), context->precision);
+}
+
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLatWithContext(const GeocodingContext *context, int segmentIndex) {
+    return CalculateSegmentCenterLatLngWithContext(context, segmentIndex).lat;
+}
+
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLngWithContext(const GeocodingContext *context, int segmentIndex) {
+    return CalculateSegmentCenterLatLngWithContext(context, segmentIndex).lng;
+}
+
+static int CenterBatchRangeWithContext(void *arg, int64_t begin, int64_t end) {
+    const BatchArgs *args = arg;
+    for (int64_t i = begin; i < end; i++) {
+        WriteSegmentCenter(CalculateSegmentCenterWithContext(args->context, args->segmentIndex[i]), (int) i,
+                           args->context->precision, args->out, args->out2);
+    }
+    return ErrorCode_None;
+}
+
+FFI_PLUGIN_EXPORT int
+CalculateSegmentCenterBatchWithContext(const GeocodingContext *context, ThreadPool *pool, int count,
+                                       const int *segmentIndex, GpsCoords *outLatLng, Vector3 *outCenter) {
+    if (context == NULL || segmentIndex == NULL || (outLatLng == NULL && outCenter == NULL)) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (count < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    BatchArgs args = {.context = context, .segmentIndex = segmentIndex, .out = outLatLng, .out2 = outCenter};
+    return RunBatch(pool, count, CenterBatchRangeWithContext, &args);
+}
+
+FFI_PLUGIN_EXPORT SegmentCornersInLatLng
+CalculateSegmentCornersInLatLngWithContext(const GeocodingContext *context, int segmentIndex) {
+    SegmentCornersInLatLng ret = {0};
+    const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbtWithContext(context, segmentIndex);
+    if (segGroupAndAbt.segGroup < 0) {
+        return ret;
+    }
+
+    Vector3 points[3];
+    CalculateSegmentCornersFromAbt(points, &context->segGroupConstants[segGroupAndAbt.segGroup], segGroupAndAbt.abt);
+    for (int i = 0; i < 3; i++) {
+        ret.points[i] = CalculateLatLngWithPrecision(points[i], context->precision);
+    }
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT NeighborSegIdList
+GetNeighborsOfSegmentIndexWithContext(const GeocodingContext *context, int segmentIndex) {
+    const SegGroupAndLocalSegIndex segGroupAndLocalSegIndex =
+            SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext(context, segmentIndex);
+    if (segGroupAndLocalSegIndex.segGroup < 0) {
+        return (NeighborSegIdList) {.count = 0};
+    }
+
+    return GetNeighborsOfSegGroupAndLocalSegIndex(context->n, segGroupAndLocalSegIndex.segGroup,
+                                                  segGroupAndLocalSegIndex.localSegIndex);
+}
+
+// 인접 표 파일 형식 (리틀 엔디언)
+//   0: uint32 magic ('SUGA')
+//   4: uint32 version
+//   8: uint32 n
+//  12: uint32 slot width (바이트, 2 / 4 / 8)
+//  16: uint64 segment count (20 * n^2)
+//  24: 예약 (0)
+//  32: 세그먼트마다 12칸씩, 이웃 세그먼트 인덱스. 빈 칸은 모든 비트가 1이다.
+#define AdjacencyTableMagic (0x41475553u)
+#define AdjacencyTableVersion (1)
+#define AdjacencyTableHeaderSize (32)
+#define AdjacencyTableSlotCount (12)
+// 한 번에 파일로 쓰는 세그먼트 수
+#define AdjacencyTableWriteChunk (4096)
+
+struct AdjacencyTable {
+    const uint8_t *slots;
+    int64_t segmentCount;
+    int n;
+    int slotWidth;
+    // 매핑 전체 (헤더 포함)
+    void *mapping;
+    size_t mappingSize;
+#if _WIN32
+    HANDLE file;
+    HANDLE fileMapping;
+#endif
+};
+
+// 빈 칸 표시(모든 비트 1)를 제외하고 모든 세그먼트 인덱스가 들어가는 가장 좁은 칸 너비를 고른다.
+static int CalculateAdjacencyTableSlotWidth(int64_t segmentCount) {
+    if (segmentCount <= UINT16_MAX) {
+        return 2;
+    }
+    if (segmentCount <= UINT32_MAX) {
+        return 4;
+    }
+    return 8;
+}
+
+static void WriteAdjacencyTableSlot(uint8_t *dst, int slotWidth, uint64_t value) {
+    for (int i = 0; i < slotWidth; i++) {
+        dst[i] = (uint8_t) (value >> (8 * i));
+    }
+}
+
+// n에 대한 전체 인접 표를 만들어 path에 쓴다. 세그먼트마다 12칸을 고정으로 쓰므로,
+// 세그먼트 s의 이웃은 파일의 32 + s * 12 * (칸 너비) 위치에서 시작한다.
+FFI_PLUGIN_EXPORT int WriteAdjacencyTableFile(int n, const char *path) {
+    if (path == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+
+    if (n < 1 || n > MaxSubdivisionCount64) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    const int64_t segmentCount = segmentCountPerGroup * GroupCount;
+    const int slotWidth = CalculateAdjacencyTableSlotWidth(segmentCount);
+    const size_t chunkSize = (size_t) AdjacencyTableWriteChunk * AdjacencyTableSlotCount * slotWidth;
+
+    uint8_t *chunk = malloc(chunkSize);
+    if (chunk == NULL) {
+        return ErrorCode_OutOfMemory;
+    }
+
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        free(chunk);
+        return ErrorCode_IoError;
+    }
+
+    uint8_t header[AdjacencyTableHeaderSize] = {0};
+    WriteAdjacencyTableSlot(header + 0, 4, AdjacencyTableMagic);
+    WriteAdjacencyTableSlot(header + 4, 4, AdjacencyTableVersion);
+    WriteAdjacencyTableSlot(header + 8, 4, (uint64_t) n);
+    WriteAdjacencyTableSlot(header + 12, 4, (uint64_t) slotWidth);
+    WriteAdjacencyTableSlot(header + 16, 8, (uint64_t) segmentCount);
+    int ok = fwrite(header, sizeof(header), 1, file) == 1;
+
+    const uint64_t emptySlot = slotWidth == 8 ? UINT64_MAX : (1ULL << (8 * slotWidth)) - 1;
+    size_t used = 0;
+    for (int segGroup = 0; ok && segGroup < GroupCount; segGroup++) {
+        for (int64_t local = 0; ok && local < segmentCountPerGroup; local++) {
+            const NeighborSegIdList64 neighbors = GetNeighborsOfSegGroupAndLocalSegIndex64(n, segGroup, local);
+            uint8_t *dst = chunk + used;
+            for (int i = 0; i < AdjacencyTableSlotCount; i++) {
+                const int64_t neighbor = i < neighbors.count ? neighbors.neighborSegId[i] : -1;
+                WriteAdjacencyTableSlot(dst + i * slotWidth, slotWidth,
+                                        neighbor >= 0 ? (uint64_t) neighbor : emptySlot);
+            }
+            used += (size_t) AdjacencyTableSlotCount * slotWidth;
+
+            if (used == chunkSize) {
+                ok = fwrite(chunk, 1, used, file) == used;
+                used = 0;
+            }
+        }
+    }
+    if (ok && used > 0) {
+        ok = fwrite(chunk, 1, used, file) == used;
+    }
+
+    free(chunk);
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    return ok ? ErrorCode_None : ErrorCode_IoError;
+}
+
+// WriteAdjacencyTableFile()로 만든 파일을 읽기 전용으로 메모리에 매핑한다.
+// 파일을 읽어 들이지 않으므로 바로 열리고, 같은 파일을 연 여러 프로세스가 페이지 캐시를 공유한다.
+// 파일이 없거나 형식이 맞지 않으면 NULL을 반환한다.
+FFI_PLUGIN_EXPORT AdjacencyTable *OpenAdjacencyTable(const char *path) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    AdjacencyTable *table = calloc(1, sizeof(AdjacencyTable));
+    if (table == NULL) {
+        return NULL;
+    }
+
+#if _WIN32
+    table->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    LARGE_INTEGER fileSize;
+    if (table->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(table->file, &fileSize) ||
+        fileSize.QuadPart < AdjacencyTableHeaderSize) {
+        if (table->file != INVALID_HANDLE_VALUE) {
+            CloseHandle(table->file);
+        }
+        free(table);
+        return NULL;
+    }
+    table->mappingSize = (size_t) fileSize.QuadPart;
+    table->fileMapping = CreateFileMappingA(table->file, NULL, PAGE_READONLY, 0, 0, NULL);
+    table->mapping = table->fileMapping == NULL ? NULL : MapViewOfFile(table->fileMapping, FILE_MAP_READ, 0, 0, 0);
+    if (table->mapping == NULL) {
+        if (table->fileMapping != NULL) {
+            CloseHandle(table->fileMapping);
+        }
+        CloseHandle(table->file);
+        free(table);
+        return NULL;
+    }
+#else
+    const int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0 || st.st_size < AdjacencyTableHeaderSize) {
+        if (fd >= 0) {
+            close(fd);
+        }
+        free(table);
+        return NULL;
+    }
+    table->mappingSize = (size_t) st.st_size;
+    table->mapping = mmap(NULL, table->mappingSize, PROT_READ, MAP_SHARED, fd, 0);
+    // 매핑은 파일 디스크립터를 닫아도 유지된다.
+    close(fd);
+    if (table->mapping == MAP_FAILED) {
+        free(table);
+        return NULL;
+    }
+#endif
+
+    // 파일은 호스트와 무관하게 리틀 엔디언이다.
+    const uint8_t *header = table->mapping;
+    const int64_t n = ReadUint32Le(header + 8);
+    const uint64_t slotWidth = ReadUint32Le(header + 12);
+    const uint64_t segmentCount = ReadUint64Le(header + 16);
+    const int valid = ReadUint32Le(header + 0) == AdjacencyTableMagic &&
+                      ReadUint32Le(header + 4) == AdjacencyTableVersion &&
+                      n >= 1 && n <= MaxSubdivisionCount64 && segmentCount == (uint64_t) (n * n * GroupCount) &&
+                      slotWidth == (uint64_t) CalculateAdjacencyTableSlotWidth(n * n * GroupCount) &&
+                      (table->mappingSize - AdjacencyTableHeaderSize) / AdjacencyTableSlotCount / slotWidth >=
+                      segmentCount;
+    if (!valid) {
+        CloseAdjacencyTable(table);
+        return NULL;
+    }
+
+    table->slots = header + AdjacencyTableHeaderSize;
+    table->segmentCount = (int64_t) segmentCount;
+    table->n = (int) n;
+    table->slotWidth = (int) slotWidth;
+    return table;
+}
+
+FFI_PLUGIN_EXPORT void CloseAdjacencyTable(AdjacencyTable *table) {
+    if (table == NULL) {
+        return;
+    }
+
+#if _WIN32
+    UnmapViewOfFile(table->mapping);
+    CloseHandle(table->fileMapping);
+    CloseHandle(table->file);
+#else
+    munmap(table->mapping, table->mappingSize);
+#endif
+    free(table);
+}
+
+FFI_PLUGIN_EXPORT int GetAdjacencyTableN(const AdjacencyTable *table) {
+    return table == NULL ? ErrorCode_Argument_NullPtr : table->n;
+}
+
+FFI_PLUGIN_EXPORT int GetAdjacencyTableSlotWidth(const AdjacencyTable *table) {
+    return table == NULL ? ErrorCode_Argument_NullPtr : table->slotWidth;
+}
+
+// 매핑된 이웃 칸 배열의 시작 주소. 세그먼트 s의 이웃은 s * 12번째 칸부터 12칸이다.
+FFI_PLUGIN_EXPORT const void *GetAdjacencyTableSlots(const AdjacencyTable *table) {
+    return table == NULL ? NULL : table->slots;
+}
+
+FFI_PLUGIN_EXPORT NeighborSegIdList64 GetNeighborsFromAdjacencyTable64(const AdjacencyTable *table,
+                                                                       int64_t segmentIndex) {
+    NeighborSegIdList64 ret = {.count = 0};
+    if (table == NULL || segmentIndex < 0 || segmentIndex >= table->segmentCount) {
+        return ret;
+    }
+
+    // 칸 너비마다 한 번의 인덱스 접근으로 12칸을 읽는다. 빈 칸은 항상 뒤쪽에 모여 있다.
+    // 칸은 리틀 엔디언으로 저장되어 있으므로 호스트 바이트 순서와 무관하게 읽는다.
+    const uint8_t *slots = table->slots + segmentIndex * AdjacencyTableSlotCount * table->slotWidth;
+    switch (table->slotWidth) {
+        case 2:
+            for (int i = 0; i < AdjacencyTableSlotCount; i++) {
+                const uint64_t slot = ReadUint16Le(slots + 2 * i);
+                if (slot == UINT16_MAX) {
+                    break;
+                }
+                ret.neighborSegId[ret.count++] = (int64_t) slot;
+            }
+            break;
+        case 4:
+            for (int i = 0; i < AdjacencyTableSlotCount; i++) {
+                const uint64_t slot = ReadUint32Le(slots + 4 * i);
+                if (slot == UINT32_MAX) {
+                    break;
+                }
+                ret.neighborSegId[ret.count++] = (int64_t) slot;
+            }
+            break;
+        default:
+            for (int i = 0; i < AdjacencyTableSlotCount; i++) {
+                const uint64_t slot = ReadUint64Le(slots + 8 * i);
+                if (slot == UINT64_MAX) {
+                    break;
+                }
+                ret.neighborSegId[ret.count++] = (int64_t) slot;
+            }
+            break;
+    }
+    return ret;
+}
+
+FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsFromAdjacencyTable(const AdjacencyTable *table, int segmentIndex) {
+    NeighborSegIdList ret = {.count = 0};
+    if (table == NULL || table->slotWidth == 8) {
+        return ret;
+    }
+
+    const NeighborSegIdList64 neighbors = GetNeighborsFromAdjacencyTable64(table, (uint32_t) segmentIndex);
+    ret.count = neighbors.count;
+    for (int i = 0; i < neighbors.count; i++) {
+        ret.neighborSegId[i] = (int) neighbors.neighborSegId[i];
+    }
+    return ret;
+}
+
+// 면마다 local 범위를 2^AggregationPartitionBits개의 연속한 조각으로 나누어 조각마다 따로 모은다.
+// 합치기와 이어 붙이기는 (면, 조각) 단위로 여러 스레드가 나누어 맡으므로, 지점이 한 면에 몰려도 병렬로 진행된다.
+#define AggregationPartitionBits (4)
+#define AggregationPartitionCount (1 << AggregationPartitionBits)
+#define AggregationMaxPartitionCount (GroupCount * AggregationPartitionCount)
+// 면 하나의 조밀한 히스토그램이 이 크기(바이트) 이하이면 세그먼트마다 칸을 두고, 넘으면 해시 표를 쓴다.
+// 조각은 처음 쓸 때 만들므로 스레드 하나의 조밀 히스토그램은 많아야 이 크기의 면 수 배이다.
+#define AggregationDenseFaceMaxBytes (64 << 10)
+#define AggregationHashInitialCapacity (64)
+#define AggregationRadixBits (11)
+
+// 히스토그램 칸은 [키, 지점 수, 가중치 합계 weightCount개] 단어가 이어진 것이다.
+// 지점 하나를 더할 때 캐시 줄 하나만 건드리도록 한 칸에 모아 둔다.
+typedef union {
+    int64_t i;
+    double d;
+} HistogramWord;
+
+// 스레드 하나가 (면, 조각) 하나에 대해 모으는 부분 히스토그램. 키는 면 안의 local이다.
+// 조밀: 조각 안의 (local - 조각 시작)번째 칸 (처음 쓸 때 만들며 키 단어는 쓰지 않는다)
+// 해시: 키가 -1이면 빈 칸. 선형 탐사를 하며 용량은 2의 거듭제곱이다.
+typedef struct {
+    HistogramWord *words;
+    int64_t capacity;
+    int64_t size;
+    int shift;
+} HistogramPartition;
+
+typedef struct {
+    HistogramPartition partitions[AggregationMaxPartitionCount];
+    AggregationThreadStats stats;
+    int error;
+} AggregationWorker;
+
+// (면, 조각) 하나를 합친 결과. 전역 세그먼트 인덱스 오름차순이며 sums는 세그먼트마다 weightCount개씩 이어져 있다.
+// offset은 최종 결과에서 이 조각이 시작하는 위치이다.
+typedef struct {
+    int64_t count;
+    int64_t offset;
+    int64_t *segmentIndex;
+    int64_t *counts;
+    double *sums;
+    int error;
+} MergedPartition;
+
+typedef struct {
+    int n;
+    int dense;
+    int weightCount;
+    // 칸 하나의 단어 수 (2 + weightCount)
+    int stride;
+    int threadCount;
+    // 합치기와 이어 붙이기를 맡는 스레드 수
+    int mergeThreadCount;
+    // local >> partitionShift가 면 안의 조각 번호이다.
+    int partitionShift;
+    int64_t segmentCountPerGroup;
+    int64_t count;
+    const double *lat;
+    const double *lng;
+    const double *const *weights;
+    const SegmentGroupConstants *segGroupConstants;
+    AggregationWorker *workers;
+    MergedPartition merged[AggregationMaxPartitionCount];
+    SegmentAggregation *aggregation;
+} AggregationJob;
+
+struct SegmentAggregation {
+    int n;
+    int weightCount;
+    int threadCount;
+    int64_t segmentCount;
+    int64_t *segmentIndex;
+    int64_t *counts;
+    // 가중치 열마다 segmentCount개씩 이어져 있다.
+    double *sums;
+    AggregationThreadStats *threadStats;
+    double mergeSeconds;
+};
+
+static void FreeHistogramPartition(HistogramPartition *part) {
+    free(part->words);
+    *part = (HistogramPartition) {0};
+}
+
+static int AllocateHistogramPartition(HistogramPartition *part, int64_t capacity, int stride, int hashed) {
+    part->words = calloc((size_t) (capacity * stride), sizeof(HistogramWord));
+    if (part->words == NULL) {
+        return 0;
+    }
+
+    if (hashed) {
+        for (int64_t i = 0; i < capacity; i++) {
+            part->words[i * stride].i = -1;
+        }
+        part->shift = 64;
+        for (int64_t c = capacity; c > 1; c >>= 1) {
+            part->shift--;
+        }
+    }
+    part->capacity = capacity;
+    part->size = 0;
+    return 1;
+}
+
+static int64_t FindHashedSlot(const HistogramPartition *part, int64_t key, int stride) {
+    const int64_t mask = part->capacity - 1;
+    int64_t slot = (int64_t) (((uint64_t) key * 0x9E3779B97F4A7C15ULL) >> part->shift);
+    while (part->words[slot * stride].i != key && part->words[slot * stride].i != -1) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+// key의 칸을 찾고, 없으면 새로 만든다. 채움률이 1/2을 넘으면 두 배로 키운다. 메모리가 부족하면 NULL을 반환한다.
+static HistogramWord *InsertHashedSlot(HistogramPartition *part, int64_t key, int stride) {
+    if ((part->size + 1) * 2 > part->capacity) {
+        HistogramPartition grown;
+        const int64_t capacity = part->capacity > 0 ? part->capacity * 2 : AggregationHashInitialCapacity;
+        if (!AllocateHistogramPartition(&grown, capacity, stride, 1)) {
+            return NULL;
+        }
+        for (int64_t i = 0; i < part->capacity; i++) {
+            if (part->words[i * stride].i != -1) {
+                const int64_t slot = FindHashedSlot(&grown, part->words[i * stride].i, stride);
+                memcpy(grown.words + slot * stride, part->words + i * stride, sizeof(HistogramWord) * stride);
+            }
+        }
+        grown.size = part->size;
+        FreeHistogramPartition(part);
+        *part = grown;
+    }
+
+    HistogramWord *words = part->words + FindHashedSlot(part, key, stride) * stride;
+    if (words[0].i == -1) {
+        words[0].i = key;
+        part->size++;
+    }
+    return words;
+}
+
+// 면 안의 조각 번호 partition이 맡는 local 범위의 시작과 길이. 조각이 면을 벗어나면 길이는 0이다.
+static int64_t CalculatePartitionLocalCount(const AggregationJob *job, int partition, int64_t *outBegin) {
+    const int64_t begin = (int64_t) partition << job->partitionShift;
+    const int64_t end = begin + ((int64_t) 1 << job->partitionShift);
+    *outBegin = begin;
+    if (begin >= job->segmentCountPerGroup) {
+        return 0;
+    }
+    return (end < job->segmentCountPerGroup ? end : job->segmentCountPerGroup) - begin;
+}
+
+// 한 번에 지오코딩하는 지점 수. 해시 표에 더하기 전에 칸을 미리 캐시로 불러 두어, 서로 다른 칸이 많은 큰 n에서
+// 메모리 대기를 겹친다.
+#define AggregationBlockSize (64)
+#define AggregationPrefetchDistance (8)
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PREFETCH_FOR_WRITE(p) __builtin_prefetch((p), 1)
+#else
+#define PREFETCH_FOR_WRITE(p) ((void) (p))
+#endif
+
+// 스레드마다 연속한 지점 구간 하나를 맡아 지오코딩하고 자기 부분 히스토그램에 더한다.
+static void AccumulatePoints(void *arg, int threadIndex) {
+    AggregationJob *job = arg;
+    AggregationWorker *worker = &job->workers[threadIndex];
+    const int64_t share = job->count / job->threadCount;
+    const int64_t extra = job->count % job->threadCount;
+    const int64_t begin = share * threadIndex + (threadIndex < extra ? threadIndex : extra);
+    const int64_t end = begin + share + (threadIndex < extra);
+    const int stride = job->stride;
+    const int64_t partitionMask = ((int64_t) 1 << job->partitionShift) - 1;
+
+    const IcosahedronGeometry *geometry = GetIcosahedronGeometry(job->n);
+    const double t0 = GetMonotonicSeconds();
+    int64_t skipped = 0;
+    int partitions[AggregationBlockSize];
+    int64_t locals[AggregationBlockSize];
+    for (int64_t blockBegin = begin; blockBegin < end && worker->error == ErrorCode_None;
+         blockBegin += AggregationBlockSize) {
+        const int blockCount = (int) (end - blockBegin < AggregationBlockSize ? end - blockBegin : AggregationBlockSize);
+        for (int j = 0; j < blockCount; j++) {
+            Vector3 intersect = {0, 0, 0};
+            const int64_t i = blockBegin + j;
+            const int segGroup = FindSegmentGroup(
+                    geometry, &intersect,
+                    ScalarMultiplyVector(2, CalculateUnitSpherePosition(job->lat[i], job->lng[i])));
+            partitions[j] = -1;
+            if (segGroup < 0 || segGroup >= GroupCount) {
+                continue;
+            }
+
+            const int64_t local = ConvertToLocalSegmentIndex2(
+                    job->n, CalculateAbCoords(job->n, &job->segGroupConstants[segGroup], intersect));
+            if (local >= 0 && local < job->segmentCountPerGroup) {
+                partitions[j] = segGroup * AggregationPartitionCount + (int) (local >> job->partitionShift);
+                locals[j] = local;
+            }
+        }
+
+        for (int j = 0; j < blockCount; j++) {
+            const int ahead = j + AggregationPrefetchDistance;
+            if (!job->dense && ahead < blockCount && partitions[ahead] >= 0) {
+                const HistogramPartition *part = &worker->partitions[partitions[ahead]];
+                if (part->capacity > 0) {
+                    PREFETCH_FOR_WRITE(part->words +
+                                       (int64_t) (((uint64_t) locals[ahead] * 0x9E3779B97F4A7C15ULL) >> part->shift) *
+                                               stride);
+                }
+            }
+            if (partitions[j] < 0) {
+                skipped++;
+                continue;
+            }
+
+            HistogramPartition *part = &worker->partitions[partitions[j]];
+            HistogramWord *words;
+            if (job->dense) {
+                int64_t partitionBegin;
+                if (part->words == NULL &&
+                    !AllocateHistogramPartition(
+                            part,
+                            CalculatePartitionLocalCount(job, partitions[j] % AggregationPartitionCount,
+                                                         &partitionBegin),
+                            stride, 0)) {
+                    worker->error = ErrorCode_OutOfMemory;
+                    break;
+                }
+                words = part->words + (locals[j] & partitionMask) * stride;
+            } else {
+                words = InsertHashedSlot(part, locals[j], stride);
+                if (words == NULL) {
+                    worker->error = ErrorCode_OutOfMemory;
+                    break;
+                }
+            }
+
+            words[1].i++;
+            for (int c = 0; c < job->weightCount; c++) {
+                words[2 + c].d += job->weights[c][blockBegin + j];
+            }
+        }
+    }
+
+    worker->stats.pointCount = end - begin;
+    worker->stats.skippedCount = skipped;
+    worker->stats.seconds = GetMonotonicSeconds() - t0;
+}
+
+typedef struct {
+    int64_t key;
+    const HistogramWord *words;
+} HashedEntry;
+
+// 키가 keyLimit 미만인 항목들을 키 순으로 정렬하고 정렬된 쪽 버퍼를 반환한다 (LSD 기수 정렬).
+// 안정 정렬이므로 키가 같은 항목은 넣은 순서를 지킨다. temp는 같은 크기의 작업 공간이다.
+static HashedEntry *SortHashedEntries(HashedEntry *entries, HashedEntry *temp, int64_t count, int64_t keyLimit) {
+    int64_t histogram[1 << AggregationRadixBits];
+    for (int shift = 0; shift < 64 && (keyLimit - 1) >> shift != 0; shift += AggregationRadixBits) {
+        memset(histogram, 0, sizeof(histogram));
+        for (int64_t i = 0; i < count; i++) {
+            histogram[(entries[i].key >> shift) & ((1 << AggregationRadixBits) - 1)]++;
+        }
+        int64_t offset = 0;
+        for (int d = 0; d < 1 << AggregationRadixBits; d++) {
+            const int64_t bucket = histogram[d];
+            histogram[d] = offset;
+            offset += bucket;
+        }
+        for (int64_t i = 0; i < count; i++) {
+            temp[histogram[(entries[i].key >> shift) & ((1 << AggregationRadixBits) - 1)]++] = entries[i];
+        }
+        HashedEntry *swap = entries;
+        entries = temp;
+        temp = swap;
+    }
+    return entries;
+}
+
+static int AllocateMergedPartition(MergedPartition *merged, int64_t count, int weightCount) {
+    merged->segmentIndex = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    merged->counts = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    merged->sums = malloc(sizeof(double) * (count * weightCount > 0 ? count * weightCount : 1));
+    if (merged->segmentIndex == NULL || merged->counts == NULL || merged->sums == NULL) {
+        merged->error = ErrorCode_OutOfMemory;
+        return 0;
+    }
+    merged->count = count;
+    return 1;
+}
+
+// 조밀한 조각: 모든 스레드의 칸을 스레드 순서대로 첫 히스토그램에 더한 뒤 칸 순서대로 꺼낸다.
+static void MergeDensePartition(AggregationJob *job, int task, int64_t segmentBegin) {
+    const int weightCount = job->weightCount;
+    const int stride = job->stride;
+    MergedPartition *merged = &job->merged[task];
+    HistogramPartition *base = NULL;
+    for (int t = 0; t < job->threadCount; t++) {
+        HistogramPartition *part = &job->workers[t].partitions[task];
+        if (part->words == NULL) {
+            continue;
+        }
+        if (base == NULL) {
+            base = part;
+            continue;
+        }
+
+        for (int64_t i = 0; i < part->capacity; i++) {
+            const HistogramWord *words = part->words + i * stride;
+            if (words[1].i == 0) {
+                continue;
+            }
+            HistogramWord *target = base->words + i * stride;
+            target[1].i += words[1].i;
+            for (int c = 0; c < weightCount; c++) {
+                target[2 + c].d += words[2 + c].d;
+            }
+        }
+        FreeHistogramPartition(part);
+    }
+    if (base == NULL) {
+        return;
+    }
+
+    int64_t count = 0;
+    for (int64_t i = 0; i < base->capacity; i++) {
+        count += base->words[i * stride + 1].i != 0;
+    }
+    if (!AllocateMergedPartition(merged, count, weightCount)) {
+        return;
+    }
+
+    int64_t written = 0;
+    for (int64_t i = 0; written < count; i++) {
+        const HistogramWord *words = base->words + i * stride;
+        if (words[1].i == 0) {
+            continue;
+        }
+        merged->segmentIndex[written] = segmentBegin + i;
+        merged->counts[written] = words[1].i;
+        for (int c = 0; c < weightCount; c++) {
+            merged->sums[written * weightCount + c] = words[2 + c].d;
+        }
+        written++;
+    }
+    FreeHistogramPartition(base);
+}
+
+// 해시 조각: 모든 스레드의 쓰인 칸을 스레드 순서대로 모아 키로 안정 정렬한 뒤, 키가 같은 칸끼리 차례로 더한다.
+// 해시 표끼리 다시 넣지 않으므로 임의 접근 없이 순차로 진행된다.
+static void MergeHashedPartition(AggregationJob *job, int task, int64_t segmentBegin, int64_t localBegin,
+                                 int64_t localCount) {
+    const int weightCount = job->weightCount;
+    const int stride = job->stride;
+    MergedPartition *merged = &job->merged[task];
+    int64_t total = 0;
+    for (int t = 0; t < job->threadCount; t++) {
+        total += job->workers[t].partitions[task].size;
+    }
+    if (total == 0) {
+        return;
+    }
+
+    HashedEntry *entries = malloc(sizeof(HashedEntry) * total);
+    HashedEntry *temp = malloc(sizeof(HashedEntry) * total);
+    if (entries == NULL || temp == NULL) {
+        merged->error = ErrorCode_OutOfMemory;
+        free(entries);
+        free(temp);
+        return;
+    }
+    int64_t entryCount = 0;
+    for (int t = 0; t < job->threadCount; t++) {
+        const HistogramPartition *part = &job->workers[t].partitions[task];
+        for (int64_t i = 0; i < part->capacity; i++) {
+            const HistogramWord *words = part->words + i * stride;
+            if (words[0].i != -1) {
+                entries[entryCount++] = (HashedEntry) {.key = words[0].i - localBegin, .words = words};
+            }
+        }
+    }
+    const HashedEntry *sorted = SortHashedEntries(entries, temp, entryCount, localCount);
+
+    int64_t count = 0;
+    for (int64_t i = 0; i < entryCount; i++) {
+        count += i == 0 || sorted[i].key != sorted[i - 1].key;
+    }
+    if (AllocateMergedPartition(merged, count, weightCount)) {
+        int64_t written = -1;
+        for (int64_t i = 0; i < entryCount; i++) {
+            const HistogramWord *words = sorted[i].words;
+            if (i == 0 || sorted[i].key != sorted[i - 1].key) {
+                written++;
+                merged->segmentIndex[written] = segmentBegin + sorted[i].key;
+                merged->counts[written] = words[1].i;
+                for (int c = 0; c < weightCount; c++) {
+                    merged->sums[written * weightCount + c] = words[2 + c].d;
+                }
+                continue;
+            }
+            merged->counts[written] += words[1].i;
+            for (int c = 0; c < weightCount; c++) {
+                merged->sums[written * weightCount + c] += words[2 + c].d;
+            }
+        }
+    }
+
+    free(entries);
+    free(temp);
+    for (int t = 0; t < job->threadCount; t++) {
+        FreeHistogramPartition(&job->workers[t].partitions[task]);
+    }
+}
+
+// (면, 조각)을 스레드마다 번갈아 맡아 합친다. 더하는 순서가 스레드 순서로 정해져 있으므로
+// 같은 입력, 같은 스레드 수이면 합계의 비트까지 같다.
+static void MergePartitions(void *arg, int threadIndex) {
+    AggregationJob *job = arg;
+    for (int task = threadIndex; task < AggregationMaxPartitionCount; task += job->mergeThreadCount) {
+        const int segGroup = task / AggregationPartitionCount;
+        int64_t localBegin;
+        const int64_t localCount = CalculatePartitionLocalCount(job, task % AggregationPartitionCount, &localBegin);
+        if (localCount == 0) {
+            continue;
+        }
+        const int64_t segmentBegin = segGroup * job->segmentCountPerGroup + localBegin;
+        if (job->dense) {
+            MergeDensePartition(job, task, segmentBegin);
+        } else {
+            MergeHashedPartition(job, task, segmentBegin, localBegin, localCount);
+        }
+    }
+}
+
+// 합친 조각들을 최종 배열의 제자리에 옮긴다. 조각 순서가 곧 전역 세그먼트 인덱스 순서이다.
+static void CopyMergedPartitions(void *arg, int threadIndex) {
+    AggregationJob *job = arg;
+    SegmentAggregation *aggregation = job->aggregation;
+    const int weightCount = job->weightCount;
+    for (int task = threadIndex; task < AggregationMaxPartitionCount; task += job->mergeThreadCount) {
+        MergedPartition *merged = &job->merged[task];
+        if (merged->count == 0) {
+            continue;
+        }
+        memcpy(aggregation->segmentIndex + merged->offset, merged->segmentIndex, sizeof(int64_t) * merged->count);
+        memcpy(aggregation->counts + merged->offset, merged->counts, sizeof(int64_t) * merged->count);
+        for (int c = 0; c < weightCount; c++) {
+            double *column = aggregation->sums + c * aggregation->segmentCount + merged->offset;
+            for (int64_t i = 0; i < merged->count; i++) {
+                column[i] = merged->sums[i * weightCount + c];
+            }
+        }
+        free(merged->segmentIndex);
+        free(merged->counts);
+        free(merged->sums);
+        *merged = (MergedPartition) {0};
+    }
+}
+
+FFI_PLUGIN_EXPORT void DestroySegmentAggregation(SegmentAggregation *aggregation) {
+    if (aggregation == NULL) {
+        return;
+    }
+
+    free(aggregation->segmentIndex);
+    free(aggregation->counts);
+    free(aggregation->sums);
+    free(aggregation->threadStats);
+    free(aggregation);
+}
+
+// 지점들을 threadCount개 스레드로 나누어 지오코딩하고 세그먼트별 지점 수와 가중치 합계를 모은다.
+// 스레드마다 (면, 조각)별 부분 히스토그램(작은 n은 조밀 배열, 큰 n은 해시 표)에 더한 다음,
+// (면, 조각)을 나누어 맡아 병렬로 합치고 최종 배열로 옮긴다. 입력이 잘못되었거나 메모리가 부족하면 NULL을 반환한다.
+FFI_PLUGIN_EXPORT SegmentAggregation *AggregatePointsBySegment(int n, int64_t count, const double *lat,
+                                                               const double *lng, const double *const *weights,
+                                                               int weightCount, int threadCount) {
+    if (n < 1 || n > MaxSubdivisionCount64 || count < 0 || weightCount < 0 ||
+        (count > 0 && (lat == NULL || lng == NULL)) || (weightCount > 0 && weights == NULL)) {
+        return NULL;
+    }
+    for (int c = 0; c < weightCount; c++) {
+        if (weights[c] == NULL && count > 0) {
+            return NULL;
+        }
+    }
+
+    if (threadCount <= 0) {
+        threadCount = GetProcessorCount();
+    }
+    threadCount = threadCount > ParallelMaxThreadCount ? ParallelMaxThreadCount : threadCount;
+    threadCount = count > 0 && threadCount > count ? (int) count : threadCount;
+
+    SegmentGroupConstants segGroupConstants[GroupCount];
+    for (int i = 0; i < GroupCount; i++) {
+        CalculateSegmentGroupConstants(&segGroupConstants[i], n, i);
+    }
+
+    // 작업 구조체는 조각마다 결과를 담으므로 스택 대신 힙에 둔다.
+    AggregationJob *job = calloc(1, sizeof(AggregationJob));
+    if (job == NULL) {
+        return NULL;
+    }
+    job->n = n;
+    job->weightCount = weightCount;
+    job->threadCount = threadCount;
+    job->mergeThreadCount = threadCount < AggregationMaxPartitionCount ? threadCount : AggregationMaxPartitionCount;
+    job->segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    job->count = count;
+    job->lat = lat;
+    job->lng = lng;
+    job->weights = weights;
+    job->segGroupConstants = segGroupConstants;
+    job->stride = 2 + weightCount;
+    job->dense = job->segmentCountPerGroup <=
+                 AggregationDenseFaceMaxBytes / (int64_t) (sizeof(HistogramWord) * job->stride);
+    while ((job->segmentCountPerGroup - 1) >> job->partitionShift >= AggregationPartitionCount) {
+        job->partitionShift++;
+    }
+    job->workers = calloc((size_t) threadCount, sizeof(AggregationWorker));
+    SegmentAggregation *aggregation = calloc(1, sizeof(SegmentAggregation));
+    job->aggregation = aggregation;
+    if (job->workers == NULL || aggregation == NULL) {
+        free(job->workers);
+        free(job);
+        free(aggregation);
+        return NULL;
+    }
+
+    RunParallel(threadCount, AccumulatePoints, job);
+    int error = ErrorCode_None;
+    for (int t = 0; t < threadCount; t++) {
+        error = error != ErrorCode_None ? error : job->workers[t].error;
+    }
+
+    const double t0 = GetMonotonicSeconds();
+    if (error == ErrorCode_None) {
+        RunParallel(job->mergeThreadCount, MergePartitions, job);
+    }
+
+    int64_t segmentCount = 0;
+    for (int task = 0; task < AggregationMaxPartitionCount; task++) {
+        error = error != ErrorCode_None ? error : job->merged[task].error;
+        job->merged[task].offset = segmentCount;
+        segmentCount += job->merged[task].count;
+    }
+    if (error == ErrorCode_None) {
+        aggregation->segmentIndex = malloc(sizeof(int64_t) * (segmentCount > 0 ? segmentCount : 1));
+        aggregation->counts = malloc(sizeof(int64_t) * (segmentCount > 0 ? segmentCount : 1));
+        aggregation->sums = malloc(sizeof(double) * (segmentCount * weightCount > 0 ? segmentCount * weightCount : 1));
+        aggregation->threadStats = malloc(sizeof(AggregationThreadStats) * threadCount);
+        if (aggregation->segmentIndex == NULL || aggregation->counts == NULL || aggregation->sums == NULL ||
+            aggregation->threadStats == NULL) {
+            error = ErrorCode_OutOfMemory;
+        }
+    }
+    if (error == ErrorCode_None) {
+        aggregation->segmentCount = segmentCount;
+        RunParallel(job->mergeThreadCount, CopyMergedPartitions, job);
+        for (int t = 0; t < threadCount; t++) {
+            aggregation->threadStats[t] = job->workers[t].stats;
+        }
+        aggregation->n = n;
+        aggregation->weightCount = weightCount;
+        aggregation->threadCount = threadCount;
+        aggregation->mergeSeconds = GetMonotonicSeconds() - t0;
+    }
+
+    for (int t = 0; t < threadCount; t++) {
+        for (int task = 0; task < AggregationMaxPartitionCount; task++) {
+            FreeHistogramPartition(&job->workers[t].partitions[task]);
+        }
+    }
+    for (int task = 0; task < AggregationMaxPartitionCount; task++) {
+        free(job->merged[task].segmentIndex);
+        free(job->merged[task].counts);
+        free(job->merged[task].sums);
+    }
+    free(job->workers);
+    free(job);
+    if (error != ErrorCode_None) {
+        DestroySegmentAggregation(aggregation);
+        return NULL;
+    }
+    return aggregation;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentAggregationSegmentCount(const SegmentAggregation *aggregation) {
+    return aggregation == NULL ? ErrorCode_Argument_NullPtr : aggregation->segmentCount;
+}
+
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentAggregationSegmentIndices(const SegmentAggregation *aggregation) {
+    return aggregation == NULL ? NULL : aggregation->segmentIndex;
+}
+
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentAggregationCounts(const SegmentAggregation *aggregation) {
+    return aggregation == NULL ? NULL : aggregation->counts;
+}
+
+FFI_PLUGIN_EXPORT const double *GetSegmentAggregationSums(const SegmentAggregation *aggregation, int weightColumn) {
+    if (aggregation == NULL || weightColumn < 0 || weightColumn >= aggregation->weightCount) {
+        return NULL;
+    }
+    return aggregation->sums + (int64_t) weightColumn * aggregation->segmentCount;
+}
+
+FFI_PLUGIN_EXPORT int GetSegmentAggregationThreadCount(const SegmentAggregation *aggregation) {
+    return aggregation == NULL ? ErrorCode_Argument_NullPtr : aggregation->threadCount;
+}
+
+FFI_PLUGIN_EXPORT AggregationThreadStats GetSegmentAggregationThreadStats(const SegmentAggregation *aggregation,
+                                                                          int threadIndex) {
+    if (aggregation == NULL || threadIndex < 0 || threadIndex >= aggregation->threadCount) {
+        return (AggregationThreadStats) {0};
+    }
+    return aggregation->threadStats[threadIndex];
+}
+
+FFI_PLUGIN_EXPORT double GetSegmentAggregationMergeSeconds(const SegmentAggregation *aggregation) {
+    return aggregation == NULL ? 0 : aggregation->mergeSeconds;
+}
+
+// 공유 정점 메시와 정점 번호 체계
+//
+// 면 g의 격자점 P(i, j) = origin + i * axisA + j * axisB (i, j >= 0, i + j <= n). 면의 꼭짓점은 P(0, 0), P(n, 0),
+// P(0, n)이고, 모서리는 0: P(0, 0)-P(n, 0) (i로 매개화), 1: P(0, 0)-P(0, n) (j), 2: P(n, 0)-P(0, n) (j)이다.
+// 정이십면체 꼭짓점과 모서리는 그것을 가진 면 가운데 번호가 가장 작은 면이 소유한다. 정점 번호는 면 순서대로
+// 면마다 연속한 구간을 차지하며, 구간 안에서는 소유한 꼭짓점, 소유한 모서리의 내부 점(n - 1개씩, 소유 면의
+// 매개화 방향), 면 내부 점(j = 1 .. n - 2 행 우선, i = 1 .. n - 1 - j) 순서다.
+// 전체 정점 수는 12 + 30 (n - 1) + 20 (n - 1)(n - 2) / 2 = 10 n^2 + 2.
+typedef struct {
+    int face;     // 소유 면
+    int slot;     // 소유 면이 소유한 꼭짓점(또는 모서리) 가운데 몇 번째인지
+    int reversed; // (모서리만) 소유 면과 반대 방향으로 매개화하는지
+} MeshElementOwner;
+
+typedef struct {
+    MeshElementOwner corners[3];
+    MeshElementOwner edges[3];
+    int ownedCornerCount;
+    int ownedEdgeCount;
+    // 앞선 면들이 소유한 꼭짓점, 모서리 수
+    int cornersBefore;
+    int edgesBefore;
+} FaceMeshTopology;
+
+// VertIndexPerFaces에서 만든 표
+static const FaceMeshTopology FaceMeshTopologies[20] = {
+        {{{0, 0, 0}, {0, 1, 0}, {0, 2, 0}},   {{0, 0, 0},  {0, 1, 0},  {0, 2, 0}},  3, 3, 0,  0}, // Face 0
+        {{{0, 0, 0}, {1, 0, 0}, {0, 1, 0}},   {{1, 0, 0},  {0, 0, 0},  {1, 1, 0}},  1, 2, 3,  3}, // Face 1
+        {{{0, 0, 0}, {0, 2, 0}, {2, 0, 0}},   {{0, 1, 0},  {2, 0, 0},  {2, 1, 0}},  1, 2, 4,  5}, // Face 2
+        {{{0, 0, 0}, {3, 0, 0}, {1, 0, 0}},   {{3, 0, 0},  {1, 0, 0},  {3, 1, 0}},  1, 2, 5,  7}, // Face 3
+        {{{0, 0, 0}, {2, 0, 0}, {3, 0, 0}},   {{2, 0, 0},  {3, 0, 0},  {4, 0, 0}},  0, 1, 6,  9}, // Face 4
+        {{{0, 1, 0}, {5, 0, 0}, {5, 1, 0}},   {{5, 0, 0},  {5, 1, 0},  {5, 2, 0}},  2, 3, 6,  10}, // Face 5
+        {{{0, 1, 0}, {5, 1, 0}, {0, 2, 0}},   {{5, 1, 0},  {0, 2, 0},  {6, 0, 0}},  0, 1, 8,  13}, // Face 6
+        {{{0, 1, 0}, {1, 0, 0}, {5, 0, 0}},   {{1, 1, 1},  {5, 0, 0},  {7, 0, 0}},  0, 1, 8,  14}, // Face 7
+        {{{8, 0, 0}, {8, 1, 0}, {8, 2, 0}},   {{8, 0, 0},  {8, 1, 0},  {8, 2, 0}},  3, 3, 8,  15}, // Face 8
+        {{{8, 0, 0}, {9, 0, 0}, {8, 1, 0}},   {{9, 0, 0},  {8, 0, 0},  {9, 1, 0}},  1, 2, 11, 18}, // Face 9
+        {{{8, 0, 0}, {8, 2, 0}, {5, 1, 0}},   {{8, 1, 0},  {10, 0, 0}, {10, 1, 0}}, 0, 2, 12, 20}, // Face 10
+        {{{8, 0, 0}, {5, 1, 0}, {5, 0, 0}},   {{10, 0, 0}, {11, 0, 0}, {5, 2, 1}},  0, 1, 12, 22}, // Face 11
+        {{{8, 0, 0}, {5, 0, 0}, {9, 0, 0}},   {{11, 0, 0}, {9, 0, 0},  {12, 0, 0}}, 0, 1, 12, 23}, // Face 12
+        {{{8, 1, 0}, {9, 0, 0}, {3, 0, 0}},   {{9, 1, 1},  {13, 0, 0}, {13, 1, 0}}, 0, 2, 12, 24}, // Face 13
+        {{{8, 1, 0}, {3, 0, 0}, {2, 0, 0}},   {{13, 0, 0}, {14, 0, 0}, {4, 0, 1}},  0, 1, 12, 26}, // Face 14
+        {{{8, 1, 0}, {2, 0, 0}, {8, 2, 0}},   {{14, 0, 0}, {8, 2, 0},  {15, 0, 0}}, 0, 1, 12, 27}, // Face 15
+        {{{1, 0, 0}, {9, 0, 0}, {5, 0, 0}},   {{16, 0, 0}, {7, 0, 0},  {12, 0, 1}}, 0, 1, 12, 28}, // Face 16
+        {{{1, 0, 0}, {3, 0, 0}, {9, 0, 0}},   {{3, 1, 1},  {16, 0, 0}, {13, 1, 1}}, 0, 0, 12, 29}, // Face 17
+        {{{8, 2, 0}, {0, 2, 0}, {5, 1, 0}},   {{18, 0, 0}, {10, 1, 0}, {6, 0, 1}},  0, 1, 12, 29}, // Face 18
+        {{{8, 2, 0}, {2, 0, 0}, {0, 2, 0}},   {{15, 0, 1}, {18, 0, 0}, {2, 1, 1}},  0, 0, 12, 30}, // Face 19
+};
+
+// 정점 번호와 삼각형 인덱스를 uint32_t로 내보내므로 32비트 세그먼트 인덱스와 같은 n 범위만 받는다.
+static int IsValidGlobeMeshN(int n) {
+    return n >= 1 && (int64_t) n * n * GroupCount <= (int64_t) UINT_MAX + 1;
+}
+
+// 면 face가 소유한 정점 구간의 시작 번호. face == GroupCount이면 전체 정점 수다.
+static int64_t CalculateFaceVertexStart(int n, int face) {
+    const int64_t m = n - 1;
+    if (face == GroupCount) {
+        return 10 * (int64_t) n * n + 2;
+    }
+    const FaceMeshTopology *topology = &FaceMeshTopologies[face];
+    return topology->cornersBefore + topology->edgesBefore * m + face * (m * (m - 1) / 2);
+}
+
+// 모서리 내부 점의 번호. k(1 .. n - 1)는 참조하는 면의 매개화 기준이다.
+static int64_t CalculateEdgeVertexId(int n, MeshElementOwner owner, int64_t k) {
+    return CalculateFaceVertexStart(n, owner.face) + FaceMeshTopologies[owner.face].ownedCornerCount +
+           (int64_t) owner.slot * (n - 1) + (owner.reversed ? n - k : k) - 1;
+}
+
+// 면 내부 점 P(i, j)의 번호 (i, j >= 1, i + j <= n - 1)
+static int64_t CalculateInteriorVertexId(int n, int face, int64_t i, int64_t j) {
+    const FaceMeshTopology *topology = &FaceMeshTopologies[face];
+    return CalculateFaceVertexStart(n, face) + topology->ownedCornerCount +
+           (int64_t) topology->ownedEdgeCount * (n - 1) + (j - 1) * (n - 1) - (j - 1) * j / 2 + i - 1;
+}
+
+// 면 face의 격자점 P(i, j)의 전역 정점 번호
+static int64_t CalculateFaceGridVertexId(int n, int face, int i, int j) {
+    const FaceMeshTopology *topology = &FaceMeshTopologies[face];
+    if (j == 0) {
+        if (i == 0 || i == n) {
+            const MeshElementOwner owner = topology->corners[i == 0 ? 0 : 1];
+            return CalculateFaceVertexStart(n, owner.face) + owner.slot;
+        }
+        return CalculateEdgeVertexId(n, topology->edges[0], i);
+    }
+    if (i == 0) {
+        if (j == n) {
+            const MeshElementOwner owner = topology->corners[2];
+            return CalculateFaceVertexStart(n, owner.face) + owner.slot;
+        }
+        return CalculateEdgeVertexId(n, topology->edges[1], j);
+    }
+    if (i + j == n) {
+        return CalculateEdgeVertexId(n, topology->edges[2], j);
+    }
+    return CalculateInteriorVertexId(n, face, i, j);
+}
+
+// 면의 한 행(j 고정, i = 0 .. n - j)의 정점 번호. 양 끝을 뺀 점은 base + step * i로 이어진다.
+typedef struct {
+    int64_t first;
+    int64_t last;
+    int64_t base;
+    int step;
+    int length; // n - j
+} MeshRowVertexIds;
+
+static MeshRowVertexIds CalculateMeshRowVertexIds(int n, int face, int j) {
+    MeshRowVertexIds row = {
+            .first = CalculateFaceGridVertexId(n, face, 0, j),
+            .last = CalculateFaceGridVertexId(n, face, n - j, j),
+            .step = 1,
+            .length = n - j,
+    };
+    if (j == 0) {
+        const MeshElementOwner owner = FaceMeshTopologies[face].edges[0];
+        row.base = CalculateEdgeVertexId(n, owner, 1) - (owner.reversed ? -1 : 1);
+        row.step = owner.reversed ? -1 : 1;
+    } else {
+        row.base = CalculateInteriorVertexId(n, face, 1, j) - 1;
+    }
+    return row;
+}
+
+static int64_t GetMeshRowVertexId(const MeshRowVertexIds *row, int i) {
+    return i == 0 ? row->first : i == row->length ? row->last : row->base + (int64_t) row->step * i;
+}
+
+// 면 face의 격자점 P(i, j)의 단위 구 위치를 out에 float 세 개로 쓴다. 꼭짓점의 가중 합으로 계산하므로, 면 경계의
+// 점은 어느 면에서 계산하든 덧셈 순서만 다를 뿐 같은 두 항(나머지 한 항은 0)이라 비트 단위로 같다.
+static void WriteFaceGridPosition(float *out, int n, int face, int i, int j) {
+    const int *vertIndex = VertIndexPerFaces[face];
+    const Vector3 p = AddVector3(AddVector3(ScalarMultiplyVector(n - i - j, Vertices[vertIndex[0]]),
+                                            ScalarMultiplyVector(i, Vertices[vertIndex[1]])),
+                                 ScalarMultiplyVector(j, Vertices[vertIndex[2]]));
+    const double inverseMagnitude = 1.0 / Magnitude(p);
+    out[0] = (float) (p.x * inverseMagnitude);
+    out[1] = (float) (p.y * inverseMagnitude);
+    out[2] = (float) (p.z * inverseMagnitude);
+}
+
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshVertexCount(int n) {
+    return IsValidGlobeMeshN(n) ? CalculateFaceVertexStart(n, GroupCount) : ErrorCode_ArgumentOutOfRangeException;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshFaceVertexStart(int n, int face) {
+    if (!IsValidGlobeMeshN(n) || face < 0 || face > GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    return CalculateFaceVertexStart(n, face);
+}
+
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshFaceVertices(int n, int face, float *outPositions, int64_t outCapacity) {
+    if (!IsValidGlobeMeshN(n) || face < 0 || face >= GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t count = CalculateFaceVertexStart(n, face + 1) - CalculateFaceVertexStart(n, face);
+    if (outPositions == NULL) {
+        return count;
+    }
+    if (outCapacity < count) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    const FaceMeshTopology *topology = &FaceMeshTopologies[face];
+    float *out = outPositions;
+    for (int c = 0; c < 3; c++) {
+        if (topology->corners[c].face == face) {
+            WriteFaceGridPosition(out, n, face, c == 1 ? n : 0, c == 2 ? n : 0);
+            out += 3;
+        }
+    }
+
+    // 소유한 모서리는 reversed가 0이고, 슬롯 순서가 모서리 번호 순서와 같다.
+    for (int e = 0; e < 3; e++) {
+        if (topology->edges[e].face != face) {
+            continue;
+        }
+        for (int k = 1; k < n; k++) {
+            WriteFaceGridPosition(out, n, face, e == 0 ? k : e == 1 ? 0 : n - k, e == 0 ? 0 : k);
+            out += 3;
+        }
+    }
+
+    for (int j = 1; j <= n - 2; j++) {
+        for (int i = 1; i <= n - 1 - j; i++) {
+            WriteFaceGridPosition(out, n, face, i, j);
+            out += 3;
+        }
+    }
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshFaceTriangles(int n, int face, uint32_t *outIndices, int64_t outCapacity) {
+    if (!IsValidGlobeMeshN(n) || face < 0 || face >= GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int64_t count = (int64_t) n * n;
+    if (outIndices == NULL) {
+        return count;
+    }
+    if (outCapacity < count) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    // 지역 세그먼트 인덱스 b * (2n - b) + 2a + t 순서. 아래 삼각형은 P(a, b), P(a+1, b), P(a, b+1),
+    // 위 삼각형은 P(a+1, b+1), P(a, b+1), P(a+1, b)로, 모든 삼각형이 면(VertIndexPerFaces)과 같은 방향으로 감긴다.
+    uint32_t *out = outIndices;
+    MeshRowVertexIds lower = CalculateMeshRowVertexIds(n, face, 0);
+    for (int b = 0; b < n; b++) {
+        const MeshRowVertexIds upper = CalculateMeshRowVertexIds(n, face, b + 1);
+        for (int a = 0; a < n - b; a++) {
+            const uint32_t p00 = (uint32_t) GetMeshRowVertexId(&lower, a);
+            const uint32_t p10 = (uint32_t) GetMeshRowVertexId(&lower, a + 1);
+            const uint32_t p01 = (uint32_t) GetMeshRowVertexId(&upper, a);
+            out[0] = p00;
+            out[1] = p10;
+            out[2] = p01;
+            out += 3;
+            if (a < n - b - 1) {
+                out[0] = (uint32_t) GetMeshRowVertexId(&upper, a + 1);
+                out[1] = p01;
+                out[2] = p10;
+                out += 3;
+            }
+        }
+        lower = upper;
+    }
+    return count;
+}
+
+// 패치: 격자 patchN(n의 약수)의 세그먼트 하나를 격자 n의 (n / patchN)^2개 세그먼트 묶음으로 쓴다.
+// 패치 안에서는 detailN(n / patchN의 약수) 격자로 면 하나처럼 매개화한다. 지역 격자점 v(i, j)는
+// i + j <= detailN이고, 아래(t = 0) 패치는 P(a s + i q, b s + j q), 위(t = 1) 패치는 P((a+1) s - i q, (b+1) s - j q)
+// 에 놓인다 (s = n / patchN, q = s / detailN). 위 패치는 두 축이 모두 뒤집히므로 감기는 방향은 그대로다.
+typedef struct {
+    int face;
+    int64_t originI;
+    int64_t originJ;
+    int64_t step; // q, 위 패치면 -q
+} GlobePatch;
+
+// patchN이 n을 나누고 detailN이 n / patchN을 나누는지 검사하고 패치 위치를 계산한다.
+static ErrorCode ResolveGlobePatch(GlobePatch *out, int n, int patchN, int patchIndex, int detailN) {
+    if (!IsValidGlobeMeshN(n) || patchN < 1 || patchN > n || n % patchN != 0 || detailN < 1 ||
+        (n / patchN) % detailN != 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    const int64_t patch = (uint32_t) patchIndex;
+    if (patch >= (int64_t) patchN * patchN * GroupCount) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbt64(patchN, patch);
+    const int64_t s = n / patchN;
+    const int top = segGroupAndAbt.abt.t == Parallelogram_Top;
+    out->face = segGroupAndAbt.segGroup;
+    out->originI = (segGroupAndAbt.abt.a + top) * s;
+    out->originJ = (segGroupAndAbt.abt.b + top) * s;
+    out->step = top ? -(s / detailN) : s / detailN;
+    return ErrorCode_None;
+}
+
+FFI_PLUGIN_EXPORT int GetGlobePatchVertices(int n, int patchN, int patchIndex, int detailN, float *outPositions,
+                                            uint32_t *outVertexIndex, int outCapacity) {
+    GlobePatch patch;
+    const ErrorCode error = ResolveGlobePatch(&patch, n, patchN, patchIndex, detailN);
+    if (error != ErrorCode_None) {
+        return error;
+    }
+
+    const int count = (detailN + 1) * (detailN + 2) / 2;
+    if (outPositions == NULL && outVertexIndex == NULL) {
+        return count;
+    }
+    if (outCapacity < count) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    int v = 0;
+    for (int j = 0; j <= detailN; j++) {
+        const int gj = (int) (patch.originJ + patch.step * j);
+        for (int i = 0; i <= detailN - j; i++, v++) {
+            const int gi = (int) (patch.originI + patch.step * i);
+            if (outPositions != NULL) {
+                WriteFaceGridPosition(outPositions + (int64_t) v * 3, n, patch.face, gi, gj);
+            }
+            if (outVertexIndex != NULL) {
+                outVertexIndex[v] = (uint32_t) CalculateFaceGridVertexId(n, patch.face, gi, gj);
+            }
+        }
+    }
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int GetGlobePatchTriangles(int detailN, uint32_t *outIndices, int outCapacity) {
+    if (!IsValidGlobeMeshN(detailN)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    const int count = detailN * detailN;
+    if (outIndices == NULL) {
+        return count;
+    }
+    if (outCapacity < count) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    // 지역 정점 v(i, j)의 번호는 j 행 앞의 정점 수 j (d + 1) - j (j - 1) / 2에 i를 더한 값이다.
+    uint32_t *out = outIndices;
+    for (int b = 0; b < detailN; b++) {
+        const uint32_t lower = (uint32_t) (b * (detailN + 1) - b * (b - 1) / 2);
+        const uint32_t upper = lower + (uint32_t) (detailN + 1 - b);
+        for (int a = 0; a < detailN - b; a++) {
+            out[0] = lower + a;
+            out[1] = lower + a + 1;
+            out[2] = upper + a;
+            out += 3;
+            if (a < detailN - b - 1) {
+                out[0] = upper + a + 1;
+                out[1] = upper + a;
+                out[2] = lower + a + 1;
+                out += 3;
+            }
+        }
+    }
+    return count;
+}
+
+FFI_PLUGIN_EXPORT int GetGlobePatchSegmentIndices(int n, int patchN, int patchIndex, int *outSegmentIndex,
+                                                  int outCapacity) {
+    GlobePatch patch;
+    const ErrorCode error = ResolveGlobePatch(&patch, n, patchN, patchIndex, n / (patchN > 0 ? patchN : 1));
+    if (error != ErrorCode_None) {
+        return error;
+    }
+
+    const int d = n / patchN;
+    const int count = d * d;
+    if (outSegmentIndex == NULL) {
+        return count;
+    }
+    if (outCapacity < count) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    // 위 패치의 지역 삼각형 (a', b', t')는 격자 n의 (originI - a' - 1, originJ - b' - 1, 1 - t')이다.
+    const int64_t groupBase = (int64_t) n * n * patch.face;
+    const int top = patch.step < 0;
+    int *out = outSegmentIndex;
+    for (int b = 0; b < d; b++) {
+        for (int a = 0; a < d - b; a++) {
+            for (int t = 0; t < 2 && (t == 0 || a < d - b - 1); t++) {
+                const AbtCoords abt = top ? (AbtCoords) {(int) patch.originI - a - 1, (int) patch.originJ - b - 1,
+                                                         (Parallelogram) (1 - t)}
+                                          : (AbtCoords) {(int) patch.originI + a, (int) patch.originJ + b,
+                                                         (Parallelogram) t};
+                *out++ = (int) (uint32_t) (groupBase + ConvertToLocalSegmentIndex2(n, abt));
+            }
+        }
+    }
+    return count;
+}
+
+// 격자 정점과 모서리의 고정 번호
+//
+// 정점 번호는 공유 정점 메시와 같다. 모서리 번호도 같은 방식으로 면마다 연속한 구간을 차지하며, 구간 안에서는
+// 소유한 정이십면체 모서리 위의 격자 모서리(n개씩, 소유 면의 매개화 방향으로 k = 0 .. n - 1), 면 내부 모서리
+// 세 종류(A: P(i, j)-P(i+1, j), B: P(i, j)-P(i, j+1), C: P(i+1, j)-P(i, j+1)) 순서다. 내부 모서리는 종류마다
+// n (n - 1) / 2개이고 행(j) 우선이다. 전체 모서리 수는 30 n + 20 * 3 n (n - 1) / 2 = 30 n^2.
+
+typedef struct {
+    int face;
+    int i;
+    int j;
+} FaceGridPoint;
+
+static int IsValidGridTopologyN(int n) {
+    return n >= 1 && n <= MaxSubdivisionCount64;
+}
+
+// 면 face가 소유한 모서리 구간의 시작 번호. face == GroupCount이면 전체 모서리 수다.
+static int64_t CalculateFaceEdgeStart(int n, int face) {
+    if (face == GroupCount) {
+        return 30 * (int64_t) n * n;
+    }
+    return (int64_t) FaceMeshTopologies[face].edgesBefore * n + face * (3 * ((int64_t) n * (n - 1) / 2));
+}
+
+// 길이가 m, m - 1, ..., 1인 행을 이어 붙였을 때 r번째 원소의 행 번호. 행 u의 시작은 u m - u (u - 1) / 2다.
+static int64_t CalculateTriangularRow(int64_t m, int64_t r) {
+    // 끝에서부터 센 행 w(1부터)는 w (w - 1) / 2 < d <= w (w + 1) / 2를 만족한다.
+    const int64_t d = m * (m + 1) / 2 - r;
+    int64_t w = (int64_t) ((sqrt(8.0 * (double) d + 1) - 1) / 2);
+    // sqrt() 반올림 오차 보정
+    while (w * (w + 1) / 2 < d) {
+        w++;
+    }
+    while (w > 1 && (w - 1) * w / 2 >= d) {
+        w--;
+    }
+    return m - w;
+}
+
+static int64_t CalculateTriangularRowStart(int64_t m, int64_t u) {
+    return u * m - u * (u - 1) / 2;
+}
+
+// owners에서 face가 소유한 slot번째 원소(꼭짓점 또는 모서리)의 위치. 소유한 원소는 슬롯 순서가 위치 순서와 같다.
+static int FindOwnedElement(const MeshElementOwner *owners, int face, int slot) {
+    for (int c = 0; c < 3; c++) {
+        if (owners[c].face == face && owners[c].slot == slot) {
+            return c;
+        }
+    }
+    return -1;
+}
+
+// 면의 꼭짓점 c의 좌표와 모서리 e 위 매개변수 k인 점의 좌표
+static FaceGridPoint GetFaceCornerPoint(int n, int face, int c) {
+    return (FaceGridPoint) {face, c == 1 ? n : 0, c == 2 ? n : 0};
+}
+
+static FaceGridPoint GetFaceEdgePoint(int n, int face, int e, int k) {
+    return (FaceGridPoint) {face, e == 0 ? k : e == 1 ? 0 : n - k, e == 0 ? 0 : k};
+}
+
+// 정점 번호를 소유 면의 격자점으로 바꾼다. 범위를 벗어나면 face가 -1이다.
+static FaceGridPoint DecodeGridVertexIndex(int n, int64_t vertexIndex) {
+    if (vertexIndex < 0 || vertexIndex >= CalculateFaceVertexStart(n, GroupCount)) {
+        return (FaceGridPoint) {-1, 0, 0};
+    }
+
+    int face = GroupCount - 1;
+    while (CalculateFaceVertexStart(n, face) > vertexIndex) {
+        face--;
+    }
+    const FaceMeshTopology *topology = &FaceMeshTopologies[face];
+    int64_t r = vertexIndex - CalculateFaceVertexStart(n, face);
+    if (r < topology->ownedCornerCount) {
+        return GetFaceCornerPoint(n, face, FindOwnedElement(topology->corners, face, (int) r));
+    }
+    r -= topology->ownedCornerCount;
+    if (r < (int64_t) topology->ownedEdgeCount * (n - 1)) {
+        const int e = FindOwnedElement(topology->edges, face, (int) (r / (n - 1)));
+        return GetFaceEdgePoint(n, face, e, (int) (r % (n - 1)) + 1);
+    }
+    r -= (int64_t) topology->ownedEdgeCount * (n - 1);
+    const int64_t u = CalculateTriangularRow(n - 2, r);
+    return (FaceGridPoint) {face, (int) (r - CalculateTriangularRowStart(n - 2, u)) + 1, (int) u + 1};
+}
+
+// 면 안에서 이웃한 두 격자점을 잇는 모서리의 번호
+static int64_t CalculateFaceGridEdgeId(int n, FaceGridPoint p, FaceGridPoint q) {
+    const FaceMeshTopology *topology = &FaceMeshTopologies[p.face];
+    const int64_t half = (int64_t) n * (n - 1) / 2;
+    const int64_t interiorStart = CalculateFaceEdgeStart(n, p.face) + (int64_t) topology->ownedEdgeCount * n;
+    int e;
+    int k;
+    if (p.j == q.j) {
+        const int i = p.i < q.i ? p.i : q.i;
+        if (p.j != 0) {
+            return interiorStart + CalculateTriangularRowStart(n - 1, p.j - 1) + i;
+        }
+        e = 0;
+        k = i;
+    } else if (p.i == q.i) {
+        const int j = p.j < q.j ? p.j : q.j;
+        if (p.i != 0) {
+            return interiorStart + half + CalculateTriangularRowStart(n - 1, j) + p.i - 1;
+        }
+        e = 1;
+        k = j;
+    } else {
+        // P(i+1, j)-P(i, j+1)
+        const FaceGridPoint low = p.j < q.j ? p : q;
+        if (low.i + low.j != n) {
+            return interiorStart + 2 * half + CalculateTriangularRowStart(n - 1, low.j) + low.i - 1;
+        }
+        e = 2;
+        k = low.j;
+    }
+
+    const MeshElementOwner owner = topology->edges[e];
+    return CalculateFaceEdgeStart(n, owner.face) + (int64_t) owner.slot * n + (owner.reversed ? n - 1 - k : k);
+}
+
+// 모서리 번호를 소유 면의 두 끝점으로 바꾼다. 범위를 벗어나면 face가 -1이다.
+static void DecodeGridEdgeIndex(int n, int64_t edgeIndex, FaceGridPoint *out) {
+    if (edgeIndex < 0 || edgeIndex >= CalculateFaceEdgeStart(n, GroupCount)) {
+        out[0] = out[1] = (FaceGridPoint) {-1, 0, 0};
+        return;
+    }
+
+    int face = GroupCount - 1;
+    while (CalculateFaceEdgeStart(n, face) > edgeIndex) {
+        face--;
+    }
+    const FaceMeshTopology *topology = &FaceMeshTopologies[face];
+    int64_t r = edgeIndex - CalculateFaceEdgeStart(n, face);
+    if (r < (int64_t) topology->ownedEdgeCount * n) {
+        const int e = FindOwnedElement(topology->edges, face, (int) (r / n));
+        const int k = (int) (r % n);
+        out[0] = GetFaceEdgePoint(n, face, e, k);
+        out[1] = GetFaceEdgePoint(n, face, e, k + 1);
+        return;
+    }
+
+    r -= (int64_t) topology->ownedEdgeCount * n;
+    const int64_t half = (int64_t) n * (n - 1) / 2;
+    const int kind = (int) (r / half);
+    r %= half;
+    const int u = (int) CalculateTriangularRow(n - 1, r);
+    const int column = (int) (r - CalculateTriangularRowStart(n - 1, u));
+    if (kind == 0) {
+        out[0] = (FaceGridPoint) {face, column, u + 1};
+        out[1] = (FaceGridPoint) {face, column + 1, u + 1};
+    } else if (kind == 1) {
+        out[0] = (FaceGridPoint) {face, column + 1, u};
+        out[1] = (FaceGridPoint) {face, column + 1, u + 1};
+    } else {
+        out[0] = (FaceGridPoint) {face, column + 1, u};
+        out[1] = (FaceGridPoint) {face, column, u + 1};
+    }
+}
+
+// p와 같은 점을 그 점을 포함하는 모든 면의 좌표로 out에 쓰고 개수(내부 1, 모서리 2, 꼭짓점 5)를 반환한다.
+static int CollectFaceGridPointAliases(int n, FaceGridPoint p, FaceGridPoint *out) {
+    const FaceMeshTopology *topology = &FaceMeshTopologies[p.face];
+    const int c = p.j == 0 && p.i == 0 ? 0 : p.j == 0 && p.i == n ? 1 : p.i == 0 && p.j == n ? 2 : -1;
+    const int e = c >= 0 ? -1 : p.j == 0 ? 0 : p.i == 0 ? 1 : p.i + p.j == n ? 2 : -1;
+    if (c < 0 && e < 0) {
+        out[0] = p;
+        return 1;
+    }
+
+    const MeshElementOwner owner = c >= 0 ? topology->corners[c] : topology->edges[e];
+    const int k = e == 0 ? p.i : p.j;
+    const int ownerK = c >= 0 || !owner.reversed ? k : n - k;
+    int count = 0;
+    for (int face = 0; face < GroupCount; face++) {
+        const MeshElementOwner *owners = c >= 0 ? FaceMeshTopologies[face].corners : FaceMeshTopologies[face].edges;
+        for (int x = 0; x < 3; x++) {
+            if (owners[x].face != owner.face || owners[x].slot != owner.slot) {
+                continue;
+            }
+            out[count++] = c >= 0 ? GetFaceCornerPoint(n, face, x)
+                                  : GetFaceEdgePoint(n, face, x, owners[x].reversed ? n - ownerK : ownerK);
+        }
+    }
+    return count;
+}
+
+static void SortInt64Small(int64_t *values, int count) {
+    for (int i = 1; i < count; i++) {
+        const int64_t value = values[i];
+        int j = i;
+        for (; j > 0 && values[j - 1] > value; j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+}
+
+// 정점을 꼭짓점으로 가지는 세그먼트(5개 또는 6개)를 오름차순으로 out에 쓰고 개수를 반환한다.
+static int CollectGridVertexSegments(int n, FaceGridPoint p, int64_t *out) {
+    FaceGridPoint aliases[5];
+    const int aliasCount = CollectFaceGridPointAliases(n, p, aliases);
+    const int64_t segmentCountPerGroup = CalculateSegmentCountPerGroup64(n);
+    int count = 0;
+    for (int x = 0; x < aliasCount; x++) {
+        const int i = aliases[x].i;
+        const int j = aliases[x].j;
+        // 아래 삼각형 (a, b)는 P(a, b), P(a+1, b), P(a, b+1)을, 위 삼각형은 P(a+1, b+1), P(a+1, b), P(a, b+1)을 잇는다.
+        const AbtCoords candidates[6] = {
+                {i, j, Parallelogram_Bottom}, {i - 1, j, Parallelogram_Bottom}, {i, j - 1, Parallelogram_Bottom},
+                {i - 1, j - 1, Parallelogram_Top}, {i - 1, j, Parallelogram_Top}, {i, j - 1, Parallelogram_Top},
+        };
+        for (int y = 0; y < 6; y++) {
+            const AbtCoords abt = candidates[y];
+            if (abt.a < 0 || abt.b < 0 || (int64_t) abt.a + abt.b + abt.t > n - 1) {
+                continue;
+            }
+            out[count++] = segmentCountPerGroup * aliases[x].face + ConvertToLocalSegmentIndex2(n, abt);
+        }
+    }
+    SortInt64Small(out, count);
+    return count;
+}
+
+// 격자점 p, q를 잇는 모서리를 공유하는 두 세그먼트를 오름차순으로 out에 쓰고 개수를 반환한다. 두 끝점을 모두
+// 꼭짓점으로 가지는 세그먼트이며, 정점마다 목록이 오름차순이므로 병합하듯 교집합을 구한다.
+static int CollectGridEdgeSegments(int n, FaceGridPoint p, FaceGridPoint q, int64_t *out) {
+    int64_t first[6];
+    int64_t second[6];
+    const int firstCount = CollectGridVertexSegments(n, p, first);
+    const int secondCount = CollectGridVertexSegments(n, q, second);
+    int count = 0;
+    for (int x = 0, y = 0; x < firstCount && y < secondCount;) {
+        if (first[x] == second[y]) {
+            out[count++] = first[x];
+            x++;
+            y++;
+        } else if (first[x] < second[y]) {
+            x++;
+        } else {
+            y++;
+        }
+    }
+    return count;
+}
+
+// 세그먼트의 세 꼭짓점 격자점. 순서는 CalculateSegmentCornersInLatLng()와 같다.
+static void GetAbtGridPoints(SegGroupAndAbt segGroupAndAbt, FaceGridPoint *out) {
+    const int face = segGroupAndAbt.segGroup;
+    const int a = segGroupAndAbt.abt.a;
+    const int b = segGroupAndAbt.abt.b;
+    const int top = segGroupAndAbt.abt.t == Parallelogram_Top;
+    out[0] = (FaceGridPoint) {face, a + top, b + top};
+    out[1] = (FaceGridPoint) {face, a + 1, b};
+    out[2] = (FaceGridPoint) {face, a, b + 1};
+}
+
+static int GetSegmentGridPoints(int n, int64_t segmentIndex, FaceGridPoint *out) {
+    const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbt64(n, segmentIndex);
+    if (segGroupAndAbt.segGroup < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    GetAbtGridPoints(segGroupAndAbt, out);
+    return ErrorCode_None;
+}
+
+// 격자점의 단위 구 위치. 세그먼트 꼭짓점과 같은 표를 쓴다.
+static Vector3 CalculateFaceGridPosition(int n, FaceGridPoint p) {
+    const Vector3 *vertices = GetIcosahedronGeometry(n)->vertices;
+    const int *vertIndex = VertIndexPerFaces[p.face];
+    return NormalizeVector3(AddVector3(AddVector3(ScalarMultiplyVector((double) n - p.i - p.j, vertices[vertIndex[0]]),
+                                                  ScalarMultiplyVector(p.i, vertices[vertIndex[1]])),
+                                       ScalarMultiplyVector(p.j, vertices[vertIndex[2]])));
+}
+
+FFI_PLUGIN_EXPORT int64_t GetGridVertexCount64(int n) {
+    return IsValidGridTopologyN(n) ? CalculateFaceVertexStart(n, GroupCount) : ErrorCode_ArgumentOutOfRangeException;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetGridEdgeCount64(int n) {
+    return IsValidGridTopologyN(n) ? CalculateFaceEdgeStart(n, GroupCount) : ErrorCode_ArgumentOutOfRangeException;
+}
+
+FFI_PLUGIN_EXPORT int GetSegmentGridVertexIndices64(int n, int64_t segmentIndex, int64_t *outVertexIndex) {
+    if (outVertexIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+    FaceGridPoint points[3];
+    if (!IsValidGridTopologyN(n) || GetSegmentGridPoints(n, segmentIndex, points) != ErrorCode_None) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    for (int c = 0; c < 3; c++) {
+        outVertexIndex[c] = CalculateFaceGridVertexId(n, points[c].face, points[c].i, points[c].j);
+    }
+    return 3;
+}
+
+FFI_PLUGIN_EXPORT int GetSegmentGridEdgeIndices64(int n, int64_t segmentIndex, int64_t *outEdgeIndex) {
+    if (outEdgeIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+    FaceGridPoint points[3];
+    if (!IsValidGridTopologyN(n) || GetSegmentGridPoints(n, segmentIndex, points) != ErrorCode_None) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    for (int c = 0; c < 3; c++) {
+        outEdgeIndex[c] = CalculateFaceGridEdgeId(n, points[c], points[(c + 1) % 3]);
+    }
+    return 3;
+}
+
+FFI_PLUGIN_EXPORT int GetGridVertexSegmentIndices64(int n, int64_t vertexIndex, int64_t *outSegmentIndex) {
+    if (outSegmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+    if (!IsValidGridTopologyN(n)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    const FaceGridPoint p = DecodeGridVertexIndex(n, vertexIndex);
+    if (p.face < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    return CollectGridVertexSegments(n, p, outSegmentIndex);
+}
+
+FFI_PLUGIN_EXPORT int GetGridEdgeVertexIndices64(int n, int64_t edgeIndex, int64_t *outVertexIndex) {
+    if (outVertexIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+    if (!IsValidGridTopologyN(n)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    FaceGridPoint points[2];
+    DecodeGridEdgeIndex(n, edgeIndex, points);
+    if (points[0].face < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    for (int x = 0; x < 2; x++) {
+        outVertexIndex[x] = CalculateFaceGridVertexId(n, points[x].face, points[x].i, points[x].j);
+    }
+    return 2;
+}
+
+FFI_PLUGIN_EXPORT int GetGridEdgeSegmentIndices64(int n, int64_t edgeIndex, int64_t *outSegmentIndex) {
+    if (outSegmentIndex == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+    if (!IsValidGridTopologyN(n)) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+    FaceGridPoint points[2];
+    DecodeGridEdgeIndex(n, edgeIndex, points);
+    if (points[0].face < 0) {
+        return ErrorCode_ArgumentOutOfRangeException;
+    }
+
+    return CollectGridEdgeSegments(n, points[0], points[1], outSegmentIndex);
+}
+
+FFI_PLUGIN_EXPORT GpsCoords CalculateGridVertexLatLng64(int n, int64_t vertexIndex) {
+    if (!IsValidGridTopologyN(n)) {
+        return (GpsCoords) {0, 0};
+    }
+    const FaceGridPoint p = DecodeGridVertexIndex(n, vertexIndex);
+    if (p.face < 0) {
+        return (GpsCoords) {0, 0};
+    }
+    return CalculateLatLng(CalculateFaceGridPosition(n, p));
+}
+
+// 세그먼트 집합의 경계
+//
+// 집합 안 세그먼트의 모서리 중 건너편 이웃이 집합 밖인 것이 경계다. 세그먼트의 꼭짓점을 바깥에서 볼 때 반시계 방향으로
+// 돌며 모서리에 방향을 주면, 경계 모서리를 이어 붙인 고리는 영역을 항상 왼쪽에 둔다.
+
+struct SegmentRegionBoundary {
+    int n;
+    int64_t loopCount;
+    int64_t vertexCount;
+    // loopCount + 1개
+    int64_t *loopOffsets;
+    int64_t *vertexIndex;
+};
+
+// 격자 정점 번호를 int64_t 값에 대응시키는 해시 표. 선형 탐사 방식이며 빈 칸은 키 -1로 표시한다.
+// 넣을 수를 미리 알고 잡으므로 키우지 않는다.
+typedef struct {
+    int64_t key;
+    int64_t value;
+} GridIdMapSlot;
+
+typedef struct {
+    GridIdMapSlot *slots;
+    uint64_t mask;
+} GridIdMap;
+
+static int InitGridIdMap(GridIdMap *map, int64_t expectedCount) {
+    uint64_t capacity = 16;
+    while (capacity < (uint64_t) expectedCount * 2) {
+        capacity <<= 1;
+    }
+
+    map->slots = malloc(sizeof(GridIdMapSlot) * capacity);
+    map->mask = capacity - 1;
+    if (map->slots == NULL) {
+        return ErrorCode_OutOfMemory;
+    }
+    for (uint64_t i = 0; i < capacity; i++) {
+        map->slots[i].key = -1;
+    }
+    return ErrorCode_None;
+}
+
+static void FreeGridIdMap(GridIdMap *map) {
+    free(map->slots);
+    map->slots = NULL;
+}
+
+// key의 값 칸. 없으면 initialValue로 새로 만든다.
+static int64_t *FindOrInsertGridIdMap(GridIdMap *map, int64_t key, int64_t initialValue) {
+    uint64_t slot = ((uint64_t) key * 0x9E3779B97F4A7C15ULL) >> 17 & map->mask;
+    while (map->slots[slot].key != key) {
+        if (map->slots[slot].key == -1) {
+            map->slots[slot] = (GridIdMapSlot) {key, initialValue};
+            break;
+        }
+        slot = (slot + 1) & map->mask;
+    }
+    return &map->slots[slot].value;
+}
+
+typedef struct {
+    int64_t from;
+    int64_t to;
+    // 같은 시작 정점에서 나가는 다음 경계 모서리 (-1이면 끝)
+    int64_t next;
+} RegionEdge;
+
+typedef struct {
+    RegionEdge *edges;
+    int64_t count;
+    int64_t capacity;
+} RegionEdgeList;
+
+typedef struct {
+    int64_t *values;
+    int64_t count;
+    int64_t capacity;
+} Int64Vector;
+
+static int PushInt64Vector(Int64Vector *vector, int64_t value) {
+    if (vector->count == vector->capacity) {
+        const int64_t capacity = vector->capacity > 0 ? vector->capacity * 2 : 64;
+        int64_t *grown = realloc(vector->values, sizeof(int64_t) * capacity);
+        if (grown == NULL) {
+            return ErrorCode_OutOfMemory;
+        }
+        vector->values = grown;
+        vector->capacity = capacity;
+    }
+    vector->values[vector->count++] = value;
+    return ErrorCode_None;
+}
+
+static int PushRegionEdge(RegionEdgeList *list, RegionEdge edge) {
+    if (list->count == list->capacity) {
+        const int64_t capacity = list->capacity > 0 ? list->capacity * 2 : 64;
+        RegionEdge *grown = realloc(list->edges, sizeof(RegionEdge) * capacity);
+        if (grown == NULL) {
+            return ErrorCode_OutOfMemory;
+        }
+        list->edges = grown;
+        list->capacity = capacity;
+    }
+    list->edges[list->count++] = edge;
+    return ErrorCode_None;
+}
+
+// 세그먼트의 모서리 c(꼭짓점 c와 (c + 1) % 3을 잇는다) 건너편 이웃. 면 안에서는 ABT 좌표로 바로 구하고, 면 경계의
+// 모서리는 그 모서리를 공유하는 두 세그먼트 중 다른 하나다.
+static int64_t GetSegmentAcrossEdge(int n, int64_t segmentIndex, SegGroupAndAbt segGroupAndAbt,
+                                    const FaceGridPoint *points, int c) {
+    const int a = segGroupAndAbt.abt.a;
+    const int b = segGroupAndAbt.abt.b;
+    AbtCoords across;
+    if (segGroupAndAbt.abt.t == Parallelogram_Top) {
+        // 위 삼각형의 건너편은 항상 같은 면의 아래 삼각형이다.
+        across = (AbtCoords) {a + (c == 0), b + (c == 2), Parallelogram_Bottom};
+    } else {
+        across = (AbtCoords) {a - (c == 2), b - (c == 0), Parallelogram_Top};
+        if (across.a < 0 || across.b < 0 || (int64_t) across.a + across.b > n - 2) {
+            int64_t sides[2];
+            CollectGridEdgeSegments(n, points[c], points[(c + 1) % 3], sides);
+            return sides[0] == segmentIndex ? sides[1] : sides[0];
+        }
+    }
+    return CalculateSegmentCountPerGroup64(n) * segGroupAndAbt.segGroup + ConvertToLocalSegmentIndex2(n, across);
+}
+
+// 집합 안 세그먼트마다 건너편 이웃이 집합 밖인 모서리를 방향을 붙여 모은다. 나온 순서대로 쓴다.
+static int CollectRegionEdges(int n, int64_t count, const int64_t *segmentIndex, RegionEdgeList *edges) {
+    // 중복을 뺀 세그먼트를 나온 순서대로 모은다.
+    SegmentIndexSet set;
+    int64_t *unique = malloc(sizeof(int64_t) * (count > 0 ? count : 1));
+    if (unique == NULL || InitSegmentIndexSet(&set, count) != ErrorCode_None) {
+        free(unique);
+        return ErrorCode_OutOfMemory;
+    }
+    const int64_t segmentCount = CalculateSegmentCountPerGroup64(n) * GroupCount;
+    int64_t uniqueCount = 0;
+    int result = ErrorCode_None;
+    for (int64_t s = 0; s < count && result == ErrorCode_None; s++) {
+        if (segmentIndex[s] < 0 || segmentIndex[s] >= segmentCount) {
+            result = ErrorCode_ArgumentOutOfRangeException;
+        } else if (InsertSegmentIndexSet(&set, (uint64_t) segmentIndex[s])) {
+            unique[uniqueCount++] = segmentIndex[s];
+        }
+    }
+
+    for (int64_t s = 0; s < uniqueCount && result == ErrorCode_None; s++) {
+        const SegGroupAndAbt segGroupAndAbt = SplitSegIndexToSegGroupAndAbt64(n, unique[s]);
+        FaceGridPoint points[3];
+        GetAbtGridPoints(segGroupAndAbt, points);
+        // 아래 삼각형의 꼭짓점 순서는 반시계 방향, 위 삼각형은 시계 방향이다.
+        const int top = segGroupAndAbt.abt.t == Parallelogram_Top;
+        for (int c = 0; c < 3 && result == ErrorCode_None; c++) {
+            const int64_t across = GetSegmentAcrossEdge(n, unique[s], segGroupAndAbt, points, c);
+            if (ContainsSegmentIndexSet(&set, (uint64_t) across)) {
+                continue;
+            }
+            const FaceGridPoint from = points[top ? (c + 1) % 3 : c];
+            const FaceGridPoint to = points[top ? c : (c + 1) % 3];
+            result = PushRegionEdge(edges, (RegionEdge) {
+                    .from = CalculateFaceGridVertexId(n, from.face, from.i, from.j),
+                    .to = CalculateFaceGridVertexId(n, to.face, to.i, to.j),
+                    .next = -1,
+            });
+        }
+    }
+    free(unique);
+    FreeSegmentIndexSet(&set);
+    return result;
+}
+
+// 경계 모서리를 따라가며 고리를 만든다. 영역이 한 점에서만 맞닿아 같은 정점을 두 번 지나게 되면 그 자리에서 고리를
+// 잘라 내므로, 모든 고리는 같은 정점을 한 번만 지난다. 모든 정점에서 들어오는 경계 모서리와 나가는 경계 모서리의 수가
+// 같으므로 걸음은 항상 이어진다.
+static int TraceRegionLoops(const RegionEdgeList *edges, GridIdMap *heads, GridIdMap *pathPositions,
+                            Int64Vector *loopOffsets, Int64Vector *vertices) {
+    Int64Vector path = {NULL, 0, 0};
+    int result = PushInt64Vector(loopOffsets, 0);
+    for (int64_t first = 0; first < edges->count && result == ErrorCode_None; first++) {
+        int64_t current = edges->edges[first].from;
+        if (*FindOrInsertGridIdMap(heads, current, -1) == -1) {
+            continue;
+        }
+
+        path.count = 0;
+        result = PushInt64Vector(&path, current);
+        *FindOrInsertGridIdMap(pathPositions, current, -1) = 0;
+        while (result == ErrorCode_None) {
+            int64_t *head = FindOrInsertGridIdMap(heads, current, -1);
+            if (*head == -1) {
+                // 시작 정점으로 돌아와 더 나갈 모서리가 없다.
+                *FindOrInsertGridIdMap(pathPositions, current, -1) = -1;
+                break;
+            }
+            const RegionEdge *edge = &edges->edges[*head];
+            *head = edge->next;
+            current = edge->to;
+
+            int64_t *position = FindOrInsertGridIdMap(pathPositions, current, -1);
+            if (*position < 0) {
+                *position = path.count;
+                result = PushInt64Vector(&path, current);
+                continue;
+            }
+
+            // path[*position ..]가 닫힌 고리다. current는 경로에 남긴다.
+            const int64_t start = *position;
+            for (int64_t i = start; i < path.count && result == ErrorCode_None; i++) {
+                result = PushInt64Vector(vertices, path.values[i]);
+                if (i > start) {
+                    *FindOrInsertGridIdMap(pathPositions, path.values[i], -1) = -1;
+                }
+            }
+            if (result == ErrorCode_None) {
+                result = PushInt64Vector(loopOffsets, vertices->count);
+            }
+            path.count = start + 1;
+        }
+    }
+    free(path.values);
+    return result;
+}
+
+FFI_PLUGIN_EXPORT void DestroySegmentRegionBoundary(SegmentRegionBoundary *boundary) {
+    if (boundary == NULL) {
+        return;
+    }
+
+    free(boundary->loopOffsets);
+    free(boundary->vertexIndex);
+    free(boundary);
+}
+
+// 세그먼트 집합(중복 허용)의 경계를 닫힌 고리들로 만든다. 입력 수에 비례하는 시간이 든다.
+// 입력이 잘못되었거나 메모리가 부족하면 NULL을 반환한다.
+FFI_PLUGIN_EXPORT SegmentRegionBoundary *ExtractSegmentRegionBoundary(int n, int64_t count,
+                                                                      const int64_t *segmentIndex) {
+    if (!IsValidGridTopologyN(n) || count < 0 || (count > 0 && segmentIndex == NULL)) {
+        return NULL;
+    }
+
+    SegmentRegionBoundary *boundary = calloc(1, sizeof(SegmentRegionBoundary));
+    RegionEdgeList edges = {NULL, 0, 0};
+    GridIdMap heads = {NULL, 0};
+    GridIdMap pathPositions = {NULL, 0};
+    Int64Vector loopOffsets = {NULL, 0, 0};
+    Int64Vector vertices = {NULL, 0, 0};
+    int result = boundary == NULL ? ErrorCode_OutOfMemory : CollectRegionEdges(n, count, segmentIndex, &edges);
+    if (result == ErrorCode_None) {
+        result = InitGridIdMap(&heads, edges.count);
+    }
+    if (result == ErrorCode_None) {
+        result = InitGridIdMap(&pathPositions, edges.count);
+    }
+
+    // 시작 정점마다 나가는 경계 모서리를 연결 리스트로 묶는다. 나온 순서를 지키도록 뒤에서부터 앞에 붙인다.
+    if (result == ErrorCode_None) {
+        for (int64_t e = edges.count - 1; e >= 0; e--) {
+            int64_t *head = FindOrInsertGridIdMap(&heads, edges.edges[e].from, -1);
+            edges.edges[e].next = *head;
+            *head = e;
+        }
+        result = TraceRegionLoops(&edges, &heads, &pathPositions, &loopOffsets, &vertices);
+    }
+    free(edges.edges);
+    FreeGridIdMap(&heads);
+    FreeGridIdMap(&pathPositions);
+
+    if (result != ErrorCode_None) {
+        free(loopOffsets.values);
+        free(vertices.values);
+        free(boundary);
+        return NULL;
+    }
+    boundary->n = n;
+    boundary->loopCount = loopOffsets.count - 1;
+    boundary->vertexCount = vertices.count;
+    boundary->loopOffsets = loopOffsets.values;
+    boundary->vertexIndex = vertices.values;
+    return boundary;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentRegionBoundaryLoopCount(const SegmentRegionBoundary *boundary) {
+    return boundary == NULL ? ErrorCode_Argument_NullPtr : boundary->loopCount;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentRegionBoundaryVertexCount(const SegmentRegionBoundary *boundary) {
+    return boundary == NULL ? ErrorCode_Argument_NullPtr : boundary->vertexCount;
+}
+
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentRegionBoundaryLoopOffsets(const SegmentRegionBoundary *boundary) {
+    return boundary == NULL ? NULL : boundary->loopOffsets;
+}
+
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentRegionBoundaryVertexIndices(const SegmentRegionBoundary *boundary) {
+    return boundary == NULL ? NULL : boundary->vertexIndex;
+}
+
+FFI_PLUGIN_EXPORT int64_t GetSegmentRegionBoundaryPoints(const SegmentRegionBoundary *boundary, GpsCoords *outLatLng,
+                                                         Vector3 *outPosition, int64_t outCapacity) {
+    if (boundary == NULL) {
+        return ErrorCode_Argument_NullPtr;
+    }
+    if (outLatLng == NULL && outPosition == NULL) {
+        return boundary->vertexCount;
+    }
+    if (outCapacity < boundary->vertexCount) {
+        return ErrorCode_BufferTooSmall;
+    }
+
+    for (int64_t i = 0; i < boundary->vertexCount; i++) {
+        const Vector3 position = CalculateFaceGridPosition(boundary->n,
+                                                           DecodeGridVertexIndex(boundary->n, boundary->vertexIndex[i]));
+        if (outPosition != NULL) {
+            outPosition[i] = position;
+        }
+        if (outLatLng != NULL) {
+            outLatLng[i] = CalculateLatLng(position);
+        }
+    }
+    return boundary->vertexCount;
+}
@@ -35,6 +35,18 @@ typedef struct
     int localSegIndex;
 } SegGroupAndLocalSegIndex;
 
+typedef struct
+{
+    int64_t neighborSegId[12];
+    int count;
+} NeighborSegIdList64;
+
+typedef struct
+{
+    int segGroup;
+    int64_t localSegIndex;
+} SegGroupAndLocalSegIndex64;
+
 typedef struct {
     double lat;
     double lng;
@@ -45,6 +57,64 @@ typedef struct
     GpsCoords points[3];
 } SegmentCornersInLatLng;
 
+typedef enum {
+    ErrorCode_None,
+    ErrorCode_LogicError_NoIntersection = -1,
+    ErrorCode_NullPtr = -2,
+    ErrorCode_Argument_NullPtr = -3,
+    ErrorCode_ArgumentOutOfRangeException = -4,
+    ErrorCode_BufferTooSmall = -5,
+    ErrorCode_OutOfMemory = -6,
+    ErrorCode_IoError = -7,
+} ErrorCode;
+
+// How segment center/corner positions are converted to lat/lng. See CreateGeocodingContextWithPrecision().
+typedef enum {
+    // libm atan2 (correctly rounded to within an ulp or so).
+    LatLngPrecision_Exact,
+    // Polynomial atan2 approximation. Max error is about 1e-11 rad (< 0.1 mm on Earth).
+    LatLngPrecision_Fast,
+} LatLngPrecision;
+
+// Which segments GetSegmentIndicesInPolygon() and GetSegmentIndicesInLatLngBox() return.
+typedef enum {
+    // Segments whose center lies inside the polygon.
+    PolygonFillMode_Center,
+    // Segments that overlap the polygon at all, including ones its boundary only touches.
+    PolygonFillMode_Overlap,
+} PolygonFillMode;
+
+// Which segments GetSegmentIndicesInCap() returns.
+typedef enum {
+    // Segments whose center lies inside the cap.
+    CapQueryMode_Exact,
+    // Segments that overlap the cap at all.
+    CapQueryMode_Conservative,
+} CapQueryMode;
+
+// Per-n precomputed tables. Create once with CreateGeocodingContext() and pass to the *WithContext functions.
+typedef struct GeocodingContext GeocodingContext;
+
+// A memory-mapped adjacency table file. Open with OpenAdjacencyTable() and release with CloseAdjacencyTable().
+typedef struct AdjacencyTable AdjacencyTable;
+
+// Worker threads with per-worker task queues and work stealing. See CreateThreadPool().
+typedef struct ThreadPool ThreadPool;
+
+// Per-segment point counts and weight sums from AggregatePointsBySegment(). Release with DestroySegmentAggregation().
+typedef struct SegmentAggregation SegmentAggregation;
+
+// Outline of a segment set from ExtractSegmentRegionBoundary(). Release with DestroySegmentRegionBoundary().
+typedef struct SegmentRegionBoundary SegmentRegionBoundary;
+
+typedef struct {
+    // Points assigned to the thread, and how many of them could not be geocoded (e.g. NaN coordinates).
+    int64_t pointCount;
+    int64_t skippedCount;
+    // Wall time the thread spent geocoding and accumulating.
+    double seconds;
+} AggregationThreadStats;
+
 // A very short-lived native function.
 //
 // For very short-lived functions, it is fine to call them on the main isolate.
@@ -53,14 +123,299 @@ typedef struct
 FFI_PLUGIN_EXPORT intptr_t sum(intptr_t a, intptr_t b);
 
 FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLng(int n, double lat, double lng);
+// Geocodes `count` points given as separate lat/lng arrays (radians) into `outSegmentIndex`.
+// A point that cannot be geocoded gets its (negative) ErrorCode in place of the segment index.
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLngBatch(ThreadPool *pool, int n, int count, const double *lat,
+                                                           const double *lng, int *outSegmentIndex);
+// Center of a segment as lat/lng (radians), computed with a single decode.
+FFI_PLUGIN_EXPORT GpsCoords CalculateSegmentCenterLatLng(int n, int segmentIndex);
+// Centers of `count` segments. Either output may be NULL; each segment is decoded once for both.
+FFI_PLUGIN_EXPORT int CalculateSegmentCenterBatch(ThreadPool *pool, int n, int count, const int *segmentIndex,
+                                                  GpsCoords *outLatLng, Vector3 *outCenter);
 FFI_PLUGIN_EXPORT double CalculateSegmentCenterLat(int n, int segmentIndex);
 FFI_PLUGIN_EXPORT double CalculateSegmentCenterLng(int n, int segmentIndex);
 FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenter(int n, int segmentIndex);
 FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsOfSegmentIndex(int n, int segmentIndex);
+// Neighbors of `count` segments in CSR form: the neighbors of segmentIndex[i] are
+// outNeighbors[outOffsets[i]] .. outNeighbors[outOffsets[i + 1] - 1], and outOffsets has count + 1 entries.
+// With `dedupe` set, each neighbor appears once in the whole output, in the row of the first segment that has it.
+// Returns the number of neighbors written, or the number needed when outNeighbors is NULL (outOffsets may then
+// also be NULL). Returns ErrorCode_BufferTooSmall if outNeighborsCapacity is exceeded; 12 * count always suffices.
+FFI_PLUGIN_EXPORT int GetNeighborsOfSegmentIndexCsr(ThreadPool *pool, int n, int count, const int *segmentIndex,
+                                                    int dedupe, int *outOffsets, int *outNeighbors,
+                                                    int outNeighborsCapacity);
+// Segments within k neighbor hops of segmentIndex (a filled disk, the center included), in ascending index order
+// (unsigned, for the 32-bit form).
+// The hollow ring is the segments exactly k hops away. Both return the number written, or the number needed when
+// outSegmentIndex is NULL, and ErrorCode_BufferTooSmall if outCapacity is exceeded. A k-ring that does not reach an
+// icosahedron vertex has 6k^2 + 6k + 1 segments (a hollow ring 12k); one that does has fewer.
+FFI_PLUGIN_EXPORT int GetKRingOfSegmentIndex(int n, int segmentIndex, int k, int *outSegmentIndex, int outCapacity);
+FFI_PLUGIN_EXPORT int GetHollowRingOfSegmentIndex(int n, int segmentIndex, int k, int *outSegmentIndex,
+                                                  int outCapacity);
+// Segments covering a spherical polygon, in ascending index order (unsigned, for the 32-bit form). The polygon is
+// ringCount rings of lat/lng vertices (radians) stored back to back in `vertices`, ringVertexCounts[r] each: ring 0
+// is the outer boundary and the rest are holes. Edges are great-circle arcs; each ring must fit in a hemisphere.
+// `mode` is a PolygonFillMode. Output is resumable: start with *cursor = 0. When outCapacity runs out, *cursor is
+// set to where the next call continues; it becomes -1 once everything has been written. Returns the number
+// written by this call. With outSegmentIndex NULL, returns the number remaining from *cursor and leaves it as is.
+FFI_PLUGIN_EXPORT int GetSegmentIndicesInPolygon(int n, const GpsCoords *vertices, const int *ringVertexCounts,
+                                                 int ringCount, int mode, int64_t *cursor, int *outSegmentIndex,
+                                                 int outCapacity);
+// Segments in the spherical cap around lat/lng (radians) with the given angular radius (radians; for a distance on
+// Earth, divide it by the Earth radius), in ascending index order (unsigned, for the 32-bit form). `mode` is a
+// CapQueryMode. Returns the number written, or the number needed when outSegmentIndex is NULL, and
+// ErrorCode_BufferTooSmall if outCapacity is exceeded.
+FFI_PLUGIN_EXPORT int GetSegmentIndicesInCap(int n, double lat, double lng, double radius, int mode,
+                                             int *outSegmentIndex, int outCapacity);
+// Segments covering a lat/lng bounding box (radians), streamed face by face in row order, which is ascending index
+// order (unsigned, for the 32-bit form). minLng > maxLng means the box crosses the antimeridian; minLng = -pi with
+// maxLng = pi covers every longitude, and a box reaching +-pi/2 includes the pole. `mode` is a PolygonFillMode.
+// Output is resumable the same way as GetSegmentIndicesInPolygon(), and the query itself only keeps a few face
+// constants, so a viewport of any size can be drained through a fixed-size buffer.
+FFI_PLUGIN_EXPORT int GetSegmentIndicesInLatLngBox(int n, double minLat, double minLng, double maxLat, double maxLng,
+                                                   int mode, int64_t *cursor, int *outSegmentIndex, int outCapacity);
+// Parent/child mapping between the n grid and the k * n grid, in integer arithmetic. Both grids subdivide the same
+// faces, so each segment of the n grid is split into exactly k^2 segments of the k * n grid.
+// GetParentSegmentIndex() takes a segment of the k * n grid and returns the n-grid segment that contains it, or a
+// negative ErrorCode. In the batch form, an invalid index gets its ErrorCode in place of the parent.
+FFI_PLUGIN_EXPORT int GetParentSegmentIndex(int n, int k, int segmentIndex);
+FFI_PLUGIN_EXPORT int GetParentSegmentIndexBatch(ThreadPool *pool, int n, int k, int count, const int *segmentIndex,
+                                                 int *outParent);
+// The k^2 segments of the k * n grid that make up segment segmentIndex of the n grid, in ascending index order
+// (unsigned, for the 32-bit form). The batch form writes k^2 children per input, in input order. Returns the number
+// written, or the number needed when outSegmentIndex is NULL, and ErrorCode_BufferTooSmall if outCapacity is
+// exceeded. The 32-bit forms need k * n <= 14654.
+FFI_PLUGIN_EXPORT int GetChildSegmentIndices(int n, int k, int segmentIndex, int *outSegmentIndex, int outCapacity);
+FFI_PLUGIN_EXPORT int GetChildSegmentIndicesBatch(ThreadPool *pool, int n, int k, int count, const int *segmentIndex,
+                                                  int *outSegmentIndex, int outCapacity);
 FFI_PLUGIN_EXPORT int ConvertToSegmentIndex2(int n, int segmentGroupIndex, int localSegmentIndex);
 FFI_PLUGIN_EXPORT SegGroupAndLocalSegIndex SplitSegIndexToSegGroupAndLocalSegmentIndex(int n, int segmentIndex);
 FFI_PLUGIN_EXPORT SegmentCornersInLatLng CalculateSegmentCornersInLatLng(int n, int segmentIndex);
 
+// Returns NULL if n is out of range. Release with DestroyGeocodingContext().
+// The *WithContext center/corner lat/lng functions use the context's LatLngPrecision (`precision`, which is fixed at
+// creation, so a context can be shared between threads); every function without a context uses LatLngPrecision_Exact.
+FFI_PLUGIN_EXPORT GeocodingContext *CreateGeocodingContext(int n);
+FFI_PLUGIN_EXPORT GeocodingContext *CreateGeocodingContextWithPrecision(int n, int precision);
+FFI_PLUGIN_EXPORT void DestroyGeocodingContext(GeocodingContext *context);
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLngWithContext(const GeocodingContext *context, double lat, double lng);
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLngBatchWithContext(const GeocodingContext *context, ThreadPool *pool,
+                                                                      int count, const double *lat, const double *lng,
+                                                                      int *outSegmentIndex);
+FFI_PLUGIN_EXPORT GpsCoords CalculateSegmentCenterLatLngWithContext(const GeocodingContext *context, int segmentIndex);
+FFI_PLUGIN_EXPORT int CalculateSegmentCenterBatchWithContext(const GeocodingContext *context, ThreadPool *pool,
+                                                             int count, const int *segmentIndex, GpsCoords *outLatLng,
+                                                             Vector3 *outCenter);
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLatWithContext(const GeocodingContext *context, int segmentIndex);
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLngWithContext(const GeocodingContext *context, int segmentIndex);
+FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenterWithContext(const GeocodingContext *context, int segmentIndex);
+FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsOfSegmentIndexWithContext(const GeocodingContext *context,
+                                                                          int segmentIndex);
+FFI_PLUGIN_EXPORT int ConvertToSegmentIndex2WithContext(const GeocodingContext *context, int segmentGroupIndex,
+                                                        int localSegmentIndex);
+FFI_PLUGIN_EXPORT SegGroupAndLocalSegIndex
+SplitSegIndexToSegGroupAndLocalSegmentIndexWithContext(const GeocodingContext *context, int segmentIndex);
+FFI_PLUGIN_EXPORT SegmentCornersInLatLng CalculateSegmentCornersInLatLngWithContext(const GeocodingContext *context,
+                                                                                    int segmentIndex);
+
+// 64-bit segment indices, for n beyond the 32-bit limit (20 * n * n <= 2^32, i.e. n <= 14654).
+// n may go up to 2^20 (1048576), about 7 m segments on the Earth. The numbering is the same as the 32-bit
+// functions, so wherever a 32-bit index is valid both return the same value. Invalid input yields a negative
+// index, or zeroed results. Up to n = 14654 both use the original 7-digit icosahedron tables, so stored ids
+// keep their meaning; larger n geocode and place centers and corners on one exact icosahedron.
+FFI_PLUGIN_EXPORT int64_t CalculateSegmentIndexFromLatLng64(int n, double lat, double lng);
+FFI_PLUGIN_EXPORT int CalculateSegmentIndexFromLatLngBatch64(ThreadPool *pool, int n, int count, const double *lat,
+                                                             const double *lng, int64_t *outSegmentIndex);
+FFI_PLUGIN_EXPORT GpsCoords CalculateSegmentCenterLatLng64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLat64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT double CalculateSegmentCenterLng64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT Vector3 CalculateSegmentCenter64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT int CalculateSegmentCenterBatch64(ThreadPool *pool, int n, int count, const int64_t *segmentIndex,
+                                                    GpsCoords *outLatLng, Vector3 *outCenter);
+FFI_PLUGIN_EXPORT NeighborSegIdList64 GetNeighborsOfSegmentIndex64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT int GetNeighborsOfSegmentIndexBatch64(ThreadPool *pool, int n, int count, const int64_t *segmentIndex,
+                                                        NeighborSegIdList64 *outNeighbors);
+FFI_PLUGIN_EXPORT int64_t GetNeighborsOfSegmentIndexCsr64(ThreadPool *pool, int n, int count,
+                                                          const int64_t *segmentIndex, int dedupe, int64_t *outOffsets,
+                                                          int64_t *outNeighbors, int64_t outNeighborsCapacity);
+FFI_PLUGIN_EXPORT int64_t GetKRingOfSegmentIndex64(int n, int64_t segmentIndex, int k, int64_t *outSegmentIndex,
+                                                   int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t GetHollowRingOfSegmentIndex64(int n, int64_t segmentIndex, int k, int64_t *outSegmentIndex,
+                                                        int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t GetSegmentIndicesInPolygon64(int n, const GpsCoords *vertices, const int *ringVertexCounts,
+                                                       int ringCount, int mode, int64_t *cursor,
+                                                       int64_t *outSegmentIndex, int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t GetSegmentIndicesInCap64(int n, double lat, double lng, double radius, int mode,
+                                                   int64_t *outSegmentIndex, int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t GetSegmentIndicesInLatLngBox64(int n, double minLat, double minLng, double maxLat,
+                                                         double maxLng, int mode, int64_t *cursor,
+                                                         int64_t *outSegmentIndex, int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t GetParentSegmentIndex64(int n, int k, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT int GetParentSegmentIndexBatch64(ThreadPool *pool, int n, int k, int count,
+                                                   const int64_t *segmentIndex, int64_t *outParent);
+FFI_PLUGIN_EXPORT int64_t GetChildSegmentIndices64(int n, int k, int64_t segmentIndex, int64_t *outSegmentIndex,
+                                                   int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t GetChildSegmentIndicesBatch64(ThreadPool *pool, int n, int k, int count,
+                                                        const int64_t *segmentIndex, int64_t *outSegmentIndex,
+                                                        int64_t outCapacity);
+FFI_PLUGIN_EXPORT int64_t ConvertToSegmentIndex64(int n, int segmentGroupIndex, int64_t localSegmentIndex);
+FFI_PLUGIN_EXPORT SegGroupAndLocalSegIndex64 SplitSegIndexToSegGroupAndLocalSegmentIndex64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT SegmentCornersInLatLng CalculateSegmentCornersInLatLng64(int n, int64_t segmentIndex);
+FFI_PLUGIN_EXPORT int CalculateSegmentCornersInLatLngBatch64(ThreadPool *pool, int n, int count,
+                                                             const int64_t *segmentIndex,
+                                                             SegmentCornersInLatLng *outCorners);
+
+// A set of segments at the finest of several nested resolutions levelN[0] < ... < levelN[L-1] (each a multiple of
+// the previous), stored as the fewest cells: every coarse cell whose (n_{i+1} / n_i)^2 children are all present
+// replaces them. The encoding is self-describing and byte-order independent: a version byte, the levels, then per
+// level the cell count, the body length, a block index (first cell and body offset of every 128 cells, 8-byte
+// little-endian each) and the body (the other cells, delta-coded as LEB128 varints).
+// CompactSegmentIndices64() takes ascending, unique indices at levelN[L-1] and returns the encoded size; with
+// out == NULL it only measures. The readers return ErrorCode_ArgumentOutOfRangeException for malformed input.
+FFI_PLUGIN_EXPORT int64_t CompactSegmentIndices64(const int *levelN, int levelCount, const int64_t *segmentIndex,
+                                                  int64_t count, uint8_t *out, int64_t outCapacity);
+// The stored cells, coarsest level first, each level ascending. With outN == NULL returns only the count.
+FFI_PLUGIN_EXPORT int64_t GetCompactSegmentCells64(const uint8_t *encoded, int64_t encodedSize, int *outN,
+                                                   int64_t *outSegmentIndex, int64_t outCapacity);
+// The original set at the finest level, ascending. With outSegmentIndex == NULL returns only the count.
+FFI_PLUGIN_EXPORT int64_t UncompactSegmentIndices64(const uint8_t *encoded, int64_t encodedSize,
+                                                    int64_t *outSegmentIndex, int64_t outCapacity);
+// 1 if the finest-level segment is in the set, 0 if not. Binary-searches each level's block index and decodes one
+// block, without expanding the set.
+FFI_PLUGIN_EXPORT int IsSegmentInCompactSet64(const uint8_t *encoded, int64_t encodedSize, int64_t segmentIndex);
+
+// Precomputed adjacency for a fixed n, stored as 12 fixed slots per segment, 2, 4 or 8 bytes wide (the narrowest
+// that fits 20 * n * n), unused slots all ones. WriteAdjacencyTableFile() generates the file;
+// OpenAdjacencyTable() maps it read-only so opening is immediate and processes share the page cache. Slots are
+// little-endian on every host. A lookup reads 12 slots; it is about 2x faster than GetNeighborsOfSegmentIndex64()
+// when the table fits in cache (n <= 64) or when segments are visited in index order, but about 2x slower for
+// random access to a table larger than cache (n >= 256).
+FFI_PLUGIN_EXPORT int WriteAdjacencyTableFile(int n, const char *path);
+// Returns NULL if the file is missing or not a valid adjacency table.
+FFI_PLUGIN_EXPORT AdjacencyTable *OpenAdjacencyTable(const char *path);
+FFI_PLUGIN_EXPORT void CloseAdjacencyTable(AdjacencyTable *table);
+FFI_PLUGIN_EXPORT int GetAdjacencyTableN(const AdjacencyTable *table);
+FFI_PLUGIN_EXPORT int GetAdjacencyTableSlotWidth(const AdjacencyTable *table);
+// The mapped slot array: the neighbors of segment s are slots s * 12 .. s * 12 + 11.
+FFI_PLUGIN_EXPORT const void *GetAdjacencyTableSlots(const AdjacencyTable *table);
+// Same neighbors, in the same order, as GetNeighborsOfSegmentIndex(). The 32-bit form needs a table with n <= 14654.
+FFI_PLUGIN_EXPORT NeighborSegIdList GetNeighborsFromAdjacencyTable(const AdjacencyTable *table, int segmentIndex);
+FFI_PLUGIN_EXPORT NeighborSegIdList64 GetNeighborsFromAdjacencyTable64(const AdjacencyTable *table,
+                                                                       int64_t segmentIndex);
+
+// A pool of threadCount workers (<= 0: one per processor), each with its own task queue; idle workers steal from
+// the others. Create it once and reuse it. DestroyThreadPool() finishes queued work and joins the workers; call it
+// only after every batch call that was given the pool has returned.
+// The *Batch* functions, and the CSR neighbor query without dedupe, take the pool as their first argument (after
+// the context, for the *WithContext forms). With a pool they split large inputs into chunks and run them on it;
+// NULL runs everything on the calling thread. Output is identical either way: every chunk writes its own fixed
+// range, and the calling thread helps until its call is done. Several threads may run batch calls on the same pool
+// at once. The CSR query runs on the pool only when outNeighborsCapacity >= 12 * count, and then uses that whole
+// buffer as scratch space.
+FFI_PLUGIN_EXPORT ThreadPool *CreateThreadPool(int threadCount);
+FFI_PLUGIN_EXPORT void DestroyThreadPool(ThreadPool *pool);
+FFI_PLUGIN_EXPORT int GetThreadPoolThreadCount(const ThreadPool *pool);
+
+// Geocodes count points on threadCount threads (<= 0: one per processor) and accumulates, per segment, the number
+// of points and the sum of each weight column (weights[c][i] is column c of point i; weights may be NULL when
+// weightCount is 0). Each thread takes a contiguous slice of the points and fills private histograms, one per
+// sixteenth of each face's index range, allocated on first use: dense arrays while one face fits in 64 KiB and hash
+// tables above that. The slices are then merged and copied into the result in parallel, so the merge scales even
+// when the points fall on one face. Sums are added in thread order, so a given input and thread count always gives
+// the same bits.
+// Points that cannot be geocoded are skipped and counted in the thread stats. Returns NULL for invalid arguments
+// or when out of memory. Blocks until done; call it off the main isolate.
+FFI_PLUGIN_EXPORT SegmentAggregation *AggregatePointsBySegment(int n, int64_t count, const double *lat,
+                                                               const double *lng, const double *const *weights,
+                                                               int weightCount, int threadCount);
+FFI_PLUGIN_EXPORT void DestroySegmentAggregation(SegmentAggregation *aggregation);
+// Number of distinct segments that received at least one point.
+FFI_PLUGIN_EXPORT int64_t GetSegmentAggregationSegmentCount(const SegmentAggregation *aggregation);
+// Parallel arrays of GetSegmentAggregationSegmentCount() entries, in ascending segment index order.
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentAggregationSegmentIndices(const SegmentAggregation *aggregation);
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentAggregationCounts(const SegmentAggregation *aggregation);
+// NULL if weightColumn is out of range.
+FFI_PLUGIN_EXPORT const double *GetSegmentAggregationSums(const SegmentAggregation *aggregation, int weightColumn);
+// Threads actually used (never more than the point count).
+FFI_PLUGIN_EXPORT int GetSegmentAggregationThreadCount(const SegmentAggregation *aggregation);
+FFI_PLUGIN_EXPORT AggregationThreadStats GetSegmentAggregationThreadStats(const SegmentAggregation *aggregation,
+                                                                          int threadIndex);
+// Wall time of the merge step.
+FFI_PLUGIN_EXPORT double GetSegmentAggregationMergeSeconds(const SegmentAggregation *aggregation);
+
+// Shared-vertex mesh of the whole grid for rendering, produced face by face so large n never has to be in memory at
+// once. Vertices are numbered 0 .. 10 * n * n + 1; each face owns a contiguous range starting at
+// GetGlobeMeshFaceVertexStart(n, face) (face == 20 gives the total), so concatenating the faces in order gives the
+// whole vertex buffer. The triangles of a face are its n * n segments in segment index order (segment
+// face * n * n + t is triangle t), as global vertex indices. Every triangle is wound the same way as the icosahedron
+// faces (counter-clockwise seen from outside); its first corner is CalculateSegmentCornersInLatLng()'s first, and the
+// other two are swapped for every second triangle to keep the winding. Needs n <= 14654.
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshVertexCount(int n);
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshFaceVertexStart(int n, int face);
+// Unit-sphere positions (x, y, z floats) of the vertices face owns, in vertex index order. outCapacity counts vertices.
+// Returns the number written, or the number needed when outPositions is NULL.
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshFaceVertices(int n, int face, float *outPositions, int64_t outCapacity);
+// Three vertex indices per triangle. outCapacity counts triangles. Returns n * n, the number written or needed.
+FFI_PLUGIN_EXPORT int64_t GetGlobeMeshFaceTriangles(int n, int face, uint32_t *outIndices, int64_t outCapacity);
+
+// Level-of-detail patches of the same mesh. A patch is a segment of a coarser grid patchN that divides n, so patchN = 1
+// gives the 20 faces, and each patch of patchN splits into the k^2 patches of k * patchN that
+// GetChildSegmentIndices(patchN, k, patchIndex) lists. GetParentSegmentIndex(patchN, n / patchN, segment) finds the
+// patch of a segment. Each patch is drawn as its own triangle grid of detailN (a divisor of n / patchN) per side, with
+// (detailN + 1)(detailN + 2) / 2 local vertices and detailN^2 triangles in the same winding as the globe mesh.
+// Positions are bit-identical to the globe mesh vertex at the same grid point, so patches of equal detail meet without
+// cracks. Vertices are in rows of the patch grid. outVertexIndex (optional) receives each vertex's index in the globe
+// mesh. Pass NULL for both outputs to get the count.
+FFI_PLUGIN_EXPORT int GetGlobePatchVertices(int n, int patchN, int patchIndex, int detailN, float *outPositions,
+                                            uint32_t *outVertexIndex, int outCapacity);
+// Local triangle indices, the same for every patch drawn at detailN. outCapacity counts triangles.
+FFI_PLUGIN_EXPORT int GetGlobePatchTriangles(int detailN, uint32_t *outIndices, int outCapacity);
+// The (n / patchN)^2 segments of a patch, in the order of its triangles at full detail (detailN = n / patchN), so a
+// pick on triangle t of that patch is segment outSegmentIndex[t].
+FFI_PLUGIN_EXPORT int GetGlobePatchSegmentIndices(int n, int patchN, int patchIndex, int *outSegmentIndex,
+                                                  int outCapacity);
+
+// Stable ids for the 10 * n * n + 2 grid vertices and 30 * n * n grid edges, computed with integer math from the
+// segment index, so they can key per-vertex or per-edge data (heights, borders, flows) across sessions. Vertex ids are
+// the globe mesh vertex indices above, extended to n <= 1048576. Edge ids are likewise grouped by face. Each call
+// returns the number of ids written, or a negative ErrorCode for an out-of-range n or id.
+FFI_PLUGIN_EXPORT int64_t GetGridVertexCount64(int n);
+FFI_PLUGIN_EXPORT int64_t GetGridEdgeCount64(int n);
+// The 3 corner vertices of a segment, in CalculateSegmentCornersInLatLng() order.
+FFI_PLUGIN_EXPORT int GetSegmentGridVertexIndices64(int n, int64_t segmentIndex, int64_t *outVertexIndex);
+// The 3 edges of a segment; edge c joins corner c and corner (c + 1) % 3.
+FFI_PLUGIN_EXPORT int GetSegmentGridEdgeIndices64(int n, int64_t segmentIndex, int64_t *outEdgeIndex);
+// The segments sharing a vertex, ascending. outSegmentIndex must hold 6; returns 5 at the 12 icosahedron corners.
+FFI_PLUGIN_EXPORT int GetGridVertexSegmentIndices64(int n, int64_t vertexIndex, int64_t *outSegmentIndex);
+// The 2 end vertices of an edge.
+FFI_PLUGIN_EXPORT int GetGridEdgeVertexIndices64(int n, int64_t edgeIndex, int64_t *outVertexIndex);
+// The 2 segments sharing an edge, ascending.
+FFI_PLUGIN_EXPORT int GetGridEdgeSegmentIndices64(int n, int64_t edgeIndex, int64_t *outSegmentIndex);
+// Position of a vertex. (0, 0) for an out-of-range n or id.
+FFI_PLUGIN_EXPORT GpsCoords CalculateGridVertexLatLng64(int n, int64_t vertexIndex);
+
+// Outline of a set of segments (duplicates allowed) as closed loops of grid vertices, for drawing territory borders
+// instead of every triangle edge. A loop edge is a segment edge whose segment on the other side is not in the set, so
+// loops follow holes and cross face boundaries like any other edge. Every loop keeps the region on its left seen from
+// outside the sphere: outer boundaries run counter-clockwise and holes clockwise. Where the region touches itself at a
+// single vertex the loops are split there, so no loop visits a vertex twice. The last vertex of a loop connects back
+// to its first, which is not repeated. Runs in time linear in count. Needs n <= 1048576; returns NULL for an
+// out-of-range n or segment index, or when out of memory.
+FFI_PLUGIN_EXPORT SegmentRegionBoundary *ExtractSegmentRegionBoundary(int n, int64_t count,
+                                                                      const int64_t *segmentIndex);
+FFI_PLUGIN_EXPORT void DestroySegmentRegionBoundary(SegmentRegionBoundary *boundary);
+FFI_PLUGIN_EXPORT int64_t GetSegmentRegionBoundaryLoopCount(const SegmentRegionBoundary *boundary);
+// Total number of loop vertices over all loops.
+FFI_PLUGIN_EXPORT int64_t GetSegmentRegionBoundaryVertexCount(const SegmentRegionBoundary *boundary);
+// Loop l is vertices [offsets[l], offsets[l + 1]); LoopCount + 1 entries.
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentRegionBoundaryLoopOffsets(const SegmentRegionBoundary *boundary);
+// Grid vertex ids (GetSegmentGridVertexIndices64()) of the loops, back to back.
+FFI_PLUGIN_EXPORT const int64_t *GetSegmentRegionBoundaryVertexIndices(const SegmentRegionBoundary *boundary);
+// Lat/lng and unit-sphere position of each loop vertex. Either output may be NULL; with both NULL, returns the count
+// needed. outCapacity counts vertices.
+FFI_PLUGIN_EXPORT int64_t GetSegmentRegionBoundaryPoints(const SegmentRegionBoundary *boundary, GpsCoords *outLatLng,
+                                                         Vector3 *outPosition, int64_t outCapacity);
+
 // A longer lived native function, which occupies the thread calling it.
 //
 // Do not call these kind of native functions in the main isolate. They will
@@ -0,0 +1,48 @@
+// Internals of sphere_uniform_geocoding.c shared with the benchmark (bench.c) and the exhaustive validator
+// (validate.c). Not part of the plugin API: include it after sphere_uniform_geocoding.h, and link against the
+// sphere_uniform_geocoding_static target, which defines SPHERE_UNIFORM_GEOCODING_INTERNAL so that the functions
+// below get external linkage. In the plugin library itself they stay static, so the compiler can still inline them.
+#include <math.h>
+
+#ifdef SPHERE_UNIFORM_GEOCODING_INTERNAL
+#define INTERNAL_EXPORT
+#else
+#define INTERNAL_EXPORT static
+#endif
+
+#define NELEMS(x)  (sizeof(x) / sizeof((x)[0]))
+
+#ifndef M_PI
+#    define M_PI (3.14159265358979323846)
+#endif
+
+#define GroupCount (20)
+
+// Largest n whose segment indices fit the 32-bit API (20 * n * n <= 2^32). Up to this n both APIs geocode with the
+// original 7-digit icosahedron tables, so ids already stored by callers stay valid; above it the 64-bit API uses
+// exact tables for geocoding, centers and corners alike.
+#define MaxSubdivisionCount32 (14654)
+
+// Largest n the 64-bit index API accepts: 2^20, about 7 m segments on the Earth. Segment ids then stay below 2^45
+// and every per-face row/column still fits an int. Checking every segment near face edges passes at 80000 and 2^20.
+#define MaxSubdivisionCount64 (1048576)
+
+// Upper bound on the number of threads RunParallel() starts.
+#define ParallelMaxThreadCount (256)
+
+typedef void (*ParallelTaskFunc)(void *arg, int threadIndex);
+
+// Runs func(arg, 0) .. func(arg, threadCount - 1) on their own threads (0 on the calling thread) and waits for all.
+INTERNAL_EXPORT void RunParallel(int threadCount, ParallelTaskFunc func, void *arg);
+INTERNAL_EXPORT int GetProcessorCount(void);
+INTERNAL_EXPORT double GetMonotonicSeconds(void);
+INTERNAL_EXPORT int64_t CalculateSegmentCountPerGroup64(int n);
+
+INTERNAL_EXPORT Vector3 CalculateUnitSpherePosition(double lat, double lng);
+INTERNAL_EXPORT Vector3 AddVector3(Vector3 a, Vector3 b);
+INTERNAL_EXPORT Vector3 DiffVector3(Vector3 a, Vector3 b);
+INTERNAL_EXPORT double Dot(Vector3 v1, Vector3 v2);
+INTERNAL_EXPORT Vector3 Cross(Vector3 v1, Vector3 v2);
+INTERNAL_EXPORT Vector3 ScalarMultiplyVector(double s, Vector3 v);
+// Latitude and longitude of any point p, in radians, computed with libm atan2.
+INTERNAL_EXPORT GpsCoords CalculateLatLng(Vector3 p);
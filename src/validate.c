@@ -0,0 +1,306 @@
+// 주어진 n의 모든 세그먼트(또는 일부 구간)를 여러 스레드로 나누어 전수 검사한다.
+//   center    CalculateSegmentIndexFromLatLng(n, 중심 위경도)가 자기 자신을 반환하는지
+//   contain   중심이 세 꼭짓점이 이루는 삼각형 안에 있는지
+//   corners   각 꼭짓점에서 중심 쪽으로 조금 들어간 지점이 자기 자신으로 지오코딩되는지
+//   neighbors 이웃 목록이 대칭인지 (A가 B를 포함하면 B도 A를 포함), 범위를 벗어나거나 자기 자신이 없는지
+// 32비트 인덱스로 표현할 수 있는 n이면 32비트 API를, 그보다 크면 64비트 API를 검사한다.
+// --edge-rows k를 주면 면 경계(세 변)에서 k줄 안에 있는 세그먼트만 검사한다. 표 오차로 인한 불일치는 여기서 먼저 생기므로,
+// 전수 검사가 너무 오래 걸리는 큰 n은 이렇게 검사한다.
+// 32비트 API의 결과는 부호 없는 값으로 읽는다. INT_MAX를 넘는 인덱스도 비트 패턴으로는 유효하다.
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sphere_uniform_geocoding.h"
+#include "sphere_uniform_geocoding_internal.h"
+
+// 검사마다 출력하는 불일치 세그먼트 예시의 최대 수
+#define ValidateExampleCount (8)
+
+// 꼭짓점에서 중심 쪽으로 들어가는 비율
+#define ValidateCornerInset (1.0 / 16)
+
+typedef enum {
+    ValidateCheckCenter,
+    ValidateCheckContain,
+    ValidateCheckCorners,
+    ValidateCheckNeighbors,
+    ValidateCheckCount,
+} ValidateCheck;
+
+static const char *const ValidateCheckNames[] = {"center", "contain", "corners", "neighbors"};
+
+typedef struct {
+    int64_t mismatchCount;
+    int64_t examples[ValidateExampleCount];
+    int exampleCount;
+} ValidateResult;
+
+typedef struct {
+    ValidateResult results[ValidateCheckCount];
+    int64_t checkedCount;
+    double seconds;
+} ValidateThread;
+
+typedef struct {
+    int n;
+    int use64;
+    int64_t segmentCount;
+    int64_t begin;
+    int64_t count;
+    // 0이 아니면 [begin, begin + count) 대신 면 경계에서 이만큼의 줄 안에 있는 세그먼트만 검사한다.
+    int edgeRows;
+    int threadCount;
+    ValidateThread threads[ParallelMaxThreadCount];
+} ValidateJob;
+
+static void AddMismatch(ValidateResult *result, int64_t segmentIndex) {
+    if (result->exampleCount < ValidateExampleCount) {
+        result->examples[result->exampleCount++] = segmentIndex;
+    }
+    result->mismatchCount++;
+}
+
+static int64_t ValidateGeocode(const ValidateJob *job, GpsCoords p) {
+    return job->use64 ? CalculateSegmentIndexFromLatLng64(job->n, p.lat, p.lng)
+                      : (uint32_t) CalculateSegmentIndexFromLatLng(job->n, p.lat, p.lng);
+}
+
+static NeighborSegIdList64 ValidateNeighbors(const ValidateJob *job, int64_t segmentIndex) {
+    if (job->use64) {
+        return GetNeighborsOfSegmentIndex64(job->n, segmentIndex);
+    }
+
+    const NeighborSegIdList list = GetNeighborsOfSegmentIndex(job->n, (int) segmentIndex);
+    NeighborSegIdList64 ret = {.count = list.count};
+    for (int i = 0; i < list.count; i++) {
+        ret.neighborSegId[i] = (uint32_t) list.neighborSegId[i];
+    }
+    return ret;
+}
+
+// p가 구면 삼각형 abc 안(경계 제외)에 있는지. 꼭짓점 순서(시계/반시계)와 관계없이 판정한다.
+static int IsInsideSphericalTriangle(Vector3 a, Vector3 b, Vector3 c, Vector3 p) {
+    const double orientation = Dot(Cross(a, b), c);
+    return Dot(Cross(a, b), p) * orientation > 0 && Dot(Cross(b, c), p) * orientation > 0 &&
+           Dot(Cross(c, a), p) * orientation > 0;
+}
+
+static void ValidateSegment(const ValidateJob *job, ValidateResult *results, int64_t segmentIndex) {
+    const GpsCoords center = job->use64 ? CalculateSegmentCenterLatLng64(job->n, segmentIndex)
+                                        : CalculateSegmentCenterLatLng(job->n, (int) segmentIndex);
+    if (ValidateGeocode(job, center) != segmentIndex) {
+        AddMismatch(&results[ValidateCheckCenter], segmentIndex);
+    }
+
+    const SegmentCornersInLatLng corners = job->use64 ? CalculateSegmentCornersInLatLng64(job->n, segmentIndex)
+                                                      : CalculateSegmentCornersInLatLng(job->n, (int) segmentIndex);
+    const Vector3 c = CalculateUnitSpherePosition(center.lat, center.lng);
+    Vector3 v[3];
+    for (int i = 0; i < 3; i++) {
+        v[i] = CalculateUnitSpherePosition(corners.points[i].lat, corners.points[i].lng);
+    }
+    if (!IsInsideSphericalTriangle(v[0], v[1], v[2], c)) {
+        AddMismatch(&results[ValidateCheckContain], segmentIndex);
+    }
+
+    // 면 위의 직선은 구면에서도 대원호이므로, 꼭짓점과 중심 사이의 점은 세그먼트 안에 있다.
+    for (int i = 0; i < 3; i++) {
+        const Vector3 inset = AddVector3(v[i], ScalarMultiplyVector(ValidateCornerInset, DiffVector3(c, v[i])));
+        if (ValidateGeocode(job, CalculateLatLng(inset)) != segmentIndex) {
+            AddMismatch(&results[ValidateCheckCorners], segmentIndex);
+            break;
+        }
+    }
+
+    const NeighborSegIdList64 neighbors = ValidateNeighbors(job, segmentIndex);
+    int symmetric = neighbors.count > 0;
+    for (int i = 0; i < neighbors.count && symmetric; i++) {
+        const int64_t neighbor = neighbors.neighborSegId[i];
+        if (neighbor < 0 || neighbor >= job->segmentCount || neighbor == segmentIndex) {
+            symmetric = 0;
+            break;
+        }
+
+        const NeighborSegIdList64 back = ValidateNeighbors(job, neighbor);
+        int found = 0;
+        for (int j = 0; j < back.count; j++) {
+            found |= back.neighborSegId[j] == segmentIndex;
+        }
+        symmetric = found;
+    }
+    if (!symmetric) {
+        AddMismatch(&results[ValidateCheckNeighbors], segmentIndex);
+    }
+}
+
+// 세그먼트 그룹 내 B 행 하나에서 면 경계로부터 edgeRows줄 안에 있는 세그먼트를 검사한다.
+// 세그먼트 (a, b, t)에서 세 변까지의 줄 수는 b, a, n - 1 - a - b - t다.
+static int64_t ValidateEdgeRow(const ValidateJob *job, ValidateResult *results, int segGroup, int b) {
+    const int n = job->n;
+    const int k = job->edgeRows;
+    const int64_t rowStart = CalculateSegmentCountPerGroup64(n) * segGroup + (int64_t) b * (2 * (int64_t) n - b);
+    int64_t checked = 0;
+    for (int t = 0; t < 2; t++) {
+        // 이 행에서 t인 세그먼트의 a는 0 .. last다.
+        const int last = n - 1 - b - t;
+        for (int a = 0; a <= last; a++) {
+            if (b >= k && a >= k && last - a >= k) {
+                // 가운데는 건너뛰고 오른쪽 변 근처로 간다.
+                a = last - k;
+                continue;
+            }
+            ValidateSegment(job, results, rowStart + 2 * (int64_t) a + t);
+            checked++;
+        }
+    }
+    return checked;
+}
+
+// 스레드마다 연속한 구간을 맡는다. 0번 스레드는 자기 구간의 진행률을 표준 오류로 알린다.
+static void RunValidateThread(void *arg, int threadIndex) {
+    ValidateJob *job = arg;
+    ValidateThread *thread = &job->threads[threadIndex];
+    if (job->edgeRows > 0) {
+        // 모든 세그먼트 그룹의 B 행 (20n개)을 나누어 맡는다.
+        const int64_t rowCount = (int64_t) GroupCount * job->n;
+        const int64_t rowBegin = rowCount * threadIndex / job->threadCount;
+        const int64_t rowEnd = rowCount * (threadIndex + 1) / job->threadCount;
+        const int64_t progressStep = (rowEnd - rowBegin) / 20 > 0 ? (rowEnd - rowBegin) / 20 : 1;
+
+        const double t0 = GetMonotonicSeconds();
+        for (int64_t row = rowBegin; row < rowEnd; row++) {
+            thread->checkedCount += ValidateEdgeRow(job, thread->results, (int) (row / job->n), (int) (row % job->n));
+            if (threadIndex == 0 && (row - rowBegin + 1) % progressStep == 0) {
+                fprintf(stderr, "progress %3d%% (%.1f s)\n", (int) ((row - rowBegin + 1) * 100 / (rowEnd - rowBegin)),
+                        GetMonotonicSeconds() - t0);
+            }
+        }
+        thread->seconds = GetMonotonicSeconds() - t0;
+        return;
+    }
+
+    // count * threadIndex는 큰 n에서 넘칠 수 있으므로 몫과 나머지로 나눈다.
+    const int64_t share = job->count / job->threadCount;
+    const int64_t extra = job->count % job->threadCount;
+    const int64_t begin = job->begin + share * threadIndex + (threadIndex < extra ? threadIndex : extra);
+    const int64_t end = begin + share + (threadIndex < extra);
+    const int64_t progressStep = (end - begin) / 20 > 0 ? (end - begin) / 20 : 1;
+
+    const double t0 = GetMonotonicSeconds();
+    for (int64_t i = begin; i < end; i++) {
+        ValidateSegment(job, thread->results, i);
+        if (threadIndex == 0 && (i - begin + 1) % progressStep == 0) {
+            fprintf(stderr, "progress %3d%% (%.1f s)\n", (int) ((i - begin + 1) * 100 / (end - begin)),
+                    GetMonotonicSeconds() - t0);
+        }
+    }
+    thread->checkedCount = end - begin;
+    thread->seconds = GetMonotonicSeconds() - t0;
+}
+
+static void PrintValidateUsage(void) {
+    fprintf(stderr, "usage: sphere_uniform_geocoding_validate <n> [options]\n");
+    fprintf(stderr, "  --threads count   worker threads (default: processor count)\n");
+    fprintf(stderr, "  --begin index     first segment index to check (default 0)\n");
+    fprintf(stderr, "  --count count     number of segments to check (default: all from begin)\n");
+    fprintf(stderr, "  --edge-rows k     check only segments within k rows of a face edge (ignores --begin, --count)\n");
+}
+
+int main(int argc, char **argv) {
+    const int n = argc >= 2 ? atoi(argv[1]) : 0;
+    if (n < 1 || n > MaxSubdivisionCount64) {
+        PrintValidateUsage();
+        return 1;
+    }
+
+    const int64_t segmentCount = CalculateSegmentCountPerGroup64(n) * GroupCount;
+    int threadCount = GetProcessorCount();
+    int64_t begin = 0;
+    int64_t count = -1;
+    int edgeRows = 0;
+    for (int i = 2; i < argc; i += 2) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        int valid = value != NULL;
+        if (valid && strcmp(argv[i], "--threads") == 0) {
+            threadCount = atoi(value);
+            valid = threadCount > 0 && threadCount <= ParallelMaxThreadCount;
+        } else if (valid && strcmp(argv[i], "--begin") == 0) {
+            begin = strtoll(value, NULL, 10);
+            valid = begin >= 0 && begin < segmentCount;
+        } else if (valid && strcmp(argv[i], "--count") == 0) {
+            count = strtoll(value, NULL, 10);
+            valid = count >= 0;
+        } else if (valid && strcmp(argv[i], "--edge-rows") == 0) {
+            edgeRows = atoi(value);
+            valid = edgeRows > 0;
+        } else {
+            valid = 0;
+        }
+
+        if (!valid) {
+            PrintValidateUsage();
+            return 1;
+        }
+    }
+    if (count < 0 || count > segmentCount - begin) {
+        count = segmentCount - begin;
+    }
+
+    ValidateJob *job = calloc(1, sizeof(ValidateJob));
+    if (job == NULL) {
+        return 1;
+    }
+    job->n = n;
+    job->use64 = n > MaxSubdivisionCount32;
+    job->segmentCount = segmentCount;
+    job->begin = begin;
+    job->count = count;
+    job->edgeRows = edgeRows;
+    job->threadCount = count < threadCount ? (count > 0 ? (int) count : 1) : threadCount;
+
+    if (edgeRows > 0) {
+        printf("n=%d, %s API, segments within %d rows of a face edge, of %lld, %d threads\n", n,
+               job->use64 ? "64-bit" : "32-bit", edgeRows, (long long) segmentCount, job->threadCount);
+    } else {
+        printf("n=%d, %s API, segments [%lld, %lld) of %lld, %d threads\n", n, job->use64 ? "64-bit" : "32-bit",
+               (long long) begin, (long long) (begin + count), (long long) segmentCount, job->threadCount);
+    }
+    const double t0 = GetMonotonicSeconds();
+    RunParallel(job->threadCount, RunValidateThread, job);
+    const double seconds = GetMonotonicSeconds() - t0;
+
+    // 스레드마다 구간이 오름차순이므로, 스레드 순서로 모으면 가장 작은 인덱스의 예시가 남는다.
+    int64_t totalMismatchCount = 0;
+    for (int check = 0; check < ValidateCheckCount; check++) {
+        ValidateResult merged = {0};
+        for (int t = 0; t < job->threadCount; t++) {
+            const ValidateResult *result = &job->threads[t].results[check];
+            merged.mismatchCount += result->mismatchCount;
+            for (int i = 0; i < result->exampleCount && merged.exampleCount < ValidateExampleCount; i++) {
+                merged.examples[merged.exampleCount++] = result->examples[i];
+            }
+        }
+
+        printf("%-9s %lld mismatches", ValidateCheckNames[check], (long long) merged.mismatchCount);
+        for (int i = 0; i < merged.exampleCount; i++) {
+            printf("%s%lld", i == 0 ? " (e.g. " : ", ", (long long) merged.examples[i]);
+        }
+        printf("%s\n", merged.exampleCount > 0 ? ")" : "");
+        totalMismatchCount += merged.mismatchCount;
+    }
+
+    double slowest = 0;
+    int64_t checkedCount = 0;
+    for (int t = 0; t < job->threadCount; t++) {
+        slowest = fmax(slowest, job->threads[t].seconds);
+        checkedCount += job->threads[t].checkedCount;
+    }
+    printf("%lld segments in %.3f s: %.0f segments/s (%.0f segments/s per thread)\n", (long long) checkedCount,
+           seconds, seconds > 0 ? (double) checkedCount / seconds : 0,
+           slowest > 0 ? (double) checkedCount / job->threadCount / slowest : 0);
+
+    free(job);
+    return totalMismatchCount != 0;
+}